@@ -35,11 +35,48 @@ constexpr size_t MAX_REC_SIZE = 1024;
 constexpr size_t SORT_BUFFER_SIZE = 64 * 1024 * 1024;
 // 10-way merge sort, max tmp file to use in merge sort
 constexpr size_t SORT_WAY_NUM = 10;
+// 1MB, read and write buffer of each run file in merge sort
+constexpr size_t SORT_IO_BUFFER_SIZE = 1024 * 1024;
+// 64MB, build side of hash join held in memory, larger build sides are partitioned to tmp files
+constexpr size_t HASH_JOIN_BUFFER_SIZE = 64 * 1024 * 1024;
+// fan-out of each partitioning pass of hash join, must be a power of 2
+constexpr size_t HASH_JOIN_PARTITION_NUM = 16;
+// 64MB, block of left records held by nested loop join, the right input is scanned once per block
+constexpr size_t NESTED_LOOP_JOIN_BUFFER_SIZE = 64 * 1024 * 1024;
+// bits per build key of the bloom filters pushed down from joins into the scans of their probe side
+constexpr size_t BLOOM_FILTER_BITS_PER_KEY = 10;
+// 16MB, max size of a bloom filter, larger build sides get fewer bits per key
+constexpr size_t BLOOM_FILTER_MAX_SIZE = 16 * 1024 * 1024;
+// IN lists of at least this many values are joined with a hash table instead of compared value by value
+constexpr size_t IN_LIST_SEMI_JOIN_THRESHOLD = 32;
+// projected fields of a table that take at least this many bytes per record are fetched by rid after joins and
+// sorts instead of being carried through them
+constexpr size_t LATE_MATERIALIZATION_MIN_SIZE = 32;
+// 64MB, groups of hash aggregation held in memory, rows of the groups that do not fit are partitioned to tmp files
+constexpr size_t AGG_BUFFER_SIZE = 64 * 1024 * 1024;
+// fan-out of each partitioning pass of hash aggregation, must be a power of 2
+constexpr size_t AGG_PARTITION_NUM = 16;
+// 4MB, read buffer of LOAD DATA INFILE, a single line should not exceed the buffer
+constexpr size_t LOAD_BUFFER_SIZE = 4 * 1024 * 1024;
+// rows per chunk in batch execution, keeps the columns of a chunk in L2 cache
+constexpr size_t CHUNK_SIZE = 2048;
+// pages of a morsel, the unit of work handed out to the workers of a parallel scan
+constexpr size_t PARALLEL_SCAN_MORSEL_SIZE = 64;
+// max workers of a parallel scan, each worker pins a page at a time so it should be well below BUFFER_POOL_SIZE
+constexpr size_t PARALLEL_SCAN_WORKER_NUM = BUFFER_POOL_SIZE / 2;
+// run queries and the inputs of sort, hash build and aggregate as push-based pipelines where the plan allows it,
+// disable this to pull every record through the executors
+constexpr bool PUSH_PIPELINE_EXECUTION = true;
+// partitions merged in parallel by parallel hash aggregation, must be a power of 2 and well above the workers
+constexpr size_t PARALLEL_AGG_PARTITION_NUM = 64;
+// interval of checking whether the clients are still connected, the tasks of a gone client are cancelled
+constexpr size_t CLIENT_CHECK_INTERVAL_MS = 100;
 
 const std::string DB_SUFFIX  = ".db";
 const std::string TAB_SUFFIX = ".tab";
 const std::string IDX_SUFFIX = ".idx";
 const std::string TMP_SUFFIX = ".tmp";
+const std::string ZM_SUFFIX  = ".zm";
 
 const std::string DB_DIR  = "db";
 const std::string TAB_DIR = "tab";
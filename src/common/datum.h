@@ -0,0 +1,222 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+/**
+ * @brief Datum is a by-value representation of a single field, used on the hot paths of execution
+ *
+ * Different from Value, datum needs no heap allocation and no virtual call. A string datum only refers to
+ * the memory it is created from, e.g. the record data or a StringValue, so it must not outlive that memory.
+ * Value is still used at the boundary of the executors, e.g. the values in the plans and the output records.
+ */
+
+#ifndef WSDB_DATUM_H
+#define WSDB_DATUM_H
+
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+#include "value.h"
+
+namespace wsdb {
+
+class Datum
+{
+public:
+  /// a null datum
+  Datum() = default;
+
+  static auto FromInt(int32_t value) -> Datum
+  {
+    Datum datum(TYPE_INT);
+    datum.int_ = value;
+    return datum;
+  }
+
+  static auto FromFloat(float value) -> Datum
+  {
+    Datum datum(TYPE_FLOAT);
+    datum.float_ = value;
+    return datum;
+  }
+
+  static auto FromBool(bool value) -> Datum
+  {
+    Datum datum(TYPE_BOOL);
+    datum.bool_ = value;
+    return datum;
+  }
+
+  static auto FromString(std::string_view value) -> Datum
+  {
+    Datum datum(TYPE_STRING);
+    datum.str_ = value.data();
+    datum.len_ = static_cast<uint32_t>(value.size());
+    return datum;
+  }
+
+  /**
+   * Make a datum from the field memory in record layout, strings end at the first '\0' like StringValue does
+   * @param type
+   * @param data
+   * @param size field size
+   */
+  static auto FromRaw(FieldType type, const char *data, size_t size) -> Datum
+  {
+    switch (type) {
+      case TYPE_BOOL: return FromBool(*reinterpret_cast<const bool *>(data));
+      case TYPE_INT: return FromInt(*reinterpret_cast<const int32_t *>(data));
+      case TYPE_FLOAT: return FromFloat(*reinterpret_cast<const float *>(data));
+      case TYPE_STRING: return FromString(std::string_view(data, strnlen(data, size)));
+      default: WSDB_FETAL(fmt::format("Unsupported datum type: {}", FieldTypeToString(type)));
+    }
+  }
+
+  /// the datum refers to the value if it is a string, array values are not supported
+  static auto FromValue(const Value &value) -> Datum
+  {
+    if (value.IsNull()) {
+      return {};
+    }
+    switch (value.GetType()) {
+      case TYPE_BOOL: return FromBool(dynamic_cast<const BoolValue &>(value).Get());
+      case TYPE_INT: return FromInt(dynamic_cast<const IntValue &>(value).Get());
+      case TYPE_FLOAT: return FromFloat(dynamic_cast<const FloatValue &>(value).Get());
+      case TYPE_STRING: return FromString(dynamic_cast<const StringValue &>(value).Get());
+      default: WSDB_FETAL(fmt::format("Unsupported datum type: {}", FieldTypeToString(value.GetType())));
+    }
+  }
+
+  [[nodiscard]] auto ToValue() const -> ValueSptr
+  {
+    switch (type_) {
+      case TYPE_BOOL: return ValueFactory::CreateBoolValue(bool_);
+      case TYPE_INT: return ValueFactory::CreateIntValue(int_);
+      case TYPE_FLOAT: return ValueFactory::CreateFloatValue(float_);
+      case TYPE_STRING: return ValueFactory::CreateStringValue(str_, len_);
+      default: WSDB_FETAL("Null datum has no type");
+    }
+  }
+
+  [[nodiscard]] auto GetType() const -> FieldType { return type_; }
+
+  [[nodiscard]] auto IsNull() const -> bool { return type_ == TYPE_NULL; }
+
+  [[nodiscard]] auto GetInt() const -> int32_t { return int_; }
+
+  [[nodiscard]] auto GetFloat() const -> float { return float_; }
+
+  [[nodiscard]] auto GetBool() const -> bool { return bool_; }
+
+  [[nodiscard]] auto GetString() const -> std::string_view { return {str_, len_}; }
+
+  /**
+   * Three-way comparison of two non-null datums, int and float are compared as float like ValueFactory::AlignTypes
+   * does, throw WSDB_TYPE_MISSMATCH for other types that differ
+   */
+  static auto Compare(const Datum &lhs, const Datum &rhs) -> int
+  {
+    if (lhs.type_ == rhs.type_) {
+      switch (lhs.type_) {
+        case TYPE_BOOL: return Cmp(lhs.bool_, rhs.bool_);
+        case TYPE_INT: return Cmp(lhs.int_, rhs.int_);
+        case TYPE_FLOAT: return Cmp(lhs.float_, rhs.float_);
+        case TYPE_STRING: return Cmp(lhs.GetString().compare(rhs.GetString()), 0);
+        default: break;
+      }
+    } else if (lhs.type_ == TYPE_INT && rhs.type_ == TYPE_FLOAT) {
+      return Cmp(static_cast<float>(lhs.int_), rhs.float_);
+    } else if (lhs.type_ == TYPE_FLOAT && rhs.type_ == TYPE_INT) {
+      return Cmp(lhs.float_, static_cast<float>(rhs.int_));
+    }
+    WSDB_THROW(WSDB_TYPE_MISSMATCH,
+        fmt::format("Type mismatch: {} != {}", FieldTypeToString(lhs.type_), FieldTypeToString(rhs.type_)));
+  }
+
+  /// ordering used by sort and merge, nulls go first
+  static auto CompareNullsFirst(const Datum &lhs, const Datum &rhs) -> int
+  {
+    if (lhs.IsNull() || rhs.IsNull()) {
+      return Cmp(!lhs.IsNull(), !rhs.IsNull());
+    }
+    return Compare(lhs, rhs);
+  }
+
+  /**
+   * Evaluate lhs op rhs with the semantics of the Value operators, i.e. comparisons with null are false
+   * except that null = null is true
+   */
+  static auto Eval(CompOp op, const Datum &lhs, const Datum &rhs) -> bool
+  {
+    if (lhs.IsNull() || rhs.IsNull()) {
+      bool both_null = lhs.IsNull() && rhs.IsNull();
+      return op == OP_EQ ? both_null : (op == OP_NE ? !both_null : false);
+    }
+    int cmp = Compare(lhs, rhs);
+    switch (op) {
+      case OP_EQ: return cmp == 0;
+      case OP_NE: return cmp != 0;
+      case OP_LT: return cmp < 0;
+      case OP_LE: return cmp <= 0;
+      case OP_GT: return cmp > 0;
+      case OP_GE: return cmp >= 0;
+      default: WSDB_FETAL(CompOpToString(op));
+    }
+  }
+
+  [[nodiscard]] auto Hash() const -> size_t
+  {
+    switch (type_) {
+      case TYPE_NULL: return 0;
+      case TYPE_BOOL: return std::hash<bool>{}(bool_);
+      case TYPE_INT: return std::hash<int32_t>{}(int_);
+      case TYPE_FLOAT: return std::hash<float>{}(float_);
+      case TYPE_STRING: return std::hash<std::string_view>{}(GetString());
+      default: WSDB_FETAL(fmt::format("Unsupported datum type: {}", FieldTypeToString(type_)));
+    }
+  }
+
+  /// mix the hash of a field into the hash of a key, the order of fields matters
+  static auto HashCombine(size_t seed, size_t hash) -> size_t
+  {
+    return seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+  }
+
+private:
+  explicit Datum(FieldType type) : type_(type) {}
+
+  template <typename T>
+  static auto Cmp(const T &lhs, const T &rhs) -> int
+  {
+    return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+  }
+
+  FieldType type_{TYPE_NULL};
+  uint32_t  len_{0};
+  union
+  {
+    int32_t     int_;
+    float       float_;
+    bool        bool_;
+    const char *str_{nullptr};
+  };
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_DATUM_H
@@ -25,6 +25,7 @@
 #include <vector>
 #include <memory>
 #include "../../common/micro.h"
+#include "rid.h"
 #include "types.h"
 
 struct FieldSchema;
@@ -80,6 +81,20 @@ struct RTField
   }
 };
 
+// hidden field that holds the rid of a table record, late materialization carries it through joins and sorts in
+// place of the fields that are only fetched by rid at the end. Identifiers of sql can not start with '$'
+constexpr char RID_FIELD_NAME[] = "$rid";
+
+inline auto MakeRidField(table_id_t table_id) -> RTField
+{
+  return {.field_ = {.table_id_ = table_id,
+              .field_name_      = RID_FIELD_NAME,
+              .field_size_      = sizeof(wsdb::RID),
+              .field_type_      = FieldType::TYPE_STRING}};
+}
+
+inline auto IsRidField(const RTField &field) -> bool { return field.field_.field_name_ == RID_FIELD_NAME; }
+
 /**
  * Table header is the first page of a table, it contains the meta information of the table
  */
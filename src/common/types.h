@@ -108,8 +108,11 @@ ENUM_TO_STRING_BODY(JoinType)
 #undef ENUM_ENTITIES
 
 #define ENUM_ENTITIES \
+  ENUM(AUTO)          \
   ENUM(NESTED_LOOP)   \
-  ENUM(SORT_MERGE)
+  ENUM(SORT_MERGE)    \
+  ENUM(HASH)          \
+  ENUM(INDEX_NESTED_LOOP)
 #define ENUM(ent) ENUMENTRY(ent)
 DECLARE_ENUM(JoinStrategy)
 #undef ENUM
@@ -137,7 +140,8 @@ ENUM_TO_STRING_BODY(OrderByDir)
   ENUM(OP_LE)         \
   ENUM(OP_GE)         \
   ENUM(OP_IN)         \
-  ENUM(OP_RNG)
+  ENUM(OP_RNG)        \
+  ENUM(OP_NOT_IN)
 #define ENUM(ent) ENUMENTRY(ent)
 DECLARE_ENUM(CompOp)
 #undef ENUM
@@ -152,6 +156,7 @@ inline auto CompOpToString(CompOp op) -> const char *{
     case OP_GE: return ">=";
     case OP_IN: return "IN";
     case OP_RNG: return "RANGE";
+    case OP_NOT_IN: return "NOT IN";
     default: return "UNKNOWN";
   }
 }
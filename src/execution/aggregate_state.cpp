@@ -0,0 +1,181 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "aggregate_state.h"
+
+namespace wsdb {
+
+auto MakeAggOutSchema(const RecordSchema &group_schema, const RecordSchema &agg_schema) -> RecordSchemaUptr
+{
+  std::vector<RTField> fields;
+  for (const auto &field : group_schema.GetFields()) {
+    fields.push_back(field);
+  }
+  for (const auto &field : agg_schema.GetFields()) {
+    fields.push_back(field);
+  }
+  return std::make_unique<RecordSchema>(fields);
+}
+
+auto ResolveGroupCols(const RecordSchema &child_schema, const RecordSchema &group_schema) -> std::vector<size_t>
+{
+  std::vector<size_t> group_cols;
+  for (const auto &field : group_schema.GetFields()) {
+    auto idx = child_schema.GetFieldIndex(field.field_.table_id_, field.field_.field_name_);
+    if (idx == child_schema.GetFieldCount()) {
+      WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+    }
+    group_cols.push_back(idx);
+  }
+  return group_cols;
+}
+
+auto ResolveAggFields(const RecordSchema &child_schema, const RecordSchema &agg_schema, size_t &state_size)
+    -> std::vector<AggField>
+{
+  std::vector<AggField> aggs;
+  state_size = 0;
+  for (const auto &field : agg_schema.GetFields()) {
+    if (field.agg_type_ == AGG_COUNT_STAR) {
+      aggs.push_back(
+          {.type_ = AGG_COUNT_STAR, .col_idx_ = 0, .field_type_ = TYPE_INT, .size_ = 0, .state_offset_ = state_size});
+      state_size += sizeof(AggState);
+      continue;
+    }
+    // the planner may change type and size of aggregate fields, so columns are matched by table id and name only
+    auto idx = child_schema.GetFieldIndex(field.field_.table_id_, field.field_.field_name_);
+    if (idx == child_schema.GetFieldCount()) {
+      WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+    }
+    const auto &col = child_schema.GetFieldAt(idx).field_;
+    if ((field.agg_type_ == AGG_SUM || field.agg_type_ == AGG_AVG) && col.field_type_ != TYPE_INT &&
+        col.field_type_ != TYPE_FLOAT) {
+      WSDB_THROW(WSDB_TYPE_MISSMATCH,
+          fmt::format("{} on {} field {}", AggTypeToString(field.agg_type_), FieldTypeToString(col.field_type_),
+              col.field_name_));
+    }
+    aggs.push_back({.type_ = field.agg_type_,
+        .col_idx_ = idx,
+        .field_type_ = col.field_type_,
+        .size_ = col.field_size_,
+        .state_offset_ = state_size});
+    state_size += sizeof(AggState);
+    if (field.agg_type_ == AGG_MIN || field.agg_type_ == AGG_MAX) {
+      // keep the next state aligned
+      state_size += (col.field_size_ + alignof(AggState) - 1) / alignof(AggState) * alignof(AggState);
+    }
+  }
+  return aggs;
+}
+
+void EncodeGroupField(const FieldSchema &field, const char *src, char *dst)
+{
+  if (field.field_type_ == TYPE_STRING) {
+    // bytes after the end of a string are not significant
+    memcpy(dst, src, strnlen(src, field.field_size_));
+  } else if (field.field_type_ == TYPE_FLOAT && *reinterpret_cast<const float *>(src) == 0) {
+    // 0.0 and -0.0 are the same group, the key is left as zero bytes
+  } else {
+    memcpy(dst, src, field.field_size_);
+  }
+}
+
+/// whether val replaces the extreme value cur of a min or max
+static auto IsNewExtreme(const AggField &agg, const char *val, const char *cur) -> bool
+{
+  auto cmp =
+      Datum::Compare(Datum::FromRaw(agg.field_type_, val, agg.size_), Datum::FromRaw(agg.field_type_, cur, agg.size_));
+  return (agg.type_ == AGG_MIN && cmp < 0) || (agg.type_ == AGG_MAX && cmp > 0);
+}
+
+void UpdateAggState(const AggField &agg, AggState *state, const char *val)
+{
+  switch (agg.type_) {
+    case AGG_COUNT_STAR:
+    case AGG_COUNT: break;
+    case AGG_SUM:
+    case AGG_AVG:
+      if (agg.field_type_ == TYPE_INT) {
+        state->int_sum_ += *reinterpret_cast<const int32_t *>(val);
+      } else {
+        state->float_sum_ += *reinterpret_cast<const float *>(val);
+      }
+      break;
+    case AGG_MIN:
+    case AGG_MAX: {
+      char *cur = reinterpret_cast<char *>(state + 1);
+      if (state->count_ == 0 || IsNewExtreme(agg, val, cur)) {
+        memcpy(cur, val, agg.size_);
+      }
+      break;
+    }
+    default: WSDB_FETAL(fmt::format("Unsupported aggregate type: {}", AggTypeToString(agg.type_)));
+  }
+  state->count_++;
+}
+
+void CombineAggState(const AggField &agg, AggState *to, const AggState *from)
+{
+  if (from->count_ == 0) {
+    return;
+  }
+  if (agg.type_ == AGG_MIN || agg.type_ == AGG_MAX) {
+    char       *cur = reinterpret_cast<char *>(to + 1);
+    const char *val = reinterpret_cast<const char *>(from + 1);
+    if (to->count_ == 0 || IsNewExtreme(agg, val, cur)) {
+      memcpy(cur, val, agg.size_);
+    }
+  }
+  to->count_ += from->count_;
+  to->int_sum_ += from->int_sum_;
+  to->float_sum_ += from->float_sum_;
+}
+
+auto WriteAggResult(const AggField &agg, const AggState *state, char *dst) -> bool
+{
+  if (agg.type_ == AGG_COUNT || agg.type_ == AGG_COUNT_STAR) {
+    *reinterpret_cast<int32_t *>(dst) = static_cast<int32_t>(state->count_);
+    return true;
+  }
+  // other aggregates of no values are null
+  if (state->count_ == 0) {
+    return false;
+  }
+  switch (agg.type_) {
+    case AGG_SUM:
+      if (agg.field_type_ == TYPE_INT) {
+        *reinterpret_cast<int32_t *>(dst) = static_cast<int32_t>(state->int_sum_);
+      } else {
+        *reinterpret_cast<float *>(dst) = static_cast<float>(state->float_sum_);
+      }
+      break;
+    case AGG_AVG:
+      // the average of an int field is an int like the field itself
+      if (agg.field_type_ == TYPE_INT) {
+        *reinterpret_cast<int32_t *>(dst) = static_cast<int32_t>(state->int_sum_ / state->count_);
+      } else {
+        *reinterpret_cast<float *>(dst) = static_cast<float>(state->float_sum_ / state->count_);
+      }
+      break;
+    case AGG_MIN:
+    case AGG_MAX: memcpy(dst, state + 1, agg.size_); break;
+    default: WSDB_FETAL(fmt::format("Unsupported aggregate type: {}", AggTypeToString(agg.type_)));
+  }
+  return true;
+}
+
+}  // namespace wsdb
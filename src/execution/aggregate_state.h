@@ -0,0 +1,75 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Group keys and aggregate states shared by the aggregation executors
+ *
+ * Group keys are the group fields in record layout followed by their null map, with strings zero-padded and -0.0
+ * folded to 0.0 so that equal values have equal keys. The states of all aggregates of a group are kept in a
+ * fixed-layout slot, an aggregate takes an AggState at its offset, followed by the extreme value for min and max.
+ */
+
+#ifndef WSDB_AGGREGATE_STATE_H
+#define WSDB_AGGREGATE_STATE_H
+
+#include "system/handle/record_handle.h"
+
+namespace wsdb {
+
+/// how an aggregate field is computed from the child
+struct AggField
+{
+  AggType   type_;
+  size_t    col_idx_;  // column in the child schema, unused for COUNT(*)
+  FieldType field_type_;
+  size_t    size_;
+  size_t    state_offset_;  // offset of its state in the state slot of a group
+};
+
+/// running state of an aggregate in a group, min and max keep the extreme value right after the state
+struct AggState
+{
+  int64_t count_;
+  int64_t int_sum_;
+  double  float_sum_;
+};
+
+/// the group fields followed by the aggregate fields
+auto MakeAggOutSchema(const RecordSchema &group_schema, const RecordSchema &agg_schema) -> RecordSchemaUptr;
+
+/// columns of the group fields in the child
+auto ResolveGroupCols(const RecordSchema &child_schema, const RecordSchema &group_schema) -> std::vector<size_t>;
+
+/// columns of the aggregate fields in the child and their offsets in a state slot of state_size bytes
+auto ResolveAggFields(const RecordSchema &child_schema, const RecordSchema &agg_schema, size_t &state_size)
+    -> std::vector<AggField>;
+
+/// write a non-null group field into its place of a zeroed key
+void EncodeGroupField(const FieldSchema &field, const char *src, char *dst);
+
+/// add a non-null value to the state, val is unused for COUNT(*)
+void UpdateAggState(const AggField &agg, AggState *state, const char *val);
+
+/// add the partial state from to the state to
+void CombineAggState(const AggField &agg, AggState *to, const AggState *from);
+
+/// write the result of the state into dst, false if the result is null
+auto WriteAggResult(const AggField &agg, const AggState *state, char *dst) -> bool;
+
+}  // namespace wsdb
+
+#endif  // WSDB_AGGREGATE_STATE_H
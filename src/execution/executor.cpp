@@ -26,6 +26,12 @@
 
 namespace wsdb {
 
+// the executor gets a copy of a schema of the plan, the plan is still shown after it runs, e.g. by EXPLAIN ANALYZE
+static auto CopySchema(const RecordSchemaUptr &schema) -> RecordSchemaUptr
+{
+  return schema == nullptr ? nullptr : std::make_unique<RecordSchema>(schema->GetFields());
+}
+
 // translate the plan to executor
 auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> AbstractExecutorUptr
 {
@@ -50,6 +56,12 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
     std::vector<RecordUptr> inserts;
     inserts.emplace_back(std::make_unique<Record>(&tab->GetSchema(), insert->values_, INVALID_RID));
     return std::make_unique<InsertExecutor>(tab, db->GetIndexes(insert->table_name_), std::move(inserts));
+  } else if (const auto load = std::dynamic_pointer_cast<LoadDataPlan>(plan)) {
+    auto tab = db->GetTable(load->table_name_);
+    if (tab == nullptr) {
+      WSDB_THROW(WSDB_TABLE_MISS, load->table_name_);
+    }
+    return std::make_unique<LoadDataExecutor>(tab, db->GetIndexes(load->table_name_), load->file_path_);
   } else if (const auto update = std::dynamic_pointer_cast<UpdatePlan>(plan)) {
     auto tab = db->GetTable(update->table_name_);
     if (tab == nullptr) {
@@ -64,41 +76,111 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
     }
     return std::make_unique<DeleteExecutor>(Translate(del->child_, db), tab, db->GetIndexes(del->table_name_));
   } else if (const auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
-    std::function<bool(const Record &)> filter_func = [filter](const Record &record) {
-      return ConditionExpr::Eval(filter->conds_, record);
-    };
-    return std::make_unique<FilterExecutor>(Translate(filter->child_, db), std::move(filter_func));
+    return std::make_unique<FilterExecutor>(Translate(filter->child_, db), filter->conds_);
   } else if (const auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
     auto tab = db->GetTable(scan->table_name_);
     if (tab == nullptr) {
       WSDB_THROW(WSDB_TABLE_MISS, scan->table_name_);
     }
-    return std::make_unique<SeqScanExecutor>(tab);
+    auto proj_schema = scan->proj_fields_.empty() ? nullptr : std::make_unique<RecordSchema>(scan->proj_fields_);
+    return std::make_unique<SeqScanExecutor>(tab, std::move(proj_schema), scan->skip_conds_, scan->runtime_filter_);
+  } else if (const auto par_scan = std::dynamic_pointer_cast<ParallelScanPlan>(plan)) {
+    auto tab = db->GetTable(par_scan->table_name_);
+    if (tab == nullptr) {
+      WSDB_THROW(WSDB_TABLE_MISS, par_scan->table_name_);
+    }
+    auto proj_schema =
+        par_scan->proj_fields_.empty() ? nullptr : std::make_unique<RecordSchema>(par_scan->proj_fields_);
+    auto out_schema = par_scan->out_fields_.empty() ? nullptr : std::make_unique<RecordSchema>(par_scan->out_fields_);
+    return std::make_unique<ParallelScanExecutor>(tab,
+        std::move(proj_schema),
+        par_scan->skip_conds_,
+        par_scan->conds_,
+        std::move(out_schema),
+        par_scan->worker_num_,
+        par_scan->runtime_filter_);
   } else if (const auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
+    auto proj_schema =
+        idx_scan->proj_fields_.empty() ? nullptr : std::make_unique<RecordSchema>(idx_scan->proj_fields_);
     return std::make_unique<IdxScanExecutor>(db->GetTable(idx_scan->table_name_),
         db->GetIndex(idx_scan->idx_id_),
         idx_scan->conds_,
-        idx_scan->matched_fields_);
+        idx_scan->matched_fields_,
+        std::move(proj_schema));
   } else if (const auto sort_plan = std::dynamic_pointer_cast<SortPlan>(plan)) {
+    if (sort_plan->is_parallel_) {
+      return std::make_unique<ParallelSortExecutor>(
+          Translate(sort_plan->child_, db), CopySchema(sort_plan->key_schema_), sort_plan->is_desc_);
+    }
     return std::make_unique<SortExecutor>(
-        Translate(sort_plan->child_, db), std::move(sort_plan->key_schema_), sort_plan->is_desc_);
+        TranslateInput(sort_plan->child_, db), CopySchema(sort_plan->key_schema_), sort_plan->is_desc_);
+  } else if (const auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    auto child = Translate(top_n->child_, db);
+    // the kept records should fit in the sort buffer, otherwise sort with tmp files and cut the result
+    if (top_n->limit_ > SORT_BUFFER_SIZE / child->GetOutSchema()->GetRecordLength()) {
+      auto sort = std::make_unique<SortExecutor>(std::move(child), CopySchema(top_n->key_schema_), top_n->is_desc_);
+      return std::make_unique<LimitExecutor>(std::move(sort), static_cast<int>(top_n->limit_));
+    }
+    return std::make_unique<TopNExecutor>(
+        std::move(child), CopySchema(top_n->key_schema_), top_n->is_desc_, top_n->limit_);
   } else if (const auto proj_plan = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
-    return std::make_unique<ProjectionExecutor>(Translate(proj_plan->child_, db), std::move(proj_plan->schema_));
+    return std::make_unique<ProjectionExecutor>(Translate(proj_plan->child_, db), CopySchema(proj_plan->schema_));
+  } else if (const auto fetch = std::dynamic_pointer_cast<FetchPlan>(plan)) {
+    std::vector<TableHandle *> tables;
+    for (const auto &table_name : fetch->table_names_) {
+      auto tab = db->GetTable(table_name);
+      if (tab == nullptr) {
+        WSDB_THROW(WSDB_TABLE_MISS, table_name);
+      }
+      tables.push_back(tab);
+    }
+    return std::make_unique<FetchExecutor>(Translate(fetch->child_, db), std::move(tables), CopySchema(fetch->schema_));
   } else if (const auto join_plan = std::dynamic_pointer_cast<JoinPlan>(plan)) {
-    if (join_plan->strategy_ == NESTED_LOOP) {
+    // a join left to the optimizer but not optimized runs as nested loop, which accepts any conditions
+    if (join_plan->strategy_ == NESTED_LOOP || join_plan->strategy_ == AUTO) {
       return std::make_unique<NestedLoopJoinExecutor>(
           join_plan->type_, Translate(join_plan->left_, db), Translate(join_plan->right_, db), join_plan->conds_);
     } else if (join_plan->strategy_ == SORT_MERGE) {
       return std::make_unique<SortMergeJoinExecutor>(join_plan->type_,
           Translate(join_plan->left_, db),
           Translate(join_plan->right_, db),
-          std::move(join_plan->left_key_schema_),
-          std::move(join_plan->right_key_schema_));
+          CopySchema(join_plan->left_key_schema_),
+          CopySchema(join_plan->right_key_schema_));
+    } else if (join_plan->strategy_ == HASH) {
+      return std::make_unique<HashJoinExecutor>(join_plan->type_,
+          Translate(join_plan->left_, db),
+          TranslateInput(join_plan->right_, db),
+          CopySchema(join_plan->left_key_schema_),
+          CopySchema(join_plan->right_key_schema_),
+          join_plan->runtime_filter_);
+    } else if (join_plan->strategy_ == INDEX_NESTED_LOOP) {
+      auto scan = std::dynamic_pointer_cast<ScanPlan>(join_plan->right_);
+      WSDB_ASSERT(scan != nullptr, "inner of index nested loop join should be a table scan");
+      return std::make_unique<IndexNestedLoopJoinExecutor>(join_plan->type_,
+          Translate(join_plan->left_, db),
+          Translate(join_plan->right_, db),
+          db->GetTable(scan->table_name_),
+          db->GetIndex(join_plan->idx_id_),
+          CopySchema(join_plan->left_key_schema_),
+          CopySchema(join_plan->right_key_schema_));
     }
+  } else if (const auto semi = std::dynamic_pointer_cast<SemiJoinPlan>(plan)) {
+    return std::make_unique<SemiJoinExecutor>(
+        Translate(semi->left_, db), Translate(semi->right_, db), semi->left_key_, semi->is_anti_);
+  } else if (const auto values = std::dynamic_pointer_cast<ValuesPlan>(plan)) {
+    return std::make_unique<ValuesExecutor>(std::make_unique<RecordSchema>(values->fields_), values->rows_);
   } else if (const auto agg_plan = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
     auto agg_schema   = std::make_unique<RecordSchema>(agg_plan->agg_fields);
     auto group_schema = std::make_unique<RecordSchema>(agg_plan->group_fields_);
-    return std::make_unique<AggregateExecutor>(
+    if (agg_plan->is_stream_) {
+      return std::make_unique<StreamAggregateExecutor>(
+          TranslateInput(agg_plan->child_, db), std::move(agg_schema), std::move(group_schema));
+    }
+    if (agg_plan->is_parallel_) {
+      return std::make_unique<ParallelAggregateExecutor>(
+          Translate(agg_plan->child_, db), std::move(agg_schema), std::move(group_schema));
+    }
+    return std::make_unique<AggregateExecutorVec>(
         Translate(agg_plan->child_, db), std::move(agg_schema), std::move(group_schema));
   } else if (const auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
     return std::make_unique<LimitExecutor>(Translate(lim->child_, db), lim->limit_);
@@ -108,6 +190,26 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
   }
   return nullptr;
 }
+
+auto Executor::TranslateInput(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> AbstractExecutorUptr
+{
+  if (PUSH_PIPELINE_EXECUTION) {
+    auto rows = std::make_unique<RowBuffer>();
+    if (auto pipeline = Pipeline::CompileToBuffer(plan, db, rows.get())) {
+      return std::make_unique<PipelineExecutor>(std::move(pipeline), std::move(rows));
+    }
+  }
+  return Translate(plan, db);
+}
+
+auto Executor::Compile(const std::shared_ptr<AbstractPlan> &plan, Context *ctx) -> PipelineUptr
+{
+  if (!PUSH_PIPELINE_EXECUTION) {
+    return nullptr;
+  }
+  return Pipeline::CompileToClient(plan, ctx);
+}
+
 void Executor::Execute(const AbstractExecutorUptr &executor, Context *ctx)
 {
   if (executor->GetType() == TXN) {
@@ -143,4 +245,24 @@ void Executor::Execute(const AbstractExecutorUptr &executor, Context *ctx)
   }
 }
 
+void Executor::Execute(const PipelineUptr &pipeline, Context *ctx)
+{
+  ctx->nt_ctl_->SendRecHeader(ctx->client_fd_, pipeline->GetOutSchema());
+  pipeline->Run();
+  ctx->nt_ctl_->SendRecFinish(ctx->client_fd_);
+}
+
+auto Executor::Analyze(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> size_t
+{
+  auto executor = Translate(plan, db);
+  if (executor->GetType() != Basic) {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, "EXPLAIN ANALYZE of a statement that is not a query");
+  }
+  size_t rec_num = 0;
+  for (executor->Init(); !executor->IsEnd(); executor->Next()) {
+    rec_num++;
+  }
+  return rec_num;
+}
+
 }  // namespace wsdb
\ No newline at end of file
@@ -24,6 +24,7 @@
 
 #include "plan/plan.h"
 #include "executor_abstract.h"
+#include "pipeline.h"
 #include "system/context.h"
 
 namespace wsdb {
@@ -35,6 +36,26 @@ public:
   static auto Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> AbstractExecutorUptr;
 
   static void Execute(const AbstractExecutorUptr &executor, Context *ctx);
+
+  /**
+   * Compile the plan of a query into a push-based pipeline that sends its rows to the client, see pipeline.h
+   * @return nullptr if push-based execution is disabled or the plan is not a pipeline, e.g. DDL and DML, run it with
+   * Translate and Execute then
+   */
+  static auto Compile(const std::shared_ptr<AbstractPlan> &plan, Context *ctx) -> PipelineUptr;
+
+  static void Execute(const PipelineUptr &pipeline, Context *ctx);
+
+  /**
+   * Run the query of the plan to the end without sending its records, e.g. for EXPLAIN ANALYZE. The plan is left as
+   * it was, with the statistics filled at execution, e.g. those of runtime filters, so it can be shown afterwards
+   * @return the number of records of the query
+   */
+  static auto Analyze(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> size_t;
+
+private:
+  /// translate the input of a pipeline breaker, as a pipeline if it is one, which returns records or chunks
+  static auto TranslateInput(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> AbstractExecutorUptr;
 };
 }  // namespace wsdb
 
@@ -24,6 +24,7 @@
 
 #include "../../common/error.h"
 #include "../../common/micro.h"
+#include "common/config.h"
 #include "system/handle/record_handle.h"
 
 namespace wsdb {
@@ -71,6 +72,29 @@ public:
     return std::make_unique<Record>(*record_);
   };
 
+  /// the current record without copying it, valid until the next call of Next
+  [[nodiscard]] auto PeekRecord() const -> const Record * { return record_.get(); }
+
+  /**
+   * Batch interface, returns the next chunk of at most CHUNK_SIZE selected rows or nullptr when exhausted. The
+   * default adapts the row interface, executors that can do better override it. Call Init first. The first chunk
+   * starts from the current record of the row interface, i.e. the record positioned by Init or the last Next is
+   * returned and the records passed by Next are not. Once NextBatch is called, keep calling it until nullptr, the row
+   * interface is not valid any more
+   */
+  virtual auto NextBatch() -> ChunkUptr
+  {
+    if (IsEnd()) {
+      return nullptr;
+    }
+    auto chunk = std::make_unique<Chunk>(GetOutSchema(), CHUNK_SIZE);
+    while (!IsEnd() && !chunk->IsFull()) {
+      chunk->AppendRecord(*record_);
+      Next();
+    }
+    return chunk;
+  }
+
 protected:
   RecordSchemaUptr out_schema_;
   RecordUptr       record_;
@@ -0,0 +1,226 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_aggregate_parallel.h"
+#include <bit>
+#include <limits>
+
+namespace wsdb {
+
+static_assert(std::has_single_bit(PARALLEL_AGG_PARTITION_NUM), "partition number should be a power of 2");
+
+ParallelAggregateExecutor::ParallelAggregateExecutor(
+    AbstractExecutorUptr child, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema, size_t buffer_size)
+    : AggregateExecutorVec(std::move(child), std::move(agg_schema), std::move(group_schema), buffer_size),
+      group_num_(0),
+      overflow_(false)
+{
+  max_running_ = 2 * group_.GetScheduler()->GetWorkerNum();
+  // the child is not read while idle_cv_ waits for a chunk to be done, wake it up when the client is gone
+  group_.SetCancelHandler([this]() {
+    std::lock_guard lock(latch_);
+    idle_cv_.notify_all();
+  });
+}
+
+void ParallelAggregateExecutor::Init()
+{
+  if (!AggregateInParallel()) {
+    // partial states cannot be spilled, so the child is aggregated again by the serial aggregation
+    AggregateExecutorVec::Init();
+  }
+}
+
+auto ParallelAggregateExecutor::AggregateInParallel() -> bool
+{
+  // a failed or cancelled run leaves the group cancelled
+  group_.Reset();
+  ClearSpill();
+  results_.clear();
+  chunk_idx_ = 0;
+  cursor_    = 0;
+  record_    = nullptr;
+  tables_.clear();
+  free_tables_.clear();
+  running_   = 0;
+  group_num_ = 0;
+  overflow_  = false;
+
+  child_->Init();
+  while (!overflow_ && !group_.IsCancelled()) {
+    auto chunk = child_->NextBatch();
+    if (chunk == nullptr) {
+      break;
+    }
+    {
+      // the child is not read into memory faster than it is aggregated
+      std::unique_lock lock(latch_);
+      idle_cv_.wait(lock, [this]() { return running_ < max_running_ || group_.IsCancelled(); });
+      if (group_.IsCancelled()) {
+        break;
+      }
+      running_++;
+    }
+    auto running = std::make_shared<RunningChunk>(this);
+    group_.Run([this, chunk = std::shared_ptr<Chunk>(std::move(chunk)), running = std::move(running)]() {
+      auto *table = AcquireTable();
+      try {
+        PreAggregate(*table, *chunk);
+      } catch (...) {
+        ReleaseTable(table);
+        throw;
+      }
+      ReleaseTable(table);
+    });
+  }
+  group_.Wait();
+  // groups are only cancelled without an error when the client is gone
+  if (group_.IsCancelled()) {
+    WSDB_THROW(WSDB_CLIENT_DOWN, "");
+  }
+  if (overflow_) {
+    tables_.clear();
+    free_tables_.clear();
+    return false;
+  }
+  // aggregation without group by always returns a row, e.g. count(*) of an empty table is 0
+  if (group_num_ == 0 && group_cols_.empty()) {
+    auto             *table = AcquireTable();
+    std::vector<char> key(key_len_, 0);
+    table->FindOrAdd(key.data(), Hash(key.data()), std::numeric_limits<size_t>::max());
+  }
+
+  radix_.assign(tables_.size(), {});
+  for (size_t t = 0; t < tables_.size(); ++t) {
+    group_.Run([this, t]() {
+      auto &parts = radix_[t];
+      parts.resize(PARALLEL_AGG_PARTITION_NUM);
+      const auto &hashes = tables_[t]->hashes_;
+      for (uint32_t gid = 0; gid < hashes.size(); ++gid) {
+        parts[RadixOf(hashes[gid])].push_back(gid);
+      }
+    });
+  }
+  group_.Wait();
+  part_results_.clear();
+  part_results_.resize(PARALLEL_AGG_PARTITION_NUM);
+  for (size_t part = 0; part < PARALLEL_AGG_PARTITION_NUM; ++part) {
+    group_.Run([this, part]() { MergePartition(part); });
+  }
+  group_.Wait();
+  tables_.clear();
+  free_tables_.clear();
+  radix_.clear();
+
+  for (auto &chunks : part_results_) {
+    for (auto &chunk : chunks) {
+      results_.push_back(std::move(chunk));
+    }
+  }
+  part_results_.clear();
+  if (LoadResults()) {
+    record_ = results_[chunk_idx_]->GetRecord(cursor_);
+  }
+  return true;
+}
+
+void ParallelAggregateExecutor::PreAggregate(GroupTable &table, const Chunk &chunk)
+{
+  constexpr auto        max_num = std::numeric_limits<size_t>::max();
+  auto                  before  = table.hashes_.size();
+  std::vector<char>     key(key_len_, 0);
+  std::vector<uint32_t> gids(chunk.GetSize());
+  if (group_cols_.empty()) {
+    std::fill(gids.begin(), gids.end(), table.FindOrAdd(key.data(), Hash(key.data()), max_num));
+  } else {
+    for (size_t i = 0; i < chunk.GetSize(); ++i) {
+      MakeKey(chunk, chunk.RowAt(i), key.data());
+      gids[i] = table.FindOrAdd(key.data(), Hash(key.data()), max_num);
+    }
+  }
+  for (size_t i = 0; i < aggs_.size(); ++i) {
+    UpdateAgg(i, chunk, gids, table.states_.data());
+  }
+  // a group may be in every table and merging takes another copy of it, so the tables take half of the buffer
+  if ((group_num_ += table.hashes_.size() - before) > max_group_num_ / 2) {
+    overflow_ = true;
+  }
+}
+
+void ParallelAggregateExecutor::MergePartition(size_t part)
+{
+  GroupTable merged;
+  merged.key_len_    = key_len_;
+  merged.state_size_ = state_size_;
+  merged.Reset();
+  for (size_t t = 0; t < tables_.size(); ++t) {
+    const auto &table = *tables_[t];
+    for (auto gid : radix_[t][part]) {
+      auto to = merged.FindOrAdd(
+          table.keys_.data() + gid * key_len_, table.hashes_[gid], std::numeric_limits<size_t>::max());
+      CombineState(merged.states_.data() + to * state_size_, table.states_.data() + gid * state_size_);
+    }
+  }
+  AppendResults(merged, part_results_[part]);
+}
+
+void ParallelAggregateExecutor::CombineState(char *dst, const char *src) const
+{
+  for (const auto &agg : aggs_) {
+    auto       *to   = reinterpret_cast<AggState *>(dst + agg.state_offset_);
+    const auto *from = reinterpret_cast<const AggState *>(src + agg.state_offset_);
+    CombineAggState(agg, to, from);
+  }
+}
+
+auto ParallelAggregateExecutor::AcquireTable() -> GroupTable *
+{
+  std::lock_guard lock(latch_);
+  if (free_tables_.empty()) {
+    auto table         = std::make_unique<GroupTable>();
+    table->key_len_    = key_len_;
+    table->state_size_ = state_size_;
+    table->Reset();
+    free_tables_.push_back(table.get());
+    tables_.push_back(std::move(table));
+  }
+  auto *table = free_tables_.back();
+  free_tables_.pop_back();
+  return table;
+}
+
+void ParallelAggregateExecutor::ReleaseTable(GroupTable *table)
+{
+  std::lock_guard lock(latch_);
+  free_tables_.push_back(table);
+}
+
+ParallelAggregateExecutor::RunningChunk::~RunningChunk()
+{
+  std::lock_guard lock(exec_->latch_);
+  exec_->running_--;
+  exec_->idle_cv_.notify_one();
+}
+
+auto ParallelAggregateExecutor::RadixOf(size_t hash) -> size_t
+{
+  // the hash tables take the low bits, so partitions take the high bits
+  constexpr size_t bits = std::countr_zero(PARALLEL_AGG_PARTITION_NUM);
+  return hash >> (sizeof(size_t) * 8 - bits);
+}
+
+}  // namespace wsdb
@@ -0,0 +1,105 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Hash aggregation with the child consumed by several tasks of the Scheduler
+ *
+ * Chunks of the child are handed out to tasks, each task aggregates its chunk into a table taken from a pool, so a
+ * table is only used by one task at a time and no locking is needed on groups. A group may thus have partial states
+ * in several tables. The groups of each table are then split into PARALLEL_AGG_PARTITION_NUM partitions by the top
+ * bits of their hash, and the partitions are merged in parallel by combining the partial states, e.g. counts and sums
+ * are added, so AVG is still computed from the merged sum and count.
+ *
+ * Partial states are not spilled. If the groups exceed the buffer, the parallel aggregation is dropped and the child
+ * is aggregated again by AggregateExecutorVec, which spills rows of the child to tmp files.
+ */
+
+#ifndef WSDB_EXECUTOR_AGGREGATE_PARALLEL_H
+#define WSDB_EXECUTOR_AGGREGATE_PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>  // NOLINT
+
+#include "executor_aggregate_vec.h"
+#include "system/scheduler.h"
+
+namespace wsdb {
+
+class ParallelAggregateExecutor : public AggregateExecutorVec
+{
+public:
+  ParallelAggregateExecutor(AbstractExecutorUptr child, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema,
+      size_t buffer_size = AGG_BUFFER_SIZE);
+
+  void Init() override;
+
+private:
+  /// aggregate the child into results_, false if the groups do not fit in the buffer
+  auto AggregateInParallel() -> bool;
+
+  /// aggregate the selected rows of the chunk into the table
+  void PreAggregate(GroupTable &table, const Chunk &chunk);
+
+  /// merge the groups of a partition from all tables and write them into part_results_
+  void MergePartition(size_t part);
+
+  /// combine the partial states of a group into dst
+  void CombineState(char *dst, const char *src) const;
+
+  auto AcquireTable() -> GroupTable *;
+
+  void ReleaseTable(GroupTable *table);
+
+  /// held by the task of a chunk, the chunk stops counting as running when the task is gone, whether it ran or was
+  /// skipped by a cancelled group
+  class RunningChunk
+  {
+  public:
+    explicit RunningChunk(ParallelAggregateExecutor *exec) : exec_(exec) {}
+
+    ~RunningChunk();
+
+    DISABLE_COPY_MOVE_AND_ASSIGN(RunningChunk)
+
+  private:
+    ParallelAggregateExecutor *exec_;
+  };
+
+  static auto RadixOf(size_t hash) -> size_t;
+
+private:
+  size_t                  max_running_;  // chunks being aggregated at a time
+  std::mutex              latch_;
+  std::condition_variable idle_cv_;  // notified when a chunk is done
+  size_t                  running_{0};
+
+  std::vector<std::unique_ptr<GroupTable>> tables_;
+  std::vector<GroupTable *>                free_tables_;  // tables not used by any task
+  std::atomic<size_t>                      group_num_;    // groups in all tables
+  std::atomic<bool>                        overflow_;
+
+  // merging, radix_[t][p] are the groups of table t in partition p
+  std::vector<std::vector<std::vector<uint32_t>>> radix_;
+  std::vector<std::vector<ChunkUptr>>             part_results_;
+
+  TaskGroup group_;  // destroyed first, so the tasks are done before the tables are gone
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_AGGREGATE_PARALLEL_H
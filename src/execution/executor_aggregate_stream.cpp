@@ -0,0 +1,123 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_aggregate_stream.h"
+
+namespace wsdb {
+
+StreamAggregateExecutor::StreamAggregateExecutor(
+    AbstractExecutorUptr child, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema)
+    : AbstractExecutor(Basic),
+      child_(std::move(child)),
+      agg_schema_(std::move(agg_schema)),
+      group_schema_(std::move(group_schema)),
+      first_(true)
+{
+  out_schema_ = MakeAggOutSchema(*group_schema_, *agg_schema_);
+  group_cols_ = ResolveGroupCols(*child_->GetOutSchema(), *group_schema_);
+  aggs_       = ResolveAggFields(*child_->GetOutSchema(), *agg_schema_, state_size_);
+  states_.resize(state_size_);
+  auto key_len = group_schema_->GetRecordLength() + BITMAP_SIZE(group_schema_->GetFieldCount());
+  group_key_.resize(key_len);
+  next_key_.resize(key_len);
+}
+
+void StreamAggregateExecutor::Init()
+{
+  child_->Init();
+  first_ = true;
+  Next();
+}
+
+void StreamAggregateExecutor::Next()
+{
+  record_ = nullptr;
+  if (child_->IsEnd()) {
+    // aggregation without group by always returns a row, e.g. count(*) of an empty table is 0
+    if (first_ && group_cols_.empty()) {
+      std::fill(states_.begin(), states_.end(), 0);
+      record_ = MakeRecord();
+    }
+    first_ = false;
+    return;
+  }
+  first_ = false;
+  std::fill(states_.begin(), states_.end(), 0);
+  MakeKey(*child_->GetRecord(), group_key_.data());
+  for (; !child_->IsEnd(); child_->Next()) {
+    auto record = child_->GetRecord();
+    MakeKey(*record, next_key_.data());
+    if (next_key_ != group_key_) {
+      break;
+    }
+    Accumulate(*record);
+  }
+  record_ = MakeRecord();
+}
+
+auto StreamAggregateExecutor::IsEnd() const -> bool { return record_ == nullptr; }
+
+void StreamAggregateExecutor::MakeKey(const Record &record, char *key) const
+{
+  const auto *schema      = record.GetSchema();
+  char       *key_nullmap = key + group_schema_->GetRecordLength();
+  memset(key, 0, group_key_.size());
+  for (size_t k = 0; k < group_cols_.size(); ++k) {
+    auto col = group_cols_[k];
+    if (BitMap::GetBit(record.GetNullMap(), col)) {
+      BitMap::SetBit(key_nullmap, k, true);
+      continue;
+    }
+    EncodeGroupField(group_schema_->GetFieldAt(k).field_,
+        record.GetData() + schema->GetFieldOffset(col),
+        key + group_schema_->GetFieldOffset(k));
+  }
+}
+
+void StreamAggregateExecutor::Accumulate(const Record &record)
+{
+  const auto *schema = record.GetSchema();
+  for (const auto &agg : aggs_) {
+    auto *state = reinterpret_cast<AggState *>(states_.data() + agg.state_offset_);
+    if (agg.type_ == AGG_COUNT_STAR) {
+      UpdateAggState(agg, state, nullptr);
+    } else if (!BitMap::GetBit(record.GetNullMap(), agg.col_idx_)) {
+      UpdateAggState(agg, state, record.GetData() + schema->GetFieldOffset(agg.col_idx_));
+    }
+  }
+}
+
+auto StreamAggregateExecutor::MakeRecord() const -> RecordUptr
+{
+  // the group fields lead the output, so the key is also the group part of the record
+  std::vector<char> nullmap(BITMAP_SIZE(out_schema_->GetFieldCount()), 0);
+  std::vector<char> data(out_schema_->GetRecordLength(), 0);
+  auto              group_num = group_cols_.size();
+  memcpy(data.data(), group_key_.data(), group_schema_->GetRecordLength());
+  for (size_t k = 0; k < group_num; ++k) {
+    BitMap::SetBit(nullmap.data(), k, BitMap::GetBit(group_key_.data() + group_schema_->GetRecordLength(), k));
+  }
+  for (size_t i = 0; i < aggs_.size(); ++i) {
+    const auto *state = reinterpret_cast<const AggState *>(states_.data() + aggs_[i].state_offset_);
+    if (!WriteAggResult(aggs_[i], state, data.data() + out_schema_->GetFieldOffset(group_num + i))) {
+      BitMap::SetBit(nullmap.data(), group_num + i, true);
+    }
+  }
+  return std::make_unique<Record>(out_schema_.get(), nullmap.data(), data.data(), INVALID_RID);
+}
+
+}  // namespace wsdb
@@ -0,0 +1,69 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Aggregation of an input whose records of a group are adjacent, e.g. sorted on the group fields
+ *
+ * A group is returned as soon as a record of the next group is read, so only the state of the current group is kept
+ * in memory. Group keys and states are those of aggregate_state.h, and the key of a group is the group part of its
+ * output record
+ */
+
+#ifndef WSDB_EXECUTOR_AGGREGATE_STREAM_H
+#define WSDB_EXECUTOR_AGGREGATE_STREAM_H
+
+#include "aggregate_state.h"
+#include "executor_abstract.h"
+
+namespace wsdb {
+
+class StreamAggregateExecutor : public AbstractExecutor
+{
+public:
+  StreamAggregateExecutor(AbstractExecutorUptr child, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  /// build the group key of a record, the group fields in record layout followed by their null map
+  void MakeKey(const Record &record, char *key) const;
+
+  void Accumulate(const Record &record);
+
+  /// the output record of the current group
+  [[nodiscard]] auto MakeRecord() const -> RecordUptr;
+
+private:
+  AbstractExecutorUptr  child_;
+  RecordSchemaUptr      agg_schema_;
+  RecordSchemaUptr      group_schema_;
+  std::vector<size_t>   group_cols_;
+  std::vector<AggField> aggs_;
+  size_t                state_size_;
+  std::vector<char>     states_;     // state slot of the current group
+  std::vector<char>     group_key_;  // key of the current group
+  std::vector<char>     next_key_;   // key of the record being read
+  bool                  first_;      // no group has been returned since Init
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_AGGREGATE_STREAM_H
@@ -20,5 +20,393 @@
 //
 
 #include "executor_aggregate_vec.h"
+#include <atomic>
+#include <bit>
+#include <filesystem>
+#include <string_view>
 
-namespace wsdb {}  // namespace wsdb
\ No newline at end of file
+// aggregations of different clients may spill at the same time, each one needs its own partition files
+static std::atomic<long long> agg_fresh_id_{0};
+#define AGG_FILE_PATH(obj_name) FILE_NAME(TMP_DIR, obj_name, TMP_SUFFIX)
+
+namespace wsdb {
+
+static_assert(std::has_single_bit(AGG_PARTITION_NUM), "partition number should be a power of 2");
+
+AggregateExecutorVec::AggregateExecutorVec(
+    AbstractExecutorUptr child, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema, size_t buffer_size)
+    : AbstractExecutor(Basic),
+      child_(std::move(child)),
+      agg_schema_(std::move(agg_schema)),
+      group_schema_(std::move(group_schema)),
+      spill_prefix_(fmt::format("agg_{}", agg_fresh_id_.fetch_add(1))),
+      chunk_idx_(0),
+      cursor_(0)
+{
+  const auto *child_schema = child_->GetOutSchema();
+  out_schema_              = MakeAggOutSchema(*group_schema_, *agg_schema_);
+  group_cols_              = ResolveGroupCols(*child_schema, *group_schema_);
+  aggs_                    = ResolveAggFields(*child_schema, *agg_schema_, state_size_);
+  key_len_                 = group_schema_->GetRecordLength() + BITMAP_SIZE(group_schema_->GetFieldCount());
+  // a group takes its key, hash, state, hash table slots and result row in memory
+  size_t group_size = key_len_ + sizeof(size_t) + state_size_ + 2 * sizeof(uint32_t) + out_schema_->GetRecordLength();
+  max_group_num_    = std::max<size_t>(buffer_size / group_size, 1);
+  groups_.key_len_    = key_len_;
+  groups_.state_size_ = state_size_;
+  spill_buf_.resize(BITMAP_SIZE(child_schema->GetFieldCount()) + child_schema->GetRecordLength());
+}
+
+AggregateExecutorVec::~AggregateExecutorVec() { ClearSpill(); }
+
+void AggregateExecutorVec::Init()
+{
+  ClearSpill();
+  groups_.Reset();
+  results_.clear();
+  chunk_idx_ = 0;
+  cursor_    = 0;
+  record_    = nullptr;
+
+  child_->Init();
+  while (auto chunk = child_->NextBatch()) {
+    Consume(*chunk);
+  }
+  // aggregation without group by always returns a row, e.g. count(*) of an empty table is 0
+  if (groups_.hashes_.empty() && group_cols_.empty()) {
+    std::vector<char> key(key_len_, 0);
+    groups_.FindOrAdd(key.data(), Hash(key.data()), max_group_num_);
+  }
+  FinishPass();
+  BuildResults();
+  if (LoadResults()) {
+    record_ = results_[chunk_idx_]->GetRecord(cursor_);
+  }
+}
+
+void AggregateExecutorVec::Next()
+{
+  if (IsEnd()) {
+    return;
+  }
+  if (++cursor_ >= results_[chunk_idx_]->GetSize()) {
+    ++chunk_idx_;
+    cursor_ = 0;
+  }
+  record_ = LoadResults() ? results_[chunk_idx_]->GetRecord(cursor_) : nullptr;
+}
+
+auto AggregateExecutorVec::IsEnd() const -> bool { return record_ == nullptr; }
+
+auto AggregateExecutorVec::NextBatch() -> ChunkUptr
+{
+  if (!LoadResults()) {
+    return nullptr;
+  }
+  auto chunk = std::move(results_[chunk_idx_++]);
+  // skip the rows already returned by the row interface
+  if (cursor_ > 0) {
+    Chunk::SelVector sel;
+    for (auto row = cursor_; row < chunk->GetRowNum(); ++row) {
+      sel.push_back(static_cast<uint32_t>(row));
+    }
+    chunk->SetSelection(std::move(sel));
+  }
+  cursor_ = 0;
+  record_ = nullptr;
+  return chunk;
+}
+
+void AggregateExecutorVec::Consume(Chunk &chunk)
+{
+  std::vector<uint32_t> gids;
+  ComputeGroupIds(chunk, gids);
+  for (size_t i = 0; i < aggs_.size(); ++i) {
+    UpdateAgg(i, chunk, gids, groups_.states_.data());
+  }
+}
+
+void AggregateExecutorVec::ComputeGroupIds(Chunk &chunk, std::vector<uint32_t> &gids)
+{
+  gids.clear();
+  std::vector<char> key(key_len_, 0);
+  if (group_cols_.empty()) {
+    gids.resize(chunk.GetSize(), groups_.FindOrAdd(key.data(), Hash(key.data()), max_group_num_));
+    return;
+  }
+  bool             spilled = false;
+  Chunk::SelVector sel;
+  for (size_t i = 0; i < chunk.GetSize(); ++i) {
+    auto row = chunk.RowAt(i);
+    MakeKey(chunk, row, key.data());
+    auto hash = Hash(key.data());
+    auto gid  = groups_.FindOrAdd(key.data(), hash, max_group_num_);
+    if (gid == NIL) {
+      SpillRow(chunk, row, hash);
+      if (!spilled) {
+        // rows before the first spilled one are all kept
+        spilled = true;
+        for (size_t j = 0; j < i; ++j) {
+          sel.push_back(static_cast<uint32_t>(chunk.RowAt(j)));
+        }
+      }
+      continue;
+    }
+    gids.push_back(gid);
+    if (spilled) {
+      sel.push_back(static_cast<uint32_t>(row));
+    }
+  }
+  if (spilled) {
+    chunk.SetSelection(std::move(sel));
+  }
+}
+
+void AggregateExecutorVec::MakeKey(const Chunk &chunk, size_t row, char *key) const
+{
+  char *key_nullmap = key + group_schema_->GetRecordLength();
+  memset(key, 0, key_len_);
+  for (size_t k = 0; k < group_cols_.size(); ++k) {
+    if (BitMap::GetBit(chunk.GetColNullMap(group_cols_[k]), row)) {
+      BitMap::SetBit(key_nullmap, k, true);
+      continue;
+    }
+    const auto &field = group_schema_->GetFieldAt(k).field_;
+    EncodeGroupField(
+        field, chunk.GetColData(group_cols_[k]) + row * field.field_size_, key + group_schema_->GetFieldOffset(k));
+  }
+}
+
+void AggregateExecutorVec::UpdateAgg(
+    size_t agg_idx, const Chunk &chunk, const std::vector<uint32_t> &gids, char *states) const
+{
+  const auto &agg   = aggs_[agg_idx];
+  char       *slots = states + agg.state_offset_;
+  auto state_at     = [slots, this](uint32_t gid) { return reinterpret_cast<AggState *>(slots + gid * state_size_); };
+  if (agg.type_ == AGG_COUNT_STAR) {
+    for (auto gid : gids) {
+      state_at(gid)->count_++;
+    }
+    return;
+  }
+  const char *data    = chunk.GetColData(agg.col_idx_);
+  const char *nullmap = chunk.GetColNullMap(agg.col_idx_);
+  for (size_t i = 0; i < chunk.GetSize(); ++i) {
+    auto row = chunk.RowAt(i);
+    if (BitMap::GetBit(nullmap, row)) {
+      continue;
+    }
+    UpdateAggState(agg, state_at(gids[i]), data + row * agg.size_);
+  }
+}
+
+auto AggregateExecutorVec::GroupTable::FindOrAdd(const char *key, size_t hash, size_t max_num) -> uint32_t
+{
+  size_t mask = slots_.size() - 1;
+  size_t pos  = hash & mask;
+  for (; slots_[pos] != NIL; pos = (pos + 1) & mask) {
+    auto gid = slots_[pos];
+    if (hashes_[gid] == hash && memcmp(keys_.data() + gid * key_len_, key, key_len_) == 0) {
+      return gid;
+    }
+  }
+  if (hashes_.size() >= max_num) {
+    return NIL;
+  }
+  auto gid    = static_cast<uint32_t>(hashes_.size());
+  slots_[pos] = gid;
+  keys_.insert(keys_.end(), key, key + key_len_);
+  hashes_.push_back(hash);
+  // states start from zero counts and sums
+  states_.resize(states_.size() + state_size_, 0);
+  // keep the load factor at most 0.5
+  if (hashes_.size() * 2 > slots_.size()) {
+    Grow();
+  }
+  return gid;
+}
+
+void AggregateExecutorVec::GroupTable::Grow()
+{
+  slots_.assign(slots_.size() * 2, NIL);
+  size_t mask = slots_.size() - 1;
+  for (uint32_t gid = 0; gid < hashes_.size(); ++gid) {
+    size_t pos = hashes_[gid] & mask;
+    while (slots_[pos] != NIL) {
+      pos = (pos + 1) & mask;
+    }
+    slots_[pos] = gid;
+  }
+}
+
+void AggregateExecutorVec::GroupTable::Reset()
+{
+  keys_.clear();
+  hashes_.clear();
+  states_.clear();
+  slots_.assign(INITIAL_SLOT_NUM, NIL);
+}
+
+auto AggregateExecutorVec::Hash(const char *key) const -> size_t
+{
+  return std::hash<std::string_view>{}(std::string_view(key, key_len_));
+}
+
+auto AggregateExecutorVec::PartitionOf(size_t hash, size_t level) -> size_t
+{
+  // the hash table takes the low bits, so partitions take the high bits
+  constexpr size_t bits = std::countr_zero(AGG_PARTITION_NUM);
+  level                 = std::min(level, MAX_PARTITION_LEVEL);
+  return (hash >> (sizeof(size_t) * 8 - bits * (level + 1))) & (AGG_PARTITION_NUM - 1);
+}
+
+/// rows are spilled in record layout, i.e. null map followed by data
+void AggregateExecutorVec::SpillRow(const Chunk &chunk, size_t row, size_t hash)
+{
+  if (partitions_.empty()) {
+    partitions_.resize(AGG_PARTITION_NUM);
+    for (auto &part : partitions_) {
+      part         = std::make_unique<Partition>();
+      part->file_  = AGG_FILE_PATH(fmt::format("{}_{}", spill_prefix_, spill_file_num_++));
+      part->level_ = level_;
+      spill_files_.push_back(part->file_);
+      part->writer_.open(part->file_, std::ios::binary | std::ios::trunc);
+      if (!part->writer_.is_open()) {
+        WSDB_THROW(WSDB_FILE_NOT_OPEN, part->file_);
+      }
+    }
+  }
+  const auto *schema  = child_->GetOutSchema();
+  char       *nullmap = spill_buf_.data();
+  char       *data    = nullmap + BITMAP_SIZE(schema->GetFieldCount());
+  BitMap::Clear(nullmap, schema->GetFieldCount());
+  for (size_t col = 0; col < schema->GetFieldCount(); ++col) {
+    auto size = schema->GetFieldAt(col).field_.field_size_;
+    memcpy(data + schema->GetFieldOffset(col), chunk.GetColData(col) + row * size, size);
+    BitMap::SetBit(nullmap, col, BitMap::GetBit(chunk.GetColNullMap(col), row));
+  }
+  auto &part = partitions_[PartitionOf(hash, level_)];
+  if (!part->writer_.write(spill_buf_.data(), static_cast<std::streamsize>(spill_buf_.size()))) {
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR, part->file_);
+  }
+  part->rec_num_++;
+}
+
+auto AggregateExecutorVec::ReadChunk(std::ifstream &file) -> ChunkUptr
+{
+  const auto *schema  = child_->GetOutSchema();
+  const char *nullmap = spill_buf_.data();
+  const char *data    = nullmap + BITMAP_SIZE(schema->GetFieldCount());
+  auto        chunk   = std::make_unique<Chunk>(schema, CHUNK_SIZE);
+  size_t      row     = 0;
+  for (; row < CHUNK_SIZE && file.read(spill_buf_.data(), static_cast<std::streamsize>(spill_buf_.size())); ++row) {
+    for (size_t col = 0; col < schema->GetFieldCount(); ++col) {
+      auto size = schema->GetFieldAt(col).field_.field_size_;
+      memcpy(chunk->GetColData(col) + row * size, data + schema->GetFieldOffset(col), size);
+      BitMap::SetBit(chunk->GetColNullMap(col), row, BitMap::GetBit(nullmap, col));
+    }
+  }
+  if (row == 0) {
+    return nullptr;
+  }
+  chunk->SetRowNum(row);
+  return chunk;
+}
+
+void AggregateExecutorVec::FinishPass()
+{
+  for (auto &part : partitions_) {
+    part->writer_.close();
+    if (part->rec_num_ == 0) {
+      std::filesystem::remove(part->file_);
+      continue;
+    }
+    pending_.push_back(std::move(part));
+  }
+  partitions_.clear();
+}
+
+void AggregateExecutorVec::AggregatePartition()
+{
+  auto part = std::move(pending_.back());
+  pending_.pop_back();
+  groups_.Reset();
+  results_.clear();
+  level_ = part->level_ + 1;
+  std::ifstream file(part->file_, std::ios::binary);
+  if (!file.is_open()) {
+    WSDB_THROW(WSDB_FILE_NOT_OPEN, part->file_);
+  }
+  while (auto chunk = ReadChunk(file)) {
+    Consume(*chunk);
+  }
+  file.close();
+  std::filesystem::remove(part->file_);
+  FinishPass();
+  BuildResults();
+}
+
+auto AggregateExecutorVec::LoadResults() -> bool
+{
+  while (chunk_idx_ >= results_.size()) {
+    if (pending_.empty()) {
+      return false;
+    }
+    AggregatePartition();
+  }
+  return true;
+}
+
+void AggregateExecutorVec::BuildResults()
+{
+  results_.clear();
+  chunk_idx_ = 0;
+  cursor_    = 0;
+  AppendResults(groups_, results_);
+  // the groups are in the results now
+  groups_.Reset();
+}
+
+void AggregateExecutorVec::AppendResults(const GroupTable &table, std::vector<ChunkUptr> &results) const
+{
+  auto group_num = group_cols_.size();
+  auto total     = table.hashes_.size();
+  for (size_t start = 0; start < total; start += CHUNK_SIZE) {
+    auto chunk = std::make_unique<Chunk>(out_schema_.get(), std::min(CHUNK_SIZE, total - start));
+    for (size_t row = 0; row < chunk->GetCapacity(); ++row) {
+      const char *key = table.keys_.data() + (start + row) * key_len_;
+      for (size_t k = 0; k < group_num; ++k) {
+        auto size = group_schema_->GetFieldAt(k).field_.field_size_;
+        memcpy(chunk->GetColData(k) + row * size, key + group_schema_->GetFieldOffset(k), size);
+        if (BitMap::GetBit(key + group_schema_->GetRecordLength(), k)) {
+          BitMap::SetBit(chunk->GetColNullMap(k), row, true);
+        }
+      }
+      const char *slot = table.states_.data() + (start + row) * state_size_;
+      for (size_t i = 0; i < aggs_.size(); ++i) {
+        const auto &agg   = aggs_[i];
+        const auto *state = reinterpret_cast<const AggState *>(slot + agg.state_offset_);
+        auto        size  = out_schema_->GetFieldAt(group_num + i).field_.field_size_;
+        char       *dst   = chunk->GetColData(group_num + i) + row * size;
+        if (!WriteAggResult(agg, state, dst)) {
+          BitMap::SetBit(chunk->GetColNullMap(group_num + i), row, true);
+        }
+      }
+    }
+    chunk->SetRowNum(chunk->GetCapacity());
+    results.push_back(std::move(chunk));
+  }
+}
+
+void AggregateExecutorVec::ClearSpill()
+{
+  partitions_.clear();
+  pending_.clear();
+  for (const auto &file : spill_files_) {
+    std::error_code ec;
+    std::filesystem::remove(file, ec);
+  }
+  spill_files_.clear();
+  level_ = 0;
+}
+
+}  // namespace wsdb
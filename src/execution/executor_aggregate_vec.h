@@ -19,14 +19,145 @@
 // Created by ziqi on 2024/8/12.
 //
 
+/**
+ * @brief Vectorized hash aggregation
+ *
+ * The child is consumed chunk by chunk. For each chunk the group ids of all selected rows are computed first, then
+ * every aggregate is updated a column at a time, so the inner loops run over contiguous fixed-size fields without
+ * materializing records or values. Groups are found by an open-addressing table on the hash of the key bytes, keys
+ * and state slots are laid out as in aggregate_state.h.
+ *
+ * If the groups exceed the buffer, the groups already in memory keep being aggregated, while rows of new groups are
+ * hash-partitioned into tmp files. The partitions are aggregated one by one after the groups in memory are returned,
+ * a partition with too many groups spills again with the next bits of the hash.
+ */
+
 #ifndef WSDB_EXECUTOR_AGGREGATE_VEC_H
 #define WSDB_EXECUTOR_AGGREGATE_VEC_H
+#include <fstream>
+#include "aggregate_state.h"
 #include "executor_abstract.h"
 
 namespace wsdb {
 
 class AggregateExecutorVec : public AbstractExecutor
-{};
+{
+public:
+  AggregateExecutorVec(AbstractExecutorUptr child, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema,
+      size_t buffer_size = AGG_BUFFER_SIZE);
+
+  ~AggregateExecutorVec() override;
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  auto NextBatch() -> ChunkUptr override;
+
+protected:
+  /// rows of the child whose groups hash to the same partition
+  struct Partition
+  {
+    std::string   file_;
+    std::ofstream writer_;
+    size_t        rec_num_{0};
+    size_t        level_{0};  // number of partitioning passes that produced the partition
+  };
+
+  using PartitionUptr = std::unique_ptr<Partition>;
+
+  /// open-addressing hash table of groups, group i has its key, hash and state slot at position i
+  struct GroupTable
+  {
+    size_t                key_len_{0};
+    size_t                state_size_{0};
+    std::vector<char>     keys_;
+    std::vector<size_t>   hashes_;
+    std::vector<char>     states_;
+    std::vector<uint32_t> slots_;
+
+    /// id of the group of the key, the group is created if absent. NIL if it is absent and there are max_num groups
+    auto FindOrAdd(const char *key, size_t hash, size_t max_num) -> uint32_t;
+
+    /// double the slots
+    void Grow();
+
+    /// drop all groups
+    void Reset();
+  };
+
+  /// aggregate the selected rows of a chunk, rows of groups that do not fit are spilled and unselected
+  void Consume(Chunk &chunk);
+
+  /// compute the group id of every selected row in the chunk, new groups are created on the fly
+  void ComputeGroupIds(Chunk &chunk, std::vector<uint32_t> &gids);
+
+  /// build the group key of a physical row of the chunk
+  void MakeKey(const Chunk &chunk, size_t row, char *key) const;
+
+  /// update an aggregate by the selected rows, gids are the groups of the rows and states the slots of the groups
+  void UpdateAgg(size_t agg_idx, const Chunk &chunk, const std::vector<uint32_t> &gids, char *states) const;
+
+  [[nodiscard]] auto Hash(const char *key) const -> size_t;
+
+  [[nodiscard]] static auto PartitionOf(size_t hash, size_t level) -> size_t;
+
+  /// write the physical row of the chunk to the partition of its group in the current pass
+  void SpillRow(const Chunk &chunk, size_t row, size_t hash);
+
+  /// read the next chunk of rows of a partition file, nullptr at the end of the file
+  auto ReadChunk(std::ifstream &file) -> ChunkUptr;
+
+  /// called when the input of a pass is exhausted, queue the partitions written in the pass
+  void FinishPass();
+
+  /// aggregate the next spilled partition and build its results
+  void AggregatePartition();
+
+  /// make sure results_[chunk_idx_] exists, aggregating spilled partitions if needed. false if all are returned
+  auto LoadResults() -> bool;
+
+  /// write the groups in memory and their aggregates into results_
+  void BuildResults();
+
+  /// write the groups of the table and their aggregates into chunks of out schema
+  void AppendResults(const GroupTable &table, std::vector<ChunkUptr> &results) const;
+
+  /// remove the tmp files and reset the spilling state
+  void ClearSpill();
+
+protected:
+  static constexpr uint32_t NIL              = UINT32_MAX;
+  static constexpr size_t   INITIAL_SLOT_NUM = 1024;
+  // each pass takes log2(AGG_PARTITION_NUM) bits from the top of the hash, deeper passes reuse the last bits
+  static constexpr size_t MAX_PARTITION_LEVEL = 15;
+
+  AbstractExecutorUptr  child_;
+  RecordSchemaUptr      agg_schema_;
+  RecordSchemaUptr      group_schema_;
+  std::vector<size_t>   group_cols_;
+  std::vector<AggField> aggs_;
+  size_t                key_len_;
+  size_t                state_size_;     // bytes of the state slot of a group
+  size_t                max_group_num_;  // groups the buffer can hold
+
+  GroupTable groups_;  // groups in memory
+
+  // spilling, partitions_ are written by the current pass whose input has gone through level_ passes
+  std::string                spill_prefix_;
+  size_t                     level_{0};
+  std::vector<PartitionUptr> partitions_;
+  std::vector<PartitionUptr> pending_;
+  std::vector<std::string>   spill_files_;
+  size_t                     spill_file_num_{0};
+  std::vector<char>          spill_buf_;
+
+  std::vector<ChunkUptr> results_;
+  size_t                 chunk_idx_;
+  size_t                 cursor_;
+};
 
 }  // namespace wsdb
 
@@ -23,17 +23,30 @@
 #define WSDB_EXECUTOR_DEFS_H
 
 #include "executor_aggregate.h"
+#include "executor_aggregate_vec.h"
+#include "executor_aggregate_stream.h"
+#include "executor_aggregate_parallel.h"
 #include "executor_ddl.h"
 #include "executor_delete.h"
+#include "executor_fetch.h"
 #include "executor_filter.h"
 #include "executor_idxscan.h"
 #include "executor_insert.h"
 #include "executor_join_nestedloop.h"
 #include "executor_join_sortmerge.h"
+#include "executor_join_hash.h"
+#include "executor_join_idxnestedloop.h"
+#include "executor_join_semi.h"
 #include "executor_limit.h"
+#include "executor_pipeline.h"
+#include "executor_load.h"
 #include "executor_projection.h"
 #include "executor_seqscan.h"
+#include "executor_parallel_scan.h"
 #include "executor_sort.h"
+#include "executor_sort_parallel.h"
+#include "executor_topn.h"
 #include "executor_update.h"
+#include "executor_values.h"
 
 #endif  // WSDB_EXECUTOR_DEFS_H
@@ -0,0 +1,156 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+#include "executor_fetch.h"
+#include <algorithm>
+
+namespace wsdb {
+
+FetchExecutor::FetchExecutor(AbstractExecutorUptr child, std::vector<TableHandle *> tables, RecordSchemaUptr out_schema)
+    : AbstractExecutor(Basic), child_(std::move(child)), tables_(std::move(tables))
+{
+  out_schema_              = std::move(out_schema);
+  const auto *child_schema = child_->GetOutSchema();
+  for (const auto *tab : tables_) {
+    auto idx = child_schema->GetRTFieldIndex(MakeRidField(tab->GetTableId()));
+    if (idx == child_schema->GetFieldCount()) {
+      WSDB_THROW(WSDB_FIELD_MISS, fmt::format("{} of {}", RID_FIELD_NAME, tab->GetTableName()));
+    }
+    rid_cols_.push_back(idx);
+  }
+  // fetch_fields[t] are the indexes of the fields read from table t in the table schema
+  std::vector<std::vector<size_t>> fetch_fields(tables_.size());
+  for (const auto &field : out_schema_->GetFields()) {
+    auto idx = child_schema->GetRTFieldIndex(field);
+    if (idx != child_schema->GetFieldCount()) {
+      sources_.push_back({.table_ = tables_.size(), .idx_ = idx});
+      continue;
+    }
+    auto it = std::find_if(tables_.begin(), tables_.end(), [&field](const TableHandle *tab) {
+      return tab->GetTableId() == field.field_.table_id_;
+    });
+    if (it == tables_.end()) {
+      WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+    }
+    const auto &schema = (*it)->GetSchema();
+    idx                = schema.GetRTFieldIndex(field);
+    if (idx == schema.GetFieldCount()) {
+      WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+    }
+    auto  table   = static_cast<size_t>(it - tables_.begin());
+    auto &fetched = fetch_fields[table];
+    auto  pos     = std::find(fetched.begin(), fetched.end(), idx);
+    if (pos == fetched.end()) {
+      pos = fetched.insert(fetched.end(), idx);
+    }
+    sources_.push_back({.table_ = table, .idx_ = static_cast<size_t>(pos - fetched.begin())});
+  }
+  // only the fields deferred to this executor are read from the pages
+  for (size_t t = 0; t < tables_.size(); ++t) {
+    std::vector<RTField> fields;
+    for (auto idx : fetch_fields[t]) {
+      fields.push_back(tables_[t]->GetSchema().GetFieldAt(idx));
+    }
+    fetch_schemas_.push_back(std::make_unique<RecordSchema>(fields));
+  }
+}
+
+void FetchExecutor::LoadBatch()
+{
+  batch_.clear();
+  cursor_ = 0;
+  std::vector<RecordUptr> rows;
+  for (; !child_->IsEnd() && rows.size() < CHUNK_SIZE; child_->Next()) {
+    rows.push_back(child_->GetRecord());
+  }
+  // fetched[t][i] is the record of table t for the i-th row, nullptr if its rid is null
+  std::vector<std::vector<const Record *>> fetched(tables_.size(), std::vector<const Record *>(rows.size(), nullptr));
+  std::vector<RecordUptr>                  records;
+  const auto                              *child_schema = child_->GetOutSchema();
+  for (size_t t = 0; t < tables_.size(); ++t) {
+    if (fetch_schemas_[t]->GetFieldCount() == 0) {
+      continue;
+    }
+    auto                                rid_offset = child_schema->GetFieldOffset(rid_cols_[t]);
+    std::vector<std::pair<RID, size_t>> row_rids;
+    for (size_t i = 0; i < rows.size(); ++i) {
+      if (!BitMap::GetBit(rows[i]->GetNullMap(), rid_cols_[t])) {
+        RID rid;
+        memcpy(&rid, rows[i]->GetData() + rid_offset, sizeof(RID));
+        row_rids.emplace_back(rid, i);
+      }
+    }
+    std::sort(row_rids.begin(), row_rids.end(), [](const auto &a, const auto &b) {
+      if (a.first.PageID() != b.first.PageID()) {
+        return a.first.PageID() < b.first.PageID();
+      }
+      return a.first.SlotID() < b.first.SlotID();
+    });
+    // rows of the same record, e.g. the matches of a join, share one fetch
+    std::vector<RID> rids;
+    for (const auto &[rid, row] : row_rids) {
+      if (rids.empty() || rids.back() != rid) {
+        rids.push_back(rid);
+      }
+    }
+    auto table_records = tables_[t]->GetRecords(rids, fetch_schemas_[t].get());
+    for (size_t i = 0, r = 0; i < row_rids.size(); ++i) {
+      if (table_records[r]->GetRID() != row_rids[i].first) {
+        r++;
+      }
+      fetched[t][row_rids[i].second] = table_records[r].get();
+    }
+    std::move(table_records.begin(), table_records.end(), std::back_inserter(records));
+  }
+  std::vector<char> nullmap(BITMAP_SIZE(out_schema_->GetFieldCount()));
+  std::vector<char> data(out_schema_->GetRecordLength());
+  batch_.reserve(rows.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    std::fill(nullmap.begin(), nullmap.end(), 0);
+    std::fill(data.begin(), data.end(), 0);
+    for (size_t f = 0; f < sources_.size(); ++f) {
+      const auto   &src    = sources_[f];
+      const Record *record = src.table_ == tables_.size() ? rows[i].get() : fetched[src.table_][i];
+      if (record == nullptr || BitMap::GetBit(record->GetNullMap(), src.idx_)) {
+        BitMap::SetBit(nullmap.data(), f, true);
+        continue;
+      }
+      memcpy(data.data() + out_schema_->GetFieldOffset(f),
+          record->GetData() + record->GetSchema()->GetFieldOffset(src.idx_),
+          out_schema_->GetFieldAt(f).field_.field_size_);
+    }
+    batch_.push_back(std::make_unique<Record>(out_schema_.get(), nullmap.data(), data.data(), INVALID_RID));
+  }
+}
+
+void FetchExecutor::Init()
+{
+  child_->Init();
+  LoadBatch();
+  record_ = batch_.empty() ? nullptr : std::move(batch_[0]);
+}
+
+void FetchExecutor::Next()
+{
+  if (++cursor_ >= batch_.size()) {
+    LoadBatch();
+  }
+  record_ = cursor_ < batch_.size() ? std::move(batch_[cursor_]) : nullptr;
+}
+
+auto FetchExecutor::IsEnd() const -> bool { return record_ == nullptr; }
+
+}  // namespace wsdb
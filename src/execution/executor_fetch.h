@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+/**
+ * @brief Late materialization: complete the records of the child with fields fetched from tables by rid
+ *
+ * The child carries the rid field (see RID_FIELD_NAME) of each table in place of the projected fields that are only
+ * needed in the result. Records of the child are read in batches of CHUNK_SIZE, the rids of a batch are sorted by page
+ * so that each page is read once and pages are read in sequence, and the records are returned in the order of the
+ * child. A null rid, e.g. from the null side of an outer join, makes the fetched fields null.
+ */
+
+#ifndef WSDB_EXECUTOR_FETCH_H
+#define WSDB_EXECUTOR_FETCH_H
+
+#include "executor_abstract.h"
+#include "system/handle/table_handle.h"
+
+namespace wsdb {
+
+class FetchExecutor : public AbstractExecutor
+{
+public:
+  /**
+   * @param child
+   * @param tables tables whose fields are fetched, the child should have their rid fields
+   * @param out_schema fields of the result, each of them is either in the child or in one of the tables
+   */
+  FetchExecutor(AbstractExecutorUptr child, std::vector<TableHandle *> tables, RecordSchemaUptr out_schema);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  /// where a field of the result comes from, the child if table_ is tables_.size()
+  struct FieldSource
+  {
+    size_t table_;
+    size_t idx_;  // index in the child schema or in the fetch schema of the table
+  };
+
+  /// read the next batch of the child and make its results
+  void LoadBatch();
+
+private:
+  AbstractExecutorUptr          child_;
+  std::vector<TableHandle *>    tables_;
+  std::vector<size_t>           rid_cols_;       // index of the rid field of each table in the child schema
+  std::vector<RecordSchemaUptr> fetch_schemas_;  // fields read from each table
+  std::vector<FieldSource>      sources_;        // source of each field of the result
+  std::vector<RecordUptr>       batch_;          // results of the current batch
+  size_t                        cursor_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_FETCH_H
@@ -20,40 +20,43 @@
 //
 
 #include "executor_filter.h"
+#include "expr/condition_expr.h"
 
 namespace wsdb {
 
 FilterExecutor::FilterExecutor(AbstractExecutorUptr child, std::function<bool(const Record &)> filter)
     : AbstractExecutor(Basic), child_(std::move(child)), filter_(std::move(filter))
 {}
-void FilterExecutor::Init() { 
-    // WSDB_STUDENT_TODO(l2, t1); 
-    child_->Init();
-    record_ = nullptr;
-    while (!child_->IsEnd())
-    {
-        /* code */
-        auto child_record = child_->GetRecord();
-        if (child_record && filter_(*child_record)) {
-            record_ = child_->GetRecord();
-            return;
-        }
-        child_->Next();
-    }
+
+FilterExecutor::FilterExecutor(AbstractExecutorUptr child, ConditionVec conds)
+    : AbstractExecutor(Basic), child_(std::move(child)), conds_(std::move(conds))
+{
+  pred_ = CompiledPredicate::Compile(conds_, child_->GetOutSchema());
 }
 
-void FilterExecutor::Next() { 
-    // WSDB_STUDENT_TODO(l2, t1); 
-    child_->Next();
-    while (!child_->IsEnd()) {
-        auto child_record = child_->GetRecord();
-        if (child_record && filter_(*child_record)) {
-            record_ = child_->GetRecord();
-            return;
-        }
-        child_->Next();
+void FilterExecutor::Init()
+{
+  child_->Init();
+  SeekPass();
+}
+
+void FilterExecutor::Next()
+{
+  child_->Next();
+  SeekPass();
+}
+
+void FilterExecutor::SeekPass()
+{
+  // only the record that passes is copied out of child
+  for (; !child_->IsEnd(); child_->Next()) {
+    const auto *child_record = child_->PeekRecord();
+    if (child_record != nullptr && Pass(*child_record)) {
+      record_ = child_->GetRecord();
+      return;
     }
-    record_ = nullptr;
+  }
+  record_ = nullptr;
 }
 
 auto FilterExecutor::IsEnd() const -> bool { 
@@ -61,5 +64,28 @@ auto FilterExecutor::IsEnd() const -> bool {
     return record_ == nullptr;
 }
 
+auto FilterExecutor::NextBatch() -> ChunkUptr
+{
+  // the record found by Init is still the current record of child, so it is returned by child's batch
+  record_ = nullptr;
+  while (auto chunk = child_->NextBatch()) {
+    if (!conds_.empty()) {
+      ConditionExpr::EvalBatch(conds_, *chunk);
+    } else {
+      Chunk::SelVector sel;
+      for (size_t i = 0; i < chunk->GetSize(); ++i) {
+        if (Pass(*chunk->GetRecord(i))) {
+          sel.push_back(static_cast<uint32_t>(chunk->RowAt(i)));
+        }
+      }
+      chunk->SetSelection(std::move(sel));
+    }
+    if (chunk->GetSize() > 0) {
+      return chunk;
+    }
+  }
+  return nullptr;
+}
+
 auto FilterExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
 }  // namespace wsdb
@@ -28,6 +28,8 @@
 #define WSDB_EXECUTOR_FILTER_H
 #include <functional>
 #include "executor_abstract.h"
+#include "common/condition.h"
+#include "expr/compiled_predicate.h"
 
 namespace wsdb {
 
@@ -36,17 +38,34 @@ class FilterExecutor : public AbstractExecutor
 public:
   FilterExecutor(AbstractExecutorUptr child, std::function<bool(const Record &)> filter);
 
+  /**
+   * filter by conditions, which allows evaluating a whole chunk at once in NextBatch. Records are evaluated by the
+   * conditions compiled against the schema of child, see CompiledPredicate
+   */
+  FilterExecutor(AbstractExecutorUptr child, ConditionVec conds);
+
   void Init() override;
 
   void Next() override;
 
   [[nodiscard]] auto IsEnd() const -> bool override;
 
+  /// only narrows the selection of child chunks, empty chunks are skipped
+  auto NextBatch() -> ChunkUptr override;
+
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
 
+private:
+  [[nodiscard]] auto Pass(const Record &record) const -> bool { return filter_ ? filter_(record) : pred_.Eval(record); }
+
+  /// move child to the first record from its current one that passes, record_ is the copy of it or nullptr if none
+  void SeekPass();
+
 private:
   AbstractExecutorUptr                child_;
-  std::function<bool(const Record &)> filter_;
+  std::function<bool(const Record &)> filter_;  // nullptr if filtered by conditions
+  ConditionVec                        conds_;
+  CompiledPredicate                   pred_;
 };
 
 }  // namespace wsdb
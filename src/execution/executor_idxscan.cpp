@@ -23,9 +23,11 @@
 
 namespace wsdb {
 
-IdxScanExecutor::IdxScanExecutor(TableHandle *tbl, IndexHandle *idx, ConditionVec conds, int cmp_field_num)
+IdxScanExecutor::IdxScanExecutor(TableHandle *tbl, IndexHandle *idx, ConditionVec conds, int cmp_field_num,
+    RecordSchemaUptr proj_schema)
     : AbstractExecutor(Basic), tbl_(tbl), idx_(idx), conds_(std::move(conds)), cmp_field_num_(cmp_field_num)
 {
+  out_schema_ = std::move(proj_schema);
   // TODO: generate low key and high key using conds, conds has been rearranged to match the index key prefix
 }
 // TODO(ziqi): implement the following functions to support index scan
@@ -33,4 +35,9 @@ void IdxScanExecutor::Init() {}
 void IdxScanExecutor::Next() {}
 auto IdxScanExecutor::IsEnd() const -> bool { return false; }
 
+auto IdxScanExecutor::GetOutSchema() const -> const RecordSchema *
+{
+  return out_schema_ != nullptr ? out_schema_.get() : &tbl_->GetSchema();
+}
+
 }  // namespace wsdb
\ No newline at end of file
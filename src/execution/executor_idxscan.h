@@ -36,7 +36,15 @@ namespace wsdb {
 class IdxScanExecutor : public AbstractExecutor
 {
 public:
-  IdxScanExecutor(TableHandle *tbl, IndexHandle *idx, ConditionVec conds, int cmp_field_num);
+  /**
+   * @param tbl
+   * @param idx
+   * @param conds
+   * @param cmp_field_num
+   * @param proj_schema fields of the output records, nullptr means all fields of the table
+   */
+  IdxScanExecutor(TableHandle *tbl, IndexHandle *idx, ConditionVec conds, int cmp_field_num,
+      RecordSchemaUptr proj_schema = nullptr);
 
   void Init() override;
 
@@ -44,13 +52,16 @@ public:
 
   [[nodiscard]] auto IsEnd() const -> bool override;
 
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+
 private:
   /// Index scan should find all the records in the range [low, high),
   /// where the comparison is based on the first cmp_field_num fields.
   /// low, high should be generated using conds. Both the schema of
   /// record low and record high are the same as the index key
   /// schema. Store the record fetched from the table handle with the
-  /// indexed rid into AbstractExecutor::record_. Remove [[maybe_unused]]
+  /// indexed rid into AbstractExecutor::record_, narrowed to the out
+  /// schema if a projection is given. Remove [[maybe_unused]]
   /// when you implement this executor
   TableHandle *tbl_;            // table handle
   IndexHandle *idx_;            // index handle
@@ -0,0 +1,510 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_join_hash.h"
+#include <atomic>
+#include <bit>
+#include <filesystem>
+#include <string_view>
+
+// hash joins of different clients are built at the same time, each one needs its own spill files
+static std::atomic<long long> hash_join_fresh_id_{0};
+#define HASH_JOIN_FILE_PATH(obj_name) FILE_NAME(TMP_DIR, obj_name, TMP_SUFFIX)
+
+namespace wsdb {
+
+static_assert(std::has_single_bit(HASH_JOIN_PARTITION_NUM), "partition number should be a power of 2");
+
+/// records are spilled as null map followed by data
+static void WriteRecord(std::ofstream &file, const Record &record)
+{
+  const auto *schema = record.GetSchema();
+  file.write(record.GetNullMap(), static_cast<std::streamsize>(BITMAP_SIZE(schema->GetFieldCount())));
+  file.write(record.GetData(), static_cast<std::streamsize>(schema->GetRecordLength()));
+}
+
+static auto ReadRecord(std::ifstream &file, const RecordSchema *schema, std::vector<char> &buf) -> RecordUptr
+{
+  size_t nullmap_size = BITMAP_SIZE(schema->GetFieldCount());
+  buf.resize(nullmap_size + schema->GetRecordLength());
+  if (!file.read(buf.data(), static_cast<std::streamsize>(buf.size()))) {
+    return nullptr;
+  }
+  return std::make_unique<Record>(schema, buf.data(), buf.data() + nullmap_size, INVALID_RID);
+}
+
+HashJoinExecutor::HashJoinExecutor(JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right,
+    RecordSchemaUptr left_key_schema, RecordSchemaUptr right_key_schema, RuntimeFilterSptr runtime_filter,
+    size_t buffer_size)
+    // like sort merge join, the conditions have been converted to key schemas
+    : JoinExecutor(join_type, std::move(left), std::move(right), {}),
+      left_key_schema_(std::move(left_key_schema)),
+      right_key_schema_(std::move(right_key_schema)),
+      left_encoder_(left_->GetOutSchema(), left_key_schema_.get()),
+      right_encoder_(right_->GetOutSchema(), right_key_schema_.get()),
+      runtime_filter_(std::move(runtime_filter)),
+      spill_prefix_(fmt::format("hash_join_{}", hash_join_fresh_id_.fetch_add(1)))
+{
+  SortKeyEncoder::Align(left_encoder_, right_encoder_);
+  key_len_ = left_encoder_.GetKeySize();
+  probe_key_.resize(key_len_);
+  // a build record takes its record, key and hash table entries in memory
+  const auto *right_schema = right_->GetOutSchema();
+  size_t      rec_size     = right_schema->GetRecordLength() + BITMAP_SIZE(right_schema->GetFieldCount());
+  size_t entry_size = sizeof(Record) + rec_size + key_len_ + sizeof(RecordUptr) + sizeof(size_t) + 3 * sizeof(uint32_t);
+  max_build_rec_num_ = std::max<size_t>(buffer_size / entry_size, 1);
+}
+
+HashJoinExecutor::~HashJoinExecutor() { ClearSpill(); }
+
+auto HashJoinExecutor::Hash(const char *key) const -> size_t
+{
+  return std::hash<std::string_view>{}(std::string_view(key, key_len_));
+}
+
+auto HashJoinExecutor::PartitionOf(size_t hash, size_t level) -> size_t
+{
+  // the hash table takes the low bits, so partitions take the high bits
+  constexpr size_t bits = std::countr_zero(HASH_JOIN_PARTITION_NUM);
+  return (hash >> (sizeof(size_t) * 8 - bits * (level + 1))) & (HASH_JOIN_PARTITION_NUM - 1);
+}
+
+void HashJoinExecutor::AppendBuild(RecordUptr record, const char *key, size_t hash)
+{
+  build_recs_.push_back(std::move(record));
+  build_keys_.insert(build_keys_.end(), key, key + key_len_);
+  build_hashes_.push_back(hash);
+}
+
+auto HashJoinExecutor::CreatePartitions(size_t level) -> std::vector<PartitionUptr>
+{
+  std::vector<PartitionUptr> parts(HASH_JOIN_PARTITION_NUM);
+  for (auto &part : parts) {
+    part              = std::make_unique<Partition>();
+    auto id           = spill_file_num_++;
+    part->build_file_ = HASH_JOIN_FILE_PATH(fmt::format("{}_build_{}", spill_prefix_, id));
+    part->probe_file_ = HASH_JOIN_FILE_PATH(fmt::format("{}_probe_{}", spill_prefix_, id));
+    part->level_      = level;
+    spill_files_.push_back(part->build_file_);
+    spill_files_.push_back(part->probe_file_);
+    part->build_writer_.open(part->build_file_, std::ios::binary | std::ios::trunc);
+    part->probe_writer_.open(part->probe_file_, std::ios::binary | std::ios::trunc);
+    if (!part->build_writer_.is_open() || !part->probe_writer_.is_open()) {
+      WSDB_THROW(WSDB_FILE_NOT_OPEN, part->build_file_);
+    }
+  }
+  return parts;
+}
+
+void HashJoinExecutor::SpillBuild()
+{
+  spilled_       = true;
+  resident_part_ = 0;
+  partitions_    = CreatePartitions(0);
+  // keep the records of the resident partition, write the others
+  size_t kept = 0;
+  for (size_t i = 0; i < build_recs_.size(); ++i) {
+    auto part_id = PartitionOf(build_hashes_[i], 0);
+    if (part_id != resident_part_) {
+      WriteRecord(partitions_[part_id]->build_writer_, *build_recs_[i]);
+      partitions_[part_id]->build_num_++;
+      continue;
+    }
+    build_recs_[kept] = std::move(build_recs_[i]);
+    memmove(build_keys_.data() + kept * key_len_, build_keys_.data() + i * key_len_, key_len_);
+    build_hashes_[kept] = build_hashes_[i];
+    kept++;
+  }
+  build_recs_.resize(kept);
+  build_keys_.resize(kept * key_len_);
+  build_hashes_.resize(kept);
+  if (build_recs_.size() > max_build_rec_num_) {
+    SpillResident();
+  }
+}
+
+void HashJoinExecutor::SpillResident()
+{
+  auto &part = partitions_[resident_part_];
+  for (const auto &record : build_recs_) {
+    WriteRecord(part->build_writer_, *record);
+  }
+  part->build_num_ += build_recs_.size();
+  build_recs_.clear();
+  build_keys_.clear();
+  build_hashes_.clear();
+  resident_part_ = NO_PARTITION;
+}
+
+void HashJoinExecutor::Build()
+{
+  build_recs_.clear();
+  build_keys_.clear();
+  build_hashes_.clear();
+  std::vector<char> key(key_len_);
+  // the bloom filter is filled as rows arrive, so spilled rows take no memory outside the buffer of the join
+  std::unique_ptr<BloomFilter> bloom_filter;
+  if (runtime_filter_ != nullptr) {
+    bloom_filter = runtime_filter_->MakeBloomFilter();
+  }
+  right_->Init();
+  for (; !right_->IsEnd(); right_->Next()) {
+    auto record = right_->GetRecord();
+    right_encoder_.Encode(*record, key.data());
+    auto hash = Hash(key.data());
+    if (bloom_filter != nullptr) {
+      bloom_filter->Insert(RuntimeFilter::Hash(key.data(), key_len_));
+    }
+    if (!spilled_) {
+      AppendBuild(std::move(record), key.data(), hash);
+      if (build_recs_.size() > max_build_rec_num_) {
+        SpillBuild();
+      }
+      continue;
+    }
+    auto part_id = PartitionOf(hash, 0);
+    if (part_id != resident_part_) {
+      WriteRecord(partitions_[part_id]->build_writer_, *record);
+      partitions_[part_id]->build_num_++;
+      continue;
+    }
+    AppendBuild(std::move(record), key.data(), hash);
+    if (build_recs_.size() > max_build_rec_num_) {
+      SpillResident();
+    }
+  }
+  for (auto &part : partitions_) {
+    part->build_writer_.close();
+  }
+  BuildTable();
+  if (runtime_filter_ != nullptr) {
+    // probe keys are encoded like build keys, so a probe row matches only if its key hash is in the filter
+    runtime_filter_->Publish(left_encoder_, std::move(bloom_filter));
+  }
+  // right fields of unmatched rows in outer join
+  auto right_schema = right_->GetOutSchema();
+  auto nullmap      = std::make_unique<char[]>(BITMAP_SIZE(right_schema->GetFieldCount()));
+  auto data         = std::make_unique<char[]>(right_schema->GetRecordLength());
+  BitMap::Set(nullmap.get(), right_schema->GetFieldCount());
+  memset(data.get(), 0, right_schema->GetRecordLength());
+  null_right_ = std::make_unique<Record>(right_schema, nullmap.get(), data.get(), INVALID_RID);
+}
+
+void HashJoinExecutor::BuildTable()
+{
+  auto num = build_recs_.size();
+  WSDB_ASSERT(num < NIL, "too many build records");
+  // keep the load factor under 0.5 so that probe sequences stay short
+  slots_.assign(std::bit_ceil(std::max<size_t>(num * 2, 16)), NIL);
+  next_.assign(num, NIL);
+  size_t mask = slots_.size() - 1;
+  // insert backwards so that each chain lists records in input order
+  for (size_t i = num; i-- > 0;) {
+    const char *key = build_keys_.data() + i * key_len_;
+    size_t      pos = build_hashes_[i] & mask;
+    for (; slots_[pos] != NIL; pos = (pos + 1) & mask) {
+      auto head = slots_[pos];
+      if (build_hashes_[head] == build_hashes_[i] && memcmp(build_keys_.data() + head * key_len_, key, key_len_) == 0) {
+        next_[i] = head;
+        break;
+      }
+    }
+    slots_[pos] = static_cast<uint32_t>(i);
+  }
+}
+
+void HashJoinExecutor::FinishPartitioning()
+{
+  left_done_ = true;
+  // join the partitions in order, a partition without probe rows produces nothing
+  for (size_t i = partitions_.size(); i-- > 0;) {
+    auto &part = partitions_[i];
+    part->probe_writer_.close();
+    if (i != resident_part_ && part->probe_num_ > 0 && (part->build_num_ > 0 || join_type_ == OUTER_JOIN)) {
+      pending_.push_back(std::move(part));
+    } else {
+      std::filesystem::remove(part->build_file_);
+      std::filesystem::remove(part->probe_file_);
+    }
+  }
+  partitions_.clear();
+}
+
+auto HashJoinExecutor::LoadPartition() -> bool
+{
+  const auto       *left_schema  = left_->GetOutSchema();
+  const auto       *right_schema = right_->GetOutSchema();
+  std::vector<char> buf;
+  std::vector<char> key(key_len_);
+  while (!pending_.empty()) {
+    auto part = std::move(pending_.back());
+    pending_.pop_back();
+    std::ifstream build_file(part->build_file_, std::ios::binary);
+    if (part->build_num_ > max_build_rec_num_ && part->level_ + 1 < MAX_PARTITION_LEVEL) {
+      // still too large, partition both sides again with the next bits of the hash
+      auto          children = CreatePartitions(part->level_ + 1);
+      std::ifstream probe_file(part->probe_file_, std::ios::binary);
+      while (auto record = ReadRecord(build_file, right_schema, buf)) {
+        right_encoder_.Encode(*record, key.data());
+        auto &child = children[PartitionOf(Hash(key.data()), part->level_ + 1)];
+        WriteRecord(child->build_writer_, *record);
+        child->build_num_++;
+      }
+      while (auto record = ReadRecord(probe_file, left_schema, buf)) {
+        left_encoder_.Encode(*record, key.data());
+        auto &child = children[PartitionOf(Hash(key.data()), part->level_ + 1)];
+        WriteRecord(child->probe_writer_, *record);
+        child->probe_num_++;
+      }
+      build_file.close();
+      probe_file.close();
+      std::filesystem::remove(part->build_file_);
+      std::filesystem::remove(part->probe_file_);
+      for (size_t i = children.size(); i-- > 0;) {
+        auto &child = children[i];
+        child->build_writer_.close();
+        child->probe_writer_.close();
+        // all keys are equal if the partition is not split, partitioning again is useless
+        if (child->build_num_ == part->build_num_) {
+          child->level_ = MAX_PARTITION_LEVEL;
+        }
+        if (child->probe_num_ > 0 && (child->build_num_ > 0 || join_type_ == OUTER_JOIN)) {
+          pending_.push_back(std::move(child));
+        } else {
+          std::filesystem::remove(child->build_file_);
+          std::filesystem::remove(child->probe_file_);
+        }
+      }
+      continue;
+    }
+    build_recs_.clear();
+    build_keys_.clear();
+    build_hashes_.clear();
+    while (auto record = ReadRecord(build_file, right_schema, buf)) {
+      right_encoder_.Encode(*record, key.data());
+      AppendBuild(std::move(record), key.data(), Hash(key.data()));
+    }
+    build_file.close();
+    std::filesystem::remove(part->build_file_);
+    BuildTable();
+    probe_file_name_ = part->probe_file_;
+    probe_file_      = std::make_unique<std::ifstream>(probe_file_name_, std::ios::binary);
+    return true;
+  }
+  return false;
+}
+
+void HashJoinExecutor::ClearSpill()
+{
+  partitions_.clear();
+  pending_.clear();
+  probe_file_ = nullptr;
+  for (const auto &file : spill_files_) {
+    std::error_code ec;
+    std::filesystem::remove(file, ec);
+  }
+  spill_files_.clear();
+  spilled_       = false;
+  resident_part_ = NO_PARTITION;
+  left_done_     = false;
+}
+
+auto HashJoinExecutor::Probe(const char *key, size_t hash) const -> uint32_t
+{
+  size_t mask = slots_.size() - 1;
+  for (size_t pos = hash & mask; slots_[pos] != NIL; pos = (pos + 1) & mask) {
+    auto head = slots_[pos];
+    if (build_hashes_[head] == hash && memcmp(build_keys_.data() + head * key_len_, key, key_len_) == 0) {
+      return head;
+    }
+  }
+  return NIL;
+}
+
+auto HashJoinExecutor::NextProbeRow(bool batch) -> bool
+{
+  left_rec_ = nullptr;
+  while (true) {
+    // probe rows of a spilled partition
+    if (probe_file_ != nullptr) {
+      left_rec_ = ReadRecord(*probe_file_, left_->GetOutSchema(), probe_buf_);
+      if (left_rec_ != nullptr) {
+        left_encoder_.Encode(*left_rec_, probe_key_.data());
+        probe_hash_ = Hash(probe_key_.data());
+        return true;
+      }
+      probe_file_ = nullptr;
+      std::filesystem::remove(probe_file_name_);
+    }
+    if (left_done_) {
+      if (!LoadPartition()) {
+        return false;
+      }
+      continue;
+    }
+    // rows of the left input
+    if (!batch) {
+      if (left_->IsEnd()) {
+        FinishPartitioning();
+        continue;
+      }
+      left_rec_ = left_->GetRecord();
+      left_->Next();
+      left_encoder_.Encode(*left_rec_, probe_key_.data());
+    } else {
+      if (probe_chunk_ != nullptr && probe_idx_ + 1 < probe_chunk_->GetSize()) {
+        ++probe_idx_;
+      } else {
+        probe_idx_ = 0;
+        do {
+          probe_chunk_ = left_->NextBatch();
+        } while (probe_chunk_ != nullptr && probe_chunk_->GetSize() == 0);
+        if (probe_chunk_ == nullptr) {
+          FinishPartitioning();
+          continue;
+        }
+      }
+      auto row = probe_chunk_->RowAt(probe_idx_);
+      for (size_t i = 0; i < left_encoder_.GetFieldCount(); ++i) {
+        auto col = left_encoder_.GetColIdx(i);
+        left_encoder_.EncodeField(i,
+            probe_chunk_->GetColData(col) + row * left_encoder_.GetFieldSize(i),
+            BitMap::GetBit(probe_chunk_->GetColNullMap(col), row),
+            probe_key_.data());
+      }
+    }
+    probe_hash_ = Hash(probe_key_.data());
+    if (!spilled_) {
+      return true;
+    }
+    auto part_id = PartitionOf(probe_hash_, 0);
+    if (part_id == resident_part_) {
+      return true;
+    }
+    auto &part = partitions_[part_id];
+    if (part->build_num_ > 0 || join_type_ == OUTER_JOIN) {
+      WriteRecord(part->probe_writer_, left_rec_ != nullptr ? *left_rec_ : *probe_chunk_->GetRecord(probe_idx_));
+      part->probe_num_++;
+    }
+    left_rec_ = nullptr;
+  }
+}
+
+void HashJoinExecutor::Advance()
+{
+  while (true) {
+    if (cursor_ != NIL) {
+      record_ = std::make_unique<Record>(out_schema_.get(), *left_rec_, *build_recs_[cursor_]);
+      cursor_ = next_[cursor_];
+      return;
+    }
+    if (!NextProbeRow(false)) {
+      record_ = nullptr;
+      return;
+    }
+    cursor_ = Probe(probe_key_.data(), probe_hash_);
+    if (cursor_ == NIL && join_type_ == OUTER_JOIN) {
+      record_ = std::make_unique<Record>(out_schema_.get(), *left_rec_, *null_right_);
+      return;
+    }
+  }
+}
+
+/// inner join
+void HashJoinExecutor::InitInnerJoin()
+{
+  ClearSpill();
+  Build();
+  probe_chunk_ = nullptr;
+  probe_idx_   = 0;
+  cursor_      = NIL;
+  left_->Init();
+  Advance();
+}
+
+void HashJoinExecutor::NextInnerJoin() { Advance(); }
+
+auto HashJoinExecutor::IsEndInnerJoin() const -> bool { return record_ == nullptr; }
+
+/// outer join, unmatched left records are joined with nulls in Advance
+void HashJoinExecutor::InitOuterJoin() { InitInnerJoin(); }
+
+void HashJoinExecutor::NextOuterJoin() { Advance(); }
+
+auto HashJoinExecutor::IsEndOuterJoin() const -> bool { return record_ == nullptr; }
+
+/// batch
+void HashJoinExecutor::AppendJoined(Chunk &out, uint32_t entry) const
+{
+  auto        row          = out.GetRowNum();
+  const auto *left_schema  = left_->GetOutSchema();
+  const auto *right_schema = right_->GetOutSchema();
+  auto        set_field    = [&out, row](size_t col, size_t size, const char *src, bool is_null) {
+    memcpy(out.GetColData(col) + row * size, src, size);
+    BitMap::SetBit(out.GetColNullMap(col), row, is_null);
+  };
+  for (size_t i = 0; i < left_schema->GetFieldCount(); ++i) {
+    auto size = left_schema->GetFieldAt(i).field_.field_size_;
+    if (left_rec_ != nullptr) {
+      set_field(i,
+          size,
+          left_rec_->GetData() + left_schema->GetFieldOffset(i),
+          BitMap::GetBit(left_rec_->GetNullMap(), i));
+    } else {
+      auto probe_row = probe_chunk_->RowAt(probe_idx_);
+      set_field(i,
+          size,
+          probe_chunk_->GetColData(i) + probe_row * size,
+          BitMap::GetBit(probe_chunk_->GetColNullMap(i), probe_row));
+    }
+  }
+  const auto &right = entry == NIL ? *null_right_ : *build_recs_[entry];
+  for (size_t i = 0; i < right_schema->GetFieldCount(); ++i) {
+    set_field(left_schema->GetFieldCount() + i,
+        right_schema->GetFieldAt(i).field_.field_size_,
+        right.GetData() + right_schema->GetFieldOffset(i),
+        BitMap::GetBit(right.GetNullMap(), i));
+  }
+  out.SetRowNum(row + 1);
+}
+
+auto HashJoinExecutor::NextBatch() -> ChunkUptr
+{
+  auto out = std::make_unique<Chunk>(out_schema_.get(), CHUNK_SIZE);
+  // the current result of the row interface goes first, the rest of its matches follow from cursor_
+  if (record_ != nullptr) {
+    out->AppendRecord(*record_);
+    record_ = nullptr;
+  }
+  while (!out->IsFull()) {
+    if (cursor_ != NIL) {
+      AppendJoined(*out, cursor_);
+      cursor_ = next_[cursor_];
+      continue;
+    }
+    if (!NextProbeRow(true)) {
+      break;
+    }
+    cursor_ = Probe(probe_key_.data(), probe_hash_);
+    if (cursor_ == NIL && join_type_ == OUTER_JOIN) {
+      AppendJoined(*out, NIL);
+    }
+  }
+  return out->GetRowNum() == 0 ? nullptr : std::move(out);
+}
+
+}  // namespace wsdb
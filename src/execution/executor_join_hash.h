@@ -0,0 +1,178 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Join two inputs on equality of their key fields with an in-memory hash table
+ *
+ * The right input is the build side: all of its records are kept in memory and indexed by an open-addressing table
+ * keyed on the normalized bytes of the join key (see SortKeyEncoder), records with equal keys are chained. The left
+ * input is the probe side, so it is also the outer table of an outer join. Like the other join strategies, null keys
+ * are equal to each other.
+ *
+ * If the build side exceeds the buffer, the join turns into a hybrid hash join: both inputs are hash-partitioned into
+ * tmp files, except that the first partition of the build side stays in memory and is joined while the left input is
+ * read. The other partitions are then joined one by one, a partition that is still too large is partitioned again with
+ * the next bits of the hash. Results of spilled partitions come after the results of the in-memory partition.
+ *
+ * If the optimizer gives the join a runtime filter, the keys of the whole build side are put into it before the left
+ * input is initialized, so that the scan of the left input drops the rows that have no match.
+ */
+
+#ifndef WSDB_EXECUTOR_JOIN_HASH_H
+#define WSDB_EXECUTOR_JOIN_HASH_H
+
+#include <fstream>
+#include "executor_join.h"
+#include "expr/runtime_filter.h"
+#include "expr/sort_key.h"
+
+namespace wsdb {
+
+class HashJoinExecutor : public JoinExecutor
+{
+public:
+  HashJoinExecutor(JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right,
+      RecordSchemaUptr left_key_schema, RecordSchemaUptr right_key_schema, RuntimeFilterSptr runtime_filter = nullptr,
+      size_t buffer_size = HASH_JOIN_BUFFER_SIZE);
+
+  ~HashJoinExecutor() override;
+
+  /// probe a chunk of the left input at a time
+  auto NextBatch() -> ChunkUptr override;
+
+private:
+  void InitInnerJoin() override;
+
+  void NextInnerJoin() override;
+
+  [[nodiscard]] auto IsEndInnerJoin() const -> bool override;
+
+  void InitOuterJoin() override;
+
+  void NextOuterJoin() override;
+
+  [[nodiscard]] auto IsEndOuterJoin() const -> bool override;
+
+  /// records of both inputs whose key hashes to the same partition
+  struct Partition
+  {
+    std::string   build_file_;
+    std::string   probe_file_;
+    std::ofstream build_writer_;
+    std::ofstream probe_writer_;
+    size_t        build_num_{0};
+    size_t        probe_num_{0};
+    size_t        level_{0};  // number of partitioning passes that produced the partition
+  };
+
+  using PartitionUptr = std::unique_ptr<Partition>;
+
+  /// read the right input into memory, spill to partitions if it exceeds the buffer
+  void Build();
+
+  /// add a record to the in-memory build side
+  void AppendBuild(RecordUptr record, const char *key, size_t hash);
+
+  /// create the tmp files of the partitions of the next pass
+  auto CreatePartitions(size_t level) -> std::vector<PartitionUptr>;
+
+  /// partition the in-memory build side, only records of the resident partition stay in memory
+  void SpillBuild();
+
+  /// write the resident partition to its file, after that nothing stays in memory
+  void SpillResident();
+
+  /// index the in-memory build side
+  void BuildTable();
+
+  /// called when the left input is exhausted, queue the spilled partitions to be joined
+  void FinishPartitioning();
+
+  /// load the next spilled partition into memory, partition it again if it is too large. false if none left
+  auto LoadPartition() -> bool;
+
+  /// remove the tmp files and reset the spilling state
+  void ClearSpill();
+
+  [[nodiscard]] auto Hash(const char *key) const -> size_t;
+
+  [[nodiscard]] static auto PartitionOf(size_t hash, size_t level) -> size_t;
+
+  /// first build record with the key, NIL if not found
+  [[nodiscard]] auto Probe(const char *key, size_t hash) const -> uint32_t;
+
+  /// move to the next result of the row interface
+  void Advance();
+
+  /**
+   * move to the next probe row and compute its key into probe_key_, rows of spilled partitions are written to files
+   * @param batch read the left input chunk by chunk
+   * @return false if all probe rows are exhausted
+   */
+  auto NextProbeRow(bool batch) -> bool;
+
+  /// append the current probe row joined with a build record, or with nulls if entry is NIL
+  void AppendJoined(Chunk &out, uint32_t entry) const;
+
+private:
+  static constexpr uint32_t NIL = UINT32_MAX;
+  // no partition is resident
+  static constexpr size_t NO_PARTITION = HASH_JOIN_PARTITION_NUM;
+  // each pass takes log2(HASH_JOIN_PARTITION_NUM) bits from the top of the hash
+  static constexpr size_t MAX_PARTITION_LEVEL = 4;
+
+  RecordSchemaUptr      left_key_schema_;
+  RecordSchemaUptr      right_key_schema_;
+  SortKeyEncoder        left_encoder_;
+  SortKeyEncoder        right_encoder_;
+  size_t                key_len_{0};
+  RuntimeFilterSptr     runtime_filter_;
+
+  // build side, entry i is build_recs_[i]
+  std::vector<RecordUptr> build_recs_;
+  std::vector<char>       build_keys_;
+  std::vector<size_t>     build_hashes_;
+  std::vector<uint32_t>   next_;
+  std::vector<uint32_t>   slots_;
+  RecordUptr              null_right_;
+  size_t                  max_build_rec_num_;  // records the buffer can hold
+
+  // spilling, partitions_ are those of the first pass, pending_ are spilled partitions waiting to be joined
+  std::string                    spill_prefix_;
+  bool                           spilled_{false};
+  size_t                         resident_part_{NO_PARTITION};
+  std::vector<PartitionUptr>     partitions_;
+  std::vector<PartitionUptr>     pending_;
+  std::vector<std::string>       spill_files_;
+  size_t                         spill_file_num_{0};
+  bool                           left_done_{false};
+  std::unique_ptr<std::ifstream> probe_file_;
+  std::string                    probe_file_name_;
+  std::vector<char>              probe_buf_;
+
+  // probe side, the current probe row is left_rec_ if set, otherwise the row probe_idx_ of probe_chunk_
+  RecordUptr        left_rec_;
+  ChunkUptr         probe_chunk_;
+  size_t            probe_idx_{0};
+  uint32_t          cursor_{NIL};
+  std::vector<char> probe_key_;
+  size_t            probe_hash_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_JOIN_HASH_H
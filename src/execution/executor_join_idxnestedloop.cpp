@@ -0,0 +1,142 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_join_idxnestedloop.h"
+
+namespace wsdb {
+
+IndexNestedLoopJoinExecutor::IndexNestedLoopJoinExecutor(JoinType join_type, AbstractExecutorUptr left,
+    AbstractExecutorUptr right, TableHandle *tab, IndexHandle *index, RecordSchemaUptr left_key_schema,
+    RecordSchemaUptr right_key_schema)
+    // like hash join, the conditions have been converted to key schemas
+    : JoinExecutor(join_type, std::move(left), std::move(right), {}),
+      tab_(tab),
+      index_(index),
+      left_key_schema_(std::move(left_key_schema)),
+      right_key_schema_(std::move(right_key_schema)),
+      left_encoder_(left_->GetOutSchema(), left_key_schema_.get()),
+      right_encoder_(right_->GetOutSchema(), right_key_schema_.get())
+{
+  SortKeyEncoder::Align(left_encoder_, right_encoder_);
+  left_key_.resize(left_encoder_.GetKeySize());
+  right_key_.resize(right_encoder_.GetKeySize());
+  const auto *left_schema = left_->GetOutSchema();
+  for (const auto &field : index_->GetKeySchema().GetFields()) {
+    auto key_idx = right_key_schema_->GetFieldIndex(field.field_.table_id_, field.field_.field_name_);
+    WSDB_ASSERT(key_idx < right_key_schema_->GetFieldCount(), "index key field is not a join key");
+    const auto &left_field = left_key_schema_->GetFieldAt(key_idx).field_;
+    index_cols_.push_back(left_schema->GetFieldIndex(left_field.table_id_, left_field.field_name_));
+    right_index_cols_.push_back(
+        right_->GetOutSchema()->GetFieldIndex(field.field_.table_id_, field.field_.field_name_));
+  }
+  null_right_ = std::make_unique<Record>(right_->GetOutSchema());
+}
+
+void IndexNestedLoopJoinExecutor::Probe()
+{
+  matches_.clear();
+  cursor_ = 0;
+  left_encoder_.Encode(*left_rec_, left_key_.data());
+  auto is_match = [this](const Record &record) {
+    // join key fields that are not in the index
+    right_encoder_.Encode(record, right_key_.data());
+    return left_encoder_.Compare(left_key_.data(), right_key_.data()) == 0;
+  };
+  std::vector<ValueSptr> values;
+  for (auto col : index_cols_) {
+    if (BitMap::GetBit(left_rec_->GetNullMap(), col)) {
+      // null equals null as in the other join strategies, but null keys cannot be looked up
+      LoadNullKeyRecords();
+      for (const auto &record : null_key_recs_) {
+        if (is_match(*record)) {
+          matches_.push_back(std::make_unique<Record>(*record));
+        }
+      }
+      return;
+    }
+    values.push_back(left_rec_->GetValueAt(col));
+  }
+  Record key(&index_->GetKeySchema(), values, INVALID_RID);
+  for (const auto &rid : index_->LookupRecord(key)) {
+    auto record = std::make_unique<Record>(right_->GetOutSchema(), *tab_->GetRecord(rid));
+    if (is_match(*record)) {
+      matches_.push_back(std::move(record));
+    }
+  }
+}
+
+void IndexNestedLoopJoinExecutor::LoadNullKeyRecords()
+{
+  if (null_key_loaded_) {
+    return;
+  }
+  null_key_loaded_ = true;
+  for (right_->Init(); !right_->IsEnd(); right_->Next()) {
+    auto record = right_->GetRecord();
+    for (auto col : right_index_cols_) {
+      if (BitMap::GetBit(record->GetNullMap(), col)) {
+        null_key_recs_.push_back(std::move(record));
+        break;
+      }
+    }
+  }
+}
+
+void IndexNestedLoopJoinExecutor::Advance()
+{
+  while (true) {
+    if (cursor_ < matches_.size()) {
+      record_ = std::make_unique<Record>(out_schema_.get(), *left_rec_, *matches_[cursor_++]);
+      return;
+    }
+    if (left_->IsEnd()) {
+      record_ = nullptr;
+      return;
+    }
+    left_rec_ = left_->GetRecord();
+    left_->Next();
+    Probe();
+    if (matches_.empty() && join_type_ == OUTER_JOIN) {
+      record_ = std::make_unique<Record>(out_schema_.get(), *left_rec_, *null_right_);
+      return;
+    }
+  }
+}
+
+/// inner join
+void IndexNestedLoopJoinExecutor::InitInnerJoin()
+{
+  null_key_recs_.clear();
+  null_key_loaded_ = false;
+  matches_.clear();
+  cursor_ = 0;
+  left_->Init();
+  Advance();
+}
+
+void IndexNestedLoopJoinExecutor::NextInnerJoin() { Advance(); }
+
+auto IndexNestedLoopJoinExecutor::IsEndInnerJoin() const -> bool { return record_ == nullptr; }
+
+/// outer join, unmatched left records are joined with nulls in Advance
+void IndexNestedLoopJoinExecutor::InitOuterJoin() { InitInnerJoin(); }
+
+void IndexNestedLoopJoinExecutor::NextOuterJoin() { Advance(); }
+
+auto IndexNestedLoopJoinExecutor::IsEndOuterJoin() const -> bool { return record_ == nullptr; }
+
+}  // namespace wsdb
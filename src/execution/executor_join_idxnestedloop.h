@@ -0,0 +1,100 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Join two inputs by looking up the records of the right table in an index for each left record
+ *
+ * The right input is a table with an index on some of its join key fields, it is never scanned: the index key is
+ * taken from each left record and the matched records are fetched from the table by rid. The whole join key is
+ * compared again on the fetched records, so key fields that are not in the index are joined as well. The left input
+ * is the outer table of an outer join. As in the other strategies a null key equals a null key, null keys are not
+ * looked up in the index but matched with the inner records of a null index key field, which are read once by
+ * scanning the right input when the first null key is probed.
+ */
+
+#ifndef WSDB_EXECUTOR_JOIN_IDXNESTEDLOOP_H
+#define WSDB_EXECUTOR_JOIN_IDXNESTEDLOOP_H
+
+#include "executor_join.h"
+#include "expr/sort_key.h"
+#include "system/handle/index_handle.h"
+#include "system/handle/table_handle.h"
+
+namespace wsdb {
+
+class IndexNestedLoopJoinExecutor : public JoinExecutor
+{
+public:
+  /**
+   * @param join_type
+   * @param left outer input
+   * @param right scan of the inner table, records are fetched through the index and it is only scanned for null keys
+   * @param tab inner table
+   * @param index index of the inner table, its key fields should be in right_key_schema
+   * @param left_key_schema
+   * @param right_key_schema join key fields of the inner table, in the order of left_key_schema
+   */
+  IndexNestedLoopJoinExecutor(JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right,
+      TableHandle *tab, IndexHandle *index, RecordSchemaUptr left_key_schema, RecordSchemaUptr right_key_schema);
+
+private:
+  void InitInnerJoin() override;
+
+  void NextInnerJoin() override;
+
+  [[nodiscard]] auto IsEndInnerJoin() const -> bool override;
+
+  void InitOuterJoin() override;
+
+  void NextOuterJoin() override;
+
+  [[nodiscard]] auto IsEndOuterJoin() const -> bool override;
+
+  /// move to the next result
+  void Advance();
+
+  /// fetch the inner records matching left_rec_ into matches_
+  void Probe();
+
+  /// read the inner records with a null index key field into null_key_recs_, once per Init
+  void LoadNullKeyRecords();
+
+private:
+  TableHandle     *tab_;
+  IndexHandle     *index_;
+  RecordSchemaUptr left_key_schema_;
+  RecordSchemaUptr right_key_schema_;
+  SortKeyEncoder   left_encoder_;
+  SortKeyEncoder   right_encoder_;
+  // index_cols_[i] is the column of the left input that gives the i-th field of the index key
+  std::vector<size_t> index_cols_;
+  // right_index_cols_[i] is the column of the right input of the i-th field of the index key
+  std::vector<size_t> right_index_cols_;
+  RecordUptr          null_right_;
+
+  RecordUptr              left_rec_;
+  std::vector<RecordUptr> matches_;  // inner records joined with left_rec_
+  size_t                  cursor_{0};
+  std::vector<char>       left_key_;
+  std::vector<char>       right_key_;
+  std::vector<RecordUptr> null_key_recs_;
+  bool                    null_key_loaded_{false};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_JOIN_IDXNESTEDLOOP_H
@@ -20,38 +20,169 @@
 //
 
 #include "executor_join_nestedloop.h"
+#include <algorithm>
 #include "expr/condition_expr.h"
 
 namespace wsdb {
-NestedLoopJoinExecutor::NestedLoopJoinExecutor(
-    JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right, ConditionVec conditions)
+NestedLoopJoinExecutor::NestedLoopJoinExecutor(JoinType join_type, AbstractExecutorUptr left,
+    AbstractExecutorUptr right, ConditionVec conditions, size_t buffer_size)
     : JoinExecutor(join_type, std::move(left), std::move(right), std::move(conditions))
-{}
+{
+  for (const auto &cond : conditions_) {
+    WSDB_ASSERT(cond.GetRhsType() == kValue || cond.GetRhsType() == kColumn, "Invalid condition type");
+    JoinPredicate pred{};
+    pred.op_       = cond.GetOp();
+    pred.lhs_      = Resolve(cond.GetLCol());
+    pred.rhs_type_ = cond.GetRhsType();
+    if (cond.GetRhsType() == kColumn) {
+      pred.rhs_ = Resolve(cond.GetRCol());
+    } else if (cond.GetOp() == OP_IN) {
+      // the datums refer to the values held by conditions_
+      for (const auto &val : std::dynamic_pointer_cast<ArrayValue>(cond.GetRVal())->Get()) {
+        pred.vals_.push_back(Datum::FromValue(*val));
+      }
+    } else {
+      pred.vals_.push_back(cond.GetRDatum());
+    }
+    predicates_.push_back(std::move(pred));
+  }
+  // a block record takes its record and datums in memory
+  const auto *left_schema = left_->GetOutSchema();
+  size_t      rec_size    = left_schema->GetRecordLength() + BITMAP_SIZE(left_schema->GetFieldCount());
+  size_t      entry_size  = sizeof(Record) + rec_size + sizeof(RecordUptr) + left_cols_.size() * sizeof(Datum) + 1;
+  max_block_rec_num_      = std::max<size_t>(buffer_size / entry_size, 1);
+  null_right_             = std::make_unique<Record>(right_->GetOutSchema());
+}
 
-/// inner join
-void NestedLoopJoinExecutor::InitInnerJoin()
+auto NestedLoopJoinExecutor::Resolve(const RTField &field) -> JoinOperand
+{
+  auto slot_of = [](std::vector<size_t> &cols, size_t col) {
+    auto it = std::find(cols.begin(), cols.end(), col);
+    if (it == cols.end()) {
+      cols.push_back(col);
+      return cols.size() - 1;
+    }
+    return static_cast<size_t>(it - cols.begin());
+  };
+  const auto *left_schema = left_->GetOutSchema();
+  auto        idx         = left_schema->GetRTFieldIndex(field);
+  if (idx != left_schema->GetFieldCount()) {
+    return {.is_right_ = false, .slot_ = slot_of(left_cols_, idx)};
+  }
+  const auto *right_schema = right_->GetOutSchema();
+  idx                      = right_schema->GetRTFieldIndex(field);
+  WSDB_ASSERT(idx != right_schema->GetFieldCount(), "Invalid field");
+  return {.is_right_ = true, .slot_ = slot_of(right_cols_, idx)};
+}
+
+auto NestedLoopJoinExecutor::Match(size_t idx) const -> bool
 {
-  WSDB_STUDENT_TODO(l2, f1);
-  WSDB_STUDENT_TODO(l3, t1);
+  const Datum *left_datums = block_datums_.data() + idx * left_cols_.size();
+  auto         datum_of    = [this, left_datums](const JoinOperand &operand) -> const Datum & {
+    return operand.is_right_ ? right_datums_[operand.slot_] : left_datums[operand.slot_];
+  };
+  for (const auto &pred : predicates_) {
+    const auto &lhs = datum_of(pred.lhs_);
+    bool        res;
+    if (pred.rhs_type_ == kColumn) {
+      res = Datum::Eval(pred.op_, lhs, datum_of(pred.rhs_));
+    } else if (pred.op_ == OP_IN) {
+      res = std::any_of(
+          pred.vals_.begin(), pred.vals_.end(), [&lhs](const Datum &val) { return Datum::Eval(OP_EQ, lhs, val); });
+    } else {
+      res = Datum::Eval(pred.op_, lhs, pred.vals_.front());
+    }
+    if (!res) {
+      return false;
+    }
+  }
+  return true;
 }
 
-void NestedLoopJoinExecutor::NextInnerJoin()
+auto NestedLoopJoinExecutor::LoadBlock() -> bool
 {
-  WSDB_STUDENT_TODO(l2, f1);
-  WSDB_STUDENT_TODO(l3, t1);
+  block_.clear();
+  block_datums_.clear();
+  while (block_.size() < max_block_rec_num_ && !left_->IsEnd()) {
+    block_.push_back(left_->GetRecord());
+    left_->Next();
+    // the datums refer to the record, which stays in place while it is in the block
+    for (auto col : left_cols_) {
+      block_datums_.push_back(block_.back()->GetDatumAt(col));
+    }
+  }
+  if (block_.empty()) {
+    return false;
+  }
+  matched_.assign(block_.size(), false);
+  block_idx_ = block_.size();
+  null_idx_  = 0;
+  right_rec_ = nullptr;
+  right_->Init();
+  return true;
 }
 
-auto NestedLoopJoinExecutor::IsEndInnerJoin() const -> bool
+void NestedLoopJoinExecutor::Advance()
 {
-  WSDB_STUDENT_TODO(l2, f1);
-  WSDB_STUDENT_TODO(l3, t1);
+  while (true) {
+    if (right_rec_ != nullptr) {
+      while (block_idx_ < block_.size()) {
+        auto idx = block_idx_++;
+        if (Match(idx)) {
+          matched_[idx] = true;
+          record_       = std::make_unique<Record>(out_schema_.get(), *block_[idx], *right_rec_);
+          return;
+        }
+      }
+      right_rec_ = nullptr;
+    }
+    if (!right_->IsEnd()) {
+      right_rec_ = right_->GetRecord();
+      right_->Next();
+      right_datums_.clear();
+      for (auto col : right_cols_) {
+        right_datums_.push_back(right_rec_->GetDatumAt(col));
+      }
+      block_idx_ = 0;
+      continue;
+    }
+    // the block has been joined with the whole right input
+    if (join_type_ == OUTER_JOIN) {
+      while (null_idx_ < block_.size()) {
+        auto idx = null_idx_++;
+        if (!matched_[idx]) {
+          record_ = std::make_unique<Record>(out_schema_.get(), *block_[idx], *null_right_);
+          return;
+        }
+      }
+    }
+    if (!LoadBlock()) {
+      record_ = nullptr;
+      return;
+    }
+  }
 }
 
-/// outer join
-void NestedLoopJoinExecutor::InitOuterJoin() { WSDB_STUDENT_TODO(l3, t2); }
+/// inner join
+void NestedLoopJoinExecutor::InitInnerJoin()
+{
+  left_->Init();
+  if (!LoadBlock()) {
+    record_ = nullptr;
+    return;
+  }
+  Advance();
+}
+
+void NestedLoopJoinExecutor::NextInnerJoin() { Advance(); }
+
+auto NestedLoopJoinExecutor::IsEndInnerJoin() const -> bool { return record_ == nullptr; }
+
+/// outer join, unmatched left records are joined with nulls in Advance
+void NestedLoopJoinExecutor::InitOuterJoin() { InitInnerJoin(); }
 
-void NestedLoopJoinExecutor::NextOuterJoin() { WSDB_STUDENT_TODO(l3, t2); }
+void NestedLoopJoinExecutor::NextOuterJoin() { Advance(); }
 
-auto NestedLoopJoinExecutor::IsEndOuterJoin() const -> bool { WSDB_STUDENT_TODO(l3, t2); }
+auto NestedLoopJoinExecutor::IsEndOuterJoin() const -> bool { return record_ == nullptr; }
 
-}  // namespace wsdb
\ No newline at end of file
+}  // namespace wsdb
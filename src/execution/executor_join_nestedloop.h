@@ -20,8 +20,15 @@
 //
 
 /**
- * @brief Make a nested loop join between two tables, for outer join, the left table is the outer table
- * 
+ * @brief Make a block nested loop join between two inputs, for outer join, the left table is the outer table
+ *
+ * Left records are read into a block of at most NESTED_LOOP_JOIN_BUFFER_SIZE, then the right input is scanned once
+ * per block and each right record is compared with all records of the block, so the right input is rescanned once
+ * per block instead of once per left record. Within a block, results come in the order of the right input, unmatched
+ * left records of an outer join come after the block has been joined.
+ *
+ * The conditions are resolved to columns once when the executor is created, the fields they compare are read into
+ * datums once per record, and each pair of records is evaluated on the datums.
  */
 
 #ifndef WSDB_EXECUTOR_JOIN_NESTEDLOOP_H
@@ -34,8 +41,8 @@ namespace wsdb {
 class NestedLoopJoinExecutor : public JoinExecutor
 {
 public:
-  NestedLoopJoinExecutor(
-      JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right, ConditionVec conditions);
+  NestedLoopJoinExecutor(JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right,
+      ConditionVec conditions, size_t buffer_size = NESTED_LOOP_JOIN_BUFFER_SIZE);
 
 private:
   void InitInnerJoin() override;
@@ -50,11 +57,51 @@ private:
 
   [[nodiscard]] auto IsEndOuterJoin() const -> bool override;
 
+  /// a field compared by a condition, slot_ is its position in the datums read from the records of its side
+  struct JoinOperand
+  {
+    bool   is_right_;
+    size_t slot_;
+  };
+
+  /// a condition resolved to the datums of both sides, vals_ holds the rhs value, or the list of IN
+  struct JoinPredicate
+  {
+    CompOp             op_;
+    JoinOperand        lhs_;
+    CondRvalType       rhs_type_;
+    JoinOperand        rhs_;
+    std::vector<Datum> vals_;
+  };
+
+  /// resolve a field of the conditions to a column of the left or right input
+  auto Resolve(const RTField &field) -> JoinOperand;
+
+  /// check the conditions on the idx-th record of the block and the current right record
+  [[nodiscard]] auto Match(size_t idx) const -> bool;
+
+  /// read the next block of left records and rescan the right input, false if the left input is exhausted
+  auto LoadBlock() -> bool;
+
+  /// move to the next result
+  void Advance();
+
 private:
-  // temporarily store record from the left executor
-  RecordUptr left_rec_ = nullptr;
-  // for outer join, indicates whether a valid right value is found
-  bool need_gen_null_{false};
+  std::vector<JoinPredicate> predicates_;
+  // columns of each side read into datums, in the order of their slots
+  std::vector<size_t> left_cols_;
+  std::vector<size_t> right_cols_;
+  size_t              max_block_rec_num_;
+  RecordUptr          null_right_;
+
+  // block_datums_ holds left_cols_.size() datums for each record of the block
+  std::vector<RecordUptr> block_;
+  std::vector<Datum>      block_datums_;
+  std::vector<bool>       matched_;  // for outer join, whether a record of the block has been joined
+  size_t                  block_idx_{0};
+  size_t                  null_idx_{0};
+  RecordUptr              right_rec_;
+  std::vector<Datum>      right_datums_;
 };
 
 }  // namespace wsdb
@@ -0,0 +1,121 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+#include "executor_join_semi.h"
+
+namespace wsdb {
+
+SemiJoinExecutor::SemiJoinExecutor(
+    AbstractExecutorUptr left, AbstractExecutorUptr right, const RTField &left_key, bool is_anti)
+    : AbstractExecutor(Basic),
+      left_(std::move(left)),
+      right_(std::move(right)),
+      left_key_schema_(std::make_unique<RecordSchema>(std::vector<RTField>{left_key})),
+      is_anti_(is_anti)
+{
+  const auto *right_schema = right_->GetOutSchema();
+  if (right_schema->GetFieldCount() != 1) {
+    WSDB_THROW(WSDB_GRAMMAR_ERROR, "subquery of IN should return one column");
+  }
+  right_key_schema_ = std::make_unique<RecordSchema>(std::vector<RTField>{right_schema->GetFieldAt(0)});
+  left_encoder_     = SortKeyEncoder(left_->GetOutSchema(), left_key_schema_.get());
+  right_encoder_    = SortKeyEncoder(right_schema, right_key_schema_.get());
+  SortKeyEncoder::Align(left_encoder_, right_encoder_);
+  probe_key_.resize(left_encoder_.GetKeySize());
+}
+
+void SemiJoinExecutor::Build()
+{
+  keys_.clear();
+  right_has_null_ = false;
+  std::string key(right_encoder_.GetKeySize(), '\0');
+  right_->Init();
+  for (; !right_->IsEnd(); right_->Next()) {
+    auto record = right_->GetRecord();
+    right_encoder_.Encode(*record, key.data());
+    right_has_null_ = right_has_null_ || BitMap::GetBit(record->GetNullMap(), right_encoder_.GetColIdx(0));
+    keys_.insert(key);
+  }
+}
+
+auto SemiJoinExecutor::Pass(bool is_null) const -> bool
+{
+  if (!is_anti_) {
+    return keys_.contains(probe_key_);
+  }
+  if (keys_.empty()) {
+    return true;
+  }
+  return !is_null && !right_has_null_ && !keys_.contains(probe_key_);
+}
+
+void SemiJoinExecutor::Advance()
+{
+  auto col = left_encoder_.GetColIdx(0);
+  for (; !left_->IsEnd(); left_->Next()) {
+    auto record = left_->GetRecord();
+    left_encoder_.Encode(*record, probe_key_.data());
+    if (Pass(BitMap::GetBit(record->GetNullMap(), col))) {
+      record_ = std::move(record);
+      return;
+    }
+  }
+  record_ = nullptr;
+}
+
+void SemiJoinExecutor::Init()
+{
+  Build();
+  left_->Init();
+  Advance();
+}
+
+void SemiJoinExecutor::Next()
+{
+  left_->Next();
+  Advance();
+}
+
+auto SemiJoinExecutor::IsEnd() const -> bool { return record_ == nullptr; }
+
+auto SemiJoinExecutor::NextBatch() -> ChunkUptr
+{
+  // the record found by Init is still the current record of left, so it is returned by left's batch
+  record_  = nullptr;
+  auto col = left_encoder_.GetColIdx(0);
+  while (auto chunk = left_->NextBatch()) {
+    const char      *data    = chunk->GetColData(col);
+    const char      *nullmap = chunk->GetColNullMap(col);
+    Chunk::SelVector sel;
+    for (size_t i = 0; i < chunk->GetSize(); ++i) {
+      auto row     = chunk->RowAt(i);
+      bool is_null = BitMap::GetBit(nullmap, row);
+      left_encoder_.EncodeField(0, data + row * left_encoder_.GetFieldSize(0), is_null, probe_key_.data());
+      if (Pass(is_null)) {
+        sel.push_back(static_cast<uint32_t>(row));
+      }
+    }
+    chunk->SetSelection(std::move(sel));
+    if (chunk->GetSize() > 0) {
+      return chunk;
+    }
+  }
+  return nullptr;
+}
+
+auto SemiJoinExecutor::GetOutSchema() const -> const RecordSchema * { return left_->GetOutSchema(); }
+
+}  // namespace wsdb
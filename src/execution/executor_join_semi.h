@@ -0,0 +1,79 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+/**
+ * @brief Return the records of the left input whose key is IN (semi join) or NOT IN (anti join) the right input
+ *
+ * The right input returns a single column, e.g. an IN subquery or the values of an IN list. It is read once in Init
+ * and its normalized keys (see SortKeyEncoder) are put into a hash set, so each left record is checked with one
+ * lookup. Like the IN condition, a null key is IN a right input that has a null.
+ *
+ * The anti join is NULL-aware as NOT IN is: a left record passes if the right input is empty, otherwise only if its
+ * key is not null, the right input has no null and the key is not in the set.
+ */
+
+#ifndef WSDB_EXECUTOR_JOIN_SEMI_H
+#define WSDB_EXECUTOR_JOIN_SEMI_H
+
+#include <string>
+#include <unordered_set>
+#include "executor_abstract.h"
+#include "expr/sort_key.h"
+
+namespace wsdb {
+
+class SemiJoinExecutor : public AbstractExecutor
+{
+public:
+  SemiJoinExecutor(AbstractExecutorUptr left, AbstractExecutorUptr right, const RTField &left_key, bool is_anti);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  /// only narrows the selection of left chunks, empty chunks are skipped
+  auto NextBatch() -> ChunkUptr override;
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+
+private:
+  /// read the right input into the key set
+  void Build();
+
+  /// whether a left key passes, probe_key_ holds its encoding
+  [[nodiscard]] auto Pass(bool is_null) const -> bool;
+
+  /// move to the first record from the current one of left that passes
+  void Advance();
+
+private:
+  AbstractExecutorUptr            left_;
+  AbstractExecutorUptr            right_;
+  RecordSchemaUptr                left_key_schema_;
+  RecordSchemaUptr                right_key_schema_;
+  SortKeyEncoder                  left_encoder_;
+  SortKeyEncoder                  right_encoder_;
+  bool                            is_anti_;
+  std::unordered_set<std::string> keys_;  // keys of the right input
+  bool                            right_has_null_{false};
+  std::string                     probe_key_;  // key of the left record being checked
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_JOIN_SEMI_H
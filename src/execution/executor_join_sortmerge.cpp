@@ -27,14 +27,21 @@ SortMergeJoinExecutor::SortMergeJoinExecutor(JoinType join_type, AbstractExecuto
     // condition vec is not used in sort merge join, it has been converted to key schemas
     : JoinExecutor(join_type, std::move(left), std::move(right), {}),
       left_key_schema_(std::move(left_key_schema)),
-      right_key_schema_(std::move(right_key_schema))
-{}
+      right_key_schema_(std::move(right_key_schema)),
+      left_encoder_(left_->GetOutSchema(), left_key_schema_.get()),
+      right_encoder_(right_->GetOutSchema(), right_key_schema_.get())
+{
+  // both sides are sorted in the order of the normalized keys, so they can be merged by comparing the keys
+  SortKeyEncoder::Align(left_encoder_, right_encoder_);
+  left_key_.resize(left_encoder_.GetKeySize());
+  right_key_.resize(right_encoder_.GetKeySize());
+}
 
 auto SortMergeJoinExecutor::Compare(const wsdb::Record &left, const wsdb::Record &right) const -> int
 {
-  auto left_key  = std::make_unique<Record>(left_key_schema_.get(), left);
-  auto right_key = std::make_unique<Record>(right_key_schema_.get(), right);
-  return Record::Compare(*left_key, *right_key);
+  left_encoder_.Encode(left, left_key_.data());
+  right_encoder_.Encode(right, right_key_.data());
+  return left_encoder_.Compare(left_key_.data(), right_key_.data());
 }
 
 void SortMergeJoinExecutor::InitInnerJoin() { WSDB_STUDENT_TODO(l3, f1); }
@@ -28,6 +28,7 @@
 #define WSDB_EXECUTOR_JOIN_SORTMERGE_H
 
 #include "executor_join.h"
+#include "expr/sort_key.h"
 
 namespace wsdb {
 class SortMergeJoinExecutor : public JoinExecutor
@@ -54,6 +55,11 @@ private:
 private:
   RecordSchemaUptr left_key_schema_;
   RecordSchemaUptr right_key_schema_;
+  SortKeyEncoder   left_encoder_;
+  SortKeyEncoder   right_encoder_;
+  // buffers of the normalized keys in Compare
+  mutable std::vector<char> left_key_;
+  mutable std::vector<char> right_key_;
 
   // temporarily store record from the left executor
   RecordUptr left_rec_;
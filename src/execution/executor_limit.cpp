@@ -23,12 +23,13 @@
 
 namespace wsdb {
 LimitExecutor::LimitExecutor(AbstractExecutorUptr child, int limit)
-    : AbstractExecutor(Basic), child_(std::move(child)), limit_(limit), count_(0)
+    : AbstractExecutor(Basic), child_(std::move(child)), limit_(limit), count_(0), batch_count_(0)
 {}
 
 void LimitExecutor::Init() { 
     // WSDB_STUDENT_TODO(l2, t1); 
     child_->Init();
+    batch_count_ = 0;
     record_ = child_->GetRecord();
     count_ += 1;
 }
@@ -49,5 +50,19 @@ void LimitExecutor::Next() {
     return false;
 }
 
+auto LimitExecutor::NextBatch() -> ChunkUptr
+{
+    if (batch_count_ >= limit_) {
+        return nullptr;
+    }
+    auto chunk = child_->NextBatch();
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    chunk->Truncate(limit_ - batch_count_);
+    batch_count_ += static_cast<int>(chunk->GetSize());
+    return chunk;
+}
+
 [[nodiscard]] auto LimitExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
 }  // namespace wsdb
@@ -41,6 +41,8 @@ public:
 
   [[nodiscard]] auto IsEnd() const -> bool override;
 
+  auto NextBatch() -> ChunkUptr override;
+
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
 
 private:
@@ -49,6 +51,8 @@ private:
   int limit_;
   // current number of records returned
   int count_;
+  // number of records returned by NextBatch
+  int batch_count_;
 };
 }  // namespace wsdb
 
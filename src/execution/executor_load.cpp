@@ -0,0 +1,323 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+#include "executor_load.h"
+
+#include <charconv>
+#include <functional>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace wsdb {
+
+static auto TrimBlank(std::string_view str) -> std::string_view
+{
+  while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+    str.remove_prefix(1);
+  }
+  while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+    str.remove_suffix(1);
+  }
+  return str;
+}
+
+LoadDataExecutor::LoadDataExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::string file_path)
+    : AbstractExecutor(DML),
+      tbl_(tbl),
+      indexes_(std::move(indexes)),
+      file_path_(std::move(file_path)),
+      is_end_(false),
+      staged_num_(0),
+      line_no_(0),
+      indexed_num_(0)
+{
+  std::vector<RTField> fields(1);
+  fields[0]   = RTField{.field_ = {.field_name_ = "loaded", .field_size_ = sizeof(int), .field_type_ = TYPE_INT}};
+  out_schema_ = std::make_unique<RecordSchema>(fields);
+  delim_      = file_path_.ends_with(".tsv") ? '\t' : ',';
+  auto &hdr   = tbl_->GetTableHeader();
+  null_maps_  = std::make_unique<char[]>(hdr.rec_per_page_ * hdr.nullmap_size_);
+  data_       = std::make_unique<char[]>(hdr.rec_per_page_ * hdr.rec_size_);
+}
+
+void LoadDataExecutor::Init() { WSDB_FETAL("LoadDataExecutor does not support Init"); }
+
+void LoadDataExecutor::Next()
+{
+  if (is_end_) {
+    return;
+  }
+  int fd = open(file_path_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    WSDB_THROW(WSDB_FILE_NOT_EXISTS, file_path_);
+  }
+  auto   buf   = std::make_unique<char[]>(LOAD_BUFFER_SIZE);
+  size_t carry = 0;
+  try {
+    while (true) {
+      // an incomplete line at the end of last read is moved to the head of the buffer
+      auto read_size = read(fd, buf.get() + carry, LOAD_BUFFER_SIZE - carry);
+      if (read_size < 0) {
+        WSDB_THROW(WSDB_FILE_READ_ERROR, file_path_);
+      }
+      if (read_size == 0) {
+        if (carry > 0) {
+          ParseLine(buf.get(), buf.get() + carry);
+        }
+        break;
+      }
+      const char *cur = buf.get();
+      const char *end = buf.get() + carry + read_size;
+      while (auto line_end = static_cast<const char *>(memchr(cur, '\n', end - cur))) {
+        ParseLine(cur, line_end);
+        cur = line_end + 1;
+      }
+      carry = end - cur;
+      if (carry == LOAD_BUFFER_SIZE) {
+        WSDB_THROW(WSDB_FILE_READ_ERROR, fmt::format("line {} exceeds {} bytes", line_no_ + 1, LOAD_BUFFER_SIZE));
+      }
+      memmove(buf.get(), cur, carry);
+    }
+    FlushPage();
+    close(fd);
+    fd = -1;
+    RebuildIndexes();
+  } catch (...) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    // the load is all or nothing, remove the index entries and the pages written before the error. A failed step is
+    // logged and the others still run, the error of the load is the one reported
+    auto rollback = [](const char *step, const std::function<void()> &func) {
+      try {
+        func();
+      } catch (std::exception &e) {
+        WSDB_LOG_ERROR(fmt::format("failed to {} of a failed load: {}", step, e.what()));
+      } catch (...) {
+        WSDB_LOG_ERROR(fmt::format("failed to {} of a failed load", step));
+      }
+    };
+    rollback("reset the indexes", [this]() { ResetIndexes(); });
+    if (!loaded_pages_.empty()) {
+      rollback("truncate the pages", [this]() { tbl_->TruncatePages(loaded_pages_.front().first); });
+    }
+    loaded_pages_.clear();
+    staged_num_ = 0;
+    throw;
+  }
+
+  int count = 0;
+  for (const auto &[pid, rec_num] : loaded_pages_) {
+    count += static_cast<int>(rec_num);
+  }
+  std::vector<ValueSptr> values{ValueFactory::CreateIntValue(count)};
+  record_ = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
+  is_end_ = true;
+}
+
+auto LoadDataExecutor::IsEnd() const -> bool { return is_end_; }
+
+void LoadDataExecutor::ParseLine(const char *begin, const char *end)
+{
+  line_no_++;
+  if (begin != end && *(end - 1) == '\r') {
+    end--;
+  }
+  if (begin == end) {
+    return;
+  }
+  auto &schema   = tbl_->GetSchema();
+  auto &hdr      = tbl_->GetTableHeader();
+  char *null_map = null_maps_.get() + staged_num_ * hdr.nullmap_size_;
+  char *data     = data_.get() + staged_num_ * hdr.rec_size_;
+  memset(null_map, 0, hdr.nullmap_size_);
+  memset(data, 0, hdr.rec_size_);
+
+  const char *cur = begin;
+  for (size_t i = 0; i < schema.GetFieldCount(); ++i) {
+    if (cur == nullptr) {
+      WSDB_THROW(
+          WSDB_FIELD_MISS, fmt::format("line {}: expect {} fields, got {}", line_no_, schema.GetFieldCount(), i));
+    }
+    std::string_view field;
+    bool             quoted = delim_ == ',' && cur < end && *cur == '"';
+    if (quoted) {
+      // unescape into field_buf_ until the closing quote
+      field_buf_.clear();
+      const char *p = cur + 1;
+      while (true) {
+        if (p == end) {
+          WSDB_THROW(WSDB_FILE_READ_ERROR, fmt::format("line {}: unterminated quoted field", line_no_));
+        }
+        if (*p == '"') {
+          if (p + 1 < end && *(p + 1) == '"') {
+            field_buf_.push_back('"');
+            p += 2;
+            continue;
+          }
+          p++;
+          break;
+        }
+        field_buf_.push_back(*p++);
+      }
+      if (p != end && *p != delim_) {
+        WSDB_THROW(WSDB_FILE_READ_ERROR, fmt::format("line {}: unexpected character after quoted field", line_no_));
+      }
+      field = field_buf_;
+      cur   = p;
+    } else {
+      auto next = static_cast<const char *>(memchr(cur, delim_, end - cur));
+      next      = next == nullptr ? end : next;
+      field     = std::string_view(cur, next - cur);
+      cur       = next;
+    }
+    ParseField(i, field, quoted, null_map, data);
+    // cur points to a delimiter or the end of line, nullptr indicates that no field is left
+    cur = cur == end ? nullptr : cur + 1;
+  }
+  if (cur != nullptr) {
+    WSDB_THROW(WSDB_FIELD_MISS, fmt::format("line {}: more than {} fields", line_no_, schema.GetFieldCount()));
+  }
+  if (++staged_num_ == hdr.rec_per_page_) {
+    FlushPage();
+  }
+}
+
+void LoadDataExecutor::ParseField(size_t idx, std::string_view field, bool quoted, char *null_map, char *data)
+{
+  auto &schema = tbl_->GetSchema().GetFieldAt(idx).field_;
+  char *dst    = data + tbl_->GetSchema().GetFieldOffset(idx);
+  auto  str    = schema.field_type_ == TYPE_STRING ? field : TrimBlank(field);
+  if (!quoted && str.empty()) {
+    BitMap::SetBit(null_map, idx, true);
+    return;
+  }
+  auto type_error = [&]() {
+    WSDB_THROW(WSDB_TYPE_MISSMATCH,
+        fmt::format("line {}: '{}' is not {} for field {}",
+            line_no_,
+            str,
+            FieldTypeToString(schema.field_type_),
+            schema.field_name_));
+  };
+  const char *last = str.data() + str.size();
+  switch (schema.field_type_) {
+    case TYPE_INT: {
+      int32_t val = 0;
+      auto [ptr, ec] = std::from_chars(str.data(), last, val);
+      if (ec != std::errc() || ptr != last) {
+        // same as insert, a float value is cast to int
+        float fval = 0;
+        auto [fptr, fec] = std::from_chars(str.data(), last, fval);
+        // 2^31, also rejects nan, the cast of a float out of the int range is undefined
+        constexpr auto int_bound = -static_cast<float>(std::numeric_limits<int32_t>::min());
+        if (fec != std::errc() || fptr != last || !(fval >= -int_bound && fval < int_bound)) {
+          type_error();
+        }
+        val = static_cast<int32_t>(fval);
+      }
+      memcpy(dst, &val, sizeof(int32_t));
+      break;
+    }
+    case TYPE_FLOAT: {
+      float val = 0;
+      auto [ptr, ec] = std::from_chars(str.data(), last, val);
+      if (ec != std::errc() || ptr != last) {
+        type_error();
+      }
+      memcpy(dst, &val, sizeof(float));
+      break;
+    }
+    case TYPE_BOOL: {
+      bool val = false;
+      if (str == "1" || str == "true" || str == "TRUE") {
+        val = true;
+      } else if (str == "0" || str == "false" || str == "FALSE") {
+        val = false;
+      } else {
+        type_error();
+      }
+      memcpy(dst, &val, sizeof(bool));
+      break;
+    }
+    case TYPE_STRING: {
+      if (str.size() > schema.field_size_) {
+        WSDB_THROW(WSDB_STRING_OVERFLOW,
+            fmt::format("line {}: field:{}, size:{}, requested:{}",
+                line_no_,
+                schema.field_name_,
+                schema.field_size_,
+                str.size()));
+      }
+      memcpy(dst, str.data(), str.size());
+      break;
+    }
+    default: WSDB_FETAL("Unsupported field type");
+  }
+}
+
+void LoadDataExecutor::FlushPage()
+{
+  if (staged_num_ == 0) {
+    return;
+  }
+  auto pid = tbl_->AppendRecords(null_maps_.get(), data_.get(), staged_num_);
+  loaded_pages_.emplace_back(pid, staged_num_);
+  staged_num_ = 0;
+}
+
+void LoadDataExecutor::RebuildIndexes()
+{
+  if (indexes_.empty()) {
+    return;
+  }
+  // each loaded page is fetched once and its records are inserted into all the indexes
+  const auto *schema = &tbl_->GetSchema();
+  for (const auto &[pid, rec_num] : loaded_pages_) {
+    tbl_->ScanPage(pid, schema, [&](const char *nullmap, const char *data, slot_id_t slot_id) {
+      Record rec(schema, nullmap, data, RID(pid, slot_id));
+      for (auto &index : indexes_) {
+        index->InsertRecord(rec);
+        indexed_num_++;
+      }
+      return true;
+    });
+  }
+}
+
+void LoadDataExecutor::ResetIndexes()
+{
+  // the entries are visited in the order RebuildIndexes inserted them
+  const auto *schema = &tbl_->GetSchema();
+  for (const auto &[pid, rec_num] : loaded_pages_) {
+    if (indexed_num_ == 0) {
+      break;
+    }
+    tbl_->ScanPage(pid, schema, [&](const char *nullmap, const char *data, slot_id_t slot_id) {
+      Record rec(schema, nullmap, data, RID(pid, slot_id));
+      for (auto it = indexes_.begin(); it != indexes_.end() && indexed_num_ > 0; ++it) {
+        (*it)->DeleteRecord(rec);
+        indexed_num_--;
+      }
+      return indexed_num_ > 0;
+    });
+  }
+}
+
+}  // namespace wsdb
@@ -0,0 +1,100 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+/**
+ * @brief Bulk load a local CSV/TSV file into the table and rebuild the indexes
+ *
+ * Fields are separated by '\t' if the file name ends with ".tsv", otherwise by ','. In CSV files a field can be quoted
+ * by '"', and a quote inside a quoted field is escaped as '""'. Each line holds exactly one record, and an unquoted
+ * empty field is loaded as null. Records are parsed straight into the fixed-width layout and written a whole page at a
+ * time through TableHandle::AppendRecords. A malformed line or a failed index insertion aborts the load, the entries
+ * already inserted into the indexes are deleted and the pages already written are removed by
+ * TableHandle::TruncatePages, so the table and its indexes are left as they were before the load.
+ */
+
+#ifndef WSDB_EXECUTOR_LOAD_H
+#define WSDB_EXECUTOR_LOAD_H
+
+#include <string_view>
+
+#include "executor_abstract.h"
+#include "system/handle/table_handle.h"
+#include "system/handle/index_handle.h"
+
+namespace wsdb {
+class LoadDataExecutor : public AbstractExecutor
+{
+public:
+  LoadDataExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::string file_path);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  /**
+   * Parse a line without the line break into the next staged slot, flush the staged records if the page is full
+   * @param begin
+   * @param end
+   */
+  void ParseLine(const char *begin, const char *end);
+
+  /**
+   * Parse a single field into the fixed-width record memory
+   * @param idx field index in the table schema
+   * @param field
+   * @param quoted quoted field is never null
+   * @param null_map
+   * @param data
+   */
+  void ParseField(size_t idx, std::string_view field, bool quoted, char *null_map, char *data);
+
+  /// write the staged records to a fresh page
+  void FlushPage();
+
+  /// insert all the loaded records into the indexes in one pass, a page at a time
+  void RebuildIndexes();
+
+  /// delete the index entries inserted by RebuildIndexes before it failed, called before the pages are truncated
+  void ResetIndexes();
+
+private:
+  TableHandle             *tbl_;
+  std::list<IndexHandle *> indexes_;
+  std::string              file_path_;
+  char                     delim_;
+  bool                     is_end_;
+
+  // records are staged here until a page is filled
+  std::unique_ptr<char[]> null_maps_;
+  std::unique_ptr<char[]> data_;
+  size_t                  staged_num_;
+  // line number of the line being parsed, used in error messages
+  size_t line_no_;
+  // buffer to unescape a quoted field
+  std::string field_buf_;
+  // pages written by this load and the number of records in each page
+  std::vector<std::pair<page_id_t, size_t>> loaded_pages_;
+  // index entries inserted by RebuildIndexes, in the order of the records and then of indexes_
+  size_t indexed_num_;
+};
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_LOAD_H
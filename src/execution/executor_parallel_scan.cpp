@@ -0,0 +1,227 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_parallel_scan.h"
+#include "expr/condition_expr.h"
+
+namespace wsdb {
+
+ParallelScanExecutor::ParallelScanExecutor(TableHandle *tab, RecordSchemaUptr proj_schema, ConditionVec skip_conds,
+    ConditionVec conds, RecordSchemaUptr out_schema, size_t worker_num, RuntimeFilterSptr runtime_filter)
+    : AbstractExecutor(Basic),
+      tab_(tab),
+      proj_schema_(std::move(proj_schema)),
+      skip_conds_(std::move(skip_conds)),
+      conds_(std::move(conds)),
+      worker_num_(std::max<size_t>(worker_num, 1)),
+      morsel_num_(0),
+      window_(2 * worker_num_),
+      runtime_filter_(std::move(runtime_filter)),
+      use_runtime_filter_(false),
+      running_(0),
+      next_morsel_(0),
+      out_morsel_(0),
+      stopped_(true),
+      cursor_(0)
+{
+  out_schema_ = std::move(out_schema);
+  // the consumer sleeps on ready_cv_ while the workers run, wake it up when the client is gone
+  group_.SetCancelHandler([this]() {
+    std::lock_guard lock(latch_);
+    ready_cv_.notify_all();
+  });
+}
+
+ParallelScanExecutor::~ParallelScanExecutor() { Stop(); }
+
+void ParallelScanExecutor::Init()
+{
+  Stop();
+  // a run cancelled by the client leaves the group cancelled
+  group_.Reset();
+  // the join publishes the filter before it initializes its probe side
+  use_runtime_filter_ = runtime_filter_ != nullptr && runtime_filter_->IsReady();
+  if (use_runtime_filter_) {
+    probe_encoder_ = runtime_filter_->MakeEncoder(proj_schema_ != nullptr ? proj_schema_.get() : &tab_->GetSchema());
+  }
+  // the first page of the table file is the header
+  auto data_page_num = tab_->GetTableHeader().page_num_ - (FILE_HEADER_PAGE_ID + 1);
+  morsel_num_        = (data_page_num + PARALLEL_SCAN_MORSEL_SIZE - 1) / PARALLEL_SCAN_MORSEL_SIZE;
+  running_           = 0;
+  next_morsel_       = 0;
+  out_morsel_        = 0;
+  stopped_           = false;
+  error_             = nullptr;
+  done_.clear();
+  pending_.clear();
+  {
+    std::lock_guard lock(latch_);
+    StartWorkers();
+  }
+  chunk_  = PopChunk();
+  cursor_ = 0;
+  record_ = chunk_ == nullptr ? nullptr : chunk_->GetRecord(0);
+}
+
+void ParallelScanExecutor::Next()
+{
+  if (chunk_ == nullptr) {
+    return;
+  }
+  if (++cursor_ == chunk_->GetSize()) {
+    chunk_  = PopChunk();
+    cursor_ = 0;
+  }
+  record_ = chunk_ == nullptr ? nullptr : chunk_->GetRecord(cursor_);
+}
+
+auto ParallelScanExecutor::IsEnd() const -> bool { return record_ == nullptr; }
+
+auto ParallelScanExecutor::NextBatch() -> ChunkUptr
+{
+  // records left by Init or the row interface go first
+  if (chunk_ != nullptr) {
+    Chunk::SelVector sel;
+    for (size_t i = cursor_; i < chunk_->GetSize(); ++i) {
+      sel.push_back(static_cast<uint32_t>(chunk_->RowAt(i)));
+    }
+    chunk_->SetSelection(std::move(sel));
+    record_ = nullptr;
+    return std::move(chunk_);
+  }
+  return PopChunk();
+}
+
+auto ParallelScanExecutor::GetOutSchema() const -> const RecordSchema *
+{
+  if (out_schema_ != nullptr) {
+    return out_schema_.get();
+  }
+  return proj_schema_ != nullptr ? proj_schema_.get() : &tab_->GetSchema();
+}
+
+void ParallelScanExecutor::StartWorkers()
+{
+  auto limit = std::min(morsel_num_, out_morsel_ + window_);
+  while (!stopped_ && running_ < worker_num_ && next_morsel_ + running_ < limit) {
+    running_++;
+    group_.Run([this]() { Work(); });
+  }
+}
+
+void ParallelScanExecutor::Work()
+{
+  std::unique_lock lock(latch_);
+  while (!stopped_ && error_ == nullptr && !group_.IsCancelled() &&
+         next_morsel_ < std::min(morsel_num_, out_morsel_ + window_)) {
+    auto morsel = next_morsel_++;
+    lock.unlock();
+    std::vector<ChunkUptr> chunks;
+    try {
+      chunks = ScanMorsel(morsel);
+    } catch (...) {
+      lock.lock();
+      error_ = std::current_exception();
+      break;
+    }
+    lock.lock();
+    done_.emplace(morsel, std::move(chunks));
+    ready_cv_.notify_one();
+  }
+  running_--;
+  ready_cv_.notify_one();
+}
+
+auto ParallelScanExecutor::ScanMorsel(size_t morsel) -> std::vector<ChunkUptr>
+{
+  const auto *scan_schema  = proj_schema_ != nullptr ? proj_schema_.get() : &tab_->GetSchema();
+  auto        rec_per_page = tab_->GetTableHeader().rec_per_page_;
+  auto        page_num     = static_cast<page_id_t>(tab_->GetTableHeader().page_num_);
+  auto        first_page   = static_cast<page_id_t>(FILE_HEADER_PAGE_ID + 1 + morsel * PARALLEL_SCAN_MORSEL_SIZE);
+  auto        last_page    = std::min(first_page + static_cast<page_id_t>(PARALLEL_SCAN_MORSEL_SIZE), page_num);
+
+  std::vector<ChunkUptr> chunks;
+  ChunkUptr              chunk;
+  auto                   finish_chunk = [this, &chunks, &chunk]() {
+    if (use_runtime_filter_) {
+      runtime_filter_->FilterChunk(probe_encoder_, *chunk);
+    }
+    ConditionExpr::EvalBatch(conds_, *chunk);
+    if (chunk->GetSize() > 0) {
+      chunks.push_back(out_schema_ == nullptr ? std::move(chunk)
+                                              : std::make_unique<Chunk>(out_schema_.get(), std::move(*chunk)));
+    }
+    chunk = nullptr;
+  };
+  for (auto pid = first_page; pid < last_page; ++pid) {
+    if (!tab_->PageMayMatch(pid, skip_conds_)) {
+      continue;
+    }
+    if (chunk == nullptr) {
+      chunk = std::make_unique<Chunk>(scan_schema, std::max(CHUNK_SIZE, rec_per_page));
+    }
+    tab_->AppendChunk(pid, chunk.get());
+    if (chunk->GetCapacity() - chunk->GetRowNum() < rec_per_page) {
+      finish_chunk();
+    }
+  }
+  if (chunk != nullptr) {
+    finish_chunk();
+  }
+  return chunks;
+}
+
+auto ParallelScanExecutor::PopChunk() -> ChunkUptr
+{
+  while (pending_.empty()) {
+    std::unique_lock lock(latch_);
+    if (out_morsel_ == morsel_num_) {
+      return nullptr;
+    }
+    ready_cv_.wait(lock, [this]() {
+      return error_ != nullptr || group_.IsCancelled() || done_.count(out_morsel_) > 0;
+    });
+    if (error_ != nullptr) {
+      std::rethrow_exception(error_);
+    }
+    // groups are only cancelled when the client is gone
+    if (group_.IsCancelled()) {
+      WSDB_THROW(WSDB_CLIENT_DOWN, "");
+    }
+    auto node = done_.extract(out_morsel_++);
+    StartWorkers();
+    lock.unlock();
+    for (auto &chunk : node.mapped()) {
+      pending_.push_back(std::move(chunk));
+    }
+  }
+  auto chunk = std::move(pending_.front());
+  pending_.pop_front();
+  return chunk;
+}
+
+void ParallelScanExecutor::Stop()
+{
+  {
+    std::lock_guard lock(latch_);
+    stopped_ = true;
+  }
+  // workers catch their own errors, so there is nothing to rethrow
+  group_.Wait();
+}
+
+}  // namespace wsdb
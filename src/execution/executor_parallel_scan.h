@@ -0,0 +1,119 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Table scan with the filter and projection above it, run by several worker threads
+ *
+ * The pages of the table are split into morsels of PARALLEL_SCAN_MORSEL_SIZE pages, which workers take in turn. A
+ * worker reads the pages of its morsel into chunks, filters and projects them, and hands them to the consumer through
+ * an exchange. The consumer returns the chunks of morsels in page order, so the output is the same as that of the
+ * serial pipeline. Workers are tasks of the Scheduler, a worker that gets a window of morsels ahead of the consumer
+ * quits instead of blocking a thread of the scheduler, and the consumer starts workers again as it moves on. Like
+ * SeqScanExecutor, rows are checked by the runtime filter of a join above before the conditions of the filter
+ */
+
+#ifndef WSDB_EXECUTOR_PARALLEL_SCAN_H
+#define WSDB_EXECUTOR_PARALLEL_SCAN_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>  // NOLINT
+
+#include "executor_abstract.h"
+#include "expr/runtime_filter.h"
+#include "system/handle/table_handle.h"
+#include "system/scheduler.h"
+
+namespace wsdb {
+
+class ParallelScanExecutor : public AbstractExecutor
+{
+public:
+  /**
+   * @param tab
+   * @param proj_schema fields to materialize, nullptr means all fields of the table
+   * @param skip_conds conditions used to skip pages by zone map
+   * @param conds conditions of the filter, records are filtered by them
+   * @param out_schema fields of the projection, nullptr means the materialized fields
+   * @param worker_num
+   * @param runtime_filter filter published by a join above, nullptr if none
+   */
+  ParallelScanExecutor(TableHandle *tab, RecordSchemaUptr proj_schema, ConditionVec skip_conds, ConditionVec conds,
+      RecordSchemaUptr out_schema, size_t worker_num, RuntimeFilterSptr runtime_filter = nullptr);
+
+  /// stop and join the workers if the consumer does not read all records, e.g. under a limit
+  ~ParallelScanExecutor() override;
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  auto NextBatch() -> ChunkUptr override;
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+
+private:
+  /// start workers while there are morsels within the window, latch_ should be held
+  void StartWorkers();
+
+  /// take morsels until there is none within the window or the scan is stopped
+  void Work();
+
+  /// read, filter and project the pages of a morsel
+  auto ScanMorsel(size_t morsel) -> std::vector<ChunkUptr>;
+
+  /// next non-empty chunk in page order, nullptr if all morsels are consumed
+  auto PopChunk() -> ChunkUptr;
+
+  void Stop();
+
+private:
+  TableHandle     *tab_;
+  RecordSchemaUptr proj_schema_;
+  ConditionVec     skip_conds_;
+  ConditionVec     conds_;
+  size_t           worker_num_;
+  size_t           morsel_num_;
+  size_t           window_;  // workers may run this many morsels ahead of the consumer
+  // workers share the encoder, it is set by Init if the runtime filter has been published
+  RuntimeFilterSptr runtime_filter_;
+  bool              use_runtime_filter_;
+  SortKeyEncoder    probe_encoder_;
+
+  std::mutex                               latch_;
+  std::condition_variable                  ready_cv_;     // a morsel is done or a worker failed
+  size_t                                   running_;      // workers started and not quit yet
+  size_t                                   next_morsel_;  // next morsel to be taken by a worker
+  std::map<size_t, std::vector<ChunkUptr>> done_;         // chunks of finished morsels not consumed yet
+  size_t                                   out_morsel_;   // next morsel to be consumed
+  bool                                     stopped_;
+  std::exception_ptr                       error_;
+
+  std::deque<ChunkUptr> pending_;  // chunks of the consumed morsels, not returned yet
+  ChunkUptr             chunk_;    // chunk of the current record in the row interface
+  size_t                cursor_;
+
+  TaskGroup group_;  // destroyed first, so the cancel handler never notifies a destroyed ready_cv_
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_PARALLEL_SCAN_H
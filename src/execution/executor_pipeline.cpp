@@ -0,0 +1,80 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+#include "executor_pipeline.h"
+
+namespace wsdb {
+
+PipelineExecutor::PipelineExecutor(PipelineUptr pipeline, std::unique_ptr<RowBuffer> rows)
+    : AbstractExecutor(Basic), pipeline_(std::move(pipeline)), rows_(std::move(rows))
+{}
+
+void PipelineExecutor::Init()
+{
+  pipeline_->Init();
+  rows_->Clear();
+  cursor_    = 0;
+  exhausted_ = false;
+  LoadRecord();
+}
+
+void PipelineExecutor::Next()
+{
+  cursor_++;
+  LoadRecord();
+}
+
+auto PipelineExecutor::IsEnd() const -> bool { return record_ == nullptr; }
+
+auto PipelineExecutor::GetOutSchema() const -> const RecordSchema * { return pipeline_->GetOutSchema(); }
+
+auto PipelineExecutor::NextBatch() -> ChunkUptr
+{
+  if (IsEnd()) {
+    return nullptr;
+  }
+  // the current row is still in the buffer at cursor_, record_ is only kept to tell the end
+  auto chunk = std::make_unique<Chunk>(GetOutSchema(), CHUNK_SIZE);
+  for (; !chunk->IsFull() && HasRow(); cursor_++) {
+    chunk->AppendRow(rows_->GetNullMap(cursor_), rows_->GetData(cursor_));
+  }
+  if (!HasRow()) {
+    record_ = nullptr;
+  }
+  return chunk;
+}
+
+auto PipelineExecutor::HasRow() -> bool
+{
+  while (cursor_ == rows_->GetRowNum()) {
+    if (exhausted_) {
+      return false;
+    }
+    rows_->Clear();
+    cursor_    = 0;
+    exhausted_ = !pipeline_->Step();
+  }
+  return true;
+}
+
+void PipelineExecutor::LoadRecord()
+{
+  record_ = HasRow() ? std::make_unique<Record>(GetOutSchema(), rows_->GetNullMap(cursor_), rows_->GetData(cursor_),
+                                                INVALID_RID)
+                     : nullptr;
+}
+
+}  // namespace wsdb
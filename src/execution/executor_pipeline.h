@@ -0,0 +1,69 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+/**
+ * @brief Return the records of a push-based pipeline to a pipeline breaker that pulls them, see pipeline.h
+ *
+ * The pipeline runs a step at a time, i.e. a page of its table, into a BufferSink, and the rows of the step are
+ * returned before the next step runs. Only the rows that pass the filters of the pipeline are copied into the buffer.
+ * The row interface makes a record of the current row, NextBatch copies the rows from the buffer into the columns of
+ * a chunk without making records.
+ */
+
+#ifndef WSDB_EXECUTOR_PIPELINE_H
+#define WSDB_EXECUTOR_PIPELINE_H
+
+#include "executor_abstract.h"
+#include "pipeline.h"
+
+namespace wsdb {
+
+class PipelineExecutor : public AbstractExecutor
+{
+public:
+  /**
+   * @param pipeline compiled by Pipeline::CompileToBuffer
+   * @param rows the buffer the pipeline appends to
+   */
+  PipelineExecutor(PipelineUptr pipeline, std::unique_ptr<RowBuffer> rows);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+
+  auto NextBatch() -> ChunkUptr override;
+
+private:
+  /// make cursor_ point to a row in the buffer, running steps once the buffer is consumed. false if exhausted
+  auto HasRow() -> bool;
+
+  /// set record_ to the row at cursor_, or to nullptr if the pipeline is exhausted
+  void LoadRecord();
+
+private:
+  PipelineUptr               pipeline_;
+  std::unique_ptr<RowBuffer> rows_;
+  size_t                     cursor_{0};
+  bool                       exhausted_{false};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_PIPELINE_H
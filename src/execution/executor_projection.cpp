@@ -54,4 +54,13 @@ auto ProjectionExecutor::IsEnd() const -> bool {
   return child_->IsEnd();  
 }
 
+auto ProjectionExecutor::NextBatch() -> ChunkUptr
+{
+  auto chunk = child_->NextBatch();
+  if (chunk == nullptr) {
+    return nullptr;
+  }
+  return std::make_unique<Chunk>(out_schema_.get(), std::move(*chunk));
+}
+
 }  // namespace wsdb
\ No newline at end of file
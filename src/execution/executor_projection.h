@@ -41,6 +41,9 @@ public:
 
   [[nodiscard]] auto IsEnd() const -> bool override;
 
+  /// columns are moved out of the child chunk, no row is copied
+  auto NextBatch() -> ChunkUptr override;
+
 private:
   AbstractExecutorUptr child_;
 };
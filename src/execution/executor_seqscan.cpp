@@ -23,27 +23,101 @@
 
 namespace wsdb {
 
-SeqScanExecutor::SeqScanExecutor(TableHandle *tab) : AbstractExecutor(Basic), tab_(tab) {}
+SeqScanExecutor::SeqScanExecutor(
+    TableHandle *tab, RecordSchemaUptr proj_schema, ConditionVec skip_conds, RuntimeFilterSptr runtime_filter)
+    : AbstractExecutor(Basic),
+      tab_(tab),
+      skip_conds_(std::move(skip_conds)),
+      page_id_(INVALID_PAGE_ID),
+      cursor_(0),
+      runtime_filter_(std::move(runtime_filter))
+{
+  out_schema_ = std::move(proj_schema);
+}
 
 void SeqScanExecutor::Init()
 {
-  rid_ = tab_->GetFirstRID();
-  
-  // WSDB_STUDENT_TODO(l2, t1);
-  record_ = tab_->GetRecord(rid_);
+  // the join publishes the filter before it initializes its probe side
+  use_runtime_filter_ = runtime_filter_ != nullptr && runtime_filter_->IsReady();
+  if (use_runtime_filter_) {
+    probe_encoder_ = runtime_filter_->MakeEncoder(GetOutSchema());
+    probe_key_.resize(probe_encoder_.GetKeySize());
+  }
+  page_id_ = FILE_HEADER_PAGE_ID;
+  LoadNextPage();
+}
+
+void SeqScanExecutor::Next()
+{
+  if (++cursor_ < page_records_.size()) {
+    record_ = std::move(page_records_[cursor_]);
+  } else {
+    LoadNextPage();
+  }
 }
 
-void SeqScanExecutor::Next() { 
-  // WSDB_STUDENT_TODO(l2, t1); 
-  rid_ = tab_->GetNextRID(rid_);
-  if (IsEnd()) return;
-  record_ = tab_->GetRecord(rid_);
+auto SeqScanExecutor::IsEnd() const -> bool { return cursor_ >= page_records_.size(); }
+
+auto SeqScanExecutor::NextBatch() -> ChunkUptr
+{
+  auto rec_per_page = tab_->GetTableHeader().rec_per_page_;
+  auto page_num     = static_cast<page_id_t>(tab_->GetTableHeader().page_num_);
+  auto chunk        = std::make_unique<Chunk>(GetOutSchema(), std::max(CHUNK_SIZE, rec_per_page));
+  // records left by Init or the row interface go first
+  if (!IsEnd()) {
+    chunk->AppendRecord(*record_);
+    for (++cursor_; cursor_ < page_records_.size(); ++cursor_) {
+      chunk->AppendRecord(*page_records_[cursor_]);
+    }
+    page_records_.clear();
+    cursor_ = 0;
+    record_ = nullptr;
+  }
+  // records of the row interface have been checked by the runtime filter
+  auto first_row = chunk->GetRowNum();
+  while (true) {
+    while (chunk->GetCapacity() - chunk->GetRowNum() >= rec_per_page && page_id_ + 1 < page_num) {
+      if (tab_->PageMayMatch(++page_id_, skip_conds_)) {
+        tab_->AppendChunk(page_id_, chunk.get());
+      }
+    }
+    if (chunk->GetRowNum() == 0) {
+      return nullptr;
+    }
+    if (!use_runtime_filter_) {
+      return chunk;
+    }
+    runtime_filter_->FilterChunk(probe_encoder_, *chunk, first_row);
+    if (chunk->GetSize() > 0) {
+      return chunk;
+    }
+    // all rows are dropped, read on instead of returning an empty chunk
+    chunk     = std::make_unique<Chunk>(GetOutSchema(), chunk->GetCapacity());
+    first_row = 0;
+  }
 }
 
-auto SeqScanExecutor::IsEnd() const -> bool { 
-  // WSDB_STUDENT_TODO(l2, t1); 
-  return rid_ == INVALID_RID;
+auto SeqScanExecutor::GetOutSchema() const -> const RecordSchema *
+{
+  return out_schema_ != nullptr ? out_schema_.get() : &tab_->GetSchema();
 }
 
-auto SeqScanExecutor::GetOutSchema() const -> const RecordSchema * { return &tab_->GetSchema(); }
-}  // namespace wsdb
\ No newline at end of file
+void SeqScanExecutor::LoadNextPage()
+{
+  page_records_.clear();
+  cursor_ = 0;
+  while (page_records_.empty() && ++page_id_ < static_cast<page_id_t>(tab_->GetTableHeader().page_num_)) {
+    if (tab_->PageMayMatch(page_id_, skip_conds_)) {
+      page_records_ = use_runtime_filter_
+                          ? tab_->GetPageRecords(page_id_,
+                                GetOutSchema(),
+                                [this](const char *nullmap, const char *data) {
+                                  return runtime_filter_->MayMatch(
+                                      probe_encoder_, GetOutSchema(), nullmap, data, probe_key_.data());
+                                })
+                          : tab_->GetPageRecords(page_id_, GetOutSchema());
+    }
+  }
+  record_ = page_records_.empty() ? nullptr : std::move(page_records_[0]);
+}
+}  // namespace wsdb
@@ -21,19 +21,30 @@
 
 /**
  * @brief Iterate over all records in the table, check TableHandle for more details
- * 
+ *
+ * Records are read a page at a time, only the fields in the projected schema are materialized. Pages that cannot
+ * satisfy the skip conditions according to the zone map of the table are not fetched at all. If a join pushes a runtime
+ * filter down into the scan, rows whose key has no match in the join are dropped before they are materialized
  */
 
 #ifndef WSDB_EXECUTOR_SEQSCAN_H
 #define WSDB_EXECUTOR_SEQSCAN_H
 #include "executor_abstract.h"
+#include "expr/runtime_filter.h"
 #include "system/handle/table_handle.h"
 
 namespace wsdb {
 class SeqScanExecutor : public AbstractExecutor
 {
 public:
-  explicit SeqScanExecutor(TableHandle *tab);
+  /**
+   * @param tab
+   * @param proj_schema fields to materialize, nullptr means all fields of the table
+   * @param skip_conds conditions used to skip pages, records are not filtered by them
+   * @param runtime_filter filter published by a join above, nullptr if none
+   */
+  explicit SeqScanExecutor(TableHandle *tab, RecordSchemaUptr proj_schema = nullptr, ConditionVec skip_conds = {},
+      RuntimeFilterSptr runtime_filter = nullptr);
 
   void Init() override;
 
@@ -41,11 +52,26 @@ public:
 
   [[nodiscard]] auto IsEnd() const -> bool override;
 
+  /// whole pages are appended to the chunk, so a chunk may exceed CHUNK_SIZE by less than a page
+  auto NextBatch() -> ChunkUptr override;
+
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
 
 private:
-  TableHandle *tab_;
-  RID          rid_;
+  /// load records of the next non-empty page, record_ is set to nullptr if there is no more page
+  void LoadNextPage();
+
+private:
+  TableHandle            *tab_;
+  ConditionVec            skip_conds_;
+  page_id_t               page_id_;
+  std::vector<RecordUptr> page_records_;
+  size_t                  cursor_;
+  RuntimeFilterSptr       runtime_filter_;
+  // set by Init if the runtime filter has been published
+  bool              use_runtime_filter_{false};
+  SortKeyEncoder    probe_encoder_;
+  std::vector<char> probe_key_;
 };
 }  // namespace wsdb
 
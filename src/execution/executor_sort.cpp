@@ -19,6 +19,8 @@
 // Created by ziqi on 2024/8/5.
 //
 #include <unistd.h>
+#include <bit>
+#include <filesystem>
 #include "common/config.h"
 #include "executor_sort.h"
 
@@ -26,117 +28,339 @@ static long long sort_result_fresh_id_ = 0;
 #define SORT_FILE_PATH(obj_name) FILE_NAME(TMP_DIR, obj_name, TMP_SUFFIX)
 
 namespace wsdb {
-SortExecutor::SortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc)
+
+void SortRunMerger::Open(const std::vector<SortRunSlice> &slices)
+{
+  WSDB_ASSERT(slices.size() <= SORT_WAY_NUM, "too many runs to merge");
+  size_t rec_size = BITMAP_SIZE(schema_->GetFieldCount()) + schema_->GetRecordLength();
+  nodes_.clear();
+  nodes_.reserve(slices.size());
+  ends_.clear();
+  for (const auto &slice : slices) {
+    // the read buffer lives as long as the file, a small slice needs no more than its size
+    size_t buf_size = std::min(SORT_IO_BUFFER_SIZE, (slice.end_ - slice.begin_) * rec_size + 1);
+    std::shared_ptr<char[]> buf(new char[buf_size]);
+    auto file = std::shared_ptr<std::ifstream>(new std::ifstream, [buf](std::ifstream *f) { delete f; });
+    file->rdbuf()->pubsetbuf(buf.get(), static_cast<std::streamsize>(buf_size));
+    file->open(slice.file_name_, std::ios::binary);
+    if (!file->is_open()) {
+      WSDB_THROW(WSDB_FILE_NOT_OPEN, slice.file_name_);
+    }
+    file->seekg(static_cast<std::streamoff>(slice.begin_ * rec_size));
+    nodes_.emplace_back(std::move(file), schema_, slice.begin_);
+    ends_.push_back(slice.end_);
+  }
+  size_t num = nodes_.size();
+  keys_.resize(num * encoder_->GetKeySize());
+  for (size_t i = 0; i < num; ++i) {
+    LoadRecord(i);
+  }
+  // every match is first won by the virtual slice, then it is replaced by the real slices one by one
+  loser_tree_.assign(std::max<size_t>(num, 1), num);
+  for (size_t i = num; i-- > 0;) {
+    AdjustLoserTree(i);
+  }
+}
+
+void SortRunMerger::LoadRecord(size_t slice)
+{
+  auto &node = nodes_[slice];
+  if (node.LoadNextRecord(ends_[slice])) {
+    encoder_->Encode(*node.GetRecord(), keys_.data() + slice * encoder_->GetKeySize());
+  }
+}
+
+void SortRunMerger::Close()
+{
+  for (auto &node : nodes_) {
+    node.CloseFile();
+  }
+  nodes_.clear();
+  ends_.clear();
+  loser_tree_.clear();
+}
+
+auto SortRunMerger::Wins(size_t lhs, size_t rhs) const -> bool
+{
+  if (lhs == nodes_.size() || rhs == nodes_.size()) {
+    return lhs == nodes_.size();
+  }
+  const auto &lrec = nodes_[lhs].GetRecord();
+  const auto &rrec = nodes_[rhs].GetRecord();
+  if (lrec == nullptr || rrec == nullptr) {
+    return rrec == nullptr && (lrec != nullptr || lhs < rhs);
+  }
+  size_t key_size = encoder_->GetKeySize();
+  int    cmp      = encoder_->Compare(keys_.data() + lhs * key_size, keys_.data() + rhs * key_size);
+  return cmp < 0 || (cmp == 0 && lhs < rhs);
+}
+
+void SortRunMerger::AdjustLoserTree(size_t leaf)
+{
+  size_t winner = leaf;
+  for (size_t node = (leaf + nodes_.size()) / 2; node > 0; node /= 2) {
+    if (Wins(loser_tree_[node], winner)) {
+      std::swap(winner, loser_tree_[node]);
+    }
+  }
+  loser_tree_[0] = winner;
+}
+
+auto SortRunMerger::Pop() -> RecordUptr
+{
+  if (nodes_.empty()) {
+    return nullptr;
+  }
+  auto  winner = loser_tree_[0];
+  auto &node   = nodes_[winner];
+  if (node.GetRecord() == nullptr) {
+    return nullptr;
+  }
+  auto record = node.TakeRecord();
+  LoadRecord(winner);
+  AdjustLoserTree(winner);
+  return record;
+}
+
+void SortRunMerger::ReadKey(std::ifstream &file, const RecordSchema *schema, const SortKeyEncoder &encoder, size_t idx,
+    std::vector<char> &rec_buf, char *key)
+{
+  size_t nullmap_size = BITMAP_SIZE(schema->GetFieldCount());
+  rec_buf.resize(nullmap_size + schema->GetRecordLength());
+  file.seekg(static_cast<std::streamoff>(idx * rec_buf.size()));
+  if (!file.read(rec_buf.data(), static_cast<std::streamsize>(rec_buf.size()))) {
+    WSDB_THROW(WSDB_FILE_READ_ERROR, fmt::format("record {} of sort run", idx));
+  }
+  encoder.Encode(Record(schema, rec_buf.data(), rec_buf.data() + nullmap_size, INVALID_RID), key);
+}
+
+SortRunWriter::SortRunWriter(const std::string &file_name) : file_(file_name, std::ios::binary | std::ios::trunc)
+{
+  if (!file_.is_open()) {
+    WSDB_THROW(WSDB_FILE_NOT_OPEN, file_name);
+  }
+}
+
+SortRunWriter::SortRunWriter(const std::string &file_name, const RecordSchema *schema, size_t first_rec)
+    : file_(file_name, std::ios::binary | std::ios::in | std::ios::out)
+{
+  if (!file_.is_open()) {
+    WSDB_THROW(WSDB_FILE_NOT_OPEN, file_name);
+  }
+  size_t rec_size = BITMAP_SIZE(schema->GetFieldCount()) + schema->GetRecordLength();
+  file_.seekp(static_cast<std::streamoff>(first_rec * rec_size));
+}
+
+void SortRunWriter::Write(const Record &record)
+{
+  const auto *schema       = record.GetSchema();
+  size_t      nullmap_size = BITMAP_SIZE(schema->GetFieldCount());
+  if (buf_.size() + nullmap_size + schema->GetRecordLength() > SORT_IO_BUFFER_SIZE) {
+    Flush();
+  }
+  buf_.insert(buf_.end(), record.GetNullMap(), record.GetNullMap() + nullmap_size);
+  buf_.insert(buf_.end(), record.GetData(), record.GetData() + schema->GetRecordLength());
+}
+
+void SortRunWriter::Flush()
+{
+  if (!file_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()))) {
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR, "sort run");
+  }
+  buf_.clear();
+}
+
+SortExecutor::SortExecutor(
+    AbstractExecutorUptr child, RecordSchemaUptr key_schema, std::vector<bool> is_desc, size_t buffer_size)
     : AbstractExecutor(Basic),
       child_(std::move(child)),
       key_schema_(std::move(key_schema)),
       buf_idx_(0),
-      is_desc_(is_desc),
+      is_desc_(std::move(is_desc)),
       is_sorted_(false),
       is_merge_sort_(false),
-      max_rec_num_(SORT_BUFFER_SIZE / child_->GetOutSchema()->GetRecordLength()),
+      max_rec_num_(std::max<size_t>(buffer_size / child_->GetOutSchema()->GetRecordLength(), 1)),
       tmp_file_num_(0),
-      merge_result_file_(fmt::format("sort_result_{}", sort_result_fresh_id_++))
-{
-  // comment the line below after testing
-  //  max_rec_num_ = 10;
-}
+      merge_result_file_(fmt::format("sort_result_{}", sort_result_fresh_id_++)),
+      encoder_(child_->GetOutSchema(), key_schema_.get(), is_desc_),
+      merger_(child_->GetOutSchema(), &encoder_)
+{}
 
-SortExecutor::~SortExecutor()
-{
-  if (is_merge_sort_) {
-    // TODO: do some clean up, e.g. close the result file
-    WSDB_STUDENT_TODO(l2, f1);
-  }
-}
+SortExecutor::~SortExecutor() { Cleanup(); }
 
 void SortExecutor::Init()
 {
-  // TODO: decide whether to use merge sort according to the cardinality of the child. 
-  // leave is_merge_sort_ as false if you just want to use in-memory sort
-  is_merge_sort_ = false;
+  Cleanup();
+  child_->Init();
+  ReadBuffer();
+  SortBuffer();
+  // use merge sort if the child has more records than the buffer can hold
+  is_merge_sort_ = !child_->IsEnd();
   if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(l2, f1);
-  }
-  // WSDB_STUDENT_TODO(l2, t1);
-  else {
-    SortBuffer();
-    Next();
+    DumpBufferToFile(tmp_file_num_++);
+    while (!child_->IsEnd()) {
+      ReadBuffer();
+      SortBuffer();
+      DumpBufferToFile(tmp_file_num_++);
+    }
+    sort_buffer_.clear();
+    sort_buffer_.shrink_to_fit();
+    Merge();
+    LoadMergeResult();
   }
+  Next();
 }
 
 void SortExecutor::Next()
 {
   if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(L2, f1);
-  }
-  // WSDB_STUDENT_TODO(L2, t1);
-  else {
+    record_ = merger_.Pop();
+  } else {
     if (buf_idx_ < sort_buffer_.size()) {
       record_ = std::move(sort_buffer_[buf_idx_]);
       buf_idx_++;
-    }
-    else {
+    } else {
       record_ = nullptr;
     }
   }
 }
 
-auto SortExecutor::IsEnd() const -> bool
+auto SortExecutor::IsEnd() const -> bool { return record_ == nullptr; }
+
+auto SortExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
+
+/// methods below are only used for merge sort
+
+auto SortExecutor::GetSortFileName(size_t file_group, size_t file_idx) const -> std::string
+{
+  return SORT_FILE_PATH(fmt::format("{}_{}_{}", merge_result_file_, file_group, file_idx));
+}
+
+void SortExecutor::ReadBuffer()
 {
-  if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(L2, f1);
-  }
-  // WSDB_STUDENT_TODO(L2, t1);
-  else {
-    return (buf_idx_ > sort_buffer_.size() || record_ == nullptr);
+  sort_buffer_.clear();
+  for (; !child_->IsEnd() && sort_buffer_.size() < max_rec_num_; child_->Next()) {
+    sort_buffer_.push_back(child_->GetRecord());
   }
+  buf_idx_ = 0;
 }
 
-auto SortExecutor::Compare(const Record &lhs, const Record &rhs) const -> bool
+void SortExecutor::SortBuffer()
 {
-  auto lkey = std::make_unique<Record>(key_schema_.get(), lhs);
-  auto rkey = std::make_unique<Record>(key_schema_.get(), rhs);
-  return is_desc_ ? Record::Compare(*lkey, *rkey) > 0 : lkey->Compare(*lkey, *rkey) < 0;
+  // encode the keys once and sort small entries of key prefix and record index, the rest of the key is only compared
+  // if the prefixes are equal
+  size_t                 num = sort_buffer_.size();
+  std::vector<char>      keys(num * encoder_.GetKeySize());
+  std::vector<SortEntry> entries(num);
+  MakeEntries(0, num, keys, entries);
+  std::sort(entries.begin(), entries.end(), SortEntryLess{.keys_ = keys.data(), .key_size_ = encoder_.GetKeySize()});
+  ApplyEntries(entries);
 }
 
-auto SortExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
+void SortExecutor::MakeEntries(size_t begin, size_t end, std::vector<char> &keys, std::vector<SortEntry> &entries) const
+{
+  size_t key_size = encoder_.GetKeySize();
+  for (size_t i = begin; i < end; ++i) {
+    char *key = keys.data() + i * key_size;
+    encoder_.Encode(*sort_buffer_[i], key);
+    uint64_t prefix = 0;
+    memcpy(&prefix, key, std::min(key_size, sizeof(uint64_t)));
+    if constexpr (std::endian::native == std::endian::little) {
+      prefix = __builtin_bswap64(prefix);
+    }
+    entries[i] = {.prefix_ = prefix, .idx_ = i};
+  }
+}
 
-/// methods below are only used for merge sort
+void SortExecutor::ApplyEntries(const std::vector<SortEntry> &entries)
+{
+  std::vector<RecordUptr> sorted(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    sorted[i] = std::move(sort_buffer_[entries[i].idx_]);
+  }
+  sort_buffer_ = std::move(sorted);
+  buf_idx_     = 0;
+}
 
-auto SortExecutor::GetSortFileName(size_t file_group, size_t file_idx) const -> std::string
+void SortExecutor::DumpBufferToFile(size_t file_idx)
 {
-  return fmt::format("{}_{}_{}", merge_result_file_, file_group, file_idx);
+  SortRun       run{.file_name_ = GetSortFileName(0, file_idx), .rec_num_ = sort_buffer_.size()};
+  SortRunWriter writer(run.file_name_);
+  for (const auto &record : sort_buffer_) {
+    writer.Write(*record);
+  }
+  writer.Flush();
+  runs_.push_back(std::move(run));
 }
 
-void SortExecutor::SortBuffer() { 
-  // WSDB_STUDENT_TODO(L2, t1); 
+auto SortExecutor::FirstMergeWay() const -> size_t { return (runs_.size() - 2) % (SORT_WAY_NUM - 1) + 2; }
 
-  // Sort the buffer using the Compare method
-  std::vector<RecordUptr> temp;
-  for (child_->Init(); !child_->IsEnd(); child_->Next()) {
-    temp.push_back(child_->GetRecord());
+void SortExecutor::Merge()
+{
+  while (runs_.size() > SORT_WAY_NUM) {
+    // a pass merges consecutive runs from the front and queues the merged runs at the back, the first merge takes
+    // just enough runs so that all later merges are SORT_WAY_NUM-way. the runs a pass leaves are moved behind its
+    // merged runs, so that the runs stay in input order and records of equal keys as well
+    size_t pass_num = runs_.size();
+    for (size_t way = FirstMergeWay(); pass_num >= way && runs_.size() > SORT_WAY_NUM; way = SORT_WAY_NUM) {
+      MergeRuns(way);
+      pass_num -= way;
+    }
+    for (; pass_num > 0; --pass_num) {
+      runs_.push_back(std::move(runs_.front()));
+      runs_.pop_front();
+    }
   }
-  // Sort the buffer using the Compare method
-  std::sort(temp.begin(), temp.end(), [this](const RecordUptr &a, const RecordUptr& b) {
-    return Compare(*a, *b);
-  });
-  
-  sort_buffer_ = std::move(temp);
-  buf_idx_ = 0;  
 }
 
-void SortExecutor::DumpBufferToFile(size_t file_idx) { WSDB_STUDENT_TODO(L2, f1); }
+void SortExecutor::MergeRuns(size_t num)
+{
+  OpenRuns(num);
+  SortRun       run{.file_name_ = GetSortFileName(1, tmp_file_num_++), .rec_num_ = 0};
+  SortRunWriter writer(run.file_name_);
+  for (auto record = merger_.Pop(); record != nullptr; record = merger_.Pop()) {
+    writer.Write(*record);
+    run.rec_num_++;
+  }
+  writer.Flush();
+  CloseRuns();
+  runs_.push_back(std::move(run));
+}
 
-void SortExecutor::LoadMergeResult() { WSDB_STUDENT_TODO(L2, f1); }
+void SortExecutor::LoadMergeResult() { OpenRuns(runs_.size()); }
 
-void SortExecutor::Merge()
+void SortExecutor::OpenRuns(size_t num)
+{
+  WSDB_ASSERT(num <= runs_.size() && num <= SORT_WAY_NUM, "too many runs to merge");
+  std::vector<SortRunSlice> slices;
+  for (size_t i = 0; i < num; ++i) {
+    merge_runs_.push_back(std::move(runs_.front()));
+    runs_.pop_front();
+    slices.push_back({.file_name_ = merge_runs_.back().file_name_, .begin_ = 0, .end_ = merge_runs_.back().rec_num_});
+  }
+  merger_.Open(slices);
+}
+
+void SortExecutor::CloseRuns()
 {
-  // 1. create a heap according to is_desc_
-  // 2. read the first tuple from each file
-  // 3. pop the top of the heap and write to file: group 1, file: file_index
-  // run until all runs are exhausted, then read tuples from group 1, file 0, write to group 0, file 0 ...
-  WSDB_STUDENT_TODO(L2, f1);
+  merger_.Close();
+  for (const auto &run : merge_runs_) {
+    std::filesystem::remove(run.file_name_);
+  }
+  merge_runs_.clear();
+}
+
+void SortExecutor::Cleanup()
+{
+  CloseRuns();
+  for (const auto &run : runs_) {
+    std::error_code ec;
+    std::filesystem::remove(run.file_name_, ec);
+  }
+  runs_.clear();
+  sort_buffer_.clear();
+  buf_idx_       = 0;
+  is_merge_sort_ = false;
 }
 
-}  // namespace wsdb
\ No newline at end of file
+}  // namespace wsdb
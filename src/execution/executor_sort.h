@@ -22,34 +22,65 @@
 /**
  * @brief Sort the records returned by the child executor
  *
+ * If the input does not fit in SORT_BUFFER_SIZE, it is sorted in runs of the buffer size that are written to tmp files,
+ * then the runs are merged SORT_WAY_NUM at a time with a loser tree. The last merge pass is not written back but
+ * streamed to the parent. Records of equal keys are in input order within a run and in run order within a merge, so
+ * the output only depends on the input order.
  */
 
 #ifndef WSDB_EXECUTOR_SORT_H
 #define WSDB_EXECUTOR_SORT_H
+#include <deque>
 #include <functional>
 #include <fstream>
+#include <string>
 #include <utility>
 #include "executor_abstract.h"
+#include "expr/sort_key.h"
 
 namespace wsdb {
 
-class SortExecutor : public AbstractExecutor
+/// a sorted run in a tmp file
+struct SortRun
 {
-public:
-  SortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc);
+  std::string file_name_;
+  size_t      rec_num_;
+};
 
-  ~SortExecutor() override;
+/// records [begin_, end_) of a sorted run
+struct SortRunSlice
+{
+  std::string file_name_;
+  size_t      begin_;
+  size_t      end_;
+};
 
-  void Init() override;
+/**
+ * @brief Merge slices of sorted runs with a loser tree
+ *
+ * Records of equal keys are returned in the order of their slices, so merging the runs of a stable sort in input
+ * order is stable as well.
+ */
+class SortRunMerger
+{
+public:
+  SortRunMerger(const RecordSchema *schema, const SortKeyEncoder *encoder) : schema_(schema), encoder_(encoder) {}
 
-  void Next() override;
+  /// open at most SORT_WAY_NUM slices and build the loser tree over them
+  void Open(const std::vector<SortRunSlice> &slices);
 
-  [[nodiscard]] auto IsEnd() const -> bool override;
+  /// pop the smallest record of the open slices, nullptr if all of them are exhausted
+  auto Pop() -> RecordUptr;
 
-  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+  /// close the open slices, the files are left as they are
+  void Close();
+
+  /// read the idx-th record of a run file and encode its key
+  static void ReadKey(std::ifstream &file, const RecordSchema *schema, const SortKeyEncoder &encoder, size_t idx,
+      std::vector<char> &rec_buf, char *key);
 
 private:
-  /// @brief  Sort heap node for merge sort algorithm, ignore it in l2.t1
+  /// @brief  A slice being merged and its current record, a leaf of the loser tree
   class SortHeapNode
   {
   public:
@@ -64,7 +95,7 @@ private:
       file_handle_ = other.file_handle_;
       schema_      = other.schema_;
       rec_idx_     = other.rec_idx_;
-      record_      = std::make_unique<Record>(*other.record_);
+      record_      = other.record_ == nullptr ? nullptr : std::make_unique<Record>(*other.record_);
     }
 
     SortHeapNode(SortHeapNode &&other) noexcept
@@ -83,7 +114,7 @@ private:
       file_handle_ = other.file_handle_;
       schema_      = other.schema_;
       rec_idx_     = other.rec_idx_;
-      record_      = std::make_unique<Record>(*other.record_);
+      record_      = other.record_ == nullptr ? nullptr : std::make_unique<Record>(*other.record_);
       return *this;
     }
 
@@ -96,12 +127,26 @@ private:
     {
       WSDB_ASSERT(file_handle_ != nullptr, "file_handle_ is nullptr");
       WSDB_ASSERT(file_handle_->is_open(), "file_handle_ is not open");
-
-      WSDB_STUDENT_TODO(l2, f1);
+      record_ = nullptr;
+      if (rec_idx_ >= max_rec_num) {
+        return false;
+      }
+      // a record is stored as null map followed by data
+      size_t nullmap_size = BITMAP_SIZE(schema_->GetFieldCount());
+      rec_buf_.resize(nullmap_size + schema_->GetRecordLength());
+      if (!file_handle_->read(rec_buf_.data(), static_cast<std::streamsize>(rec_buf_.size()))) {
+        WSDB_THROW(WSDB_FILE_READ_ERROR, fmt::format("record {} of sort run", rec_idx_));
+      }
+      record_ = std::make_unique<Record>(schema_, rec_buf_.data(), rec_buf_.data() + nullmap_size, INVALID_RID);
+      rec_idx_++;
+      return true;
     }
 
     [[nodiscard]] auto GetRecord() const -> const RecordUptr & { return record_; }
 
+    /// move the current record out, LoadNextRecord should be called before the next access
+    auto TakeRecord() -> RecordUptr { return std::move(record_); }
+
     void CloseFile()
     {
       WSDB_ASSERT(file_handle_ != nullptr, "file_handle_ is nullptr");
@@ -113,28 +158,143 @@ private:
     std::shared_ptr<std::ifstream> file_handle_;
     const RecordSchema            *schema_;   // schema of the record
     size_t                         rec_idx_;  // index of the record in the file
-    RecordUptr                     record_;   // record
+    RecordUptr                     record_;   // record, nullptr if the run is exhausted
+    std::vector<char>              rec_buf_;  // raw record read from the file
   };
 
+  /// load the next record of an open slice and encode its key
+  void LoadRecord(size_t slice);
+
+  /// whether the current record of slice lhs goes before that of slice rhs, an exhausted slice goes last
+  [[nodiscard]] auto Wins(size_t lhs, size_t rhs) const -> bool;
+
+  /// replay the matches from leaf to the root of the loser tree
+  void AdjustLoserTree(size_t leaf);
+
 private:
-  [[nodiscard]] inline auto GetSortFileName(size_t file_group, size_t file_idx) const -> std::string;
+  const RecordSchema       *schema_;
+  const SortKeyEncoder     *encoder_;
+  std::vector<size_t>       ends_;   // end of each open slice
+  std::vector<SortHeapNode> nodes_;  // current record of each open slice
+  // loser_tree_[0] is the winner, loser_tree_[i] is the loser of the match at node i, nodes_.size() is a virtual
+  // slice that wins all matches, it is only used when building the tree
+  std::vector<size_t> loser_tree_;
+  std::vector<char>   keys_;  // normalized key of the current record of each open slice
+};
 
-  [[nodiscard]] inline auto Compare(const Record &lhs, const Record &rhs) const -> bool;
+/// buffered writer of records to a run file
+class SortRunWriter
+{
+public:
+  /// create the file, or overwrite it if it exists
+  explicit SortRunWriter(const std::string &file_name);
 
+  /// write into an existing file from the first_rec-th record on, so that slices of a run can be written in parallel
+  SortRunWriter(const std::string &file_name, const RecordSchema *schema, size_t first_rec);
+
+  void Write(const Record &record);
+
+  /// write the buffered records to the file
+  void Flush();
+
+private:
+  std::ofstream     file_;
+  std::vector<char> buf_;
+};
+
+class SortExecutor : public AbstractExecutor
+{
+public:
+  SortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, std::vector<bool> is_desc,
+      size_t buffer_size = SORT_BUFFER_SIZE);
+
+  ~SortExecutor() override;
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+
+protected:
+  /// an entry of the in-memory sort, prefix_ is the first bytes of the normalized key in big-endian
+  struct SortEntry
+  {
+    uint64_t prefix_;
+    size_t   idx_;
+  };
+
+  /// order of entries whose keys are in keys_, entries of equal keys are in input order so the sort is stable
+  struct SortEntryLess
+  {
+    const char *keys_;
+    size_t      key_size_;
+
+    auto operator()(const SortEntry &a, const SortEntry &b) const -> bool
+    {
+      if (a.prefix_ != b.prefix_) {
+        return a.prefix_ < b.prefix_;
+      }
+      if (key_size_ > sizeof(uint64_t)) {
+        int cmp = memcmp(keys_ + a.idx_ * key_size_ + sizeof(uint64_t),
+            keys_ + b.idx_ * key_size_ + sizeof(uint64_t),
+            key_size_ - sizeof(uint64_t));
+        if (cmp != 0) {
+          return cmp < 0;
+        }
+      }
+      return a.idx_ < b.idx_;
+    }
+  };
+
+protected:
+  /// path of the idx-th tmp file of a group, runs of the buffer are in group 0 and merged runs in group 1
+  [[nodiscard]] auto GetSortFileName(size_t file_group, size_t file_idx) const -> std::string;
+
+  /// read at most max_rec_num_ records from the child into the buffer
+  void ReadBuffer();
+
+  /// sort the buffer
   void SortBuffer();
 
+  /// encode the keys of the buffered records [begin, end) into keys and make their entries
+  void MakeEntries(size_t begin, size_t end, std::vector<char> &keys, std::vector<SortEntry> &entries) const;
+
+  /// reorder the buffer by the sorted entries
+  void ApplyEntries(const std::vector<SortEntry> &entries);
+
+  /// write the sorted buffer as a run
   void DumpBufferToFile(size_t file_idx);
 
+  /// open the remaining runs for the last merge pass, whose result is returned by Next
   void LoadMergeResult();
 
-  inline void Merge();
+  /// merge runs until at most SORT_WAY_NUM runs are left
+  void Merge();
 
-private:
+  /// merge the first num runs into a new run at the back of runs_
+  virtual void MergeRuns(size_t num);
+
+  /// number of runs to merge first, so that all later merges are SORT_WAY_NUM-way
+  [[nodiscard]] auto FirstMergeWay() const -> size_t;
+
+  /// open the first num runs for merging
+  void OpenRuns(size_t num);
+
+  /// close the open runs and remove their files
+  void CloseRuns();
+
+  /// remove all tmp files
+  void Cleanup();
+
+protected:
   AbstractExecutorUptr    child_;
   RecordSchemaUptr        key_schema_;
   std::vector<RecordUptr> sort_buffer_;
   size_t                  buf_idx_;
-  bool                    is_desc_;
+  std::vector<bool>       is_desc_;  // direction of each key field
   bool                    is_sorted_;
   // use for merge sort, if you want to use merge sort, set it to true if the record number is larger than max_rec_num_
   bool        is_merge_sort_;
@@ -142,7 +302,10 @@ private:
   size_t      tmp_file_num_;
   std::string merge_result_file_;
   // we use file stream instead of disk manager to obtain faster sort speed;
-  std::unique_ptr<std::ifstream> merge_result_file_handle_;
+  std::deque<SortRun>  runs_;        // runs waiting to be merged
+  std::vector<SortRun> merge_runs_;  // runs being merged
+  SortKeyEncoder       encoder_;
+  SortRunMerger        merger_;
 };
 
 }  // namespace wsdb
@@ -0,0 +1,359 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_sort_parallel.h"
+#include <algorithm>
+#include <filesystem>
+#include <numeric>
+
+namespace wsdb {
+
+ParallelSortExecutor::ParallelSortExecutor(
+    AbstractExecutorUptr child, RecordSchemaUptr key_schema, std::vector<bool> is_desc, size_t buffer_size)
+    : SortExecutor(std::move(child), std::move(key_schema), std::move(is_desc), buffer_size)
+{
+  worker_num_ = group_.GetScheduler()->GetWorkerNum();
+}
+
+void ParallelSortExecutor::Init()
+{
+  // a failed or cancelled run leaves the group cancelled
+  group_.Reset();
+  Cleanup();
+  last_bounds_.clear();
+  next_range_   = 0;
+  is_streaming_ = false;
+  child_->Init();
+  ReadBuffer();
+  SortBufferInParallel();
+  // use merge sort if the child has more records than the buffer can hold
+  is_merge_sort_ = !child_->IsEnd();
+  if (is_merge_sort_) {
+    DumpBufferInParallel(tmp_file_num_++);
+    while (!child_->IsEnd()) {
+      ReadBuffer();
+      SortBufferInParallel();
+      DumpBufferInParallel(tmp_file_num_++);
+    }
+    sort_buffer_.clear();
+    sort_buffer_.shrink_to_fit();
+    Merge();
+    SplitLastMerge();
+  }
+  Next();
+}
+
+void ParallelSortExecutor::Next()
+{
+  if (!is_merge_sort_) {
+    SortExecutor::Next();
+    return;
+  }
+  while (true) {
+    if (is_streaming_) {
+      record_ = merger_.Pop();
+      if (record_ != nullptr) {
+        return;
+      }
+      merger_.Close();
+      is_streaming_ = false;
+    }
+    if (buf_idx_ < sort_buffer_.size()) {
+      record_ = std::move(sort_buffer_[buf_idx_++]);
+      return;
+    }
+    if (next_range_ + 1 >= last_bounds_.size()) {
+      record_ = nullptr;
+      return;
+    }
+    LoadRanges();
+  }
+}
+
+void ParallelSortExecutor::SortBufferInParallel()
+{
+  size_t num       = sort_buffer_.size();
+  size_t slice_num = TaskNum(num, worker_num_);
+  if (slice_num < 2) {
+    SortBuffer();
+    return;
+  }
+  std::vector<char>      keys(num * encoder_.GetKeySize());
+  std::vector<SortEntry> entries(num);
+  SortEntryLess          less{.keys_ = keys.data(), .key_size_ = encoder_.GetKeySize()};
+  std::vector<size_t>    bounds(slice_num + 1);
+  for (size_t i = 0; i <= slice_num; ++i) {
+    bounds[i] = num * i / slice_num;
+  }
+  for (size_t i = 0; i < slice_num; ++i) {
+    group_.Run([this, &keys, &entries, &less, begin = bounds[i], end = bounds[i + 1]]() {
+      MakeEntries(begin, end, keys, entries);
+      std::sort(entries.begin() + begin, entries.begin() + end, less);
+    });
+  }
+  WaitTasks();
+  // merge adjacent slices pairwise, entries of equal keys stay in input order as the slices are in input order
+  std::vector<SortEntry> merged(num);
+  for (size_t width = 1; width < slice_num; width *= 2) {
+    for (size_t i = 0; i < slice_num; i += 2 * width) {
+      auto lo  = bounds[i];
+      auto mid = bounds[std::min(i + width, slice_num)];
+      auto hi  = bounds[std::min(i + 2 * width, slice_num)];
+      group_.Run([&entries, &merged, &less, lo, mid, hi]() {
+        std::merge(entries.begin() + lo,
+            entries.begin() + mid,
+            entries.begin() + mid,
+            entries.begin() + hi,
+            merged.begin() + lo,
+            less);
+      });
+    }
+    WaitTasks();
+    entries.swap(merged);
+  }
+  ApplyEntries(entries);
+}
+
+void ParallelSortExecutor::DumpBufferInParallel(size_t file_idx)
+{
+  SortRun run{.file_name_ = GetSortFileName(0, file_idx), .rec_num_ = sort_buffer_.size()};
+  CreateRunFile(run.file_name_, run.rec_num_);
+  // the run is in runs_ from now on, so it is removed by Cleanup if the tasks fail
+  runs_.push_back(run);
+  size_t slice_num = TaskNum(run.rec_num_, worker_num_);
+  for (size_t i = 0; i < slice_num; ++i) {
+    size_t begin = run.rec_num_ * i / slice_num;
+    size_t end   = run.rec_num_ * (i + 1) / slice_num;
+    group_.Run([this, &run, begin, end]() {
+      SortRunWriter writer(run.file_name_, GetOutSchema(), begin);
+      for (size_t j = begin; j < end; ++j) {
+        writer.Write(*sort_buffer_[j]);
+      }
+      writer.Flush();
+    });
+  }
+  WaitTasks();
+}
+
+void ParallelSortExecutor::MergeRuns(size_t num)
+{
+  for (size_t i = 0; i < num; ++i) {
+    merge_runs_.push_back(std::move(runs_.front()));
+    runs_.pop_front();
+  }
+  size_t total = 0;
+  for (const auto &merge_run : merge_runs_) {
+    total += merge_run.rec_num_;
+  }
+  auto    bounds    = SplitRuns(TaskNum(total, 2 * worker_num_));
+  size_t  range_num = bounds.size() - 1;
+  SortRun run{.file_name_ = GetSortFileName(1, tmp_file_num_++), .rec_num_ = 0};
+  for (const auto &merge_run : merge_runs_) {
+    run.rec_num_ += merge_run.rec_num_;
+  }
+  CreateRunFile(run.file_name_, run.rec_num_);
+  runs_.push_back(run);
+  for (size_t p = 0, first_rec = 0; p < range_num; ++p) {
+    std::vector<SortRunSlice> slices;
+    size_t                    rec_num = 0;
+    for (size_t r = 0; r < merge_runs_.size(); ++r) {
+      slices.push_back({.file_name_ = merge_runs_[r].file_name_, .begin_ = bounds[p][r], .end_ = bounds[p + 1][r]});
+      rec_num += bounds[p + 1][r] - bounds[p][r];
+    }
+    if (rec_num > 0) {
+      group_.Run([this, &run, slices = std::move(slices), first_rec]() {
+        SortRunMerger merger(GetOutSchema(), &encoder_);
+        merger.Open(slices);
+        SortRunWriter writer(run.file_name_, GetOutSchema(), first_rec);
+        for (auto record = merger.Pop(); record != nullptr; record = merger.Pop()) {
+          writer.Write(*record);
+        }
+        writer.Flush();
+        merger.Close();
+      });
+    }
+    first_rec += rec_num;
+  }
+  WaitTasks();
+  CloseRuns();
+}
+
+void ParallelSortExecutor::SplitLastMerge()
+{
+  size_t total = 0;
+  for (const auto &run : runs_) {
+    total += run.rec_num_;
+  }
+  while (!runs_.empty()) {
+    merge_runs_.push_back(std::move(runs_.front()));
+    runs_.pop_front();
+  }
+  // ranges are merged into the buffer a few at a time, so they are made small enough for the workers to share it
+  size_t range_rec_num = std::max<size_t>(max_rec_num_ / worker_num_, 1);
+  size_t range_num     = std::max(2 * worker_num_, (total + range_rec_num - 1) / range_rec_num);
+  last_bounds_         = SplitRuns(TaskNum(total, range_num));
+  next_range_          = 0;
+}
+
+void ParallelSortExecutor::LoadRanges()
+{
+  sort_buffer_.clear();
+  buf_idx_ = 0;
+  // a range larger than the buffer is streamed by a single merge, as SortExecutor does with the whole last pass
+  if (RangeRecNum(next_range_) > max_rec_num_) {
+    merger_.Open(RangeSlices(next_range_++));
+    is_streaming_ = true;
+    return;
+  }
+  size_t range_end = next_range_;
+  size_t rec_num   = 0;
+  for (; range_end + 1 < last_bounds_.size() && rec_num + RangeRecNum(range_end) <= max_rec_num_; ++range_end) {
+    rec_num += RangeRecNum(range_end);
+  }
+  sort_buffer_.resize(rec_num);
+  for (size_t p = next_range_, first_rec = 0; p < range_end; ++p) {
+    size_t range_rec_num = RangeRecNum(p);
+    if (range_rec_num > 0) {
+      group_.Run([this, slices = RangeSlices(p), first_rec]() {
+        SortRunMerger merger(GetOutSchema(), &encoder_);
+        merger.Open(slices);
+        size_t idx = first_rec;
+        for (auto record = merger.Pop(); record != nullptr; record = merger.Pop()) {
+          sort_buffer_[idx++] = std::move(record);
+        }
+        merger.Close();
+      });
+    }
+    first_rec += range_rec_num;
+  }
+  WaitTasks();
+  next_range_ = range_end;
+}
+
+auto ParallelSortExecutor::RangeSlices(size_t p) const -> std::vector<SortRunSlice>
+{
+  std::vector<SortRunSlice> slices;
+  for (size_t r = 0; r < merge_runs_.size(); ++r) {
+    slices.push_back(
+        {.file_name_ = merge_runs_[r].file_name_, .begin_ = last_bounds_[p][r], .end_ = last_bounds_[p + 1][r]});
+  }
+  return slices;
+}
+
+auto ParallelSortExecutor::RangeRecNum(size_t p) const -> size_t
+{
+  size_t rec_num = 0;
+  for (size_t r = 0; r < merge_runs_.size(); ++r) {
+    rec_num += last_bounds_[p + 1][r] - last_bounds_[p][r];
+  }
+  return rec_num;
+}
+
+auto ParallelSortExecutor::SplitRuns(size_t range_num) -> std::vector<std::vector<size_t>>
+{
+  const auto *schema   = GetOutSchema();
+  size_t      run_num  = merge_runs_.size();
+  size_t      key_size = encoder_.GetKeySize();
+  size_t      total    = 0;
+  for (const auto &run : merge_runs_) {
+    total += run.rec_num_;
+  }
+  std::vector<std::vector<size_t>> bounds(range_num + 1, std::vector<size_t>(run_num, 0));
+  for (size_t r = 0; r < run_num; ++r) {
+    bounds[range_num][r] = merge_runs_[r].rec_num_;
+  }
+  if (range_num < 2) {
+    return bounds;
+  }
+  std::vector<std::ifstream> files(run_num);
+  for (size_t r = 0; r < run_num; ++r) {
+    files[r].open(merge_runs_[r].file_name_, std::ios::binary);
+    if (!files[r].is_open()) {
+      WSDB_THROW(WSDB_FILE_NOT_OPEN, merge_runs_[r].file_name_);
+    }
+  }
+  // sample keys evenly from each run, in proportion to the size of the run
+  std::vector<char> rec_buf;
+  std::vector<char> samples;
+  size_t            sample_total = range_num * SAMPLE_PER_RANGE;
+  for (size_t r = 0; r < run_num; ++r) {
+    size_t rec_num    = merge_runs_[r].rec_num_;
+    size_t sample_num = std::min(rec_num, std::max<size_t>(sample_total * rec_num / total, 1));
+    for (size_t i = 0; i < sample_num; ++i) {
+      samples.resize(samples.size() + key_size);
+      SortRunMerger::ReadKey(files[r],
+          schema,
+          encoder_,
+          rec_num * (2 * i + 1) / (2 * sample_num),
+          rec_buf,
+          samples.data() + samples.size() - key_size);
+    }
+  }
+  size_t              sample_num = samples.size() / key_size;
+  std::vector<size_t> order(sample_num);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&samples, key_size](size_t a, size_t b) {
+    return memcmp(samples.data() + a * key_size, samples.data() + b * key_size, key_size) < 0;
+  });
+  // range p starts at the first record not less than its splitter, so records of equal keys are in the same range
+  std::vector<char> key(key_size);
+  for (size_t p = 1; p < range_num; ++p) {
+    const char *splitter = samples.data() + order[p * sample_num / range_num] * key_size;
+    for (size_t r = 0; r < run_num; ++r) {
+      size_t lo = bounds[p - 1][r];
+      size_t hi = merge_runs_[r].rec_num_;
+      while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        SortRunMerger::ReadKey(files[r], schema, encoder_, mid, rec_buf, key.data());
+        if (encoder_.Compare(key.data(), splitter) < 0) {
+          lo = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      bounds[p][r] = lo;
+    }
+  }
+  return bounds;
+}
+
+void ParallelSortExecutor::CreateRunFile(const std::string &file_name, size_t rec_num) const
+{
+  std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    WSDB_THROW(WSDB_FILE_NOT_OPEN, file_name);
+  }
+  file.close();
+  const auto *schema = GetOutSchema();
+  std::filesystem::resize_file(file_name, rec_num * (BITMAP_SIZE(schema->GetFieldCount()) + schema->GetRecordLength()));
+}
+
+auto ParallelSortExecutor::TaskNum(size_t num, size_t max_num) -> size_t
+{
+  return std::max<size_t>(std::min(max_num, num / CHUNK_SIZE), 1);
+}
+
+void ParallelSortExecutor::WaitTasks()
+{
+  group_.Wait();
+  // groups are only cancelled without an error when the client is gone
+  if (group_.IsCancelled()) {
+    WSDB_THROW(WSDB_CLIENT_DOWN, "");
+  }
+}
+
+}  // namespace wsdb
@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Sort with the steps of SortExecutor split into tasks of the Scheduler
+ *
+ * The runs and merge passes are those of SortExecutor. The buffer is sorted in slices by several tasks and the slices
+ * are merged pairwise, then the run is written in slices at their offsets of the file. A merge is split by key range:
+ * splitter keys are sampled from the runs, each splitter is located in each run by binary search, and each range is
+ * merged by a task into its offset of the merged run. Ties are broken the same way as SortExecutor does, so the
+ * output is the same. The last merge pass is not written back: it is split into key ranges as well, and consecutive
+ * ranges that fit in the buffer together are merged into memory in parallel and returned in range order, while a range
+ * too large for the buffer, e.g. of many equal keys, is streamed to the parent by a single merge.
+ */
+
+#ifndef WSDB_EXECUTOR_SORT_PARALLEL_H
+#define WSDB_EXECUTOR_SORT_PARALLEL_H
+
+#include "executor_sort.h"
+#include "system/scheduler.h"
+
+namespace wsdb {
+
+class ParallelSortExecutor : public SortExecutor
+{
+public:
+  ParallelSortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, std::vector<bool> is_desc,
+      size_t buffer_size = SORT_BUFFER_SIZE);
+
+  void Init() override;
+
+  void Next() override;
+
+private:
+  /// sort the buffer by slices in parallel
+  void SortBufferInParallel();
+
+  /// write the sorted buffer as a run by slices in parallel
+  void DumpBufferInParallel(size_t file_idx);
+
+  /// key ranges of the runs are merged in parallel
+  void MergeRuns(size_t num) override;
+
+  /// split the runs being merged into range_num key ranges, range p of run r is [bounds[p][r], bounds[p + 1][r])
+  auto SplitRuns(size_t range_num) -> std::vector<std::vector<size_t>>;
+
+  /// split the runs left for the last merge pass into the key ranges returned by Next
+  void SplitLastMerge();
+
+  /// merge the next ranges of the last pass into the buffer in parallel, or open the next range for streaming
+  void LoadRanges();
+
+  /// slices of the runs being merged in range p
+  auto RangeSlices(size_t p) const -> std::vector<SortRunSlice>;
+
+  /// number of records of the runs being merged in range p
+  auto RangeRecNum(size_t p) const -> size_t;
+
+  /// create a run file of rec_num records, so that its slices can be written at their offsets
+  void CreateRunFile(const std::string &file_name, size_t rec_num) const;
+
+  /// number of tasks to split num records into, each task takes CHUNK_SIZE records at least
+  static auto TaskNum(size_t num, size_t max_num) -> size_t;
+
+  /// wait for the tasks, throw if they are cancelled
+  void WaitTasks();
+
+private:
+  // keys sampled from the runs of a merge for each key range
+  static constexpr size_t SAMPLE_PER_RANGE = 16;
+
+  size_t worker_num_;
+  // key ranges of the last merge pass, see SplitRuns, and the next range to load
+  std::vector<std::vector<size_t>> last_bounds_;
+  size_t                           next_range_{0};
+  bool                             is_streaming_{false};  // whether merger_ streams a range of the last pass
+  TaskGroup                        group_;  // destroyed first, so the tasks are done before the buffer is gone
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_SORT_PARALLEL_H
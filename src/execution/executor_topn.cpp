@@ -0,0 +1,108 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_topn.h"
+#include <algorithm>
+
+namespace wsdb {
+
+TopNExecutor::TopNExecutor(
+    AbstractExecutorUptr child, RecordSchemaUptr key_schema, std::vector<bool> is_desc, size_t limit)
+    : AbstractExecutor(Basic),
+      child_(std::move(child)),
+      key_schema_(std::move(key_schema)),
+      limit_(limit),
+      encoder_(child_->GetOutSchema(), key_schema_.get(), is_desc),
+      key_size_(encoder_.GetKeySize()),
+      key_buf_(encoder_.GetKeySize()),
+      seq_(0),
+      cursor_(0)
+{}
+
+void TopNExecutor::Init()
+{
+  keys_.clear();
+  seqs_.clear();
+  recs_.clear();
+  heap_.clear();
+  seq_    = 0;
+  cursor_ = 0;
+  child_->Init();
+  auto before = [this](size_t lhs, size_t rhs) { return Before(lhs, rhs); };
+  // the child is read in chunks so that the keys are encoded from the columns without materializing records
+  for (auto chunk = child_->NextBatch(); chunk != nullptr && limit_ > 0; chunk = child_->NextBatch()) {
+    for (size_t i = 0; i < chunk->GetSize(); ++i, ++seq_) {
+      auto row = chunk->RowAt(i);
+      for (size_t f = 0; f < encoder_.GetFieldCount(); ++f) {
+        auto col = encoder_.GetColIdx(f);
+        encoder_.EncodeField(f,
+            chunk->GetColData(col) + row * encoder_.GetFieldSize(f),
+            BitMap::GetBit(chunk->GetColNullMap(col), row),
+            key_buf_.data());
+      }
+      Offer(*chunk, i);
+    }
+  }
+  std::sort_heap(heap_.begin(), heap_.end(), before);
+  Next();
+}
+
+void TopNExecutor::Offer(const Chunk &chunk, size_t i)
+{
+  auto before = [this](size_t lhs, size_t rhs) { return Before(lhs, rhs); };
+  size_t slot;
+  if (heap_.size() < limit_) {
+    slot = recs_.size();
+    keys_.resize(keys_.size() + key_size_);
+    seqs_.push_back(0);
+    recs_.emplace_back();
+  } else {
+    // the row comes after all kept ones, so it is dropped unless its key is strictly smaller than the largest
+    slot = heap_.front();
+    if (memcmp(key_buf_.data(), keys_.data() + slot * key_size_, key_size_) >= 0) {
+      return;
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), before);
+    heap_.pop_back();
+  }
+  memcpy(keys_.data() + slot * key_size_, key_buf_.data(), key_size_);
+  seqs_[slot] = seq_;
+  recs_[slot] = chunk.GetRecord(i);
+  heap_.push_back(slot);
+  std::push_heap(heap_.begin(), heap_.end(), before);
+}
+
+auto TopNExecutor::Before(size_t lhs, size_t rhs) const -> bool
+{
+  int cmp = memcmp(keys_.data() + lhs * key_size_, keys_.data() + rhs * key_size_, key_size_);
+  return cmp < 0 || (cmp == 0 && seqs_[lhs] < seqs_[rhs]);
+}
+
+void TopNExecutor::Next()
+{
+  if (cursor_ < heap_.size()) {
+    record_ = std::move(recs_[heap_[cursor_++]]);
+  } else {
+    record_ = nullptr;
+  }
+}
+
+auto TopNExecutor::IsEnd() const -> bool { return record_ == nullptr; }
+
+auto TopNExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
+
+}  // namespace wsdb
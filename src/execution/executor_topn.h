@@ -0,0 +1,71 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Return the first limit records of the child in the order of the key fields, i.e. a sort followed by a limit
+ *
+ * Only the best limit records seen so far are kept, in a max-heap on their normalized keys (see SortKeyEncoder), so
+ * the input is read once in O(n log limit) time with O(limit) memory instead of being fully sorted. Records with equal
+ * keys are returned in input order. A record is materialized only if it enters the heap.
+ */
+
+#ifndef WSDB_EXECUTOR_TOPN_H
+#define WSDB_EXECUTOR_TOPN_H
+
+#include "executor_abstract.h"
+#include "expr/sort_key.h"
+
+namespace wsdb {
+
+class TopNExecutor : public AbstractExecutor
+{
+public:
+  TopNExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, std::vector<bool> is_desc, size_t limit);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+
+private:
+  /// whether the record in slot lhs goes before that in slot rhs
+  [[nodiscard]] auto Before(size_t lhs, size_t rhs) const -> bool;
+
+  /// keep the row i of chunk if its key, which is in key_buf_, is among the best ones seen so far
+  void Offer(const Chunk &chunk, size_t i);
+
+private:
+  AbstractExecutorUptr    child_;
+  RecordSchemaUptr        key_schema_;
+  size_t                  limit_;
+  SortKeyEncoder          encoder_;
+  size_t                  key_size_;
+  std::vector<char>       keys_;     // normalized key of the record in each slot
+  std::vector<size_t>     seqs_;     // input position of the record in each slot, breaks ties of keys
+  std::vector<RecordUptr> recs_;     // kept records
+  std::vector<size_t>     heap_;     // slots, a max-heap while reading the child, sorted afterwards
+  std::vector<char>       key_buf_;  // key of the row being offered
+  size_t                  seq_;      // number of rows read from the child
+  size_t                  cursor_;   // next position in heap_ to return
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_TOPN_H
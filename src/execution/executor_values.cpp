@@ -0,0 +1,45 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+#include "executor_values.h"
+
+namespace wsdb {
+
+ValuesExecutor::ValuesExecutor(RecordSchemaUptr schema, const std::vector<std::vector<ValueSptr>> &rows)
+    : AbstractExecutor(Basic)
+{
+  out_schema_ = std::move(schema);
+  records_.reserve(rows.size());
+  for (const auto &row : rows) {
+    records_.push_back(std::make_unique<Record>(out_schema_.get(), row, INVALID_RID));
+  }
+}
+
+void ValuesExecutor::Init()
+{
+  cursor_ = 0;
+  record_ = cursor_ < records_.size() ? std::make_unique<Record>(*records_[cursor_]) : nullptr;
+}
+
+void ValuesExecutor::Next()
+{
+  cursor_++;
+  record_ = cursor_ < records_.size() ? std::make_unique<Record>(*records_[cursor_]) : nullptr;
+}
+
+auto ValuesExecutor::IsEnd() const -> bool { return record_ == nullptr; }
+
+}  // namespace wsdb
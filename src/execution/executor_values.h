@@ -0,0 +1,47 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+/**
+ * @brief Return constant records, e.g. the values of an IN list
+ *
+ */
+
+#ifndef WSDB_EXECUTOR_VALUES_H
+#define WSDB_EXECUTOR_VALUES_H
+
+#include "executor_abstract.h"
+
+namespace wsdb {
+
+class ValuesExecutor : public AbstractExecutor
+{
+public:
+  ValuesExecutor(RecordSchemaUptr schema, const std::vector<std::vector<ValueSptr>> &rows);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  std::vector<RecordUptr> records_;
+  size_t                  cursor_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_VALUES_H
@@ -0,0 +1,132 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+#include "pipeline.h"
+#include "executor.h"
+
+namespace wsdb {
+
+namespace {
+
+/// a limit, a projection and filters over a source, from the top down
+struct PipelineShape
+{
+  std::shared_ptr<LimitPlan>               limit_;
+  std::shared_ptr<ProjectPlan>             proj_;
+  std::vector<std::shared_ptr<FilterPlan>> filters_;
+  std::shared_ptr<AbstractPlan>            source_;
+};
+
+/// @return false if there is no operator over the source, which is not worth a pipeline
+auto MatchPipeline(const std::shared_ptr<AbstractPlan> &plan, PipelineShape &shape) -> bool
+{
+  auto node = plan;
+  if (auto limit = std::dynamic_pointer_cast<LimitPlan>(node)) {
+    shape.limit_ = limit;
+    node         = limit->child_;
+  }
+  if (auto proj = std::dynamic_pointer_cast<ProjectPlan>(node)) {
+    shape.proj_ = proj;
+    node        = proj->child_;
+  }
+  while (auto filter = std::dynamic_pointer_cast<FilterPlan>(node)) {
+    shape.filters_.push_back(filter);
+    node = filter->child_;
+  }
+  shape.source_ = node;
+  return shape.limit_ != nullptr || shape.proj_ != nullptr || !shape.filters_.empty();
+}
+
+/**
+ * Instantiate the operators of the shape over the source, from the sink up. Each operator that is present wraps the
+ * chain below it, so every combination of operators is a type of its own and the chain is inlined into the source
+ */
+template <typename Source, typename MakeSink>
+auto Fuse(PipelineShape &shape, Source source, MakeSink &&make_sink) -> PipelineUptr
+{
+  const auto *in_schema = source.GetOutSchema();
+  // the projection gets a copy of the schema of the plan, which may be shown after the pipeline runs
+  auto proj_schema =
+      shape.proj_ != nullptr ? std::make_unique<RecordSchema>(shape.proj_->schema_->GetFields()) : nullptr;
+  const auto  *out_schema = proj_schema != nullptr ? proj_schema.get() : in_schema;
+  PipelineUptr pipeline;
+  auto         with_source = [&](auto op) {
+    pipeline = std::make_unique<FusedPipeline<Source, decltype(op)>>(std::move(source), std::move(op), out_schema);
+  };
+  auto with_filter = [&](auto op) {
+    if (shape.filters_.empty()) {
+      with_source(std::move(op));
+      return;
+    }
+    ConditionVec conds;
+    for (const auto &filter : shape.filters_) {
+      conds.insert(conds.end(), filter->conds_.begin(), filter->conds_.end());
+    }
+    with_source(FilterOp<decltype(op)>(CompiledPredicate::Compile(std::move(conds), in_schema), std::move(op)));
+  };
+  auto with_project = [&](auto op) {
+    if (shape.proj_ == nullptr) {
+      with_filter(std::move(op));
+      return;
+    }
+    with_filter(ProjectOp<decltype(op)>(in_schema, std::move(proj_schema), std::move(op)));
+  };
+  auto sink = make_sink(out_schema);
+  if (shape.limit_ != nullptr) {
+    with_project(LimitOp<decltype(sink)>(shape.limit_->limit_, std::move(sink)));
+  } else {
+    with_project(std::move(sink));
+  }
+  return pipeline;
+}
+
+template <typename MakeSink>
+auto Compile(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db, MakeSink &&make_sink) -> PipelineUptr
+{
+  if (db == nullptr) {
+    WSDB_THROW(WSDB_DB_NOT_OPEN, "");
+  }
+  PipelineShape shape;
+  if (!MatchPipeline(plan, shape)) {
+    return nullptr;
+  }
+  if (auto scan = std::dynamic_pointer_cast<ScanPlan>(shape.source_)) {
+    auto tab = db->GetTable(scan->table_name_);
+    if (tab == nullptr) {
+      WSDB_THROW(WSDB_TABLE_MISS, scan->table_name_);
+    }
+    auto proj_schema = scan->proj_fields_.empty() ? nullptr : std::make_unique<RecordSchema>(scan->proj_fields_);
+    return Fuse(shape,
+        TableSource(tab, std::move(proj_schema), scan->skip_conds_, scan->runtime_filter_),
+        std::forward<MakeSink>(make_sink));
+  }
+  return Fuse(shape, ExecutorSource(Executor::Translate(shape.source_, db)), std::forward<MakeSink>(make_sink));
+}
+
+}  // namespace
+
+auto Pipeline::CompileToClient(const std::shared_ptr<AbstractPlan> &plan, Context *ctx) -> PipelineUptr
+{
+  return Compile(plan, ctx->db_, [ctx](const RecordSchema *schema) { return ClientSink(ctx, schema); });
+}
+
+auto Pipeline::CompileToBuffer(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db, RowBuffer *rows)
+    -> PipelineUptr
+{
+  return Compile(plan, db, [rows](const RecordSchema *schema) { return BufferSink(rows, schema); });
+}
+
+}  // namespace wsdb
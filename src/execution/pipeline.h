@@ -0,0 +1,364 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+/**
+ * @brief Push-based pipelines, the alternative to pulling records through the executors one by one
+ *
+ * A pipeline is a source followed by a chain of operators that ends in a sink, e.g. scan -> filter -> project ->
+ * client. The source pushes each row into the first operator as the null map and data of the row in record layout,
+ * and each operator pushes the rows it produces into the next one by calling its Push. Operators are templates on the
+ * type of the next operator, so the whole chain is inlined into the loop of the source over the slots of a page: there
+ * is no virtual call and no record made per row and per operator, only the sink makes one.
+ *
+ * Pipeline breakers, i.e. sort, hash build and aggregate, need all their input before they return a record. The
+ * pipeline of their input ends in a BufferSink that the breaker drains through PipelineExecutor, and the breaker is
+ * the source (ExecutorSource) of the pipeline above it. Pipelines are compiled from the plans given to
+ * Executor::Translate, see Executor::Compile, and the plans that are not pipelines still run on the executors.
+ */
+
+#ifndef WSDB_PIPELINE_H
+#define WSDB_PIPELINE_H
+
+#include <vector>
+#include "executor_abstract.h"
+#include "expr/compiled_predicate.h"
+#include "expr/runtime_filter.h"
+#include "plan/plan.h"
+#include "system/context.h"
+#include "system/handle/table_handle.h"
+
+namespace wsdb {
+
+template <typename Next>
+class FilterOp
+{
+public:
+  FilterOp(CompiledPredicate pred, Next next) : pred_(std::move(pred)), next_(std::move(next)) {}
+
+  void Init() { next_.Init(); }
+
+  auto Push(const char *nullmap, const char *data) -> bool
+  {
+    return !pred_.Eval(nullmap, data) || next_.Push(nullmap, data);
+  }
+
+private:
+  CompiledPredicate pred_;
+  Next              next_;
+};
+
+template <typename Next>
+class ProjectOp
+{
+public:
+  /**
+   * @param in_schema layout of the pushed rows
+   * @param out_schema fields of the result, each of them should be in in_schema
+   * @param next
+   */
+  ProjectOp(const RecordSchema *in_schema, RecordSchemaUptr out_schema, Next next)
+      : out_schema_(std::move(out_schema)),
+        nullmap_(BITMAP_SIZE(out_schema_->GetFieldCount())),
+        data_(out_schema_->GetRecordLength()),
+        next_(std::move(next))
+  {
+    for (size_t i = 0; i < out_schema_->GetFieldCount(); ++i) {
+      const auto &field = out_schema_->GetFieldAt(i);
+      auto        idx   = in_schema->GetRTFieldIndex(field);
+      if (idx == in_schema->GetFieldCount()) {
+        WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+      }
+      projs_.push_back({.field_idx_ = idx,
+          .proj_idx_                = i,
+          .src_offset_              = in_schema->GetFieldOffset(idx),
+          .dst_offset_              = out_schema_->GetFieldOffset(i),
+          .size_                    = field.field_.field_size_});
+    }
+  }
+
+  void Init() { next_.Init(); }
+
+  auto Push(const char *nullmap, const char *data) -> bool
+  {
+    std::fill(nullmap_.begin(), nullmap_.end(), 0);
+    for (const auto &proj : projs_) {
+      memcpy(data_.data() + proj.dst_offset_, data + proj.src_offset_, proj.size_);
+      if (BitMap::GetBit(nullmap, proj.field_idx_)) {
+        BitMap::SetBit(nullmap_.data(), proj.proj_idx_, true);
+      }
+    }
+    return next_.Push(nullmap_.data(), data_.data());
+  }
+
+private:
+  RecordSchemaUptr             out_schema_;
+  std::vector<FieldProjection> projs_;
+  std::vector<char>            nullmap_;
+  std::vector<char>            data_;
+  Next                         next_;
+};
+
+/// stops the pipeline after limit rows
+template <typename Next>
+class LimitOp
+{
+public:
+  LimitOp(size_t limit, Next next) : limit_(limit), next_(std::move(next)) {}
+
+  void Init()
+  {
+    left_ = limit_;
+    next_.Init();
+  }
+
+  auto Push(const char *nullmap, const char *data) -> bool
+  {
+    if (left_ == 0) {
+      return false;
+    }
+    return next_.Push(nullmap, data) && --left_ > 0;
+  }
+
+private:
+  size_t limit_;
+  size_t left_{0};
+  Next   next_;
+};
+
+/// sends the rows to the client
+class ClientSink
+{
+public:
+  ClientSink(Context *ctx, const RecordSchema *schema) : ctx_(ctx), schema_(schema) {}
+
+  void Init() {}
+
+  auto Push(const char *nullmap, const char *data) -> bool
+  {
+    Record record(schema_, nullmap, data, INVALID_RID);
+    ctx_->nt_ctl_->SendRec(ctx_->client_fd_, &record);
+    return true;
+  }
+
+private:
+  Context            *ctx_;
+  const RecordSchema *schema_;
+};
+
+/// rows in record layout kept for an executor that pulls them, each row is its null map followed by its data
+class RowBuffer
+{
+public:
+  void SetSchema(const RecordSchema *schema)
+  {
+    nullmap_size_ = BITMAP_SIZE(schema->GetFieldCount());
+    row_size_     = nullmap_size_ + schema->GetRecordLength();
+  }
+
+  void Append(const char *nullmap, const char *data)
+  {
+    auto offset = bytes_.size();
+    bytes_.resize(offset + row_size_);
+    memcpy(bytes_.data() + offset, nullmap, nullmap_size_);
+    memcpy(bytes_.data() + offset + nullmap_size_, data, row_size_ - nullmap_size_);
+  }
+
+  /// the memory is kept for the next rows
+  void Clear() { bytes_.clear(); }
+
+  [[nodiscard]] auto GetRowNum() const -> size_t { return row_size_ == 0 ? 0 : bytes_.size() / row_size_; }
+
+  [[nodiscard]] auto GetNullMap(size_t i) const -> const char * { return bytes_.data() + i * row_size_; }
+
+  [[nodiscard]] auto GetData(size_t i) const -> const char * { return GetNullMap(i) + nullmap_size_; }
+
+private:
+  size_t            nullmap_size_{0};
+  size_t            row_size_{0};
+  std::vector<char> bytes_;
+};
+
+/// copies the rows into a buffer for an executor that pulls them, see PipelineExecutor
+class BufferSink
+{
+public:
+  BufferSink(RowBuffer *rows, const RecordSchema *schema) : rows_(rows) { rows_->SetSchema(schema); }
+
+  void Init() {}
+
+  auto Push(const char *nullmap, const char *data) -> bool
+  {
+    rows_->Append(nullmap, data);
+    return true;
+  }
+
+private:
+  RowBuffer *rows_;
+};
+
+/// pushes the records of a table a page at a time, pages are skipped and rows are dropped as SeqScanExecutor does
+class TableSource
+{
+public:
+  /**
+   * @param tab
+   * @param proj_schema fields to materialize, nullptr means all fields of the table
+   * @param skip_conds conditions used to skip pages by the zone map
+   * @param runtime_filter filter published by a join above, nullptr if none
+   */
+  TableSource(TableHandle *tab, RecordSchemaUptr proj_schema, ConditionVec skip_conds, RuntimeFilterSptr runtime_filter)
+      : tab_(tab),
+        proj_schema_(std::move(proj_schema)),
+        skip_conds_(std::move(skip_conds)),
+        runtime_filter_(std::move(runtime_filter))
+  {}
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema *
+  {
+    return proj_schema_ != nullptr ? proj_schema_.get() : &tab_->GetSchema();
+  }
+
+  void Init()
+  {
+    page_id_            = FILE_HEADER_PAGE_ID;
+    use_runtime_filter_ = runtime_filter_ != nullptr && runtime_filter_->IsReady();
+    if (use_runtime_filter_) {
+      probe_encoder_ = runtime_filter_->MakeEncoder(GetOutSchema());
+      probe_key_.resize(probe_encoder_.GetKeySize());
+    }
+  }
+
+  /// push the rows of the next page that may match, false if there is no page left or op wants no more rows
+  template <typename Op>
+  auto Push(Op &op) -> bool
+  {
+    const auto *schema   = GetOutSchema();
+    auto        page_num = static_cast<page_id_t>(tab_->GetTableHeader().page_num_);
+    while (++page_id_ < page_num) {
+      if (!tab_->PageMayMatch(page_id_, skip_conds_)) {
+        continue;
+      }
+      return tab_->ScanPage(page_id_, schema, [&](const char *nullmap, const char *data, slot_id_t) {
+        if (use_runtime_filter_ &&
+            !runtime_filter_->MayMatch(probe_encoder_, schema, nullmap, data, probe_key_.data())) {
+          return true;
+        }
+        return op.Push(nullmap, data);
+      });
+    }
+    return false;
+  }
+
+private:
+  TableHandle      *tab_;
+  RecordSchemaUptr  proj_schema_;
+  ConditionVec      skip_conds_;
+  page_id_t         page_id_{INVALID_PAGE_ID};
+  RuntimeFilterSptr runtime_filter_;
+  bool              use_runtime_filter_{false};
+  SortKeyEncoder    probe_encoder_;
+  std::vector<char> probe_key_;
+};
+
+/// pushes the records of an executor, e.g. of a pipeline breaker, CHUNK_SIZE records at a time
+class ExecutorSource
+{
+public:
+  explicit ExecutorSource(AbstractExecutorUptr child) : child_(std::move(child)) {}
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
+
+  void Init() { child_->Init(); }
+
+  template <typename Op>
+  auto Push(Op &op) -> bool
+  {
+    for (size_t i = 0; i < CHUNK_SIZE && !child_->IsEnd(); ++i, child_->Next()) {
+      const auto *record = child_->PeekRecord();
+      WSDB_ASSERT(record != nullptr, "executor is not at the end but has no record");
+      if (!op.Push(record->GetNullMap(), record->GetData())) {
+        return false;
+      }
+    }
+    return !child_->IsEnd();
+  }
+
+private:
+  AbstractExecutorUptr child_;
+};
+
+class Pipeline
+{
+public:
+  virtual ~Pipeline() = default;
+
+  virtual void Init() = 0;
+
+  /**
+   * Push the rows of the next step of the source, i.e. a page of a table or CHUNK_SIZE records of an executor
+   * @return false if the source is exhausted or the sink wants no more rows
+   */
+  virtual auto Step() -> bool = 0;
+
+  [[nodiscard]] virtual auto GetOutSchema() const -> const RecordSchema * = 0;
+
+  void Run()
+  {
+    Init();
+    while (Step()) {}
+  }
+
+  /**
+   * Compile a plan of an optional limit, an optional projection and filters over a source into a pipeline that sends
+   * its rows to the client. The source is a table scan or any other plan, which is translated to executors
+   * @return nullptr if the plan is not such a pipeline or has no operator over the source
+   */
+  static auto CompileToClient(const std::shared_ptr<AbstractPlan> &plan, Context *ctx) -> std::unique_ptr<Pipeline>;
+
+  /// compile as CompileToClient, but the rows are appended to rows
+  static auto CompileToBuffer(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db, RowBuffer *rows)
+      -> std::unique_ptr<Pipeline>;
+};
+
+DEFINE_UNIQUE_PTR(Pipeline);
+
+template <typename Source, typename Op>
+class FusedPipeline : public Pipeline
+{
+public:
+  FusedPipeline(Source source, Op op, const RecordSchema *out_schema)
+      : source_(std::move(source)), op_(std::move(op)), out_schema_(out_schema)
+  {}
+
+  void Init() override
+  {
+    source_.Init();
+    op_.Init();
+  }
+
+  auto Step() -> bool override { return source_.Push(op_); }
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override { return out_schema_; }
+
+private:
+  Source              source_;
+  Op                  op_;
+  const RecordSchema *out_schema_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_PIPELINE_H
@@ -0,0 +1,363 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+#include "compiled_predicate.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include "common/bitmap.h"
+
+namespace wsdb {
+
+using Step = CompiledPredicate::Step;
+
+template <CompOp OP, typename T>
+static auto Apply(const T &lhs, const T &rhs) -> bool
+{
+  if constexpr (OP == OP_EQ) {
+    return lhs == rhs;
+  } else if constexpr (OP == OP_NE) {
+    return lhs != rhs;
+  } else if constexpr (OP == OP_LT) {
+    return lhs < rhs;
+  } else if constexpr (OP == OP_LE) {
+    return lhs <= rhs;
+  } else if constexpr (OP == OP_GT) {
+    return lhs > rhs;
+  } else {
+    return lhs >= rhs;
+  }
+}
+
+/// a null compares unequal to any value, and null = null is true
+template <CompOp OP>
+static auto ApplyNull(bool lnull, bool rnull) -> bool
+{
+  if constexpr (OP == OP_EQ) {
+    return lnull && rnull;
+  } else if constexpr (OP == OP_NE) {
+    return lnull != rnull;
+  } else {
+    return false;
+  }
+}
+
+template <typename C>
+static auto Load(const char *data) -> C
+{
+  C val;
+  memcpy(&val, data, sizeof(C));
+  return val;
+}
+
+static auto StringAt(const char *data, size_t size) -> std::string_view { return {data, strnlen(data, size)}; }
+
+template <typename T>
+static auto ConstOf(const Step &step) -> T
+{
+  if constexpr (std::is_same_v<T, bool>) {
+    return step.bool_;
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    return step.int_;
+  } else {
+    return step.float_;
+  }
+}
+
+/// C is the type stored in the row, T the type to compare in, the constant is stored as T
+template <typename C, typename T, CompOp OP>
+static auto CmpConst(const Step &step, const char *nullmap, const char *data) -> bool
+{
+  if (BitMap::GetBit(nullmap, step.lhs_idx_)) {
+    return ApplyNull<OP>(true, false);
+  }
+  return Apply<OP, T>(static_cast<T>(Load<C>(data + step.lhs_offset_)), ConstOf<T>(step));
+}
+
+template <CompOp OP>
+static auto CmpConstString(const Step &step, const char *nullmap, const char *data) -> bool
+{
+  if (BitMap::GetBit(nullmap, step.lhs_idx_)) {
+    return ApplyNull<OP>(true, false);
+  }
+  return Apply<OP, std::string_view>(StringAt(data + step.lhs_offset_, step.lhs_size_), step.str_);
+}
+
+template <typename L, typename R, CompOp OP>
+static auto CmpColumns(const Step &step, const char *nullmap, const char *data) -> bool
+{
+  bool lnull = BitMap::GetBit(nullmap, step.lhs_idx_);
+  bool rnull = BitMap::GetBit(nullmap, step.rhs_idx_);
+  if (lnull || rnull) {
+    return ApplyNull<OP>(lnull, rnull);
+  }
+  using T = std::common_type_t<L, R>;
+  return Apply<OP, T>(
+      static_cast<T>(Load<L>(data + step.lhs_offset_)), static_cast<T>(Load<R>(data + step.rhs_offset_)));
+}
+
+template <CompOp OP>
+static auto CmpColumnsString(const Step &step, const char *nullmap, const char *data) -> bool
+{
+  bool lnull = BitMap::GetBit(nullmap, step.lhs_idx_);
+  bool rnull = BitMap::GetBit(nullmap, step.rhs_idx_);
+  if (lnull || rnull) {
+    return ApplyNull<OP>(lnull, rnull);
+  }
+  return Apply<OP, std::string_view>(
+      StringAt(data + step.lhs_offset_, step.lhs_size_), StringAt(data + step.rhs_offset_, step.rhs_size_));
+}
+
+template <typename T>
+static auto ListOf(const Step &step) -> std::span<const T>
+{
+  if constexpr (std::is_same_v<T, int32_t>) {
+    return step.int_list_;
+  } else {
+    return step.float_list_;
+  }
+}
+
+/// C is the type stored in the row, T the type of the list. a null is IN a list with a null
+template <typename C, typename T>
+static auto InList(const Step &step, const char *nullmap, const char *data) -> bool
+{
+  if (BitMap::GetBit(nullmap, step.lhs_idx_)) {
+    return step.list_has_null_;
+  }
+  auto list = ListOf<T>(step);
+  return std::find(list.begin(), list.end(), static_cast<T>(Load<C>(data + step.lhs_offset_))) != list.end();
+}
+
+static auto InListString(const Step &step, const char *nullmap, const char *data) -> bool
+{
+  if (BitMap::GetBit(nullmap, step.lhs_idx_)) {
+    return step.list_has_null_;
+  }
+  auto lhs = StringAt(data + step.lhs_offset_, step.lhs_size_);
+  return std::find(step.str_list_.begin(), step.str_list_.end(), lhs) != step.str_list_.end();
+}
+
+static auto DatumAt(const char *nullmap, const char *data, size_t idx, size_t offset, size_t size, FieldType type)
+    -> Datum
+{
+  return BitMap::GetBit(nullmap, idx) ? Datum{} : Datum::FromRaw(type, data + offset, size);
+}
+
+/// the condition evaluated as ConditionExpr does, for the conditions that have no typed comparator
+static auto EvalGeneric(const Step &step, const char *nullmap, const char *data) -> bool
+{
+  const auto &cond = *step.cond_;
+  auto        lhs  = DatumAt(nullmap, data, step.lhs_idx_, step.lhs_offset_, step.lhs_size_, step.lhs_type_);
+  if (cond.GetOp() == OP_IN) {
+    const auto &vals = std::dynamic_pointer_cast<ArrayValue>(cond.GetRVal())->Get();
+    return std::any_of(vals.begin(), vals.end(), [&lhs](const ValueSptr &val) {
+      return Datum::Eval(OP_EQ, lhs, Datum::FromValue(*val));
+    });
+  }
+  if (cond.GetRhsType() == kValue) {
+    return Datum::Eval(cond.GetOp(), lhs, cond.GetRDatum());
+  }
+  auto rhs = DatumAt(nullmap, data, step.rhs_idx_, step.rhs_offset_, step.rhs_size_, step.rhs_type_);
+  return Datum::Eval(cond.GetOp(), lhs, rhs);
+}
+
+/// comparator of a field and a constant, nullptr if there is none for the types, the constant is stored in step
+template <CompOp OP>
+static auto MakeConstFn(FieldType ltype, const Datum &val, Step &step) -> CompiledPredicate::StepFn
+{
+  switch (ltype) {
+    case TYPE_BOOL:
+      if (val.GetType() == TYPE_BOOL) {
+        step.bool_ = val.GetBool();
+        return CmpConst<bool, bool, OP>;
+      }
+      break;
+    case TYPE_INT:
+      if (val.GetType() == TYPE_INT) {
+        step.int_ = val.GetInt();
+        return CmpConst<int32_t, int32_t, OP>;
+      } else if (val.GetType() == TYPE_FLOAT) {
+        step.float_ = val.GetFloat();
+        return CmpConst<int32_t, float, OP>;
+      }
+      break;
+    case TYPE_FLOAT:
+      if (val.GetType() == TYPE_INT || val.GetType() == TYPE_FLOAT) {
+        step.float_ = val.GetType() == TYPE_INT ? static_cast<float>(val.GetInt()) : val.GetFloat();
+        return CmpConst<float, float, OP>;
+      }
+      break;
+    case TYPE_STRING:
+      if (val.GetType() == TYPE_STRING) {
+        step.str_ = val.GetString();
+        return CmpConstString<OP>;
+      }
+      break;
+    default: break;
+  }
+  return nullptr;
+}
+
+/// comparator of two fields, nullptr if there is none for the types
+template <CompOp OP>
+static auto MakeColumnsFn(FieldType ltype, FieldType rtype) -> CompiledPredicate::StepFn
+{
+  switch (ltype) {
+    case TYPE_BOOL: return rtype == TYPE_BOOL ? CmpColumns<bool, bool, OP> : nullptr;
+    case TYPE_INT:
+      if (rtype == TYPE_INT) {
+        return CmpColumns<int32_t, int32_t, OP>;
+      }
+      return rtype == TYPE_FLOAT ? CmpColumns<int32_t, float, OP> : nullptr;
+    case TYPE_FLOAT:
+      if (rtype == TYPE_FLOAT) {
+        return CmpColumns<float, float, OP>;
+      }
+      return rtype == TYPE_INT ? CmpColumns<float, int32_t, OP> : nullptr;
+    case TYPE_STRING: return rtype == TYPE_STRING ? CmpColumnsString<OP> : nullptr;
+    default: return nullptr;
+  }
+}
+
+/// pick the comparator of a condition whose fields are bound in step
+static auto MakeStepFn(const Condition &cond, Step &step) -> CompiledPredicate::StepFn
+{
+  auto ltype = step.lhs_type_;
+  if (cond.GetRhsType() == kValue) {
+    const auto &val = cond.GetRDatum();
+    if (val.IsNull()) {
+      return nullptr;
+    }
+    switch (cond.GetOp()) {
+      case OP_EQ: return MakeConstFn<OP_EQ>(ltype, val, step);
+      case OP_NE: return MakeConstFn<OP_NE>(ltype, val, step);
+      case OP_LT: return MakeConstFn<OP_LT>(ltype, val, step);
+      case OP_LE: return MakeConstFn<OP_LE>(ltype, val, step);
+      case OP_GT: return MakeConstFn<OP_GT>(ltype, val, step);
+      case OP_GE: return MakeConstFn<OP_GE>(ltype, val, step);
+      default: return nullptr;
+    }
+  }
+  auto rtype = step.rhs_type_;
+  switch (cond.GetOp()) {
+    case OP_EQ: return MakeColumnsFn<OP_EQ>(ltype, rtype);
+    case OP_NE: return MakeColumnsFn<OP_NE>(ltype, rtype);
+    case OP_LT: return MakeColumnsFn<OP_LT>(ltype, rtype);
+    case OP_LE: return MakeColumnsFn<OP_LE>(ltype, rtype);
+    case OP_GT: return MakeColumnsFn<OP_GT>(ltype, rtype);
+    case OP_GE: return MakeColumnsFn<OP_GE>(ltype, rtype);
+    default: return nullptr;
+  }
+}
+
+auto CompiledPredicate::MakeInFn(const Condition &cond, Step &step) -> StepFn
+{
+  // values are aligned with the field as FilterKernel::SelectIn does, an int field is compared as float if a value is
+  std::vector<Datum> vals;
+  bool               has_float = false;
+  for (const auto &val : std::dynamic_pointer_cast<ArrayValue>(cond.GetRVal())->Get()) {
+    auto datum = Datum::FromValue(*val);
+    if (datum.IsNull()) {
+      step.list_has_null_ = true;
+      continue;
+    }
+    bool numeric = (step.lhs_type_ == TYPE_INT || step.lhs_type_ == TYPE_FLOAT) &&
+                   (datum.GetType() == TYPE_INT || datum.GetType() == TYPE_FLOAT);
+    if (datum.GetType() != step.lhs_type_ && !numeric) {
+      return nullptr;
+    }
+    has_float = has_float || datum.GetType() == TYPE_FLOAT;
+    vals.push_back(datum);
+  }
+  switch (step.lhs_type_) {
+    case TYPE_BOOL: {
+      auto &list = int_lists_.emplace_back();
+      for (const auto &val : vals) {
+        list.push_back(val.GetBool());
+      }
+      step.int_list_ = list;
+      return InList<bool, int32_t>;
+    }
+    case TYPE_INT:
+      if (!has_float) {
+        auto &list = int_lists_.emplace_back();
+        for (const auto &val : vals) {
+          list.push_back(val.GetInt());
+        }
+        step.int_list_ = list;
+        return InList<int32_t, int32_t>;
+      }
+      [[fallthrough]];
+    case TYPE_FLOAT: {
+      auto &list = float_lists_.emplace_back();
+      for (const auto &val : vals) {
+        list.push_back(val.GetType() == TYPE_INT ? static_cast<float>(val.GetInt()) : val.GetFloat());
+      }
+      step.float_list_ = list;
+      return step.lhs_type_ == TYPE_INT ? InList<int32_t, float> : InList<float, float>;
+    }
+    case TYPE_STRING: {
+      auto &list = str_lists_.emplace_back();
+      for (const auto &val : vals) {
+        list.push_back(val.GetString());
+      }
+      step.str_list_ = list;
+      return InListString;
+    }
+    default: return nullptr;
+  }
+}
+
+auto CompiledPredicate::Compile(ConditionVec conds, const RecordSchema *schema) -> CompiledPredicate
+{
+  auto field_idx = [schema](const RTField &field) {
+    auto idx = schema->GetRTFieldIndex(field);
+    if (idx == schema->GetFieldCount()) {
+      WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+    }
+    return idx;
+  };
+  CompiledPredicate pred;
+  pred.conds_ = std::move(conds);
+  for (const auto &cond : pred.conds_) {
+    WSDB_ASSERT(cond.GetRhsType() == kValue || cond.GetRhsType() == kColumn, "Invalid condition type");
+    auto        lidx   = field_idx(cond.GetLCol());
+    const auto &lfield = schema->GetFieldAt(lidx).field_;
+    Step        step{.fn_     = nullptr,
+               .lhs_idx_    = lidx,
+               .lhs_offset_ = schema->GetFieldOffset(lidx),
+               .lhs_size_   = lfield.field_size_,
+               .lhs_type_   = lfield.field_type_,
+               .cond_       = &cond};
+    if (cond.GetRhsType() == kColumn) {
+      auto        ridx   = field_idx(cond.GetRCol());
+      const auto &rfield = schema->GetFieldAt(ridx).field_;
+      step.rhs_idx_      = ridx;
+      step.rhs_offset_   = schema->GetFieldOffset(ridx);
+      step.rhs_size_     = rfield.field_size_;
+      step.rhs_type_     = rfield.field_type_;
+    }
+    step.fn_ = cond.GetOp() == OP_IN ? pred.MakeInFn(cond, step) : MakeStepFn(cond, step);
+    if (step.fn_ == nullptr) {
+      step.fn_ = EvalGeneric;
+    }
+    pred.steps_.push_back(step);
+  }
+  return pred;
+}
+
+}  // namespace wsdb
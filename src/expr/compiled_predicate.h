@@ -0,0 +1,112 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+/**
+ * @brief Conditions compiled against a row layout, the row-at-a-time counterpart of FilterKernel
+ *
+ * Compile binds the fields of each condition to their index and offset in the schema once, and picks a comparator
+ * template instantiated on the field types and the operator, e.g. CmpConst<int32_t, int32_t, OP_LT>. The result is a
+ * flat program of steps that Eval runs on the null map and data of a row, with no field lookup, no type dispatch and
+ * no allocation per row. Null semantics follow Datum::Eval. An IN list is converted once into a typed list that a row
+ * is looked up in, with int and float aligned as FilterKernel::SelectIn does. Conditions that have no typed
+ * comparator, e.g. a comparison with a null constant, run as generic steps that evaluate the condition as
+ * ConditionExpr does.
+ */
+
+#ifndef WSDB_COMPILED_PREDICATE_H
+#define WSDB_COMPILED_PREDICATE_H
+
+#include <span>
+#include <string_view>
+#include <vector>
+#include "common/condition.h"
+#include "system/handle/record_handle.h"
+
+namespace wsdb {
+
+class CompiledPredicate
+{
+public:
+  /// a predicate that every row passes
+  CompiledPredicate() = default;
+
+  /// steps refer to the conditions held by the predicate, so it can be moved but not copied
+  CompiledPredicate(const CompiledPredicate &)                     = delete;
+  auto operator=(const CompiledPredicate &) -> CompiledPredicate & = delete;
+  CompiledPredicate(CompiledPredicate &&) noexcept                 = default;
+  auto operator=(CompiledPredicate &&) noexcept -> CompiledPredicate & = default;
+
+  /**
+   * @param conds conjunction to compile, the right hand sides should be values or columns
+   * @param schema layout of the rows, throw WSDB_FIELD_MISS if a field of the conditions is not in it
+   */
+  static auto Compile(ConditionVec conds, const RecordSchema *schema) -> CompiledPredicate;
+
+  [[nodiscard]] auto Eval(const char *nullmap, const char *data) const -> bool
+  {
+    for (const auto &step : steps_) {
+      if (!step.fn_(step, nullmap, data)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// the record should have the schema the predicate is compiled against
+  [[nodiscard]] auto Eval(const Record &record) const -> bool { return Eval(record.GetNullMap(), record.GetData()); }
+
+  struct Step;
+  using StepFn = bool (*)(const Step &, const char *, const char *);
+
+  /// a condition bound to the row layout, the comparator reads only the members it is instantiated for
+  struct Step
+  {
+    StepFn                            fn_;
+    size_t                            lhs_idx_;
+    size_t                            lhs_offset_;
+    size_t                            lhs_size_;
+    FieldType                         lhs_type_;
+    size_t                            rhs_idx_{0};  // below is available if the right hand side is a column
+    size_t                            rhs_offset_{0};
+    size_t                            rhs_size_{0};
+    FieldType                         rhs_type_{TYPE_NULL};
+    int32_t                           int_{0};  // below is available if the right hand side is a value
+    float                             float_{0};
+    bool                              bool_{false};
+    std::string_view                  str_;
+    std::span<const int32_t>          int_list_;  // below is available if the condition is IN, bools are kept as ints
+    std::span<const float>            float_list_;
+    std::span<const std::string_view> str_list_;
+    bool                              list_has_null_{false};
+    const Condition                  *cond_;  // the condition, used by generic steps
+  };
+
+private:
+  /// membership step of an IN condition whose field is bound in step, nullptr if the types are not comparable
+  auto MakeInFn(const Condition &cond, Step &step) -> StepFn;
+
+private:
+  ConditionVec      conds_;  // holds the string constants and the IN lists the steps refer to
+  std::vector<Step> steps_;
+  // the non-null values of the IN lists in the type they are compared in
+  std::vector<std::vector<int32_t>>          int_lists_;
+  std::vector<std::vector<float>>            float_lists_;
+  std::vector<std::vector<std::string_view>> str_lists_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_COMPILED_PREDICATE_H
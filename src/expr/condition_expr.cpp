@@ -20,6 +20,7 @@
 //
 
 #include "condition_expr.h"
+#include "filter_kernel.h"
 
 namespace wsdb {
 
@@ -34,28 +35,65 @@ auto ConditionExpr::EvalCond(const Condition &condition, const wsdb::Record &rec
   // first get the lhs value according to condition
   auto idx = record.GetSchema()->GetRTFieldIndex(condition.GetLCol());
   WSDB_ASSERT(idx != record.GetSchema()->GetFieldCount(), "Invalid field");
-  auto lhs = record.GetValueAt(idx);
   WSDB_ASSERT(condition.GetRhsType() == kValue || condition.GetRhsType() == kColumn, "Invalid condition type");
-  ValueSptr rhs;
+  // compare with datums to avoid allocating values for every record
+  auto lhs = record.GetDatumAt(idx);
+  if (condition.GetOp() == OP_IN) {
+    // int and float are compared as float, the same as FilterKernel::SelectIn
+    const auto &vals = std::dynamic_pointer_cast<ArrayValue>(condition.GetRVal())->Get();
+    return std::any_of(vals.begin(), vals.end(), [&lhs](const ValueSptr &val) {
+      return Datum::Eval(OP_EQ, lhs, Datum::FromValue(*val));
+    });
+  }
   if (condition.GetRhsType() == kValue) {
-    rhs = condition.GetRVal();
-  } else {
-    idx = record.GetSchema()->GetRTFieldIndex(condition.GetRCol());
-    WSDB_ASSERT(idx != record.GetSchema()->GetFieldCount(), "Invalid field");
-    rhs = record.GetValueAt(idx);
+    return Datum::Eval(condition.GetOp(), lhs, condition.GetRDatum());
+  }
+  idx = record.GetSchema()->GetRTFieldIndex(condition.GetRCol());
+  WSDB_ASSERT(idx != record.GetSchema()->GetFieldCount(), "Invalid field");
+  return Datum::Eval(condition.GetOp(), lhs, record.GetDatumAt(idx));
+}
+
+void ConditionExpr::EvalBatch(const ConditionVec &condition, Chunk &chunk)
+{
+  for (const auto &cond : condition) {
+    if (chunk.GetSize() == 0) {
+      return;
+    }
+    EvalCondBatch(cond, chunk);
   }
-  ValueFactory::AlignTypes(lhs, rhs);
-  switch (condition.GetOp()) {
-    case OP_EQ: return *lhs == *rhs;
-    case OP_NE: return *lhs != *rhs;
-    case OP_LT: return *lhs < *rhs;
-    case OP_LE: return *lhs <= *rhs;
-    case OP_GT: return *lhs > *rhs;
-    case OP_GE: return *lhs >= *rhs;
-    case OP_IN: return std::dynamic_pointer_cast<ArrayValue>(rhs)->Contains(lhs);
-    default: WSDB_FETAL(CompOpToString(condition.GetOp()));
+}
+
+void ConditionExpr::EvalCondBatch(const Condition &condition, Chunk &chunk)
+{
+  const auto *schema = chunk.GetSchema();
+  auto        column = [&chunk, schema](const RTField &field) {
+    auto idx = schema->GetRTFieldIndex(field);
+    WSDB_ASSERT(idx != schema->GetFieldCount(), "Invalid field");
+    const char *nullmap = chunk.GetColNullMap(idx);
+    return ColumnView{.type_ = schema->GetFieldAt(idx).field_.field_type_,
+        .size_ = schema->GetFieldAt(idx).field_.field_size_,
+        .data_ = chunk.GetColData(idx),
+        .nullmap_ = FilterKernel::HasNull(nullmap, chunk.GetRowNum()) ? nullmap : nullptr};
+  };
+  WSDB_ASSERT(condition.GetRhsType() == kValue || condition.GetRhsType() == kColumn, "Invalid condition type");
+  auto             lhs = column(condition.GetLCol());
+  auto             n   = chunk.GetSize();
+  const uint32_t  *sel = chunk.HasSelection() ? chunk.GetSelection().data() : nullptr;
+  Chunk::SelVector out(n);
+  size_t           k;
+  if (condition.GetOp() == OP_IN) {
+    std::vector<Datum> vals;
+    for (const auto &val : std::dynamic_pointer_cast<ArrayValue>(condition.GetRVal())->Get()) {
+      vals.push_back(Datum::FromValue(*val));
+    }
+    k = FilterKernel::SelectIn(lhs, vals, sel, n, out.data());
+  } else if (condition.GetRhsType() == kValue) {
+    k = FilterKernel::SelectConst(condition.GetOp(), lhs, condition.GetRDatum(), sel, n, out.data());
+  } else {
+    k = FilterKernel::SelectColumns(condition.GetOp(), lhs, column(condition.GetRCol()), sel, n, out.data());
   }
-  // should never reach here
+  out.resize(k);
+  chunk.SetSelection(std::move(out));
 }
 
 }  // namespace wsdb
\ No newline at end of file
@@ -35,8 +35,18 @@ public:
 
   static auto Eval(const ConditionVec &condition, const Record &record)-> bool;
 
+  /**
+   * Narrow the selection of the chunk to the rows satisfying all conditions, columns are resolved once per chunk and
+   * each condition runs as a typed kernel over the column, see FilterKernel
+   * @param condition
+   * @param chunk
+   */
+  static void EvalBatch(const ConditionVec &condition, Chunk &chunk);
+
 private:
   static auto EvalCond(const Condition &condition, const Record &record) -> bool;
+
+  static void EvalCondBatch(const Condition &condition, Chunk &chunk);
 };
 
 }  // namespace wsdb
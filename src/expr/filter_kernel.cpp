@@ -0,0 +1,405 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+#include "filter_kernel.h"
+#include <algorithm>
+#include <type_traits>
+#include "common/bitmap.h"
+
+namespace wsdb {
+
+template <CompOp OP>
+struct CmpOp
+{
+  template <typename T>
+  auto operator()(const T &lhs, const T &rhs) const -> bool
+  {
+    if constexpr (OP == OP_EQ) {
+      return lhs == rhs;
+    } else if constexpr (OP == OP_NE) {
+      return lhs != rhs;
+    } else if constexpr (OP == OP_LT) {
+      return lhs < rhs;
+    } else if constexpr (OP == OP_LE) {
+      return lhs <= rhs;
+    } else if constexpr (OP == OP_GT) {
+      return lhs > rhs;
+    } else {
+      return lhs >= rhs;
+    }
+  }
+};
+
+static auto IsNull(const char *nullmap, uint32_t row) -> bool { return (nullmap[row >> 3] >> (row & 7)) & 1; }
+
+static auto StringAt(const ColumnView &col, uint32_t row) -> std::string_view
+{
+  const char *str = col.data_ + row * col.size_;
+  return {str, strnlen(str, col.size_)};
+}
+
+// rows are evaluated in blocks so that the mask stays on the stack
+static constexpr size_t KERNEL_BLOCK = 1024;
+
+/**
+ * Append the rows whose mask is set to out, 8 rows at a time, words that all fail or all pass are handled without
+ * looking at single rows. out[k] never passes rows[i], so out can be the array of rows
+ */
+template <typename RowAt>
+static auto Compact(const uint8_t *mask, size_t len, RowAt row_at, uint32_t *out, size_t k) -> size_t
+{
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t word;
+    memcpy(&word, mask + i, sizeof(word));
+    if (word == 0) {
+      continue;
+    }
+    if (word == 0x0101010101010101ULL) {
+      for (size_t j = 0; j < 8; ++j) {
+        out[k + j] = row_at(i + j);
+      }
+      k += 8;
+      continue;
+    }
+    for (size_t j = 0; j < 8; ++j) {
+      out[k] = row_at(i + j);
+      k += mask[i + j];
+    }
+  }
+  for (; i < len; ++i) {
+    out[k] = row_at(i);
+    k += mask[i];
+  }
+  return k;
+}
+
+/**
+ * The only loop that writes selections. The predicate is first evaluated into a byte mask, which has no
+ * data-dependent stores and is vectorized for contiguous rows, then the passing rows are compacted
+ */
+template <typename Pred>
+static auto SelectRows(const uint32_t *sel, size_t n, uint32_t *out, Pred pred) -> size_t
+{
+  uint8_t mask[KERNEL_BLOCK];
+  size_t  k = 0;
+  for (size_t begin = 0; begin < n; begin += KERNEL_BLOCK) {
+    size_t len = std::min(KERNEL_BLOCK, n - begin);
+    if (sel == nullptr) {
+      auto first = static_cast<uint32_t>(begin);
+      for (uint32_t i = 0; i < len; ++i) {
+        mask[i] = pred(first + i);
+      }
+      k = Compact(mask, len, [first](size_t i) { return static_cast<uint32_t>(first + i); }, out, k);
+    } else {
+      const uint32_t *rows = sel + begin;
+      for (size_t i = 0; i < len; ++i) {
+        mask[i] = pred(rows[i]);
+      }
+      k = Compact(mask, len, [rows](size_t i) { return rows[i]; }, out, k);
+    }
+  }
+  return k;
+}
+
+/// C is the type stored in the column, T the type to compare in
+template <typename C, typename T, typename Op>
+static auto SelectConstTyped(const ColumnView &col, T val, bool null_match, const uint32_t *sel, size_t n,
+    uint32_t *out) -> size_t
+{
+  const auto *data = reinterpret_cast<const C *>(col.data_);
+  if (col.nullmap_ == nullptr) {
+    return SelectRows(sel, n, out, [data, val](uint32_t row) { return Op{}(static_cast<T>(data[row]), val); });
+  }
+  const char *nullmap = col.nullmap_;
+  return SelectRows(sel, n, out, [data, val, nullmap, null_match](uint32_t row) {
+    return IsNull(nullmap, row) ? null_match : Op{}(static_cast<T>(data[row]), val);
+  });
+}
+
+template <typename Op>
+static auto SelectConstOp(CompOp op, const ColumnView &col, const Datum &val, const uint32_t *sel, size_t n,
+    uint32_t *out) -> size_t
+{
+  // a null compares unequal to any value
+  bool null_match = op == OP_NE;
+  switch (col.type_) {
+    case TYPE_BOOL: return SelectConstTyped<bool, bool, Op>(col, val.GetBool(), null_match, sel, n, out);
+    case TYPE_INT:
+      if (val.GetType() == TYPE_FLOAT) {
+        return SelectConstTyped<int32_t, float, Op>(col, val.GetFloat(), null_match, sel, n, out);
+      }
+      return SelectConstTyped<int32_t, int32_t, Op>(col, val.GetInt(), null_match, sel, n, out);
+    case TYPE_FLOAT: {
+      auto fval = val.GetType() == TYPE_INT ? static_cast<float>(val.GetInt()) : val.GetFloat();
+      return SelectConstTyped<float, float, Op>(col, fval, null_match, sel, n, out);
+    }
+    case TYPE_STRING: {
+      auto sval = val.GetString();
+      if (col.nullmap_ == nullptr) {
+        return SelectRows(sel, n, out, [&col, sval](uint32_t row) { return Op{}(StringAt(col, row), sval); });
+      }
+      return SelectRows(sel, n, out, [&col, sval, null_match](uint32_t row) {
+        return IsNull(col.nullmap_, row) ? null_match : Op{}(StringAt(col, row), sval);
+      });
+    }
+    default: WSDB_FETAL(fmt::format("Unsupported column type: {}", FieldTypeToString(col.type_)));
+  }
+}
+
+template <typename L, typename R, typename Op>
+static auto SelectColumnsTyped(const ColumnView &lhs, const ColumnView &rhs, bool null_eq, const uint32_t *sel,
+    size_t n, uint32_t *out) -> size_t
+{
+  using T           = std::common_type_t<L, R>;
+  const auto *ldata = reinterpret_cast<const L *>(lhs.data_);
+  const auto *rdata = reinterpret_cast<const R *>(rhs.data_);
+  if (lhs.nullmap_ == nullptr && rhs.nullmap_ == nullptr) {
+    return SelectRows(sel, n, out, [ldata, rdata](uint32_t row) {
+      return Op{}(static_cast<T>(ldata[row]), static_cast<T>(rdata[row]));
+    });
+  }
+  // null = null is true, null <> value is true, other comparisons with null are false
+  return SelectRows(sel, n, out, [&lhs, &rhs, ldata, rdata, null_eq](uint32_t row) {
+    bool lnull = lhs.nullmap_ != nullptr && IsNull(lhs.nullmap_, row);
+    bool rnull = rhs.nullmap_ != nullptr && IsNull(rhs.nullmap_, row);
+    if (lnull || rnull) {
+      return null_eq ? lnull && rnull : lnull != rnull;
+    }
+    return Op{}(static_cast<T>(ldata[row]), static_cast<T>(rdata[row]));
+  });
+}
+
+template <typename Op>
+static auto SelectColumnsOp(CompOp op, const ColumnView &lhs, const ColumnView &rhs, const uint32_t *sel, size_t n,
+    uint32_t *out) -> size_t
+{
+  if (op != OP_EQ && op != OP_NE && (lhs.nullmap_ != nullptr || rhs.nullmap_ != nullptr)) {
+    // only EQ and NE can be true for nulls, drop them first so that the typed loop is null-free
+    auto        k    = SelectRows(sel, n, out, [&lhs, &rhs](uint32_t row) {
+      return !(lhs.nullmap_ != nullptr && IsNull(lhs.nullmap_, row)) &&
+             !(rhs.nullmap_ != nullptr && IsNull(rhs.nullmap_, row));
+    });
+    ColumnView l    = {lhs.type_, lhs.size_, lhs.data_, nullptr};
+    ColumnView r    = {rhs.type_, rhs.size_, rhs.data_, nullptr};
+    return SelectColumnsOp<Op>(op, l, r, out, k, out);
+  }
+  bool null_eq = op == OP_EQ;
+  switch (lhs.type_) {
+    case TYPE_BOOL: return SelectColumnsTyped<bool, bool, Op>(lhs, rhs, null_eq, sel, n, out);
+    case TYPE_INT:
+      if (rhs.type_ == TYPE_FLOAT) {
+        return SelectColumnsTyped<int32_t, float, Op>(lhs, rhs, null_eq, sel, n, out);
+      }
+      return SelectColumnsTyped<int32_t, int32_t, Op>(lhs, rhs, null_eq, sel, n, out);
+    case TYPE_FLOAT:
+      if (rhs.type_ == TYPE_INT) {
+        return SelectColumnsTyped<float, int32_t, Op>(lhs, rhs, null_eq, sel, n, out);
+      }
+      return SelectColumnsTyped<float, float, Op>(lhs, rhs, null_eq, sel, n, out);
+    case TYPE_STRING:
+      return SelectRows(sel, n, out, [&lhs, &rhs, null_eq](uint32_t row) {
+        bool lnull = lhs.nullmap_ != nullptr && IsNull(lhs.nullmap_, row);
+        bool rnull = rhs.nullmap_ != nullptr && IsNull(rhs.nullmap_, row);
+        if (lnull || rnull) {
+          return null_eq ? lnull && rnull : lnull != rnull;
+        }
+        return Op{}(StringAt(lhs, row), StringAt(rhs, row));
+      });
+    default: WSDB_FETAL(fmt::format("Unsupported column type: {}", FieldTypeToString(lhs.type_)));
+  }
+}
+
+/// the list is usually short, a linear scan over a typed array beats hashing. C is the type stored in the column, T
+/// the type of the list to compare in
+template <typename C, typename T>
+static auto SelectInTyped(const ColumnView &col, const std::vector<T> &list, bool has_null, const uint32_t *sel,
+    size_t n, uint32_t *out) -> size_t
+{
+  const auto *data = reinterpret_cast<const C *>(col.data_);
+  return SelectRows(sel, n, out, [&col, &list, data, has_null](uint32_t row) {
+    if (col.nullmap_ != nullptr && IsNull(col.nullmap_, row)) {
+      return has_null;
+    }
+    return std::find(list.begin(), list.end(), static_cast<T>(data[row])) != list.end();
+  });
+}
+
+/// the non-null values of the list as T, int and float values are converted to each other
+template <typename T>
+static auto TypedList(const std::vector<Datum> &vals) -> std::vector<T>
+{
+  std::vector<T> list;
+  for (const auto &val : vals) {
+    if (val.IsNull()) {
+      continue;
+    }
+    if constexpr (std::is_same_v<T, bool>) {
+      list.push_back(val.GetBool());
+    } else {
+      list.push_back(val.GetType() == TYPE_INT ? static_cast<T>(val.GetInt()) : static_cast<T>(val.GetFloat()));
+    }
+  }
+  return list;
+}
+
+/// int and float can be compared with each other, other types only with themselves
+static void CheckComparable(FieldType lhs, FieldType rhs)
+{
+  bool numeric = (lhs == TYPE_INT || lhs == TYPE_FLOAT) && (rhs == TYPE_INT || rhs == TYPE_FLOAT);
+  if (lhs != rhs && !numeric) {
+    WSDB_THROW(WSDB_TYPE_MISSMATCH,
+        fmt::format("Type mismatch: {} != {}", FieldTypeToString(lhs), FieldTypeToString(rhs)));
+  }
+}
+
+auto FilterKernel::HasNull(const char *nullmap, size_t n) -> bool
+{
+  size_t bytes = n / BITMAP_WIDTH;
+  for (size_t i = 0; i < bytes; ++i) {
+    if (nullmap[i] != 0) {
+      return true;
+    }
+  }
+  return n % BITMAP_WIDTH != 0 && (nullmap[bytes] & ((1 << (n % BITMAP_WIDTH)) - 1)) != 0;
+}
+
+auto FilterKernel::SelectConst(
+    CompOp op, const ColumnView &col, const Datum &val, const uint32_t *sel, size_t n, uint32_t *out) -> size_t
+{
+  if (val.IsNull()) {
+    // only null = null and value <> null are true
+    if (op != OP_EQ && op != OP_NE) {
+      return 0;
+    }
+    if (col.nullmap_ == nullptr) {
+      return op == OP_EQ ? 0 : SelectRows(sel, n, out, [](uint32_t) { return true; });
+    }
+    bool want_null = op == OP_EQ;
+    return SelectRows(sel, n, out, [&col, want_null](uint32_t row) { return IsNull(col.nullmap_, row) == want_null; });
+  }
+  CheckComparable(col.type_, val.GetType());
+  if (col.type_ == TYPE_STRING && (op == OP_EQ || op == OP_NE)) {
+    return SelectStringEqual(op == OP_EQ, col, val.GetString(), sel, n, out);
+  }
+  switch (op) {
+    case OP_EQ: return SelectConstOp<CmpOp<OP_EQ>>(op, col, val, sel, n, out);
+    case OP_NE: return SelectConstOp<CmpOp<OP_NE>>(op, col, val, sel, n, out);
+    case OP_LT: return SelectConstOp<CmpOp<OP_LT>>(op, col, val, sel, n, out);
+    case OP_LE: return SelectConstOp<CmpOp<OP_LE>>(op, col, val, sel, n, out);
+    case OP_GT: return SelectConstOp<CmpOp<OP_GT>>(op, col, val, sel, n, out);
+    case OP_GE: return SelectConstOp<CmpOp<OP_GE>>(op, col, val, sel, n, out);
+    default: WSDB_FETAL(CompOpToString(op));
+  }
+}
+
+auto FilterKernel::SelectColumns(CompOp op, const ColumnView &lhs, const ColumnView &rhs, const uint32_t *sel,
+    size_t n, uint32_t *out) -> size_t
+{
+  CheckComparable(lhs.type_, rhs.type_);
+  switch (op) {
+    case OP_EQ: return SelectColumnsOp<CmpOp<OP_EQ>>(op, lhs, rhs, sel, n, out);
+    case OP_NE: return SelectColumnsOp<CmpOp<OP_NE>>(op, lhs, rhs, sel, n, out);
+    case OP_LT: return SelectColumnsOp<CmpOp<OP_LT>>(op, lhs, rhs, sel, n, out);
+    case OP_LE: return SelectColumnsOp<CmpOp<OP_LE>>(op, lhs, rhs, sel, n, out);
+    case OP_GT: return SelectColumnsOp<CmpOp<OP_GT>>(op, lhs, rhs, sel, n, out);
+    case OP_GE: return SelectColumnsOp<CmpOp<OP_GE>>(op, lhs, rhs, sel, n, out);
+    default: WSDB_FETAL(CompOpToString(op));
+  }
+}
+
+auto FilterKernel::SelectStringEqual(
+    bool equal, const ColumnView &col, std::string_view val, const uint32_t *sel, size_t n, uint32_t *out) -> size_t
+{
+  // a null is unequal to any string
+  const char *nullmap = col.nullmap_;
+  if (val.size() > col.size_) {
+    // the column can not hold the string
+    return equal ? 0 : SelectRows(sel, n, out, [](uint32_t) { return true; });
+  }
+  // the string is equal if the bytes match and the field ends right after them
+  const char *data = col.data_;
+  size_t      size = col.size_;
+  size_t      len  = val.size();
+  const char *str  = val.data();
+  return SelectRows(sel, n, out, [data, size, len, str, nullmap, equal](uint32_t row) {
+    if (nullmap != nullptr && IsNull(nullmap, row)) {
+      return !equal;
+    }
+    const char *field = data + row * size;
+    bool        eq    = memcmp(field, str, len) == 0 && (len == size || field[len] == '\0');
+    return eq == equal;
+  });
+}
+
+auto FilterKernel::SelectStringPrefix(
+    const ColumnView &col, std::string_view prefix, const uint32_t *sel, size_t n, uint32_t *out) -> size_t
+{
+  if (prefix.size() > col.size_) {
+    return 0;
+  }
+  const char *data    = col.data_;
+  const char *nullmap = col.nullmap_;
+  size_t      size    = col.size_;
+  return SelectRows(sel, n, out, [data, size, prefix, nullmap](uint32_t row) {
+    bool is_null = nullmap != nullptr && IsNull(nullmap, row);
+    return !is_null && memcmp(data + row * size, prefix.data(), prefix.size()) == 0;
+  });
+}
+
+auto FilterKernel::SelectIn(
+    const ColumnView &col, const std::vector<Datum> &vals, const uint32_t *sel, size_t n, uint32_t *out) -> size_t
+{
+  // values are aligned with the column as SelectConst does, an int column is compared as float if a value is float
+  bool has_null  = false;
+  bool has_float = false;
+  for (const auto &val : vals) {
+    if (val.IsNull()) {
+      has_null = true;
+      continue;
+    }
+    CheckComparable(col.type_, val.GetType());
+    has_float = has_float || val.GetType() == TYPE_FLOAT;
+  }
+  switch (col.type_) {
+    case TYPE_BOOL: return SelectInTyped<bool, bool>(col, TypedList<bool>(vals), has_null, sel, n, out);
+    case TYPE_INT:
+      if (has_float) {
+        return SelectInTyped<int32_t, float>(col, TypedList<float>(vals), has_null, sel, n, out);
+      }
+      return SelectInTyped<int32_t, int32_t>(col, TypedList<int32_t>(vals), has_null, sel, n, out);
+    case TYPE_FLOAT: return SelectInTyped<float, float>(col, TypedList<float>(vals), has_null, sel, n, out);
+    case TYPE_STRING: {
+      std::vector<std::string_view> list;
+      for (const auto &val : vals) {
+        if (!val.IsNull()) {
+          list.push_back(val.GetString());
+        }
+      }
+      return SelectRows(sel, n, out, [&col, &list, has_null](uint32_t row) {
+        if (col.nullmap_ != nullptr && IsNull(col.nullmap_, row)) {
+          return has_null;
+        }
+        return std::find(list.begin(), list.end(), StringAt(col, row)) != list.end();
+      });
+    }
+    default: WSDB_FETAL(fmt::format("Unsupported column type: {}", FieldTypeToString(col.type_)));
+  }
+}
+
+}  // namespace wsdb
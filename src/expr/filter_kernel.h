@@ -0,0 +1,79 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+/**
+ * @brief Typed predicate kernels over the columns of a chunk
+ *
+ * A kernel evaluates one predicate on a contiguous column array and writes the physical rows that pass into an
+ * output selection vector. The loops are branch-free and specialized on the column type and the operator, so the
+ * compiler can keep them in registers and vectorize the comparisons. Null semantics follow Datum::Eval.
+ *
+ * All kernels take the input selection (nullptr means rows [0, n)) and return the number of rows written to out,
+ * out may be the same array as the input selection.
+ */
+
+#ifndef WSDB_FILTER_KERNEL_H
+#define WSDB_FILTER_KERNEL_H
+
+#include <string_view>
+#include "common/datum.h"
+
+namespace wsdb {
+
+/// a column of a chunk in record layout, nullmap_ is nullptr if the column has no null
+struct ColumnView
+{
+  FieldType   type_;
+  size_t      size_;
+  const char *data_;
+  const char *nullmap_;
+};
+
+class FilterKernel
+{
+public:
+  FilterKernel() = delete;
+  DISABLE_COPY_MOVE_AND_ASSIGN(FilterKernel);
+
+  /// check if any of the first n bits in the null map is set
+  static auto HasNull(const char *nullmap, size_t n) -> bool;
+
+  /// col op val, int and float are compared as float
+  static auto SelectConst(CompOp op, const ColumnView &col, const Datum &val, const uint32_t *sel, size_t n,
+      uint32_t *out) -> size_t;
+
+  /// lhs op rhs of the same row
+  static auto SelectColumns(CompOp op, const ColumnView &lhs, const ColumnView &rhs, const uint32_t *sel, size_t n,
+      uint32_t *out) -> size_t;
+
+  /// equality of a fixed-size char column and a string, compares at most the length of the string plus one byte
+  static auto SelectStringEqual(bool equal, const ColumnView &col, std::string_view val, const uint32_t *sel, size_t n,
+      uint32_t *out) -> size_t;
+
+  /// rows whose string starts with prefix, nulls never match
+  static auto SelectStringPrefix(const ColumnView &col, std::string_view prefix, const uint32_t *sel, size_t n,
+      uint32_t *out) -> size_t;
+
+  /// col IN (vals), a null row matches only if vals has a null, int and float are compared as float
+  static auto SelectIn(const ColumnView &col, const std::vector<Datum> &vals, const uint32_t *sel, size_t n,
+      uint32_t *out) -> size_t;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_FILTER_KERNEL_H
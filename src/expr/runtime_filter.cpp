@@ -0,0 +1,84 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "runtime_filter.h"
+#include <algorithm>
+
+namespace wsdb {
+
+BloomFilter::BloomFilter(size_t key_num, size_t bits_per_key)
+{
+  // a larger key number would exceed the max size anyway, and SIZE_MAX stands for an unknown number
+  key_num          = std::min(key_num, BLOOM_FILTER_MAX_SIZE * 8 / bits_per_key);
+  size_t block_num = (key_num * bits_per_key + sizeof(Block) * 8 - 1) / (sizeof(Block) * 8);
+  blocks_.resize(std::clamp<size_t>(block_num, 1, BLOOM_FILTER_MAX_SIZE / sizeof(Block)), Block{});
+}
+
+void BloomFilter::Insert(size_t hash)
+{
+  auto &block = blocks_[BlockOf(hash)];
+  for (size_t i = 0; i < WORD_NUM; ++i) {
+    block.words_[i] |= BitOf(hash, i);
+  }
+}
+
+void RuntimeFilter::Publish(const SortKeyEncoder &probe_encoder, std::unique_ptr<BloomFilter> filter)
+{
+  WSDB_ASSERT(probe_encoder.GetFieldCount() == probe_key_schema_->GetFieldCount(), "key fields should match");
+  encoder_ = probe_encoder;
+  filter_  = std::move(filter);
+}
+
+auto RuntimeFilter::MayMatch(
+    const SortKeyEncoder &encoder, const RecordSchema *schema, const char *nullmap, const char *data, char *key) -> bool
+{
+  encoder.Encode(schema, nullmap, data, key);
+  bool may_match = filter_->MayContain(Hash(key, encoder.GetKeySize()));
+  checked_num_.fetch_add(1, std::memory_order_relaxed);
+  if (!may_match) {
+    dropped_num_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return may_match;
+}
+
+void RuntimeFilter::FilterChunk(const SortKeyEncoder &encoder, Chunk &chunk, size_t first_row)
+{
+  std::vector<char> key(encoder.GetKeySize());
+  Chunk::SelVector  sel;
+  size_t            checked = 0;
+  for (size_t i = 0; i < chunk.GetSize(); ++i) {
+    auto row = chunk.RowAt(i);
+    if (row >= first_row) {
+      for (size_t k = 0; k < encoder.GetFieldCount(); ++k) {
+        auto col  = encoder.GetColIdx(k);
+        auto size = encoder.GetFieldSize(k);
+        encoder.EncodeField(
+            k, chunk.GetColData(col) + row * size, BitMap::GetBit(chunk.GetColNullMap(col), row), key.data());
+      }
+      checked++;
+      if (!filter_->MayContain(Hash(key.data(), key.size()))) {
+        continue;
+      }
+    }
+    sel.push_back(static_cast<uint32_t>(row));
+  }
+  checked_num_.fetch_add(checked, std::memory_order_relaxed);
+  dropped_num_.fetch_add(chunk.GetSize() - sel.size(), std::memory_order_relaxed);
+  chunk.SetSelection(std::move(sel));
+}
+
+}  // namespace wsdb
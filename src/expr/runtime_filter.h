@@ -0,0 +1,179 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Runtime filters that a join pushes down into the scan of its probe side
+ *
+ * As a hash join reads its build side, the hashes of the normalized build keys are put into a bloom filter, sized by
+ * the optimizer's estimate of the build side. Once the join publishes the filter, the scan of the probe side drops the
+ * rows whose key is not in the filter before they are materialized and passed up the pipeline. The filter is blocked:
+ * a key sets 8 bits in a single 64-byte block, one bit in each 64-bit word, so a lookup touches one cache line. A row
+ * passes if its key may be in the filter, so the join still sees all rows that match, plus a few false positives.
+ *
+ * The optimizer creates the runtime filter and gives it to the plans of the join and the scan, so their executors
+ * share it. It is empty until the join publishes it, and an empty runtime filter lets all rows pass.
+ */
+
+#ifndef WSDB_RUNTIME_FILTER_H
+#define WSDB_RUNTIME_FILTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include "common/config.h"
+#include "sort_key.h"
+
+namespace wsdb {
+
+class BloomFilter
+{
+public:
+  /// make a filter with about bits_per_key bits for each of key_num keys, at most BLOOM_FILTER_MAX_SIZE bytes
+  explicit BloomFilter(size_t key_num, size_t bits_per_key = BLOOM_FILTER_BITS_PER_KEY);
+
+  void Insert(size_t hash);
+
+  [[nodiscard]] auto MayContain(size_t hash) const -> bool
+  {
+    const auto &block = blocks_[BlockOf(hash)];
+    for (size_t i = 0; i < WORD_NUM; ++i) {
+      if ((block.words_[i] & BitOf(hash, i)) == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// size of the filter in bytes
+  [[nodiscard]] auto GetSize() const -> size_t { return blocks_.size() * sizeof(Block); }
+
+private:
+  static constexpr size_t WORD_NUM = 8;
+
+  struct alignas(64) Block
+  {
+    uint64_t words_[WORD_NUM];
+  };
+
+  /// the high half of the hash picks the block
+  [[nodiscard]] auto BlockOf(size_t hash) const -> size_t
+  {
+    return static_cast<size_t>(((hash >> 32) * static_cast<uint64_t>(blocks_.size())) >> 32);
+  }
+
+  /// the low half of the hash times an odd salt picks a bit in each word
+  static auto BitOf(size_t hash, size_t i) -> uint64_t
+  {
+    static constexpr uint32_t SALTS[WORD_NUM] = {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+    return uint64_t{1} << ((static_cast<uint32_t>(hash) * SALTS[i]) >> 26);
+  }
+
+  std::vector<Block> blocks_;
+};
+
+class RuntimeFilter
+{
+public:
+  /**
+   * @param probe_keys join key fields of the probe side, in the order of the build side keys
+   * @param build_key_num expected number of build keys, which sizes the bloom filter, SIZE_MAX if unknown
+   */
+  explicit RuntimeFilter(const std::vector<RTField> &probe_keys, size_t build_key_num = SIZE_MAX)
+      : probe_key_schema_(std::make_unique<RecordSchema>(probe_keys)), build_key_num_(build_key_num)
+  {}
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(RuntimeFilter);
+
+  [[nodiscard]] auto GetProbeKeys() const -> const std::vector<RTField> & { return probe_key_schema_->GetFields(); }
+
+  /// hash of a normalized key
+  static auto Hash(const char *key, size_t key_size) -> size_t
+  {
+    return std::hash<std::string_view>{}(std::string_view(key, key_size));
+  }
+
+  /// an empty bloom filter sized for the expected build keys, the join inserts the hashes of its build keys into it
+  [[nodiscard]] auto MakeBloomFilter() const -> std::unique_ptr<BloomFilter>
+  {
+    return std::make_unique<BloomFilter>(build_key_num_);
+  }
+
+  /**
+   * Publish the filter, called by the join once its build side is read and before its probe side is initialized
+   * @param probe_encoder encoder of the probe keys of the join, aligned with that of the build keys
+   * @param filter made by MakeBloomFilter, with the hashes of the normalized build keys
+   */
+  void Publish(const SortKeyEncoder &probe_encoder, std::unique_ptr<BloomFilter> filter);
+
+  [[nodiscard]] auto IsReady() const -> bool { return filter_ != nullptr; }
+
+  /// an encoder of the probe keys for the records of a scan, the scan should have all probe key fields
+  [[nodiscard]] auto MakeEncoder(const RecordSchema *schema) const -> SortKeyEncoder
+  {
+    return encoder_.Rebind(schema, probe_key_schema_.get());
+  }
+
+  /**
+   * Check a row in record layout
+   * @param encoder made by MakeEncoder for the schema of the row
+   * @param schema
+   * @param nullmap
+   * @param data
+   * @param key buffer of the key size of encoder
+   * @return false if the row has no match in the build side
+   */
+  auto MayMatch(const SortKeyEncoder &encoder, const RecordSchema *schema, const char *nullmap, const char *data,
+      char *key) -> bool;
+
+  /// narrow the selection of the chunk to the rows that may have a match, physical rows before first_row are kept
+  void FilterChunk(const SortKeyEncoder &encoder, Chunk &chunk, size_t first_row = 0);
+
+  /// number of rows checked by the scans
+  [[nodiscard]] auto GetCheckedNum() const -> size_t { return checked_num_.load(std::memory_order_relaxed); }
+
+  /// number of rows dropped by the scans
+  [[nodiscard]] auto GetDroppedNum() const -> size_t { return dropped_num_.load(std::memory_order_relaxed); }
+
+  /// the probe keys, and the rows dropped once the scans have run, as shown by EXPLAIN ANALYZE
+  [[nodiscard]] auto ToString() const -> std::string
+  {
+    std::string keys;
+    for (const auto &field : GetProbeKeys()) {
+      keys += (keys.empty() ? "" : ", ") + field.ToString();
+    }
+    auto checked = GetCheckedNum();
+    return checked == 0 ? fmt::format("bloom filter on {}", keys)
+                        : fmt::format("bloom filter on {}, {} of {} rows dropped", keys, GetDroppedNum(), checked);
+  }
+
+private:
+  RecordSchemaUptr             probe_key_schema_;
+  size_t                       build_key_num_;
+  SortKeyEncoder               encoder_;
+  std::unique_ptr<BloomFilter> filter_;
+  // scans of a parallel pipeline check rows concurrently
+  std::atomic<size_t> checked_num_{0};
+  std::atomic<size_t> dropped_num_{0};
+};
+
+DEFINE_SHARED_PTR(RuntimeFilter);
+
+}  // namespace wsdb
+
+#endif  // WSDB_RUNTIME_FILTER_H
@@ -0,0 +1,165 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "sort_key.h"
+#include <bit>
+
+namespace wsdb {
+
+/// memcmp compares bytes from the lowest address, so the most significant byte goes first
+static auto ToBigEndian(uint32_t value) -> uint32_t
+{
+  if constexpr (std::endian::native == std::endian::little) {
+    return __builtin_bswap32(value);
+  }
+  return value;
+}
+
+SortKeyEncoder::SortKeyEncoder(const RecordSchema *input, const RecordSchema *key_schema, bool is_desc)
+    : SortKeyEncoder(input, key_schema, std::vector<bool>(key_schema->GetFieldCount(), is_desc))
+{}
+
+SortKeyEncoder::SortKeyEncoder(
+    const RecordSchema *input, const RecordSchema *key_schema, const std::vector<bool> &is_desc)
+{
+  WSDB_ASSERT(is_desc.size() == key_schema->GetFieldCount(), "direction of each key field should be given");
+  for (size_t i = 0; i < key_schema->GetFieldCount(); ++i) {
+    const auto &field = key_schema->GetFieldAt(i);
+    auto        idx   = input->GetRTFieldIndex(field);
+    if (idx == input->GetFieldCount()) {
+      WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+    }
+    const auto &schema = input->GetFieldAt(idx).field_;
+    AddField(idx, schema.field_type_, schema.field_size_, is_desc[i]);
+  }
+}
+
+auto SortKeyEncoder::Rebind(const RecordSchema *input, const RecordSchema *key_schema) const -> SortKeyEncoder
+{
+  WSDB_ASSERT(key_schema->GetFieldCount() == fields_.size(), "key fields should match the encoder");
+  SortKeyEncoder encoder = *this;
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    const auto &field = key_schema->GetFieldAt(i);
+    auto        idx   = input->GetRTFieldIndex(field);
+    if (idx == input->GetFieldCount()) {
+      WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+    }
+    encoder.fields_[i].col_idx_ = idx;
+  }
+  return encoder;
+}
+
+void SortKeyEncoder::AddField(size_t col_idx, FieldType type, size_t size, bool is_desc)
+{
+  size_t enc_size = type == TYPE_BOOL ? 1 : size;
+  fields_.push_back({.col_idx_ = col_idx,
+      .type_ = type,
+      .size_ = size,
+      .enc_type_ = type,
+      .enc_size_ = enc_size,
+      .offset_ = 0,
+      .is_desc_ = is_desc});
+  Layout();
+}
+
+void SortKeyEncoder::Align(SortKeyEncoder &lhs, SortKeyEncoder &rhs)
+{
+  WSDB_ASSERT(lhs.fields_.size() == rhs.fields_.size(), "key size mismatch");
+  auto is_numeric = [](FieldType type) { return type == TYPE_INT || type == TYPE_FLOAT; };
+  for (size_t i = 0; i < lhs.fields_.size(); ++i) {
+    auto &l = lhs.fields_[i];
+    auto &r = rhs.fields_[i];
+    if (l.type_ != r.type_) {
+      if (!is_numeric(l.type_) || !is_numeric(r.type_)) {
+        WSDB_THROW(WSDB_TYPE_MISSMATCH,
+            fmt::format("Type mismatch: {} != {}", FieldTypeToString(l.type_), FieldTypeToString(r.type_)));
+      }
+      l.enc_type_ = r.enc_type_ = TYPE_FLOAT;
+    }
+    l.enc_size_ = r.enc_size_ = std::max(l.enc_size_, r.enc_size_);
+  }
+  lhs.Layout();
+  rhs.Layout();
+}
+
+void SortKeyEncoder::Layout()
+{
+  key_size_ = 0;
+  for (auto &field : fields_) {
+    field.offset_ = key_size_;
+    key_size_ += 1 + field.enc_size_;
+  }
+}
+
+void SortKeyEncoder::EncodeField(size_t i, const char *src, bool is_null, char *key) const
+{
+  const auto &field = fields_[i];
+  auto       *dst   = reinterpret_cast<uint8_t *>(key + field.offset_);
+  // nulls go first, the value of a null is all zero so that nulls are equal
+  dst[0] = is_null ? 0 : 1;
+  memset(dst + 1, 0, field.enc_size_);
+  if (!is_null) {
+    switch (field.enc_type_) {
+      case TYPE_BOOL: dst[1] = *src != 0; break;
+      case TYPE_INT: {
+        int32_t value;
+        memcpy(&value, src, sizeof(int32_t));
+        auto bits = ToBigEndian(static_cast<uint32_t>(value) ^ 0x80000000U);
+        memcpy(dst + 1, &bits, sizeof(uint32_t));
+        break;
+      }
+      case TYPE_FLOAT: {
+        float value;
+        if (field.type_ == TYPE_INT) {
+          int32_t int_value;
+          memcpy(&int_value, src, sizeof(int32_t));
+          value = static_cast<float>(int_value);
+        } else {
+          memcpy(&value, src, sizeof(float));
+        }
+        // 0.0 and -0.0 are equal
+        auto bits = std::bit_cast<uint32_t>(value == 0 ? 0.0F : value);
+        bits      = (bits & 0x80000000U) != 0 ? ~bits : bits ^ 0x80000000U;
+        bits      = ToBigEndian(bits);
+        memcpy(dst + 1, &bits, sizeof(uint32_t));
+        break;
+      }
+      case TYPE_STRING: memcpy(dst + 1, src, strnlen(src, field.size_)); break;
+      default: WSDB_FETAL(fmt::format("Unsupported key type: {}", FieldTypeToString(field.enc_type_)));
+    }
+  }
+  if (field.is_desc_) {
+    for (size_t j = 0; j <= field.enc_size_; ++j) {
+      dst[j] = ~dst[j];
+    }
+  }
+}
+
+void SortKeyEncoder::Encode(const Record &record, char *key) const
+{
+  Encode(record.GetSchema(), record.GetNullMap(), record.GetData(), key);
+}
+
+void SortKeyEncoder::Encode(const RecordSchema *schema, const char *nullmap, const char *data, char *key) const
+{
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    auto col = fields_[i].col_idx_;
+    EncodeField(i, data + schema->GetFieldOffset(col), BitMap::GetBit(nullmap, col), key);
+  }
+}
+
+}  // namespace wsdb
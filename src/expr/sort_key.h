@@ -0,0 +1,117 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Normalized keys for sorting, merging and hashing
+ *
+ * A key is encoded once into a byte string whose memcmp order is the order of Datum::CompareNullsFirst, so sorting
+ * and merging compare keys with memcmp instead of interpreting fields. Each field takes a null byte followed by
+ * its value: ints are stored big-endian with the sign bit flipped, floats as their bits with the sign bit flipped
+ * for positive values and all bits flipped for negative ones, strings zero-padded to the field size. All bytes of a
+ * descending field are inverted. Equal values have equal bytes, so a key can also be hashed and compared for
+ * equality as a whole.
+ */
+
+#ifndef WSDB_SORT_KEY_H
+#define WSDB_SORT_KEY_H
+
+#include <cstring>
+#include "system/handle/record_handle.h"
+
+namespace wsdb {
+
+class SortKeyEncoder
+{
+public:
+  SortKeyEncoder() = default;
+
+  /**
+   * Make an encoder of the key fields of records in the input schema
+   * @param input schema of the records to encode
+   * @param key_schema key fields, should be in the input schema
+   * @param is_desc whether all fields are descending
+   */
+  SortKeyEncoder(const RecordSchema *input, const RecordSchema *key_schema, bool is_desc = false);
+
+  /// same as above, but is_desc gives the direction of each key field
+  SortKeyEncoder(const RecordSchema *input, const RecordSchema *key_schema, const std::vector<bool> &is_desc);
+
+  /// append a key field, col_idx is its index in the records to encode
+  void AddField(size_t col_idx, FieldType type, size_t size, bool is_desc = false);
+
+  /**
+   * Make the keys of two encoders comparable with each other, e.g. the keys of the two sides of a join. Int fields
+   * are encoded as float if the other side is float, strings are padded to the longer side. Throw
+   * WSDB_TYPE_MISSMATCH for other types that differ
+   */
+  static void Align(SortKeyEncoder &lhs, SortKeyEncoder &rhs);
+
+  /**
+   * Make an encoder with the same encoding for records of another schema, e.g. the records of a scan below the input,
+   * throw WSDB_FIELD_MISS if a key field is not in input
+   * @param input schema of the records to encode
+   * @param key_schema key fields in the order of this encoder
+   */
+  [[nodiscard]] auto Rebind(const RecordSchema *input, const RecordSchema *key_schema) const -> SortKeyEncoder;
+
+  [[nodiscard]] auto GetKeySize() const -> size_t { return key_size_; }
+
+  [[nodiscard]] auto GetFieldCount() const -> size_t { return fields_.size(); }
+
+  /// index of the i-th key field in the records to encode
+  [[nodiscard]] auto GetColIdx(size_t i) const -> size_t { return fields_[i].col_idx_; }
+
+  /// size of the i-th key field in the records to encode
+  [[nodiscard]] auto GetFieldSize(size_t i) const -> size_t { return fields_[i].size_; }
+
+  /// encode the i-th key field from its memory in record layout
+  void EncodeField(size_t i, const char *src, bool is_null, char *key) const;
+
+  /// encode the key of a record into key, which should have GetKeySize() bytes
+  void Encode(const Record &record, char *key) const;
+
+  /// encode the key of a record in record layout, i.e. its null map and data
+  void Encode(const RecordSchema *schema, const char *nullmap, const char *data, char *key) const;
+
+  /// three-way comparison of two keys of the same encoding
+  [[nodiscard]] auto Compare(const char *lhs, const char *rhs) const -> int
+  {
+    int cmp = memcmp(lhs, rhs, key_size_);
+    return (cmp > 0) - (cmp < 0);
+  }
+
+private:
+  struct KeyField
+  {
+    size_t    col_idx_;
+    FieldType type_;      // type in the record
+    size_t    size_;      // size in the record
+    FieldType enc_type_;  // type in the key
+    size_t    enc_size_;  // size of the value in the key
+    size_t    offset_;    // offset of the null byte in the key
+    bool      is_desc_;
+  };
+
+  void Layout();
+
+  std::vector<KeyField> fields_;
+  size_t                key_size_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_SORT_KEY_H
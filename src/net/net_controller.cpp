@@ -21,6 +21,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include <cerrno>
 #include "net_controller.h"
 
 #include <sys/socket.h>
@@ -190,4 +191,14 @@ void NetController::Remove(int fd)
   }
 }
 
+auto NetController::IsClientDown(int fd) const -> bool
+{
+  char c;
+  auto n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n == 0) {
+    return true;
+  }
+  return n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+}
+
 }  // namespace wsdb
\ No newline at end of file
@@ -57,6 +57,10 @@ public:
 
   void Remove(int fd);
 
+  /// whether the peer has closed the connection, checked without consuming any data so it can be called while the
+  /// client thread is busy with a query
+  auto IsClientDown(int fd) const -> bool;
+
 private:
   // currently receive and send use the same pkg_
   int                                  server_fd_{0};
@@ -20,6 +20,9 @@
 //
 
 #include "optimizer.h"
+#include <bit>
+#include "system/scheduler.h"
+
 namespace wsdb {
 auto Optimizer::Optimize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
 {
@@ -52,17 +55,93 @@ auto Optimizer::LogicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHand
   } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
     join->left_  = LogicalOptimize(join->left_, db);
     join->right_ = LogicalOptimize(join->right_, db);
-    return LogicalOptimizeJoin(join);
+    return LogicalOptimizeJoin(join, db);
+  } else if (auto semi = std::dynamic_pointer_cast<SemiJoinPlan>(plan)) {
+    semi->left_  = LogicalOptimize(semi->left_, db);
+    semi->right_ = LogicalOptimize(semi->right_, db);
+    return semi;
   } else if (auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
     agg->child_ = LogicalOptimize(agg->child_, db);
-    return agg;
+    return LogicalOptimizeAggregate(agg, db);
   } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
     lim->child_ = LogicalOptimize(lim->child_, db);
-    return lim;
+    return LogicalOptimizeLimit(lim);
   }
   return plan;
 }
 
+auto Optimizer::LogicalOptimizeLimit(const std::shared_ptr<LimitPlan> &lim) -> std::shared_ptr<AbstractPlan>
+{
+  // a projection keeps the number and order of records, so the limit can be fused with a sort below it
+  auto proj = std::dynamic_pointer_cast<ProjectPlan>(lim->child_);
+  auto sort = std::dynamic_pointer_cast<SortPlan>(proj == nullptr ? lim->child_ : proj->child_);
+  if (sort == nullptr) {
+    return lim;
+  }
+  auto top_n = std::make_shared<TopNPlan>(
+      std::move(sort->child_), std::move(sort->key_schema_), std::move(sort->is_desc_), lim->limit_);
+  if (proj == nullptr) {
+    return top_n;
+  }
+  proj->child_ = top_n;
+  return proj;
+}
+
+auto Optimizer::LogicalOptimizeAggregate(
+    const std::shared_ptr<AggregatePlan> &agg, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
+{
+  // aggregation without group by has a single group, which is what the hash aggregation is fast at
+  if (agg->group_fields_.empty()) {
+    return agg;
+  }
+  // records of a group are adjacent if the leading order fields are exactly the group fields, in any order
+  ColumnSet groups;
+  for (const auto &field : agg->group_fields_) {
+    groups.emplace(field.field_.table_id_, field.field_.field_name_);
+  }
+  auto order = OutputOrder(agg->child_, db);
+  if (order.size() < groups.size()) {
+    return agg;
+  }
+  ColumnSet leading;
+  for (size_t i = 0; i < groups.size(); ++i) {
+    leading.emplace(order[i].field_.table_id_, order[i].field_.field_name_);
+  }
+  agg->is_stream_ = leading == groups;
+  return agg;
+}
+
+auto Optimizer::OutputOrder(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> std::vector<RTField>
+{
+  if (auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+    return sort->key_schema_->GetFields();
+  } else if (auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    return top_n->key_schema_->GetFields();
+  } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    return OutputOrder(filter->child_, db);
+  } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+    return OutputOrder(lim->child_, db);
+  } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+    // sort merge join returns records in the order of the left keys, unmatched left records of outer join included
+    if (join->strategy_ == SORT_MERGE && join->left_key_schema_ != nullptr) {
+      return join->left_key_schema_->GetFields();
+    }
+    // index nested loop join returns the matches of each left record in turn
+    if (join->strategy_ == INDEX_NESTED_LOOP) {
+      return OutputOrder(join->left_, db);
+    }
+  } else if (auto semi = std::dynamic_pointer_cast<SemiJoinPlan>(plan)) {
+    // semi and anti joins only drop left records
+    return OutputOrder(semi->left_, db);
+  } else if (auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
+    auto *index = db->GetIndex(idx_scan->idx_id_);
+    if (index->GetIndexType() == IndexType::BPTREE) {
+      return index->GetKeySchema().GetFields();
+    }
+  }
+  return {};
+}
+
 auto Optimizer::LogicalOptimizeScan(const std::shared_ptr<ScanPlan> &scan, ConditionVec conds,
     wsdb::DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
 {
@@ -73,17 +152,21 @@ auto Optimizer::LogicalOptimizeScan(const std::shared_ptr<ScanPlan> &scan, Condi
   std::shared_ptr<AbstractPlan> new_scan = scan;
   if (index != nullptr) {
     new_scan = std::make_shared<IdxScanPlan>(scan->table_name_, index->GetIndexId(), index_conds, max_matched_fields);
+  } else {
+    // the filter is kept, the conditions only let the scan skip pages by zone map
+    scan->skip_conds_ = std::move(conds);
   }
   return new_scan;
 }
 
-auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shared_ptr<AbstractPlan>
+auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
 {
   if (join->strategy_ == NESTED_LOOP) {
     return join;
   }
-  WSDB_ASSERT(join->strategy_ == SORT_MERGE, "Unknown join strategy");
-  // try to generate SortMergeJoin
+  WSDB_ASSERT(join->strategy_ == AUTO || join->strategy_ == SORT_MERGE || join->strategy_ == HASH,
+      "Unknown join strategy");
+  // try to generate SortMergeJoin or HashJoin
   // check if all conditions are equality comparison
   auto all_eq =
       std::all_of(join->conds_.begin(), join->conds_.end(), [](const auto &cond) { return cond.GetOp() == OP_EQ; });
@@ -101,15 +184,32 @@ auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shar
     left_key_fields.push_back(cond.GetLCol());
     right_key_fields.push_back(cond.GetRCol());
   }
-  std::shared_ptr<AbstractPlan> left = std::dynamic_pointer_cast<IdxScanPlan>(join->left_);
+  // a strategy given by the user is kept, otherwise choose one. sort merge is never chosen as its executor is not
+  // implemented
+  if (join->strategy_ == AUTO) {
+    auto *index     = JoinIndex(*join, left_key_fields, right_key_fields, db);
+    join->strategy_ = index != nullptr ? INDEX_NESTED_LOOP : HASH;
+    if (index != nullptr) {
+      join->idx_id_ = index->GetIndexId();
+    }
+  }
+  if (join->strategy_ == INDEX_NESTED_LOOP || join->strategy_ == HASH) {
+    join->left_key_schema_  = std::make_unique<RecordSchema>(left_key_fields);
+    join->right_key_schema_ = std::make_unique<RecordSchema>(right_key_fields);
+    return join;
+  }
+  std::shared_ptr<AbstractPlan> left  = std::dynamic_pointer_cast<IdxScanPlan>(join->left_);
+  std::shared_ptr<AbstractPlan> right = std::dynamic_pointer_cast<IdxScanPlan>(join->right_);
   // generate sort plan
   if (left == nullptr) {
-    left = std::make_shared<SortPlan>(std::move(join->left_), std::make_unique<RecordSchema>(left_key_fields), false);
+    left = std::make_shared<SortPlan>(std::move(join->left_),
+        std::make_unique<RecordSchema>(left_key_fields),
+        std::vector<bool>(left_key_fields.size(), false));
   }
-  std::shared_ptr<AbstractPlan> right = std::dynamic_pointer_cast<IdxScanPlan>(join->right_);
   if (right == nullptr) {
-    right =
-        std::make_shared<SortPlan>(std::move(join->right_), std::make_unique<RecordSchema>(right_key_fields), false);
+    right = std::make_shared<SortPlan>(std::move(join->right_),
+        std::make_unique<RecordSchema>(right_key_fields),
+        std::vector<bool>(right_key_fields.size(), false));
   }
   join->left_             = left;
   join->right_            = right;
@@ -118,12 +218,385 @@ auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shar
   return join;
 }
 
+auto Optimizer::JoinIndex(const JoinPlan &join, const std::vector<RTField> &left_keys,
+    const std::vector<RTField> &right_keys, DatabaseHandle *db) -> IndexHandle *
+{
+  auto scan = std::dynamic_pointer_cast<ScanPlan>(join.right_);
+  if (scan == nullptr) {
+    return nullptr;
+  }
+  // a probe costs about log(inner) while the other strategies read the whole inner table once
+  size_t inner_rows = db->GetTable(scan->table_name_)->GetTableHeader().rec_num_;
+  size_t outer_rows = EstimateRows(join.left_, db);
+  if (outer_rows > inner_rows / std::max<size_t>(std::bit_width(inner_rows), 1)) {
+    return nullptr;
+  }
+  // the index key is taken from the left record, so each key field should be a right key of the same type
+  auto is_join_key = [&left_keys, &right_keys](const RTField &field) {
+    for (size_t i = 0; i < right_keys.size(); ++i) {
+      if (right_keys[i].field_.table_id_ == field.field_.table_id_ &&
+          right_keys[i].field_.field_name_ == field.field_.field_name_) {
+        return left_keys[i].field_.field_type_ == field.field_.field_type_ &&
+               left_keys[i].field_.field_size_ == field.field_.field_size_;
+      }
+    }
+    return false;
+  };
+  for (auto *index : db->GetIndexes(scan->table_name_)) {
+    const auto &key_fields = index->GetKeySchema().GetFields();
+    if (index->IsLookupSupported() && !key_fields.empty() &&
+        std::all_of(key_fields.begin(), key_fields.end(), is_join_key)) {
+      return index;
+    }
+  }
+  return nullptr;
+}
+
+auto Optimizer::EstimateRows(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> size_t
+{
+  if (auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+    return db->GetTable(scan->table_name_)->GetTableHeader().rec_num_;
+  } else if (auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
+    return db->GetTable(idx_scan->table_name_)->GetTableHeader().rec_num_;
+  } else if (auto par_scan = std::dynamic_pointer_cast<ParallelScanPlan>(plan)) {
+    return EstimateFilterRows(db->GetTable(par_scan->table_name_)->GetTableHeader().rec_num_, par_scan->conds_);
+  } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    return EstimateFilterRows(EstimateRows(filter->child_, db), filter->conds_);
+  } else if (auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    return EstimateRows(proj->child_, db);
+  } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+    return std::min(lim->limit_, EstimateRows(lim->child_, db));
+  } else if (auto semi = std::dynamic_pointer_cast<SemiJoinPlan>(plan)) {
+    return EstimateRows(semi->left_, db);
+  }
+  return SIZE_MAX;
+}
+
+auto Optimizer::EstimateFilterRows(size_t rows, const ConditionVec &conds) -> size_t
+{
+  // without statistics, a condition is assumed to keep a tenth of the rows if it is an equality or an IN list and a
+  // third otherwise, and conditions are assumed to be independent
+  for (const auto &cond : conds) {
+    if (rows == SIZE_MAX) {
+      break;
+    }
+    rows = cond.GetOp() == OP_EQ || cond.GetOp() == OP_IN ? rows / 10 : rows / 3;
+  }
+  return rows;
+}
+
 auto Optimizer::PhysicalOptimize(
     std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
 {
+  // the projection of a query may be under the limit of the query, which keeps the records as they come
+  std::shared_ptr<AbstractPlan> *query = &plan;
+  while (auto lim = std::dynamic_pointer_cast<LimitPlan>(*query)) {
+    query = &lim->child_;
+  }
+  // only queries are projected, update and delete write back the whole record
+  if (std::dynamic_pointer_cast<ProjectPlan>(*query) != nullptr) {
+    PushDownProjection(*query, {}, db);
+    *query = LateMaterialize(*query, db);
+    *query = ParallelizeScan(*query, db);
+    PushDownRuntimeFilters(*query, db);
+  }
+  return plan;
+}
+
+auto Optimizer::LateMaterialize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
+{
+  auto                  proj        = std::dynamic_pointer_cast<ProjectPlan>(plan);
+  std::vector<LateScan> scans;
+  bool                  has_carrier = false;
+  if (!CollectLateScans(proj->child_, true, scans, has_carrier) || !has_carrier) {
+    return plan;
+  }
+  // the scans materialize the fields of the whole query now, narrow them to the fields used below the projection
+  std::vector<std::vector<RTField>> query_fields;
+  for (const auto &scan : scans) {
+    query_fields.push_back(*scan.proj_fields_);
+  }
+  PushDownProjection(proj->child_, {}, db);
+  std::vector<std::string> fetch_tables;
+  for (size_t i = 0; i < scans.size(); ++i) {
+    auto       &scan   = scans[i];
+    const auto *tab    = db->GetTable(scan.table_name_);
+    auto        narrow = scan.proj_fields_->empty() ? tab->GetSchema().GetFields() : *scan.proj_fields_;
+    size_t      fetch_size = 0;
+    for (const auto &field : proj->schema_->GetFields()) {
+      if (field.field_.table_id_ == tab->GetTableId() &&
+          std::none_of(narrow.begin(), narrow.end(), [&field](const RTField &f) { return f.field_ == field.field_; })) {
+        fetch_size += field.field_.field_size_;
+      }
+    }
+    if (!scan.can_defer_ || fetch_size < LATE_MATERIALIZATION_MIN_SIZE) {
+      *scan.proj_fields_ = std::move(query_fields[i]);
+      continue;
+    }
+    narrow.push_back(MakeRidField(tab->GetTableId()));
+    *scan.proj_fields_ = std::move(narrow);
+    fetch_tables.push_back(scan.table_name_);
+  }
+  if (fetch_tables.empty()) {
+    return plan;
+  }
+  return std::make_shared<FetchPlan>(std::move(proj->child_), std::move(fetch_tables), std::move(proj->schema_));
+}
+
+auto Optimizer::CollectLateScans(
+    const std::shared_ptr<AbstractPlan> &plan, bool can_defer, std::vector<LateScan> &scans, bool &has_carrier) -> bool
+{
+  if (auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+    scans.push_back({.table_name_ = scan->table_name_, .proj_fields_ = &scan->proj_fields_, .can_defer_ = can_defer});
+    return true;
+  } else if (auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
+    scans.push_back(
+        {.table_name_ = idx_scan->table_name_, .proj_fields_ = &idx_scan->proj_fields_, .can_defer_ = false});
+    return true;
+  } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    return CollectLateScans(filter->child_, can_defer, scans, has_carrier);
+  } else if (auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+    has_carrier = true;
+    return CollectLateScans(sort->child_, can_defer, scans, has_carrier);
+  } else if (auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    has_carrier = true;
+    return CollectLateScans(top_n->child_, can_defer, scans, has_carrier);
+  } else if (auto semi = std::dynamic_pointer_cast<SemiJoinPlan>(plan)) {
+    // the right input is a query of its own
+    return CollectLateScans(semi->left_, can_defer, scans, has_carrier);
+  } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+    has_carrier = true;
+    // the inner of index nested loop join reads records by the index, not by the scan
+    return CollectLateScans(join->left_, can_defer, scans, has_carrier) &&
+           CollectLateScans(join->right_, can_defer && join->strategy_ != INDEX_NESTED_LOOP, scans, has_carrier);
+  }
+  return false;
+}
+
+void Optimizer::PushDownRuntimeFilters(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db)
+{
+  if (auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    PushDownRuntimeFilters(proj->child_, db);
+  } else if (auto fetch = std::dynamic_pointer_cast<FetchPlan>(plan)) {
+    PushDownRuntimeFilters(fetch->child_, db);
+  } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    PushDownRuntimeFilters(filter->child_, db);
+  } else if (auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+    PushDownRuntimeFilters(sort->child_, db);
+  } else if (auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    PushDownRuntimeFilters(top_n->child_, db);
+  } else if (auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+    PushDownRuntimeFilters(agg->child_, db);
+  } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+    PushDownRuntimeFilters(lim->child_, db);
+  } else if (auto semi = std::dynamic_pointer_cast<SemiJoinPlan>(plan)) {
+    PushDownRuntimeFilters(semi->left_, db);
+    PushDownRuntimeFilters(semi->right_, db);
+  } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+    PushDownRuntimeFilters(join->left_, db);
+    PushDownRuntimeFilters(join->right_, db);
+    if (join->strategy_ != HASH || join->type_ != INNER_JOIN) {
+      return;
+    }
+    // the pipeline of the left input is either still a scan with its filter and projection or a parallel scan
+    const auto &keys     = join->left_key_schema_->GetFields();
+    auto        par_scan = std::dynamic_pointer_cast<ParallelScanPlan>(join->left_);
+    auto        scan     = PipelineScan(join->left_);
+    if (par_scan == nullptr && scan == nullptr) {
+      return;
+    }
+    const auto &table_name  = par_scan != nullptr ? par_scan->table_name_ : scan->table_name_;
+    const auto &proj_fields = par_scan != nullptr ? par_scan->proj_fields_ : scan->proj_fields_;
+    const auto &schema      = db->GetTable(table_name)->GetSchema();
+    // the scan should materialize all key fields, which holds unless the keys come from a projection
+    bool has_keys = std::all_of(keys.begin(), keys.end(), [&schema, &proj_fields](const RTField &key) {
+      if (proj_fields.empty()) {
+        return schema.GetRTFieldIndex(key) != schema.GetFieldCount();
+      }
+      return std::any_of(
+          proj_fields.begin(), proj_fields.end(), [&key](const RTField &field) { return field.field_ == key.field_; });
+    });
+    if (!has_keys) {
+      return;
+    }
+    join->runtime_filter_ = std::make_shared<RuntimeFilter>(keys, EstimateRows(join->right_, db));
+    (par_scan != nullptr ? par_scan->runtime_filter_ : scan->runtime_filter_) = join->runtime_filter_;
+  }
+}
+
+auto Optimizer::ParallelizeScan(
+    std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
+{
+  auto worker_num = std::min(Scheduler::GetInstance()->GetWorkerNum(), PARALLEL_SCAN_WORKER_NUM);
+  if (worker_num < 2) {
+    return plan;
+  }
+  std::vector<PipelineSlot> pipelines;
+  CollectPipelines(plan, nullptr, pipelines);
+  std::shared_ptr<AbstractPlan> *largest   = nullptr;
+  AbstractPlan                  *parent    = nullptr;
+  size_t                         max_pages = 2 * PARALLEL_SCAN_MORSEL_SIZE;
+  for (auto [pipeline, pipeline_parent] : pipelines) {
+    auto pages = db->GetTable(PipelineScan(*pipeline)->table_name_)->GetTableHeader().page_num_;
+    if (pages > max_pages) {
+      largest   = pipeline;
+      parent    = pipeline_parent;
+      max_pages = pages;
+    }
+  }
+  if (largest == nullptr) {
+    return plan;
+  }
+  auto proj   = std::dynamic_pointer_cast<ProjectPlan>(*largest);
+  auto filter = std::dynamic_pointer_cast<FilterPlan>(proj == nullptr ? *largest : proj->child_);
+  auto scan   = PipelineScan(*largest);
+
+  auto par_scan          = std::make_shared<ParallelScanPlan>(scan->table_name_, worker_num);
+  par_scan->proj_fields_ = scan->proj_fields_;
+  par_scan->skip_conds_  = scan->skip_conds_;
+  if (filter != nullptr) {
+    par_scan->conds_ = filter->conds_;
+  }
+  if (proj != nullptr) {
+    par_scan->out_fields_ = proj->schema_->GetFields();
+  }
+  *largest = par_scan;
+  // the chunks of the workers are aggregated in parallel too, stream aggregation needs no hash table to begin with
+  if (auto *agg = dynamic_cast<AggregatePlan *>(parent); agg != nullptr && !agg->is_stream_) {
+    agg->is_parallel_ = true;
+  }
+  if (auto *sort = dynamic_cast<SortPlan *>(parent); sort != nullptr) {
+    sort->is_parallel_ = true;
+  }
   return plan;
 }
 
+auto Optimizer::PipelineScan(const std::shared_ptr<AbstractPlan> &plan) -> std::shared_ptr<ScanPlan>
+{
+  auto proj   = std::dynamic_pointer_cast<ProjectPlan>(plan);
+  auto below  = proj == nullptr ? plan : proj->child_;
+  auto filter = std::dynamic_pointer_cast<FilterPlan>(below);
+  auto scan   = std::dynamic_pointer_cast<ScanPlan>(filter == nullptr ? below : filter->child_);
+  // workers filter whole chunks, which needs conditions on values or columns
+  if (filter != nullptr && std::any_of(filter->conds_.begin(), filter->conds_.end(), [](const Condition &cond) {
+        return cond.GetRhsType() != kValue && cond.GetRhsType() != kColumn;
+      })) {
+    return nullptr;
+  }
+  return scan;
+}
+
+void Optimizer::CollectPipelines(
+    std::shared_ptr<AbstractPlan> &plan, AbstractPlan *parent, std::vector<PipelineSlot> &pipelines)
+{
+  if (PipelineScan(plan) != nullptr) {
+    pipelines.emplace_back(&plan, parent);
+  } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    CollectPipelines(filter->child_, filter.get(), pipelines);
+  } else if (auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+    CollectPipelines(sort->child_, sort.get(), pipelines);
+  } else if (auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    CollectPipelines(top_n->child_, top_n.get(), pipelines);
+  } else if (auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    CollectPipelines(proj->child_, proj.get(), pipelines);
+  } else if (auto fetch = std::dynamic_pointer_cast<FetchPlan>(plan)) {
+    CollectPipelines(fetch->child_, fetch.get(), pipelines);
+  } else if (auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+    CollectPipelines(agg->child_, agg.get(), pipelines);
+  } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+    CollectPipelines(lim->child_, lim.get(), pipelines);
+  } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+    CollectPipelines(join->left_, join.get(), pipelines);
+    // the inner side of nested loop join is scanned again for every outer record, that of index nested loop join is
+    // not scanned at all
+    if (join->strategy_ != NESTED_LOOP && join->strategy_ != INDEX_NESTED_LOOP) {
+      CollectPipelines(join->right_, join.get(), pipelines);
+    }
+  } else if (auto semi = std::dynamic_pointer_cast<SemiJoinPlan>(plan)) {
+    // the right input is read to the end before the left one is initialized
+    CollectPipelines(semi->left_, semi.get(), pipelines);
+    CollectPipelines(semi->right_, semi.get(), pipelines);
+  }
+}
+
+void Optimizer::PushDownProjection(const std::shared_ptr<AbstractPlan> &plan, ColumnSet required, DatabaseHandle *db)
+{
+  auto add_field = [&required](const RTField &field) {
+    // count(*) does not reference any column
+    if (!field.field_.field_name_.empty()) {
+      required.emplace(field.field_.table_id_, field.field_.field_name_);
+    }
+  };
+  auto add_cond = [&add_field](const Condition &cond) {
+    add_field(cond.GetLCol());
+    if (cond.GetRhsType() == kColumn) {
+      add_field(cond.GetRCol());
+    }
+  };
+  if (auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    // columns above a projection are produced by the projection itself
+    required.clear();
+    for (const auto &field : proj->schema_->GetFields()) {
+      add_field(field);
+    }
+    PushDownProjection(proj->child_, std::move(required), db);
+  } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    std::for_each(filter->conds_.begin(), filter->conds_.end(), add_cond);
+    PushDownProjection(filter->child_, std::move(required), db);
+  } else if (auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+    for (const auto &field : sort->key_schema_->GetFields()) {
+      add_field(field);
+    }
+    PushDownProjection(sort->child_, std::move(required), db);
+  } else if (auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    for (const auto &field : top_n->key_schema_->GetFields()) {
+      add_field(field);
+    }
+    PushDownProjection(top_n->child_, std::move(required), db);
+  } else if (auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+    required.clear();
+    std::for_each(agg->group_fields_.begin(), agg->group_fields_.end(), add_field);
+    std::for_each(agg->agg_fields.begin(), agg->agg_fields.end(), add_field);
+    PushDownProjection(agg->child_, std::move(required), db);
+  } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+    std::for_each(join->conds_.begin(), join->conds_.end(), add_cond);
+    // columns of the other side are never matched by a scan, so both sides can share the set
+    PushDownProjection(join->left_, required, db);
+    PushDownProjection(join->right_, std::move(required), db);
+  } else if (auto semi = std::dynamic_pointer_cast<SemiJoinPlan>(plan)) {
+    add_field(semi->left_key_);
+    PushDownProjection(semi->left_, std::move(required), db);
+    // the right input is a subquery with its own projection or a list of values
+    PushDownProjection(semi->right_, {}, db);
+  } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+    PushDownProjection(lim->child_, std::move(required), db);
+  } else if (auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+    scan->proj_fields_ = MakeScanProjection(db->GetTable(scan->table_name_)->GetSchema(), required);
+  } else if (auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
+    std::for_each(idx_scan->conds_.begin(), idx_scan->conds_.end(), add_cond);
+    idx_scan->proj_fields_ = MakeScanProjection(db->GetTable(idx_scan->table_name_)->GetSchema(), required);
+  }
+}
+
+auto Optimizer::MakeScanProjection(const RecordSchema &schema, const ColumnSet &required) -> std::vector<RTField>
+{
+  std::vector<RTField> fields;
+  // keep the order of the table schema so that the fields of a minipage are still read in sequence
+  for (const auto &field : schema.GetFields()) {
+    if (required.count({field.field_.table_id_, field.field_.field_name_}) != 0) {
+      fields.push_back(field);
+    }
+  }
+  if (fields.size() == schema.GetFieldCount()) {
+    return {};
+  }
+  // e.g. select count(*), records still have to be produced, so keep the narrowest non-empty schema
+  if (fields.empty()) {
+    fields.push_back(schema.GetFieldAt(0));
+  }
+  return fields;
+}
+
 auto Optimizer::CanIndexScan(ConditionVec &conds, ConditionVec &index_conds, const std::list<IndexHandle *> &indexes,
     size_t &max_matched_fields) -> IndexHandle *
 {
@@ -21,6 +21,8 @@
 
 #ifndef WSDB_OPTIMIZER_H
 #define WSDB_OPTIMIZER_H
+#include <set>
+
 #include "plan/plan.h"
 #include "system/handle/database_handle.h"
 
@@ -39,10 +41,96 @@ private:
   static auto LogicalOptimizeScan(const std::shared_ptr<ScanPlan> &scan, ConditionVec conds,
       wsdb::DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
 
-  static auto LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shared_ptr<AbstractPlan>;
+  static auto LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * an index of the right table that supports lookups and whose key fields are all join keys, if the join is cheaper
+   * by probing the index for each left record than by reading the right table. The right input should be a scan,
+   * otherwise nullptr
+   */
+  static auto JoinIndex(const JoinPlan &join, const std::vector<RTField> &left_keys,
+      const std::vector<RTField> &right_keys, DatabaseHandle *db) -> IndexHandle *;
+
+  /// estimated number of records returned by plan from table sizes and filter conditions, SIZE_MAX if unknown
+  static auto EstimateRows(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> size_t;
+
+  /// estimated number of the rows that pass conds
+  static auto EstimateFilterRows(size_t rows, const ConditionVec &conds) -> size_t;
+
+  /// replace a sort under the limit by a top-n, which keeps only limit records in memory
+  static auto LogicalOptimizeLimit(const std::shared_ptr<LimitPlan> &lim) -> std::shared_ptr<AbstractPlan>;
+
+  /// aggregate by streaming if the child is ordered on the group fields
+  static auto LogicalOptimizeAggregate(
+      const std::shared_ptr<AggregatePlan> &agg, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+
+  /// fields the output of plan is ordered on, the most significant first, empty if the order is unknown
+  static auto OutputOrder(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> std::vector<RTField>;
 
   static auto PhysicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
 
+  /// columns are identified by table id and field name, as condition and key fields carry no alias
+  using ColumnSet = std::set<std::pair<table_id_t, std::string>>;
+
+  /**
+   * push the columns referenced by the operators above down into the table scans,
+   * so that scans only materialize the fields that are needed by the query
+   * @param plan
+   * @param required columns referenced by the ancestors of plan
+   * @param db
+   */
+  static void PushDownProjection(const std::shared_ptr<AbstractPlan> &plan, ColumnSet required, DatabaseHandle *db);
+
+  /// a table scan below the projection of a query, see LateMaterialize
+  struct LateScan
+  {
+    std::string           table_name_;
+    std::vector<RTField> *proj_fields_;
+    bool                  can_defer_;  // whether the scan can emit rids, which is not the case for index scans
+  };
+
+  /**
+   * late materialization of a query that joins or sorts. The scans below emit only the fields used by the operators
+   * and the rid of their records, and the projected fields of a table that take at least LATE_MATERIALIZATION_MIN_SIZE
+   * bytes per record are fetched by rid at the end, so that joins and sorts move narrow records. The projection is
+   * replaced by a fetch if there is such a table
+   */
+  static auto LateMaterialize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * collect the scans of a tree of joins, filters and sorts
+   * @return false if there are other operators in the tree
+   */
+  static auto CollectLateScans(const std::shared_ptr<AbstractPlan> &plan, bool can_defer, std::vector<LateScan> &scans,
+      bool &has_carrier) -> bool;
+
+  /**
+   * replace a pipeline of projection, filter and scan by a parallel scan. The workers pin pages while the rest of
+   * the plan runs, so only the pipeline of the largest table is parallel, and only if it has two morsels at least.
+   * A hash aggregation or a sort right above the parallel scan is made parallel as well
+   */
+  static auto ParallelizeScan(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * give each inner hash join whose left input is a pipeline of a scan a runtime filter on its join keys, which the
+   * join fills with its build side and the scan uses to drop the rows that have no match. Outer joins keep all left
+   * rows, so they get no filter
+   */
+  static void PushDownRuntimeFilters(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db);
+
+  /// the scan of plan if plan is a scan with an optional filter and projection above it, otherwise nullptr
+  static auto PipelineScan(const std::shared_ptr<AbstractPlan> &plan) -> std::shared_ptr<ScanPlan>;
+
+  /// a pipeline that can be run by a parallel scan and its parent, nullptr if it is the root
+  using PipelineSlot = std::pair<std::shared_ptr<AbstractPlan> *, AbstractPlan *>;
+
+  /// collect the pipelines that can be run by a parallel scan, plan itself included
+  static void CollectPipelines(
+      std::shared_ptr<AbstractPlan> &plan, AbstractPlan *parent, std::vector<PipelineSlot> &pipelines);
+
+  /// return the fields of the table schema that are in required, empty if all fields are required
+  static auto MakeScanProjection(const RecordSchema &schema, const ColumnSet &required) -> std::vector<RTField>;
+
   /**
    * check if there is an index that can be used to scan the table,
    * and return the index with the most matched fields, should store
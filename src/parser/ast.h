@@ -55,8 +55,10 @@ struct Help : public TreeNode
 struct Explain : public TreeNode
 {
   std::shared_ptr<TreeNode> stmt;
+  bool                      analyze;  // run the statement and show the plan after its execution
 
-  explicit Explain(std::shared_ptr<TreeNode> stmt_) : stmt(std::move(stmt_)) {}
+  explicit Explain(std::shared_ptr<TreeNode> stmt_, bool analyze_ = false) : stmt(std::move(stmt_)), analyze(analyze_)
+  {}
 };
 
 struct ShowTables : public TreeNode
@@ -251,12 +253,18 @@ struct BinaryExpr : public TreeNode
 
 struct OrderBy : public TreeNode
 {
-  OrderByDir                        orderby_dir_;
   std::vector<std::shared_ptr<Col>> cols_;
+  std::vector<OrderByDir>           dirs_;  // direction of each column
 
   OrderBy(OrderByDir orderby_dir, std::vector<std::shared_ptr<Col>> cols)
-      : orderby_dir_(std::move(orderby_dir)), cols_(std::move(cols))
+      : cols_(std::move(cols)), dirs_(cols_.size(), orderby_dir)
   {}
+
+  void AddCol(std::shared_ptr<Col> col, OrderByDir dir)
+  {
+    cols_.push_back(std::move(col));
+    dirs_.push_back(dir);
+  }
 };
 
 struct GroupBy : public TreeNode
@@ -276,6 +284,16 @@ struct InsertStmt : public TreeNode
   {}
 };
 
+struct LoadData : public TreeNode
+{
+  std::string file_path;
+  std::string tab_name;
+
+  LoadData(std::string file_path_, std::string tab_name_)
+      : file_path(std::move(file_path_)), tab_name(std::move(tab_name_))
+  {}
+};
+
 struct DeleteStmt : public TreeNode
 {
   std::string                              tab_name;
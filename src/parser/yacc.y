@@ -32,13 +32,15 @@ using namespace ast;
 %define parse.error verbose
 
 // keywords
-%token EXPLAIN SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM OPEN DATABASE ON ASC AS ORDER GROUP BY SUM AVG MAX MIN COUNT IN STATIC_CHECKPOINT USING NESTED_LOOP_JOIN SORT_MERGE_JOIN
+%token EXPLAIN ANALYZE SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM OPEN DATABASE ON ASC AS ORDER GROUP BY SUM AVG MAX MIN COUNT IN NOT STATIC_CHECKPOINT USING NESTED_LOOP_JOIN SORT_MERGE_JOIN HASH_JOIN
 WHERE HAVING UPDATE SET SELECT INT CHAR FLOAT BOOL INDEX AND JOIN INNER OUTER EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY ENABLE_NESTLOOP ENABLE_SORTMERGE STORAGE PAX NARY LIMIT
 // non-keywords
 %token LEQ NEQ GEQ T_EOF
 
 // type-specific tokens
 %token <sv_str> IDENTIFIER VALUE_STRING
+// keywords that are not reserved, they carry their text to be used as names
+%token <sv_str> LOAD DATA INFILE
 %token <sv_int> VALUE_INT
 %token <sv_float> VALUE_FLOAT
 %token <sv_bool> VALUE_BOOL
@@ -55,7 +57,7 @@ WHERE HAVING UPDATE SET SELECT INT CHAR FLOAT BOOL INDEX AND JOIN INNER OUTER EX
 %type <sv_expr> expr
 %type <sv_val> value
 %type <sv_vals> valueList
-%type <sv_str> tbName colName optAlias
+%type <sv_str> tbName colName optAlias unreservedWord
 %type <sv_strs> colNameList
 %type <sv_node_arr> tableList
 %type <sv_col> col aggCol
@@ -66,7 +68,7 @@ WHERE HAVING UPDATE SET SELECT INT CHAR FLOAT BOOL INDEX AND JOIN INNER OUTER EX
 %type <sv_conds> whereClause optWhereClause havingClause optHavingClause
 %type <sv_groupby> optGroupByClause
 %type <sv_join_strategy> optUsingJoinClause
-%type <sv_orderby>  order_clause opt_order_clause
+%type <sv_orderby>  order_clause opt_order_clause order_item_list
 %type <sv_orderby_dir> opt_asc_desc
 
 %%
@@ -82,6 +84,12 @@ start:
         wsdb_ast_ = std::make_shared<Explain>($2);
         YYACCEPT;
     }
+    |
+        EXPLAIN ANALYZE stmt ';'
+    {
+        wsdb_ast_ = std::make_shared<Explain>($3, true);
+        YYACCEPT;
+    }
     |   HELP
     {
         wsdb_ast_ = std::make_shared<Help>();
@@ -199,6 +207,10 @@ dml:
     {
         $$ = std::make_shared<UpdateStmt>($2, $4, $5);
     }
+    |   LOAD DATA INFILE VALUE_STRING INTO TABLE tbName
+    {
+        $$ = std::make_shared<LoadData>($4, $7);
+    }
     |   selectStmt
     {
         $$ = $1;
@@ -339,6 +351,15 @@ condition:
         auto arr = std::make_shared<ArrLit>($4);
         $$ = std::make_shared<BinaryExpr>($1, OP_IN, arr);
     }
+    | col NOT IN '(' selectStmt ')'
+    {
+        $$ = std::make_shared<BinaryExpr>($1, OP_NOT_IN, $5);
+    }
+    | col NOT IN '(' valueList ')'
+    {
+        auto arr = std::make_shared<ArrLit>($5);
+        $$ = std::make_shared<BinaryExpr>($1, OP_NOT_IN, arr);
+    }
     ;
 
 optWhereClause:
@@ -350,11 +371,13 @@ optWhereClause:
     ;
 
 optUsingJoinClause:
-    /* epsilon */ {$$ = NESTED_LOOP;}
+    /* epsilon, let the optimizer choose */ {$$ = AUTO;}
     |   USING NESTED_LOOP_JOIN
     {   $$ = NESTED_LOOP;  }
     |   USING SORT_MERGE_JOIN
     {   $$ = SORT_MERGE;}
+    |   USING HASH_JOIN
+    {   $$ = HASH;}
 
 conditionAgg:
         aggCol op value
@@ -579,9 +602,30 @@ opt_order_clause:
     ;
 
 order_clause:
-      opt_asc_desc colListWithoutAlias
+      order_item_list
     {
-        $$ = std::make_shared<OrderBy>($1, $2);
+        $$ = $1;
+    }
+    /* a leading direction applies to all columns */
+    |   ASC colListWithoutAlias
+    {
+        $$ = std::make_shared<OrderBy>(OrderBy_ASC, $2);
+    }
+    |   DESC colListWithoutAlias
+    {
+        $$ = std::make_shared<OrderBy>(OrderBy_DESC, $2);
+    }
+    ;
+
+order_item_list:
+      col opt_asc_desc
+    {
+        $$ = std::make_shared<OrderBy>($2, std::vector<std::shared_ptr<Col>>{$1});
+    }
+    |   order_item_list ',' col opt_asc_desc
+    {
+        $$ = $1;
+        $$->AddCol($3, $4);
     }
     ;
 
@@ -591,7 +635,9 @@ opt_asc_desc:
     |               { $$ = OrderBy_ASC; }
     ;
 
-tbName: IDENTIFIER;
+tbName: IDENTIFIER | unreservedWord;
+
+colName: IDENTIFIER | unreservedWord;
 
-colName: IDENTIFIER;
+unreservedWord: LOAD | DATA | INFILE;
 %%
@@ -25,6 +25,7 @@
 
 #include "system/handle/record_handle.h"
 #include "common/condition.h"
+#include "expr/runtime_filter.h"
 
 #define TAB_STR(level) std::string(2 * level, ' ')
 
@@ -40,9 +41,13 @@ public:
 class ExplainPlan : public AbstractPlan
 {
 public:
-  explicit ExplainPlan(std::shared_ptr<AbstractPlan> plan) : logical_plan_(std::move(plan)) {}
+  explicit ExplainPlan(std::shared_ptr<AbstractPlan> plan, bool analyze = false)
+      : logical_plan_(std::move(plan)), analyze_(analyze)
+  {}
 
   std::shared_ptr<AbstractPlan> logical_plan_;
+  // the query is run before its physical plan is shown, so the plan shows what happened at execution
+  bool analyze_;
 };
 
 class CreateDBPlan : public AbstractPlan
@@ -133,6 +138,20 @@ public:
   std::vector<ValueSptr> values_;
 };
 
+class LoadDataPlan : public AbstractPlan
+{
+public:
+  LoadDataPlan(std::string file_path, std::string table_name)
+      : file_path_(std::move(file_path)), table_name_(std::move(table_name))
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format("{}LoadDataPlan [{}] <{}>", TAB_STR(level), table_name_, file_path_);
+  }
+  std::string file_path_;
+  std::string table_name_;
+};
+
 class UpdatePlan : public AbstractPlan
 {
 public:
@@ -189,15 +208,84 @@ public:
   ConditionVec                  conds_;
 };
 
+/// format the runtime filter of a join or scan plan, nullptr means no filter
+inline auto RuntimeFilterToString(const RuntimeFilterSptr &filter) -> std::string
+{
+  return filter == nullptr ? "" : fmt::format(" <{}>", filter->ToString());
+}
+
+/// format the projected fields of scan plans, an empty list means all fields
+inline auto ProjFieldsToString(const std::vector<RTField> &fields) -> std::string
+{
+  if (fields.empty()) {
+    return "";
+  }
+  std::string str = " <";
+  for (const auto &field : fields) {
+    str += field.ToString() + ", ";
+  }
+  str.pop_back();
+  str.back() = '>';
+  return str;
+}
+
 class ScanPlan : public AbstractPlan
 {
 public:
   explicit ScanPlan(std::string table_name) : table_name_(std::move(table_name)) {}
   auto ToString(int level) const -> std::string override
   {
-    return fmt::format("{}ScanPlan [{}]", TAB_STR(level), table_name_);
+    return fmt::format("{}ScanPlan [{}]{}{}",
+        TAB_STR(level),
+        table_name_,
+        ProjFieldsToString(proj_fields_),
+        RuntimeFilterToString(runtime_filter_));
   }
   std::string table_name_;
+  // fields to materialize, filled by optimizer, empty means all fields
+  std::vector<RTField> proj_fields_;
+  // conditions of the filter above, used to skip pages by zone map, filled by optimizer
+  ConditionVec skip_conds_;
+  // filter published by the join above whose probe side is this scan, filled by optimizer
+  RuntimeFilterSptr runtime_filter_;
+};
+
+// a table scan with the filter and projection above it, run by several workers on morsels of pages,
+// generated by optimizer from a pipeline of projection, filter and scan of a large table
+class ParallelScanPlan : public AbstractPlan
+{
+public:
+  ParallelScanPlan(std::string table_name, size_t worker_num)
+      : table_name_(std::move(table_name)), worker_num_(worker_num)
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    std::string cond_str;
+    if (!conds_.empty()) {
+      cond_str += conds_.front().ToString();
+      for (size_t i = 1; i < conds_.size(); i++) {
+        cond_str += " AND " + conds_[i].ToString();
+      }
+    }
+    return fmt::format("{}ParallelScanPlan [{}] <{}> <{} workers>{}{}",
+        TAB_STR(level),
+        table_name_,
+        cond_str,
+        worker_num_,
+        ProjFieldsToString(out_fields_.empty() ? proj_fields_ : out_fields_),
+        RuntimeFilterToString(runtime_filter_));
+  }
+  std::string table_name_;
+  size_t      worker_num_;
+  // fields to materialize and conditions to skip pages, same as those of ScanPlan
+  std::vector<RTField> proj_fields_;
+  ConditionVec         skip_conds_;
+  // conditions of the filter
+  ConditionVec conds_;
+  // same as that of ScanPlan
+  RuntimeFilterSptr runtime_filter_;
+  // fields of the projection, empty if there is no projection
+  std::vector<RTField> out_fields_;
 };
 
 class IdxScanPlan : public AbstractPlan
@@ -215,27 +303,54 @@ public:
         cond_str += " AND " + conds_[i].ToString();
       }
     }
-    return fmt::format("{}IdxScanPlan [{}] <{}>", TAB_STR(level), table_name_, cond_str);
+    return fmt::format(
+        "{}IdxScanPlan [{}] <{}>{}", TAB_STR(level), table_name_, cond_str, ProjFieldsToString(proj_fields_));
   }
   std::string  table_name_;
   idx_id_t     idx_id_;
   ConditionVec conds_;
   int          matched_fields_;
+  // fields to materialize, filled by optimizer, empty means all fields
+  std::vector<RTField> proj_fields_;
 };
 
 class SortPlan : public AbstractPlan
 {
 public:
-  SortPlan(std::shared_ptr<AbstractPlan> child, RecordSchemaUptr key_schema, bool is_desc)
-      : child_(std::move(child)), key_schema_(std::move(key_schema)), is_desc_(is_desc)
+  SortPlan(std::shared_ptr<AbstractPlan> child, RecordSchemaUptr key_schema, std::vector<bool> is_desc)
+      : child_(std::move(child)), key_schema_(std::move(key_schema)), is_desc_(std::move(is_desc))
   {}
   auto ToString(int level) const -> std::string override
   {
-    return fmt::format("{}SortPlan <{}>\n{}", TAB_STR(level), key_schema_->ToString(), child_->ToString(level + 1));
+    return fmt::format("{}{}SortPlan <{}>\n{}",
+        TAB_STR(level),
+        is_parallel_ ? "Parallel" : "",
+        key_schema_->ToString(),
+        child_->ToString(level + 1));
   }
   std::shared_ptr<AbstractPlan> child_;
   RecordSchemaUptr              key_schema_;
-  bool                          is_desc_;
+  std::vector<bool>             is_desc_;  // direction of each key field
+  // set by optimizer if child is a parallel scan
+  bool is_parallel_{false};
+};
+
+// the first limit_ records in the order of a sort, generated by optimizer from a limit over a sort
+class TopNPlan : public AbstractPlan
+{
+public:
+  TopNPlan(std::shared_ptr<AbstractPlan> child, RecordSchemaUptr key_schema, std::vector<bool> is_desc, size_t limit)
+      : child_(std::move(child)), key_schema_(std::move(key_schema)), is_desc_(std::move(is_desc)), limit_(limit)
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format(
+        "{}TopNPlan <{}> <top {}>\n{}", TAB_STR(level), key_schema_->ToString(), limit_, child_->ToString(level + 1));
+  }
+  std::shared_ptr<AbstractPlan> child_;
+  RecordSchemaUptr              key_schema_;
+  std::vector<bool>             is_desc_;
+  size_t                        limit_;
 };
 
 class ProjectPlan : public AbstractPlan
@@ -252,6 +367,31 @@ public:
   RecordSchemaUptr              schema_;
 };
 
+// the projection of a query whose scans emit only the fields used below and the rid of their records, the other
+// projected fields of those tables are fetched by rid. Generated by optimizer, see late materialization
+class FetchPlan : public AbstractPlan
+{
+public:
+  FetchPlan(std::shared_ptr<AbstractPlan> child, std::vector<std::string> table_names, RecordSchemaUptr schema)
+      : child_(std::move(child)), table_names_(std::move(table_names)), schema_(std::move(schema))
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    std::string tables;
+    for (const auto &name : table_names_) {
+      tables += (tables.empty() ? "" : ", ") + name;
+    }
+    return fmt::format("{}FetchPlan [{}] <{}>\n{}",
+        TAB_STR(level),
+        tables,
+        schema_->ToString(),
+        child_->ToString(level + 1));
+  }
+  std::shared_ptr<AbstractPlan> child_;
+  std::vector<std::string>      table_names_;  // tables whose fields are fetched by rid
+  RecordSchemaUptr              schema_;
+};
+
 class JoinPlan : public AbstractPlan
 {
 public:
@@ -268,11 +408,12 @@ public:
         cond_str += " AND " + conds_[i].ToString();
       }
     }
-    return fmt::format("{}JoinPlan <conds: {}, type: {}, strategy: {}>\n{}\n{}",
+    return fmt::format("{}JoinPlan <conds: {}, type: {}, strategy: {}>{}\n{}\n{}",
         TAB_STR(level),
         cond_str,
         JoinTypeToString(type_),
         JoinStrategyToString(strategy_),
+        RuntimeFilterToString(runtime_filter_),
         left_->ToString(level + 1),
         right_->ToString(level + 1));
   }
@@ -281,9 +422,52 @@ public:
   ConditionVec                  conds_;
   JoinType                      type_;
   JoinStrategy                  strategy_;
-  // below is available when strategy == SortMerge
+  // below is available when strategy == SortMerge, Hash or IndexNestedLoop
   RecordSchemaUptr left_key_schema_;
   RecordSchemaUptr right_key_schema_;
+  // index of the right table probed by IndexNestedLoop, right_ is a scan of the table
+  idx_id_t idx_id_{INVALID_FILE_ID};
+  // filled by optimizer if the join publishes a runtime filter to the scan of its left input
+  RuntimeFilterSptr runtime_filter_;
+};
+
+// rows of the left input whose key is IN (semi join) or NOT IN (anti join) the values of the right input, which
+// returns a single column, e.g. an IN subquery or a long IN list. Generated by planner from the where clause
+class SemiJoinPlan : public AbstractPlan
+{
+public:
+  SemiJoinPlan(std::shared_ptr<AbstractPlan> left, std::shared_ptr<AbstractPlan> right, RTField left_key, bool is_anti)
+      : left_(std::move(left)), right_(std::move(right)), left_key_(std::move(left_key)), is_anti_(is_anti)
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format("{}{} <{} {}>\n{}\n{}",
+        TAB_STR(level),
+        is_anti_ ? "AntiJoinPlan" : "SemiJoinPlan",
+        left_key_.ToString(),
+        is_anti_ ? "NOT IN" : "IN",
+        left_->ToString(level + 1),
+        right_->ToString(level + 1));
+  }
+  std::shared_ptr<AbstractPlan> left_;
+  std::shared_ptr<AbstractPlan> right_;
+  RTField                       left_key_;
+  bool                          is_anti_;
+};
+
+// constant rows, e.g. the values of an IN list
+class ValuesPlan : public AbstractPlan
+{
+public:
+  ValuesPlan(std::vector<RTField> fields, std::vector<std::vector<ValueSptr>> rows)
+      : fields_(std::move(fields)), rows_(std::move(rows))
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format("{}ValuesPlan <{} rows>", TAB_STR(level), rows_.size());
+  }
+  std::vector<RTField>                fields_;
+  std::vector<std::vector<ValueSptr>> rows_;
 };
 
 class AggregatePlan : public AbstractPlan
@@ -314,12 +498,20 @@ public:
       agg_fields_str.pop_back();
       agg_fields_str.pop_back();
     }
-    return fmt::format(
-        "{}AggregatePlan <{}> <{}>\n{}", TAB_STR(level), group_fields_str, agg_fields_str, child_->ToString(level + 1));
+    return fmt::format("{}{}AggregatePlan <{}> <{}>\n{}",
+        TAB_STR(level),
+        is_stream_ ? "Stream" : (is_parallel_ ? "Parallel" : ""),
+        group_fields_str,
+        agg_fields_str,
+        child_->ToString(level + 1));
   }
   std::shared_ptr<AbstractPlan> child_;
   std::vector<RTField>          group_fields_;
   std::vector<RTField>          agg_fields;
+  // set by optimizer if records of a group are adjacent in the output of child
+  bool is_stream_{false};
+  // set by optimizer if child is a parallel scan
+  bool is_parallel_{false};
 };
 
 class LimitPlan : public AbstractPlan
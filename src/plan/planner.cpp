@@ -36,7 +36,7 @@ std::shared_ptr<AbstractPlan> Planner::PlanAST(const std::shared_ptr<ast::TreeNo
   } else if (const auto odb = std::dynamic_pointer_cast<ast::OpenDatabase>(ast)) {
     return std::make_shared<OpenDBPlan>(odb->db_name_);
   } else if (const auto exp = std::dynamic_pointer_cast<ast::Explain>(ast)) {
-    return std::make_shared<ExplainPlan>(std::move(PlanAST(exp->stmt, db)));
+    return std::make_shared<ExplainPlan>(std::move(PlanAST(exp->stmt, db)), exp->analyze);
   }
   if (db == nullptr) {
     WSDB_THROW(WSDB_DB_NOT_OPEN, "");
@@ -59,6 +59,10 @@ std::shared_ptr<AbstractPlan> Planner::PlanAST(const std::shared_ptr<ast::TreeNo
     }
     return std::make_shared<InsertPlan>(ins->tab_name, values);
   }
+  /// load data
+  if (const auto load = std::dynamic_pointer_cast<ast::LoadData>(ast)) {
+    return std::make_shared<LoadDataPlan>(load->file_path, load->tab_name);
+  }
   /// update
   if (const auto upd = std::dynamic_pointer_cast<ast::UpdateStmt>(ast)) {
     std::vector<std::pair<RTField, ValueSptr>> updates;
@@ -68,18 +72,24 @@ std::shared_ptr<AbstractPlan> Planner::PlanAST(const std::shared_ptr<ast::TreeNo
       auto &l_col = tbl->GetSchema().GetFieldByName(tbl->GetTableId(), u->col_name);
       updates.emplace_back(l_col, TransformValue(u->val));
     }
-    auto conds = MakeConditionVec(upd->conds, db, {upd->tab_name});
+    std::vector<std::shared_ptr<AbstractPlan>> subqueries;
+    auto conds      = MakeConditionVec(upd->conds, db, {upd->tab_name}, &subqueries);
+    auto semi_conds = ExtractSemiJoinConditions(conds);
     // ScanPlan
-    auto scan_plan   = std::make_shared<ScanPlan>(upd->tab_name);
-    auto filter_plan = std::make_shared<FilterPlan>(scan_plan, conds);
+    auto                          scan_plan   = std::make_shared<ScanPlan>(upd->tab_name);
+    std::shared_ptr<AbstractPlan> filter_plan = std::make_shared<FilterPlan>(scan_plan, conds);
+    filter_plan                               = MakeSemiJoinPlan(filter_plan, semi_conds, subqueries);
     return std::make_shared<UpdatePlan>(filter_plan, upd->tab_name, updates);
   }
   /// delete
   if (const auto del = std::dynamic_pointer_cast<ast::DeleteStmt>(ast)) {
-    auto conds = MakeConditionVec(del->conds, db, {del->tab_name});
+    std::vector<std::shared_ptr<AbstractPlan>> subqueries;
+    auto conds      = MakeConditionVec(del->conds, db, {del->tab_name}, &subqueries);
+    auto semi_conds = ExtractSemiJoinConditions(conds);
     // ScanPlan
-    auto scan_plan   = std::make_shared<ScanPlan>(del->tab_name);
-    auto filter_plan = std::make_shared<FilterPlan>(scan_plan, conds);
+    auto                          scan_plan   = std::make_shared<ScanPlan>(del->tab_name);
+    std::shared_ptr<AbstractPlan> filter_plan = std::make_shared<FilterPlan>(scan_plan, conds);
+    filter_plan                               = MakeSemiJoinPlan(filter_plan, semi_conds, subqueries);
     return std::make_shared<DeletePlan>(filter_plan, del->tab_name);
   }
   /// create table
@@ -172,13 +182,20 @@ auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::D
     sel_fields.push_back(rt);
   }
   /// analyse conditions
-  // get where and having conditions
-  auto where  = MakeConditionVec(sel->conds, db, tabs);
-  auto having = MakeConditionVec(sel->having, db, tabs);
+  // get where and having conditions, IN subqueries and long IN lists of where are evaluated by semi joins
+  std::vector<std::shared_ptr<AbstractPlan>> subqueries;
+  auto where      = MakeConditionVec(sel->conds, db, tabs, &subqueries);
+  auto semi_conds = ExtractSemiJoinConditions(where);
+  auto having     = MakeConditionVec(sel->having, db, tabs);
   // check order by cols
   std::vector<RTField> order_fields =
       sel->has_sort ? TransformCols(sel->order->cols_, db, tabs) : std::vector<RTField>{};
-  bool is_desc = sel->has_sort && sel->order->orderby_dir_ == OrderBy_DESC;
+  std::vector<bool> is_desc;
+  if (sel->has_sort) {
+    for (auto dir : sel->order->dirs_) {
+      is_desc.push_back(dir == OrderBy_DESC);
+    }
+  }
   // check group by cols
   std::vector<RTField> group_fields =
       sel->has_groupby ? TransformCols(sel->groupby->cols, db, tabs) : std::vector<RTField>{};
@@ -186,7 +203,7 @@ auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::D
   /// analyse and generate plans
   if (sub_plan != nullptr) {
     /// select with sub query
-    auto plan = std::move(sub_plan);
+    auto plan = MakeSemiJoinPlan(sub_plan, semi_conds, subqueries);
     if (is_agg) {
       plan = MakeAggregatePlan(plan, group_fields, sel_fields, having);
     }
@@ -194,6 +211,7 @@ auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::D
   } else if (tabs.size() == 1) {
     /// single table without sub query or joins
     auto plan = MakeFilterScanPlan(tabs[0], where);
+    plan      = MakeSemiJoinPlan(plan, semi_conds, subqueries);
     if (is_agg) {
       plan = MakeAggregatePlan(plan, group_fields, sel_fields, having);
     }
@@ -211,6 +229,7 @@ auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::D
       std::shared_ptr<AbstractPlan> right_plan = MakeFilterScanPlan(join_expr->right, right_cond);
       std::shared_ptr<AbstractPlan> sum_plan   = std::make_shared<JoinPlan>(
           std::move(left_plan), std::move(right_plan), join_cond, join_expr->type, sel->join_strategy);
+      sum_plan = MakeSemiJoinPlan(sum_plan, semi_conds, subqueries);
       if (is_agg) {
         sum_plan = MakeAggregatePlan(sum_plan, group_fields, sel_fields, having);
       }
@@ -239,6 +258,7 @@ auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::D
         join_tabs.pop_back();
         right_tree_tables.push_back(left_tab_name);
       }
+      right_plan = MakeSemiJoinPlan(right_plan, semi_conds, subqueries);
       if (is_agg) {
         right_plan = MakeAggregatePlan(right_plan, group_fields, sel_fields, having);
       }
@@ -261,6 +281,13 @@ auto Planner::TransformValue(const std::shared_ptr<ast::Value> &val) -> ValueSpt
     // as we do not know the type or size of the null value, we use int type and 0 size, should
     // handle carefully in executors
     return ValueFactory::CreateNullValue(TYPE_INT);
+  } else if (const auto arr = std::dynamic_pointer_cast<ast::ArrLit>(val)) {
+    std::vector<ValueSptr> values;
+    values.reserve(arr->val_.size());
+    for (const auto &v : arr->val_) {
+      values.push_back(TransformValue(v));
+    }
+    return ValueFactory::CreateArrayValue(values);
   } else {
     WSDB_FETAL("Invalid value type");
   }
@@ -286,7 +313,7 @@ auto Planner::TransformCols(const std::vector<std::shared_ptr<ast::Col>> &cols,
 }
 
 auto Planner::MakeConditionVec(const std::vector<std::shared_ptr<ast::BinaryExpr>> &exprs, DatabaseHandle *db,
-    const std::vector<std::string> &tabs) -> ConditionVec
+    const std::vector<std::string> &tabs, std::vector<std::shared_ptr<AbstractPlan>> *subqueries) -> ConditionVec
 {
   ConditionVec conds;
   conds.reserve(exprs.size());
@@ -320,9 +347,23 @@ auto Planner::MakeConditionVec(const std::vector<std::shared_ptr<ast::BinaryExpr
       conds.emplace_back(e->op_, l_rt, r_rt);
     } else if (const auto val = std::dynamic_pointer_cast<ast::Value>(rhs)) {
       auto v = TransformValue(val);
+      if (e->op_ == OP_NOT_IN && subqueries == nullptr) {
+        WSDB_THROW(WSDB_NOT_IMPLEMENTED, "NOT IN is only supported in where clause");
+      }
       conds.emplace_back(e->op_, l_rt, v);
     } else if (const auto sel = std::dynamic_pointer_cast<ast::SelectStmt>(rhs)) {
-      // TODO: subquery in condition
+      // subqueries are not correlated, so each of them is planned on its own and evaluated once by a semi join
+      if (e->op_ != OP_IN && e->op_ != OP_NOT_IN) {
+        WSDB_THROW(WSDB_NOT_IMPLEMENTED, fmt::format("subquery with {}", CompOpToString(e->op_)));
+      }
+      if (subqueries == nullptr) {
+        WSDB_THROW(WSDB_NOT_IMPLEMENTED, "subquery is only supported in where clause");
+      }
+      if (sel->cols.size() != 1) {
+        WSDB_THROW(WSDB_GRAMMAR_ERROR, "subquery of IN should return one column");
+      }
+      subqueries->push_back(PlanAST(sel, db));
+      conds.emplace_back(e->op_, l_rt, static_cast<int32_t>(subqueries->size() - 1));
     } else {
       WSDB_THROW(WSDB_GRAMMAR_ERROR, "Invalid right hand side");
     }
@@ -456,6 +497,72 @@ auto Planner::MakeFilterScanPlan(
   return std::make_shared<FilterPlan>(std::move(scan_plan), conds);
 }
 
+auto Planner::ExtractSemiJoinConditions(ConditionVec &conds) -> ConditionVec
+{
+  ConditionVec semi_conds;
+  auto         is_semi = [](const Condition &c) {
+    if (c.GetRhsType() == kSubquery || c.GetOp() == OP_NOT_IN) {
+      return true;
+    }
+    return c.GetOp() == OP_IN && c.GetRhsType() == kValue &&
+           std::dynamic_pointer_cast<ArrayValue>(c.GetRVal())->GetValueNum() >= IN_LIST_SEMI_JOIN_THRESHOLD;
+  };
+  auto it = std::stable_partition(conds.begin(), conds.end(), [&is_semi](const Condition &c) { return !is_semi(c); });
+  semi_conds.assign(it, conds.end());
+  conds.erase(it, conds.end());
+  return semi_conds;
+}
+
+auto Planner::MakeSemiJoinPlan(std::shared_ptr<AbstractPlan> &child, const ConditionVec &semi_conds,
+    const std::vector<std::shared_ptr<AbstractPlan>> &subqueries) -> std::shared_ptr<AbstractPlan>
+{
+  auto plan = std::move(child);
+  for (const auto &c : semi_conds) {
+    auto right = c.GetRhsType() == kSubquery ? subqueries[c.GetSubqueryId()]
+                                             : MakeValuesPlan(*std::dynamic_pointer_cast<ArrayValue>(c.GetRVal()));
+    plan = std::make_shared<SemiJoinPlan>(std::move(plan), std::move(right), c.GetLCol(), c.GetOp() == OP_NOT_IN);
+  }
+  return plan;
+}
+
+auto Planner::MakeValuesPlan(const ArrayValue &arr) -> std::shared_ptr<AbstractPlan>
+{
+  // nulls are of int type, see TransformValue, so the type is decided by the other values
+  FieldSchema field{.field_name_ = "in_list", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  bool        has_value = false;
+  for (const auto &v : arr.Get()) {
+    if (v->IsNull()) {
+      continue;
+    }
+    if (!has_value) {
+      field.field_type_ = v->GetType();
+      field.field_size_ = v->GetSize();
+      has_value         = true;
+    } else if (v->GetType() == TYPE_STRING && field.field_type_ == TYPE_STRING) {
+      field.field_size_ = std::max(field.field_size_, v->GetSize());
+    } else if (v->GetType() != field.field_type_) {
+      if (v->GetType() == TYPE_STRING || field.field_type_ == TYPE_STRING) {
+        WSDB_THROW(WSDB_TYPE_MISSMATCH,
+            fmt::format("{} != {} in IN list", FieldTypeToString(v->GetType()), FieldTypeToString(field.field_type_)));
+      }
+      field.field_type_ = TYPE_FLOAT;
+      field.field_size_ = sizeof(float);
+    }
+  }
+  std::vector<std::vector<ValueSptr>> rows;
+  rows.reserve(arr.GetValueNum());
+  for (const auto &v : arr.Get()) {
+    if (v->IsNull()) {
+      rows.push_back({ValueFactory::CreateNullValue(field.field_type_)});
+    } else if (v->GetType() != field.field_type_) {
+      rows.push_back({ValueFactory::CastTo(v, field.field_type_)});
+    } else {
+      rows.push_back({v});
+    }
+  }
+  return std::make_shared<ValuesPlan>(std::vector<RTField>{{.field_ = field}}, std::move(rows));
+}
+
 auto Planner::MakeAggregatePlan(std::shared_ptr<AbstractPlan> &child, const std::vector<RTField> &group_fields,
     const std::vector<RTField> &proj_fields, const ConditionVec &havings) -> std::shared_ptr<AbstractPlan>
 {
@@ -497,7 +604,7 @@ auto Planner::MakeAggregatePlan(std::shared_ptr<AbstractPlan> &child, const std:
 }
 
 auto Planner::MakeProjSortPlan(std::shared_ptr<AbstractPlan> &child, const std::vector<RTField> &proj_fields,
-    const std::vector<RTField> &sort_fields, bool is_desc) -> std::shared_ptr<AbstractPlan>
+    const std::vector<RTField> &sort_fields, const std::vector<bool> &is_desc) -> std::shared_ptr<AbstractPlan>
 {
   if (sort_fields.empty()) {
     return std::make_shared<ProjectPlan>(std::move(child), proj_fields);
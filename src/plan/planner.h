@@ -48,9 +48,14 @@ private:
   static auto TransformCols(const std::vector<std::shared_ptr<ast::Col>> &cols, DatabaseHandle *db,
       const std::vector<std::string> &tabs) -> std::vector<RTField>;
 
-  /// make a condition vector form a list of binary expressions
+  /**
+   * make a condition vector form a list of binary expressions
+   * @param subqueries plans of IN and NOT IN subqueries, a subquery condition refers to its plan by index. Subqueries
+   * are not supported if it is nullptr
+   */
   static auto MakeConditionVec(const std::vector<std::shared_ptr<ast::BinaryExpr>> &exprs, DatabaseHandle *db,
-      const std::vector<std::string> &tabs) -> ConditionVec;
+      const std::vector<std::string> &tabs,
+      std::vector<std::shared_ptr<AbstractPlan>> *subqueries = nullptr) -> ConditionVec;
 
   /// make record schema for table definition
   static auto CreateRecordSchema(const std::vector<std::shared_ptr<ast::Field>> &fields, std::string &tab_name,
@@ -79,11 +84,22 @@ private:
   static auto MakeFilterScanPlan(
       const std::string &tab_name, const ConditionVec &conds) -> std::shared_ptr<AbstractPlan>;
 
+  /// move the conditions that are evaluated by semi or anti joins out of conds, i.e. IN and NOT IN subqueries,
+  /// NOT IN lists and IN lists of at least IN_LIST_SEMI_JOIN_THRESHOLD values
+  static auto ExtractSemiJoinConditions(ConditionVec &conds) -> ConditionVec;
+
+  /// join child with the subquery or the list of each semi join condition
+  static auto MakeSemiJoinPlan(std::shared_ptr<AbstractPlan> &child, const ConditionVec &semi_conds,
+      const std::vector<std::shared_ptr<AbstractPlan>> &subqueries) -> std::shared_ptr<AbstractPlan>;
+
+  /// a single column of the values of an IN list, ints are cast to float if there is a float
+  static auto MakeValuesPlan(const ArrayValue &arr) -> std::shared_ptr<AbstractPlan>;
+
   static auto MakeAggregatePlan(std::shared_ptr<AbstractPlan> &child, const std::vector<RTField> &group_fields,
       const std::vector<RTField> &proj_fields, const ConditionVec &havings) -> std::shared_ptr<AbstractPlan>;
 
   static auto MakeProjSortPlan(std::shared_ptr<AbstractPlan> &child, const std::vector<RTField> &proj_fields,
-      const std::vector<RTField> &sort_fields, bool is_desc) -> std::shared_ptr<AbstractPlan>;
+      const std::vector<RTField> &sort_fields, const std::vector<bool> &is_desc) -> std::shared_ptr<AbstractPlan>;
 };
 }  // namespace wsdb
 
@@ -93,9 +93,12 @@ auto BufferPoolManager::DeletePage(file_id_t fid, page_id_t pid) -> bool
     if (frames_[frame_id].GetPinCount() > 0) {
         return false;
     }
+    // flush before reset, otherwise the zeroed frame is written over the page on disk
+    if (frames_[frame_id].IsDirty()) {
+        disk_manager_->WritePage(fid, pid, frames_[frame_id].GetPage()->GetData());
+    }
     frames_[frame_id].Reset();
     replacer_->Unpin(frame_id);
-    disk_manager_->WritePage(fid, pid, frames_[frame_id].GetPage()->GetData());
     page_frame_lookup_.erase({fid, pid});
     free_list_.push_back(frame_id);
     return true;
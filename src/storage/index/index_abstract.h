@@ -55,6 +55,12 @@ public:
 
   virtual void Delete(const Record &key, const RID &rid) = 0;
 
+  /// rids of the records whose key equals the given key
+  virtual auto Lookup(const Record &key) -> std::vector<RID> = 0;
+
+  /// whether Lookup is implemented, an index that does not support it is never probed by a join
+  [[nodiscard]] virtual auto IsLookupSupported() const -> bool { return false; }
+
   [[nodiscard]] auto GetIndexType() const -> IndexType { return index_type_; }
 
 private:
@@ -32,4 +32,5 @@ BPTreeIndex::BPTreeIndex(
 }
 void BPTreeIndex::Insert(const Record &key, const RID &rid) {}
 void BPTreeIndex::Delete(const Record &key, const RID &rid) {}
+auto BPTreeIndex::Lookup(const Record &key) -> std::vector<RID> { WSDB_THROW(WSDB_NOT_IMPLEMENTED, ""); }
 }  // namespace wsdb
\ No newline at end of file
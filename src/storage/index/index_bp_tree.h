@@ -32,6 +32,8 @@ public:
 
   void Delete(const Record &key, const RID &rid) override;
 
+  auto Lookup(const Record &key) -> std::vector<RID> override;
+
 
   BPTreeIndex(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, idx_id_t index_id, RecordSchema *key_schema);
 };
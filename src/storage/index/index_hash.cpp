@@ -32,4 +32,5 @@ HashIndex::HashIndex(
 }
 void HashIndex::Insert(const Record &key, const RID &rid) {}
 void HashIndex::Delete(const Record &key, const RID &rid) {}
+auto HashIndex::Lookup(const Record &key) -> std::vector<RID> { WSDB_THROW(WSDB_NOT_IMPLEMENTED, ""); }
 }  // namespace wsdb
\ No newline at end of file
@@ -34,6 +34,8 @@ public:
   void Insert(const Record &key, const RID &rid) override;
 
   void Delete(const Record &key, const RID &rid) override;
+
+  auto Lookup(const Record &key) -> std::vector<RID> override;
 };
 
 }  // namespace wsdb
@@ -48,11 +48,40 @@ IndexHandle::IndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_po
   }
 }
 
-void IndexHandle::InsertRecord(const Record &rec) {}
+IndexHandle::IndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, table_id_t tid,
+    idx_id_t iid, Index *index, RecordSchemaUptr key_schema)
+    : disk_manager_(disk_manager),
+      buffer_pool_manager_(buffer_pool_manager),
+      table_id_(tid),
+      index_id_(iid),
+      index_(index),
+      key_schema_(std::move(key_schema))
+{}
 
-void IndexHandle::DeleteRecord(const Record &rec) {}
+// the built-in indexes do not parse their key schema yet, so only a wrapped index is maintained
+void IndexHandle::InsertRecord(const Record &rec)
+{
+  if (key_schema_ == nullptr) {
+    return;
+  }
+  index_->Insert(Record(key_schema_.get(), rec), rec.GetRID());
+}
+
+void IndexHandle::DeleteRecord(const Record &rec)
+{
+  if (key_schema_ == nullptr) {
+    return;
+  }
+  index_->Delete(Record(key_schema_.get(), rec), rec.GetRID());
+}
+
+void IndexHandle::UpdateRecord(const Record &old_rec, const Record &new_rec)
+{
+  DeleteRecord(old_rec);
+  InsertRecord(new_rec);
+}
 
-void IndexHandle::UpdateRecord(const Record &old_rec, const Record &new_rec) {}
+auto IndexHandle::LookupRecord(const Record &key) -> std::vector<RID> { return index_->Lookup(key); }
 
 IndexHandle::~IndexHandle() { delete index_; }
 }  // namespace wsdb
\ No newline at end of file
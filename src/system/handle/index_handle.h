@@ -30,6 +30,14 @@ public:
   IndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, table_id_t tid, idx_id_t iid,
       IndexType index_type);
 
+  /**
+   * wrap an index made by the caller instead of one of index_type, e.g. an index kept in memory
+   * @param index owned by the handle, its key schema should be key_schema
+   * @param key_schema key fields of the index, fields of table tid
+   */
+  IndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, table_id_t tid, idx_id_t iid,
+      Index *index, RecordSchemaUptr key_schema);
+
   ~IndexHandle();
 
   /**
@@ -51,6 +59,14 @@ public:
    */
   void UpdateRecord(const Record &old_rec, const Record &new_rec);
 
+  /**
+   * rids of the records whose key equals the given key
+   * @param key record of the key schema
+   */
+  auto LookupRecord(const Record &key) -> std::vector<RID>;
+
+  [[nodiscard]] auto IsLookupSupported() const -> bool { return index_->IsLookupSupported(); }
+
   [[nodiscard]] auto GetTableId() const -> table_id_t { return table_id_; }
 
   [[nodiscard]] auto GetIndexId() const -> idx_id_t { return index_id_; }
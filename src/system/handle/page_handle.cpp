@@ -35,7 +35,16 @@ void PageHandle::WriteSlot(size_t slot_id, const char *null_map, const char *dat
 }
 
 void PageHandle::ReadSlot(size_t slot_id, char *null_map, char *data) { WSDB_THROW(WSDB_EXCEPTION_EMPTY, ""); }
+void PageHandle::ReadSlotNullMap(size_t slot_id, char *null_map) { WSDB_THROW(WSDB_EXCEPTION_EMPTY, ""); }
+void PageHandle::ReadSlotFields(size_t slot_id, const std::vector<FieldProjection> &projs, char *null_map, char *data)
+{
+    WSDB_THROW(WSDB_EXCEPTION_EMPTY, "");
+}
 auto PageHandle::ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr { WSDB_THROW(WSDB_EXCEPTION_EMPTY, ""); }
+void PageHandle::AppendToChunk(const std::vector<FieldProjection> &projs, Chunk *chunk)
+{
+    WSDB_THROW(WSDB_EXCEPTION_EMPTY, "");
+}
 
 NAryPageHandle::NAryPageHandle(const TableHeader *tab_hdr, Page *page)
     : PageHandle(
@@ -61,6 +70,47 @@ void NAryPageHandle::ReadSlot(size_t slot_id, char *null_map, char *data)
     memcpy(data, slots_mem_ + slot_id * rec_full_size + tab_hdr_->nullmap_size_, tab_hdr_->rec_size_);
 }
 
+void NAryPageHandle::ReadSlotNullMap(size_t slot_id, char *null_map)
+{
+    WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+    WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == true, "slot is empty");
+    size_t rec_full_size = tab_hdr_->nullmap_size_ + tab_hdr_->rec_size_;
+    memcpy(null_map, slots_mem_ + slot_id * rec_full_size, tab_hdr_->nullmap_size_);
+}
+
+void NAryPageHandle::ReadSlotFields(
+    size_t slot_id, const std::vector<FieldProjection> &projs, char *null_map, char *data)
+{
+    WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+    WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == true, "slot is empty");
+    const char *slot_null_map = slots_mem_ + slot_id * (tab_hdr_->nullmap_size_ + tab_hdr_->rec_size_);
+    const char *slot_data     = slot_null_map + tab_hdr_->nullmap_size_;
+    for (const auto &proj : projs) {
+        memcpy(data + proj.dst_offset_, slot_data + proj.src_offset_, proj.size_);
+        if (BitMap::GetBit(slot_null_map, proj.field_idx_)) {
+            BitMap::SetBit(null_map, proj.proj_idx_, true);
+        }
+    }
+}
+
+void NAryPageHandle::AppendToChunk(const std::vector<FieldProjection> &projs, Chunk *chunk)
+{
+    WSDB_ASSERT(chunk->GetRowNum() + page_->GetRecordNum() <= chunk->GetCapacity(), "chunk overflow");
+    size_t rec_full_size = tab_hdr_->nullmap_size_ + tab_hdr_->rec_size_;
+    size_t row           = chunk->GetRowNum();
+    for (size_t slot_id = BitMap::FindFirst(bitmap_, tab_hdr_->rec_per_page_, 0, true);
+         slot_id < tab_hdr_->rec_per_page_;
+         slot_id = BitMap::FindFirst(bitmap_, tab_hdr_->rec_per_page_, slot_id + 1, true), ++row) {
+        const char *slot_null_map = slots_mem_ + slot_id * rec_full_size;
+        const char *slot_data     = slot_null_map + tab_hdr_->nullmap_size_;
+        for (const auto &proj : projs) {
+            memcpy(chunk->GetColData(proj.proj_idx_) + row * proj.size_, slot_data + proj.src_offset_, proj.size_);
+            BitMap::SetBit(chunk->GetColNullMap(proj.proj_idx_), row, BitMap::GetBit(slot_null_map, proj.field_idx_));
+        }
+    }
+    chunk->SetRowNum(row);
+}
+
 PAXPageHandle::PAXPageHandle(
     const TableHeader *tab_hdr, Page *page, const RecordSchema *schema, const std::vector<size_t> &offsets)
     : PageHandle(tab_hdr, page, page->GetData() + PAGE_HEADER_SIZE,
@@ -79,21 +129,90 @@ PAXPageHandle::~PAXPageHandle() = default;
 // | field_m_1, field_m_2, ... , field_m_n |
 void PAXPageHandle::WriteSlot(size_t slot_id, const char *null_map, const char *data, bool update)
 {
-    // WSDB_STUDENT_TODO(l1, f2);
-    
+    WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+    WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == update, fmt::format("update: {}", update));
+    memcpy(slots_mem_ + slot_id * tab_hdr_->nullmap_size_, null_map, tab_hdr_->nullmap_size_);
+    for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+        size_t field_size = schema_->GetFieldAt(i).field_.field_size_;
+        memcpy(slots_mem_ + offsets_[i] + slot_id * field_size, data + schema_->GetFieldOffset(i), field_size);
+    }
+}
+
+void PAXPageHandle::ReadSlot(size_t slot_id, char *null_map, char *data)
+{
+    WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+    WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == true, "slot is empty");
+    memcpy(null_map, slots_mem_ + slot_id * tab_hdr_->nullmap_size_, tab_hdr_->nullmap_size_);
+    for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+        size_t field_size = schema_->GetFieldAt(i).field_.field_size_;
+        memcpy(data + schema_->GetFieldOffset(i), slots_mem_ + offsets_[i] + slot_id * field_size, field_size);
+    }
+}
+
+void PAXPageHandle::ReadSlotNullMap(size_t slot_id, char *null_map)
+{
+    WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+    WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == true, "slot is empty");
+    memcpy(null_map, slots_mem_ + slot_id * tab_hdr_->nullmap_size_, tab_hdr_->nullmap_size_);
 }
 
-void PAXPageHandle::ReadSlot(size_t slot_id, char *null_map, char *data) { 
-    // WSDB_STUDENT_TODO(l1, f2); 
-        
+void PAXPageHandle::ReadSlotFields(
+    size_t slot_id, const std::vector<FieldProjection> &projs, char *null_map, char *data)
+{
+    WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+    WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == true, "slot is empty");
+    const char *slot_null_map = slots_mem_ + slot_id * tab_hdr_->nullmap_size_;
+    for (const auto &proj : projs) {
+        memcpy(data + proj.dst_offset_, slots_mem_ + offsets_[proj.field_idx_] + slot_id * proj.size_, proj.size_);
+        if (BitMap::GetBit(slot_null_map, proj.field_idx_)) {
+            BitMap::SetBit(null_map, proj.proj_idx_, true);
+        }
+    }
 }
 
 auto PAXPageHandle::ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr
 {
-    std::vector<ArrayValueSptr> col_arrs;
-    col_arrs.reserve(chunk_schema->GetFieldCount());
-    // read data each field and construct ArrayValue
-    WSDB_STUDENT_TODO(l1, f2);
-    return std::make_unique<Chunk>(chunk_schema, std::move(col_arrs));
+    std::vector<FieldProjection> projs;
+    projs.reserve(chunk_schema->GetFieldCount());
+    for (size_t i = 0; i < chunk_schema->GetFieldCount(); ++i) {
+        const auto &field = chunk_schema->GetFieldAt(i);
+        size_t      idx   = schema_->GetRTFieldIndex(field);
+        if (idx == schema_->GetFieldCount()) {
+            WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+        }
+        projs.push_back({.field_idx_ = idx,
+            .proj_idx_ = i,
+            .src_offset_ = schema_->GetFieldOffset(idx),
+            .dst_offset_ = chunk_schema->GetFieldOffset(i),
+            .size_ = field.field_.field_size_});
+    }
+    auto chunk = std::make_unique<Chunk>(chunk_schema, tab_hdr_->rec_per_page_);
+    AppendToChunk(projs, chunk.get());
+    return chunk;
+}
+
+void PAXPageHandle::AppendToChunk(const std::vector<FieldProjection> &projs, Chunk *chunk)
+{
+    WSDB_ASSERT(chunk->GetRowNum() + page_->GetRecordNum() <= chunk->GetCapacity(), "chunk overflow");
+    // a minipage is copied column by column, only the minipages of requested fields are touched
+    size_t first_row = chunk->GetRowNum();
+    size_t row       = first_row;
+    for (const auto &proj : projs) {
+        const char *minipage = slots_mem_ + offsets_[proj.field_idx_];
+        char       *col      = chunk->GetColData(proj.proj_idx_);
+        char       *col_null = chunk->GetColNullMap(proj.proj_idx_);
+        row                  = first_row;
+        for (size_t slot_id = BitMap::FindFirst(bitmap_, tab_hdr_->rec_per_page_, 0, true);
+             slot_id < tab_hdr_->rec_per_page_;
+             slot_id = BitMap::FindFirst(bitmap_, tab_hdr_->rec_per_page_, slot_id + 1, true), ++row) {
+            memcpy(col + row * proj.size_, minipage + slot_id * proj.size_, proj.size_);
+            const char *slot_null_map = slots_mem_ + slot_id * tab_hdr_->nullmap_size_;
+            BitMap::SetBit(col_null, row, BitMap::GetBit(slot_null_map, proj.field_idx_));
+        }
+    }
+    if (projs.empty()) {
+        row += page_->GetRecordNum();
+    }
+    chunk->SetRowNum(row);
 }
 }  // namespace wsdb
@@ -27,6 +27,19 @@
 #include "record_handle.h"
 
 namespace wsdb {
+
+/**
+ * Describe how a field of the table record is copied into a projected record, offsets are in record layout
+ */
+struct FieldProjection
+{
+  size_t field_idx_;   // field index in the table schema
+  size_t proj_idx_;    // field index in the projected schema
+  size_t src_offset_;  // field offset in the table record
+  size_t dst_offset_;  // field offset in the projected record
+  size_t size_;
+};
+
 class PageHandle
 {
 public:
@@ -45,8 +58,31 @@ public:
 
   virtual void ReadSlot(size_t slot_id, char *null_map, char *data);
 
+  /**
+   * Read only the null map of the record in the slot
+   * @param slot_id
+   * @param null_map null map of the table record
+   */
+  virtual void ReadSlotNullMap(size_t slot_id, char *null_map);
+
+  /**
+   * Read only the projected fields of the record in the slot
+   * @param slot_id
+   * @param projs fields to read, see FieldProjection
+   * @param null_map null map of the projected record, should be zeroed by the caller
+   * @param data data of the projected record
+   */
+  virtual void ReadSlotFields(size_t slot_id, const std::vector<FieldProjection> &projs, char *null_map, char *data);
+
   virtual auto ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr;
 
+  /**
+   * Append the projected fields of all records in the page to the chunk, the records are appended in slot order
+   * @param projs fields to read, proj_idx_ is the column in the chunk
+   * @param chunk should have room for all records of the page and no selection
+   */
+  virtual void AppendToChunk(const std::vector<FieldProjection> &projs, Chunk *chunk);
+
   virtual ~PageHandle() = default;
 
   void SetNextPageId(page_id_t next_pid) { next_pid_ = next_pid; }
@@ -75,6 +111,12 @@ public:
   void WriteSlot(size_t slot_id, const char *null_map, const char *data, bool update) override;
 
   void ReadSlot(size_t slot_id, char *null_map, char *data) override;
+
+  void ReadSlotNullMap(size_t slot_id, char *null_map) override;
+
+  void ReadSlotFields(size_t slot_id, const std::vector<FieldProjection> &projs, char *null_map, char *data) override;
+
+  void AppendToChunk(const std::vector<FieldProjection> &projs, Chunk *chunk) override;
 };
 
 /**
@@ -101,8 +143,14 @@ public:
 
   void ReadSlot(size_t slot_id, char *null_map, char *data) override;
 
+  void ReadSlotNullMap(size_t slot_id, char *null_map) override;
+
+  void ReadSlotFields(size_t slot_id, const std::vector<FieldProjection> &projs, char *null_map, char *data) override;
+
   auto ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr override;
 
+  void AppendToChunk(const std::vector<FieldProjection> &projs, Chunk *chunk) override;
+
 private:
   const RecordSchema        *schema_;
   const std::vector<size_t> &offsets_;
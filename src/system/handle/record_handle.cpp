@@ -189,7 +189,7 @@ Record::Record(const RecordSchema *schema, const Record &other) : schema_(schema
       WSDB_FETAL("Field not found in other record");
     }
     auto other_offset = other.schema_->offsets_[other_idx];
-    std::memcpy(data_ + schema_->offsets_[i], other.data_ + other_offset, field.field_.field_size_);
+    std::memcpy(data_ + schema_->GetFieldOffset(i), other.data_ + other_offset, field.field_.field_size_);
     if (BitMap::GetBit(other.nullmap_, other_idx)) {
       BitMap::SetBit(nullmap_, i, true);
     }
@@ -301,28 +301,13 @@ auto Record::operator==(const Record &other) const -> bool
 
 auto Record::Hash() const -> size_t
 {
-  // use schema and data_ to generate hash
+  // use schema and data_ to generate hash, null fields are skipped
   size_t hash = 0;
   for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
     if (BitMap::GetBit(nullmap_, i)) {
       continue;
     }
-    auto &field = schema_->GetFieldAt(i);
-    switch (field.field_.field_type_) {
-      case FieldType::TYPE_BOOL:
-        hash ^= std::hash<bool>{}(*reinterpret_cast<const bool *>(data_ + schema_->offsets_[i]));
-        break;
-      case FieldType::TYPE_INT:
-        hash ^= std::hash<int32_t>{}(*reinterpret_cast<const int32_t *>(data_ + schema_->offsets_[i]));
-        break;
-      case FieldType::TYPE_FLOAT:
-        hash ^= std::hash<float>{}(*reinterpret_cast<const float *>(data_ + schema_->offsets_[i]));
-        break;
-      case FieldType::TYPE_STRING:
-        hash ^= std::hash<std::string>{}(std::string(data_ + schema_->offsets_[i], field.field_.field_size_));
-        break;
-      default: WSDB_FETAL("Unsupported field type to hash");
-    }
+    hash = Datum::HashCombine(hash, GetDatumAt(i).Hash());
   }
   return hash;
 }
@@ -338,6 +323,16 @@ auto Record::GetValueAt(size_t index) const -> ValueSptr
       field.field_.field_type_, data_ + schema_->offsets_[index], field.field_.field_size_);
 }
 
+auto Record::GetDatumAt(size_t index) const -> Datum
+{
+  WSDB_ASSERT(index < schema_->GetFieldCount(), "Index out of range");
+  if (BitMap::GetBit(nullmap_, index)) {
+    return {};
+  }
+  auto &field = schema_->GetFieldAt(index);
+  return Datum::FromRaw(field.field_.field_type_, data_ + schema_->offsets_[index], field.field_.field_size_);
+}
+
 auto Record::Compare(const wsdb::Record &lrec, const wsdb::Record &rrec) -> int
 {
   // compare two records,
@@ -345,27 +340,82 @@ auto Record::Compare(const wsdb::Record &lrec, const wsdb::Record &rrec) -> int
   // more loose assert to support two similar records
   WSDB_ASSERT(lrec.GetSchema()->GetFieldCount() == rrec.GetSchema()->GetFieldCount(), "field count mismatch");
   for (size_t i = 0; i < lrec.GetSchema()->GetFieldCount(); ++i) {
-    auto lval = lrec.GetValueAt(i);
-    auto rval = rrec.GetValueAt(i);
-    if (lval->IsNull() && rval->IsNull()) {
-      continue;
-    }
-    if (lval->IsNull() || rval->IsNull()) {
-      return lval->IsNull() ? -1 : 1;
-    }
-    if (*lval < *rval) {
-      return -1;
-    }
-    if (*lval > *rval) {
-      return 1;
+    int cmp = Datum::CompareNullsFirst(lrec.GetDatumAt(i), rrec.GetDatumAt(i));
+    if (cmp != 0) {
+      return cmp;
     }
   }
   return 0;
 }
 
-Chunk::Chunk(const RecordSchema *schema, std::vector<ArrayValueSptr> cols) : schema_(schema), cols_(std::move(cols))
+Chunk::Chunk(const RecordSchema *schema, size_t capacity)
+    : schema_(schema), capacity_(capacity), row_num_(0), has_sel_(false)
+{
+  col_data_.reserve(schema_->GetFieldCount());
+  null_maps_.reserve(schema_->GetFieldCount());
+  for (const auto &field : schema_->GetFields()) {
+    col_data_.emplace_back(capacity_ * field.field_.field_size_);
+    null_maps_.emplace_back(BITMAP_SIZE(capacity_));
+  }
+}
+
+Chunk::Chunk(const RecordSchema *schema, std::vector<ArrayValueSptr> cols)
+    : Chunk(schema, cols.empty() ? 0 : cols[0]->GetValueNum())
+{
+  WSDB_ASSERT(schema_->GetFieldCount() == cols.size(), "Field count mismatch");
+  for (size_t i = 0; i < cols.size(); ++i) {
+    const auto &field = schema_->GetFieldAt(i).field_;
+    const auto &vals  = cols[i]->Get();
+    WSDB_ASSERT(vals.size() == capacity_, "Column size mismatch");
+    for (size_t row = 0; row < vals.size(); ++row) {
+      char *dst = col_data_[i].data() + row * field.field_size_;
+      if (vals[row]->IsNull()) {
+        BitMap::SetBit(null_maps_[i].data(), row, true);
+        continue;
+      }
+      switch (field.field_type_) {
+        case TYPE_BOOL: *reinterpret_cast<bool *>(dst) = std::dynamic_pointer_cast<BoolValue>(vals[row])->Get(); break;
+        case TYPE_INT: *reinterpret_cast<int32_t *>(dst) = std::dynamic_pointer_cast<IntValue>(vals[row])->Get(); break;
+        case TYPE_FLOAT:
+          *reinterpret_cast<float *>(dst) = std::dynamic_pointer_cast<FloatValue>(vals[row])->Get();
+          break;
+        case TYPE_STRING: {
+          const auto &str = std::dynamic_pointer_cast<StringValue>(vals[row])->Get();
+          memcpy(dst, str.data(), std::min(str.size(), field.field_size_));
+          break;
+        }
+        default: WSDB_FETAL("Unsupported field type");
+      }
+    }
+  }
+  row_num_ = capacity_;
+}
+
+Chunk::Chunk(const RecordSchema *schema, Chunk &&other)
+    : schema_(schema),
+      capacity_(other.capacity_),
+      row_num_(other.row_num_),
+      has_sel_(other.has_sel_),
+      sel_(std::move(other.sel_))
 {
-  WSDB_ASSERT(schema_->GetFieldCount() == cols_.size(), "Field count mismatch");
+  // a column of other may be requested more than once, only the first one can take it
+  std::vector<size_t> taken_by(other.schema_->GetFieldCount(), schema_->GetFieldCount());
+  col_data_.reserve(schema_->GetFieldCount());
+  null_maps_.reserve(schema_->GetFieldCount());
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    auto idx = other.schema_->GetRTFieldIndex(schema_->GetFieldAt(i));
+    if (idx == other.schema_->GetFieldCount()) {
+      WSDB_FETAL("Field not found in other chunk");
+    }
+    if (taken_by[idx] != schema_->GetFieldCount()) {
+      col_data_.push_back(col_data_[taken_by[idx]]);
+      null_maps_.push_back(null_maps_[taken_by[idx]]);
+      continue;
+    }
+    taken_by[idx] = i;
+    col_data_.push_back(std::move(other.col_data_[idx]));
+    null_maps_.push_back(std::move(other.null_maps_[idx]));
+  }
 }
 
 Chunk::~Chunk() = default;
@@ -378,7 +428,85 @@ Chunk &Chunk::operator=(const wsdb::Chunk &chunk) = default;
 
 Chunk &Chunk::operator=(wsdb::Chunk &&chunk) noexcept = default;
 
-auto Chunk::GetCol(int index) -> ArrayValueSptr { return cols_[index]; }
+auto Chunk::GetCol(int index) -> ArrayValueSptr
+{
+  auto col = ValueFactory::CreateArrayValue();
+  for (size_t i = 0; i < GetSize(); ++i) {
+    auto datum = GetDatum(index, RowAt(i));
+    col->Append(datum.IsNull() ? ValueFactory::CreateNullValue(schema_->GetFieldAt(index).field_.field_type_)
+                               : datum.ToValue());
+  }
+  return col;
+}
+
+auto Chunk::GetColCount() -> size_t { return col_data_.size(); }
+
+void Chunk::SetRowNum(size_t row_num)
+{
+  WSDB_ASSERT(row_num <= capacity_, fmt::format("row num {} exceeds capacity {}", row_num, capacity_));
+  row_num_ = row_num;
+}
+
+void Chunk::SetSelection(SelVector sel)
+{
+  sel_     = std::move(sel);
+  has_sel_ = true;
+}
+
+void Chunk::Truncate(size_t n)
+{
+  if (n >= GetSize()) {
+    return;
+  }
+  if (has_sel_) {
+    sel_.resize(n);
+  } else {
+    row_num_ = n;
+  }
+}
+
+auto Chunk::GetDatum(size_t col, size_t row) const -> Datum
+{
+  if (BitMap::GetBit(null_maps_[col].data(), row)) {
+    return {};
+  }
+  const auto &field = schema_->GetFieldAt(col).field_;
+  return Datum::FromRaw(field.field_type_, col_data_[col].data() + row * field.field_size_, field.field_size_);
+}
+
+void Chunk::AppendRecord(const Record &record) { AppendRow(record.GetNullMap(), record.GetData()); }
+
+void Chunk::AppendRow(const char *nullmap, const char *data)
+{
+  WSDB_ASSERT(!has_sel_ && row_num_ < capacity_, "Chunk is full or selected");
+  for (size_t i = 0; i < col_data_.size(); ++i) {
+    auto size = schema_->GetFieldAt(i).field_.field_size_;
+    memcpy(col_data_[i].data() + row_num_ * size, data + schema_->GetFieldOffset(i), size);
+    BitMap::SetBit(null_maps_[i].data(), row_num_, BitMap::GetBit(nullmap, i));
+  }
+  row_num_++;
+}
+
+auto Chunk::GetRecord(size_t i) const -> RecordUptr
+{
+  auto row     = RowAt(i);
+  auto data    = std::make_unique<char[]>(schema_->GetRecordLength());
+  auto nullmap = std::make_unique<char[]>(BITMAP_SIZE(schema_->GetFieldCount()));
+  memset(nullmap.get(), 0, BITMAP_SIZE(schema_->GetFieldCount()));
+  for (size_t col = 0; col < col_data_.size(); ++col) {
+    auto size = schema_->GetFieldAt(col).field_.field_size_;
+    memcpy(data.get() + schema_->GetFieldOffset(col), col_data_[col].data() + row * size, size);
+    if (BitMap::GetBit(null_maps_[col].data(), row)) {
+      BitMap::SetBit(nullmap.get(), col, true);
+    }
+  }
+  return std::make_unique<Record>(schema_, nullmap.get(), data.get(), INVALID_RID);
+}
 
-auto Chunk::GetColCount() -> size_t { return cols_.size(); }
+void Chunk::Reset()
+{
+  row_num_ = 0;
+  has_sel_ = false;
+  sel_.clear();
+}
 }  // namespace wsdb
\ No newline at end of file
@@ -26,6 +26,7 @@
 #include "common/meta.h"
 #include "common/rid.h"
 #include "common/value.h"
+#include "common/datum.h"
 #include "common/bitmap.h"
 
 namespace wsdb {
@@ -165,6 +166,9 @@ public:
 
   [[nodiscard]] auto GetValueAt(size_t index) const -> ValueSptr;
 
+  /// Get the field as a datum, string datum refers to the record data, so it is valid as long as the record is alive
+  [[nodiscard]] auto GetDatumAt(size_t index) const -> Datum;
+
   /// Get the schema of this record
   [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
 
@@ -181,13 +185,28 @@ private:
   RID                 rid_{};
 };
 
+/**
+ * Chunk is a batch of records stored by column, each column is a contiguous array of fixed-size fields in record
+ * layout with a null bitmap. A selection vector marks the rows that are still alive, e.g. after filtering, so that
+ * operators only narrow it instead of copying the columns. Rows are addressed in two ways: the physical row is the
+ * position in the column arrays, the logical row is the position in the selection
+ */
 class Chunk
 {
 public:
+  using SelVector = std::vector<uint32_t>;
+
   Chunk() = delete;
 
+  /// make an empty chunk that can hold capacity rows
+  Chunk(const RecordSchema *schema, size_t capacity);
+
+  /// make a chunk of the values, all columns should have the same number of values
   Chunk(const RecordSchema *schema, std::vector<ArrayValueSptr> cols);
 
+  /// make a chunk of the fields in schema by moving the columns out of other, the selection is kept
+  Chunk(const RecordSchema *schema, Chunk &&other);
+
   ~Chunk();
 
   Chunk(const Chunk &chunk);
@@ -198,13 +217,69 @@ public:
 
   Chunk &operator=(Chunk &&chunk) noexcept;
 
+  /// materialize the values of the selected rows in a column
   auto GetCol(int index) -> ArrayValueSptr;
 
   auto GetColCount() -> size_t;
 
+  [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
+
+  [[nodiscard]] auto GetCapacity() const -> size_t { return capacity_; }
+
+  /// number of physical rows
+  [[nodiscard]] auto GetRowNum() const -> size_t { return row_num_; }
+
+  /// set the number of physical rows after filling the columns directly
+  void SetRowNum(size_t row_num);
+
+  [[nodiscard]] auto IsFull() const -> bool { return row_num_ == capacity_; }
+
+  /// number of selected rows
+  [[nodiscard]] auto GetSize() const -> size_t { return has_sel_ ? sel_.size() : row_num_; }
+
+  /// physical row of the logical row i
+  [[nodiscard]] auto RowAt(size_t i) const -> size_t { return has_sel_ ? sel_[i] : i; }
+
+  [[nodiscard]] auto HasSelection() const -> bool { return has_sel_; }
+
+  [[nodiscard]] auto GetSelection() const -> const SelVector & { return sel_; }
+
+  /// replace the selection with physical rows in ascending order
+  void SetSelection(SelVector sel);
+
+  /// keep only the first n selected rows
+  void Truncate(size_t n);
+
+  [[nodiscard]] auto GetColData(size_t col) -> char * { return col_data_[col].data(); }
+
+  [[nodiscard]] auto GetColData(size_t col) const -> const char * { return col_data_[col].data(); }
+
+  [[nodiscard]] auto GetColNullMap(size_t col) -> char * { return null_maps_[col].data(); }
+
+  [[nodiscard]] auto GetColNullMap(size_t col) const -> const char * { return null_maps_[col].data(); }
+
+  [[nodiscard]] auto GetDatum(size_t col, size_t row) const -> Datum;
+
+  /// append a record whose schema has the same layout as the chunk, the chunk should not have a selection
+  void AppendRecord(const Record &record);
+
+  /// append a row given by its null map and data in record layout of the schema of the chunk
+  void AppendRow(const char *nullmap, const char *data);
+
+  /// materialize the logical row i
+  [[nodiscard]] auto GetRecord(size_t i) const -> RecordUptr;
+
+  /// clear rows and selection for reuse
+  void Reset();
+
 private:
-  const RecordSchema         *schema_;
-  std::vector<ArrayValueSptr> cols_;
+  const RecordSchema            *schema_;
+  size_t                         capacity_;
+  size_t                         row_num_;
+  std::vector<std::vector<char>> col_data_;
+  std::vector<std::vector<char>> null_maps_;
+  bool                           has_sel_;
+  SelVector                      sel_;
 };
 
 }  // namespace wsdb
@@ -29,14 +29,19 @@ TableHandle::TableHandle(DiskManager *disk_manager, BufferPoolManager *buffer_po
       disk_manager_(disk_manager),
       buffer_pool_manager_(buffer_pool_manager),
       schema_(std::move(schema)),
-      storage_model_(storage_model)
+      storage_model_(storage_model),
+      zone_map_(std::make_unique<ZoneMap>(schema_.get())),
+      slot_nullmap_(tab_hdr_.nullmap_size_)
 {
     // set table id for table handle;
     schema_->SetTableId(table_id_);
     if (storage_model_ == PAX_MODEL) {
         field_offset_.resize(schema_->GetFieldCount());
-        // calculate offsets of fields
-        WSDB_STUDENT_TODO(l1, f2);
+        // calculate offsets of fields, offsets are relative to the beginning of slot memory, minipage of field i
+        // follows the null maps and the minipages of the former fields
+        for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+            field_offset_[i] = tab_hdr_.rec_per_page_ * (tab_hdr_.nullmap_size_ + schema_->GetFieldOffset(i));
+        }
     }
 }
 
@@ -59,11 +64,111 @@ auto TableHandle::GetRecord(const RID &rid) -> RecordUptr
     }
 }
 
-auto TableHandle::GetChunk(page_id_t pid, const RecordSchema *chunk_schema) -> ChunkUptr { 
-    // WSDB_STUDENT_TODO(l1, f2); 
-    
+auto TableHandle::GetRecords(const std::vector<RID> &rids, const RecordSchema *proj_schema)
+    -> std::vector<RecordUptr>
+{
+    // a full record can be read by slot, otherwise copy the projected fields one by one
+    bool full    = proj_schema == schema_.get();
+    auto projs   = full ? std::vector<FieldProjection>{} : MakeFieldProjections(proj_schema);
+    auto rid_idx = full ? proj_schema->GetFieldCount() : RidFieldIndex(proj_schema);
+
+    auto                    nullmap = std::make_unique<char[]>(BITMAP_SIZE(proj_schema->GetFieldCount()));
+    auto                    data    = std::make_unique<char[]>(proj_schema->GetRecordLength());
+    std::vector<RecordUptr> records;
+    records.reserve(rids.size());
+    PageHandleUptr page_handle;
+    try {
+        for (const auto &rid : rids) {
+            if (page_handle == nullptr || page_handle->GetPage()->GetPageId() != rid.PageID()) {
+                if (page_handle != nullptr) {
+                    buffer_pool_manager_->UnpinPage(table_id_, page_handle->GetPage()->GetPageId(), false);
+                    page_handle = nullptr;
+                }
+                page_handle = FetchPageHandle(rid.PageID());
+            }
+            if (!BitMap::GetBit(page_handle->GetBitmap(), rid.SlotID())) {
+                WSDB_THROW(WSDB_RECORD_MISS, "");
+            }
+            if (full) {
+                page_handle->ReadSlot(rid.SlotID(), nullmap.get(), data.get());
+            } else {
+                memset(nullmap.get(), 0, BITMAP_SIZE(proj_schema->GetFieldCount()));
+                page_handle->ReadSlotFields(rid.SlotID(), projs, nullmap.get(), data.get());
+            }
+            if (rid_idx != proj_schema->GetFieldCount()) {
+                memcpy(data.get() + proj_schema->GetFieldOffset(rid_idx), &rid, sizeof(RID));
+            }
+            records.push_back(std::make_unique<Record>(proj_schema, nullmap.get(), data.get(), rid));
+        }
+    } catch (...) {
+        if (page_handle != nullptr) {
+            buffer_pool_manager_->UnpinPage(table_id_, page_handle->GetPage()->GetPageId(), false);
+        }
+        throw;
+    }
+    if (page_handle != nullptr) {
+        buffer_pool_manager_->UnpinPage(table_id_, page_handle->GetPage()->GetPageId(), false);
+    }
+    return records;
 }
 
+auto TableHandle::GetPageRecords(page_id_t pid, const RecordSchema *proj_schema,
+    const std::function<bool(const char *, const char *)> &filter) -> std::vector<RecordUptr>
+{
+    std::vector<RecordUptr> records;
+    ScanPage(pid, proj_schema, [&](const char *nullmap, const char *data, slot_id_t slot_id) {
+        if (filter == nullptr || filter(nullmap, data)) {
+            records.push_back(std::make_unique<Record>(proj_schema, nullmap, data, RID(pid, slot_id)));
+        }
+        return true;
+    });
+    return records;
+}
+
+auto TableHandle::GetChunk(page_id_t pid, const RecordSchema *chunk_schema) -> ChunkUptr
+{
+    if (pid <= FILE_HEADER_PAGE_ID || pid >= static_cast<page_id_t>(tab_hdr_.page_num_)) {
+        WSDB_THROW(WSDB_PAGE_MISS, fmt::format("Page: {}", pid));
+    }
+    auto page_handle = FetchPageHandle(pid);
+    try {
+        auto chunk = page_handle->ReadChunk(chunk_schema);
+        buffer_pool_manager_->UnpinPage(table_id_, pid, false);
+        return chunk;
+    } catch (...) {
+        // e.g. bad_alloc of the chunk columns, the scan workers would run out of frames if the page stayed pinned
+        buffer_pool_manager_->UnpinPage(table_id_, pid, false);
+        throw;
+    }
+}
+
+void TableHandle::AppendChunk(page_id_t pid, Chunk *chunk)
+{
+    auto projs       = MakeFieldProjections(chunk->GetSchema());
+    auto rid_idx     = RidFieldIndex(chunk->GetSchema());
+    auto first_row   = chunk->GetRowNum();
+    auto page_handle = FetchPageHandle(pid);
+    try {
+        page_handle->AppendToChunk(projs, chunk);
+    } catch (...) {
+        buffer_pool_manager_->UnpinPage(table_id_, pid, false);
+        throw;
+    }
+    // the records are appended in slot order
+    if (rid_idx != chunk->GetSchema()->GetFieldCount()) {
+        char  *col    = chunk->GetColData(rid_idx);
+        char  *bitmap = page_handle->GetBitmap();
+        size_t row    = first_row;
+        for (size_t slot_id = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, 0, true);
+             slot_id < tab_hdr_.rec_per_page_;
+             slot_id = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, slot_id + 1, true), ++row) {
+            RID rid(pid, static_cast<slot_id_t>(slot_id));
+            memcpy(col + row * sizeof(RID), &rid, sizeof(RID));
+            BitMap::SetBit(chunk->GetColNullMap(rid_idx), row, false);
+        }
+    }
+    buffer_pool_manager_->UnpinPage(table_id_, pid, false);
+}
 
 auto TableHandle::InsertRecord(const Record &record) -> RID
 {
@@ -86,6 +191,7 @@ auto TableHandle::InsertRecord(const Record &record) -> RID
     }
     // is_dirty should be set true because insert record to a page makes the page dirty
     page_id_t page_id = newPageHandle->GetPage()->GetPageId();
+    zone_map_->AddRecord(page_id, record.GetNullMap(), record.GetData());
     buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
     return RID(page_id, empty_slot);
 }
@@ -123,7 +229,54 @@ void TableHandle::InsertRecord(const RID &rid, const Record &record)
         }
     }
     page_id_t page_id = page->GetPageId();
+    zone_map_->AddRecord(page_id, record.GetNullMap(), record.GetData());
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+}
+
+auto TableHandle::AppendRecords(const char *null_maps, const char *data, size_t rec_num) -> page_id_t
+{
+    WSDB_ASSERT(rec_num > 0 && rec_num <= tab_hdr_.rec_per_page_, fmt::format("rec_num: {}", rec_num));
+    auto page_id = static_cast<page_id_t>(tab_hdr_.page_num_);
+    tab_hdr_.page_num_++;
+    auto page = buffer_pool_manager_->FetchPage(table_id_, page_id);
+    // the page is beyond the end of file, the frame may still hold bytes of its previous page
+    memset(page->GetData(), 0, PAGE_SIZE);
+    auto  page_handle = WrapPageHandle(page);
+    char *bitmap      = page_handle->GetBitmap();
+    for (size_t slot_id = 0; slot_id < rec_num; slot_id++) {
+        const char *null_map = null_maps + slot_id * tab_hdr_.nullmap_size_;
+        const char *rec_data = data + slot_id * tab_hdr_.rec_size_;
+        page_handle->WriteSlot(slot_id, null_map, rec_data, false);
+        BitMap::SetBit(bitmap, slot_id, true);
+        zone_map_->AddRecord(page_id, null_map, rec_data);
+    }
+    page->SetRecordNum(rec_num);
+    page->SetNextFreePageId(INVALID_PAGE_ID);
+    if (rec_num < tab_hdr_.rec_per_page_) {
+        page->SetNextFreePageId(tab_hdr_.first_free_page_);
+        tab_hdr_.first_free_page_ = page_id;
+    }
+    tab_hdr_.rec_num_ += rec_num;
     buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+    return page_id;
+}
+
+void TableHandle::TruncatePages(page_id_t pid)
+{
+    WSDB_ASSERT(pid > FILE_HEADER_PAGE_ID && static_cast<size_t>(pid) <= tab_hdr_.page_num_, fmt::format("pid: {}", pid));
+    while (tab_hdr_.first_free_page_ != INVALID_PAGE_ID && tab_hdr_.first_free_page_ >= pid) {
+        auto page                 = buffer_pool_manager_->FetchPage(table_id_, tab_hdr_.first_free_page_);
+        tab_hdr_.first_free_page_ = page->GetNextFreePageId();
+        buffer_pool_manager_->UnpinPage(table_id_, page->GetPageId(), false);
+    }
+    for (auto page_id = pid; static_cast<size_t>(page_id) < tab_hdr_.page_num_; ++page_id) {
+        auto page = buffer_pool_manager_->FetchPage(table_id_, page_id);
+        tab_hdr_.rec_num_ -= page->GetRecordNum();
+        buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+    }
+    // frames of the removed pages are cleared before they are reused, see AppendRecords and CreateNewPageHandle
+    tab_hdr_.page_num_ = pid;
+    zone_map_->Truncate(pid);
 }
 
 void TableHandle::DeleteRecord(const RID &rid)
@@ -136,6 +289,9 @@ void TableHandle::DeleteRecord(const RID &rid)
         buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), false);
         WSDB_THROW(WSDB_RECORD_MISS, "");
     }
+    // the zone map bounds are kept, only the value counts of the page are decreased
+    page_handle->ReadSlotNullMap(slot_id, slot_nullmap_.data());
+    zone_map_->RemoveRecord(rid.PageID(), slot_nullmap_.data());
     BitMap::SetBit(bitmap, slot_id, false);
     size_t curRecordNum = page_handle->GetPage()->GetRecordNum();
     page_handle->GetPage()->SetRecordNum(--curRecordNum);
@@ -158,7 +314,10 @@ void TableHandle::UpdateRecord(const RID &rid, const Record &record)
         buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), false);
         WSDB_THROW(WSDB_RECORD_MISS, "");
     }
+    page_handle->ReadSlotNullMap(slot_id, slot_nullmap_.data());
+    zone_map_->RemoveRecord(rid.PageID(), slot_nullmap_.data());
     page_handle->WriteSlot(slot_id, record.GetNullMap(), record.GetData(), true);
+    zone_map_->AddRecord(rid.PageID(), record.GetNullMap(), record.GetData());
     buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), true);
 }
 
@@ -181,13 +340,46 @@ auto TableHandle::CreateNewPageHandle() -> PageHandleUptr
 {
     auto page_id = static_cast<page_id_t>(tab_hdr_.page_num_);
     tab_hdr_.page_num_++;
-    auto page   = buffer_pool_manager_->FetchPage(table_id_, page_id);
+    auto page = buffer_pool_manager_->FetchPage(table_id_, page_id);
+    memset(page->GetData(), 0, PAGE_SIZE);
     auto pg_hdl = WrapPageHandle(page);
     page->SetNextFreePageId(tab_hdr_.first_free_page_);
     tab_hdr_.first_free_page_ = page_id;
     return pg_hdl;
 }
 
+auto TableHandle::MakeFieldProjections(const RecordSchema *proj_schema) const -> std::vector<FieldProjection>
+{
+    std::vector<FieldProjection> projs;
+    projs.reserve(proj_schema->GetFieldCount());
+    for (size_t i = 0; i < proj_schema->GetFieldCount(); ++i) {
+        const auto &field = proj_schema->GetFieldAt(i);
+        if (IsRidField(field)) {
+            continue;
+        }
+        size_t idx = schema_->GetRTFieldIndex(field);
+        if (idx == schema_->GetFieldCount()) {
+            WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+        }
+        projs.push_back({.field_idx_ = idx,
+            .proj_idx_ = i,
+            .src_offset_ = schema_->GetFieldOffset(idx),
+            .dst_offset_ = proj_schema->GetFieldOffset(i),
+            .size_ = field.field_.field_size_});
+    }
+    return projs;
+}
+
+auto TableHandle::RidFieldIndex(const RecordSchema *proj_schema) -> size_t
+{
+    for (size_t i = 0; i < proj_schema->GetFieldCount(); ++i) {
+        if (IsRidField(proj_schema->GetFieldAt(i))) {
+            return i;
+        }
+    }
+    return proj_schema->GetFieldCount();
+}
+
 auto TableHandle::WrapPageHandle(Page *page) -> PageHandleUptr
 {
     switch (storage_model_) {
@@ -198,6 +390,42 @@ auto TableHandle::WrapPageHandle(Page *page) -> PageHandleUptr
     }
 }
 
+auto TableHandle::PageMayMatch(page_id_t pid, const ConditionVec &conds) const -> bool
+{
+    return zone_map_->MayMatch(pid, conds);
+}
+
+void TableHandle::LoadZoneMap(const std::string &file_name)
+{
+    bool loaded = zone_map_->Load(file_name, tab_hdr_.page_num_);
+    if (DiskManager::FileExists(file_name)) {
+        DiskManager::DestroyFile(file_name);
+    }
+    if (loaded) {
+        return;
+    }
+    zone_map_ = std::make_unique<ZoneMap>(schema_.get());
+
+    auto nullmap = std::make_unique<char[]>(tab_hdr_.nullmap_size_);
+    auto data    = std::make_unique<char[]>(tab_hdr_.rec_size_);
+    for (auto pid = FILE_HEADER_PAGE_ID + 1; pid < static_cast<page_id_t>(tab_hdr_.page_num_); ++pid) {
+        auto  page_handle = FetchPageHandle(pid);
+        char *bitmap      = page_handle->GetBitmap();
+        for (size_t slot_id = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, 0, true);
+             slot_id < tab_hdr_.rec_per_page_;
+             slot_id = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, slot_id + 1, true)) {
+            page_handle->ReadSlot(slot_id, nullmap.get(), data.get());
+            zone_map_->AddRecord(pid, nullmap.get(), data.get());
+        }
+        buffer_pool_manager_->UnpinPage(table_id_, pid, false);
+    }
+}
+
+void TableHandle::FlushZoneMap(const std::string &file_name) const
+{
+    zone_map_->Flush(file_name, tab_hdr_.page_num_);
+}
+
 auto TableHandle::GetTableId() const -> table_id_t { return table_id_; }
 
 auto TableHandle::GetTableHeader() const -> const TableHeader & { return tab_hdr_; }
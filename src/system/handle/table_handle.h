@@ -21,12 +21,14 @@
 
 #ifndef WSDB_TABLE_HANDLE_H
 #define WSDB_TABLE_HANDLE_H
+#include <functional>
 #include <utility>
 
 #include "../../../common/micro.h"
 #include "common/page.h"
 #include "storage/storage.h"
 #include "page_handle.h"
+#include "zone_map.h"
 
 namespace wsdb {
 
@@ -52,6 +54,37 @@ class TableHandle
      */
     auto GetRecord(const RID &rid) -> RecordUptr;
 
+    /**
+     * Get the records of rids with only the fields in proj_schema materialized, each page is fetched once for adjacent
+     * rids of the page
+     * @param rids should be sorted by page so that pages are read in sequence
+     * @param proj_schema as GetPageRecords
+     * @return records in the order of rids
+     */
+    auto GetRecords(const std::vector<RID> &rids, const RecordSchema *proj_schema) -> std::vector<RecordUptr>;
+
+    /**
+     * Read all the records in a page with only the fields in proj_schema materialized
+     * @param pid
+     * @param proj_schema fields should be a subset of the table schema, or the rid field of the table (see RID_FIELD_NAME)
+     * @param filter called with the null map and data of each projected slot, slots it rejects are not materialized
+     * @return records in slot order
+     */
+    auto GetPageRecords(page_id_t pid, const RecordSchema *proj_schema,
+        const std::function<bool(const char *, const char *)> &filter = nullptr) -> std::vector<RecordUptr>;
+
+    /**
+     * Push the records in a page to the consumer with only the fields in proj_schema materialized, no record is made.
+     * Used by push-based pipelines, where the consumer is inlined into the loop over slots
+     * @param pid
+     * @param proj_schema as GetPageRecords
+     * @param consumer called as consumer(nullmap, data, slot_id) for each slot in slot order, the memory is reused
+     * for the next slot. Returns false to stop the scan
+     * @return false if the consumer stopped the scan
+     */
+    template <typename Consumer>
+    auto ScanPage(page_id_t pid, const RecordSchema *proj_schema, Consumer &&consumer) -> bool;
+
     /**
      * Get a chunk in page using record schema indicating which columns should be loaded
      * @param pid
@@ -60,6 +93,14 @@ class TableHandle
      */
     auto GetChunk(page_id_t pid, const RecordSchema *chunk_schema) -> ChunkUptr;
 
+    /**
+     * Append the records in page to the chunk, the columns to read are given by the chunk schema, which may have the
+     * rid field of the table as GetPageRecords
+     * @param pid
+     * @param chunk should have room for rec_per_page records
+     */
+    void AppendChunk(page_id_t pid, Chunk *chunk);
+
     /**
      * 该函数是在没有free_page的情况下才会调用（？），这样以来first_free_page肯定就是这个新建的page_handle了
      * Insert a record into the table
@@ -85,6 +126,24 @@ class TableHandle
      */
     void InsertRecord(const RID &rid, const Record &record);
 
+    /**
+     * Bulk append records to a fresh page at the end of the table, used by bulk loading.
+     * The free page list is bypassed, only a page left with empty slots is linked into it
+     * @param null_maps null maps of the records, stored contiguously
+     * @param data data of the records, stored contiguously
+     * @param rec_num number of records, should be in range [1, rec_per_page]
+     * @return page id of the appended page
+     */
+    auto AppendRecords(const char *null_maps, const char *data, size_t rec_num) -> page_id_t;
+
+    /**
+     * Remove the pages from pid to the end of the table, used to undo AppendRecords when a bulk load fails.
+     * The pages should be appended after any page in the free page list, i.e. only the appended pages can be unlinked
+     * from the head of the list
+     * @param pid first page to remove
+     */
+    void TruncatePages(page_id_t pid);
+
     /**
      * Delete the record by rid
      * 1. if the slot is empty, unpin the page and throw WSDB_RECORD_MISS
@@ -106,6 +165,23 @@ class TableHandle
      */
     void UpdateRecord(const RID &rid, const Record &record);
 
+    /**
+     * Check the zone map to see if any record in the page may satisfy the conditions
+     * @param pid
+     * @param conds
+     * @return false if the page can be skipped by scans
+     */
+    [[nodiscard]] auto PageMayMatch(page_id_t pid, const ConditionVec &conds) const -> bool;
+
+    /**
+     * Load the zone map saved when the table was closed, rebuild it by scanning the table if the file is missing or
+     * stale. The file is removed once loaded, so a table that is not closed properly never leaves a stale one behind
+     * @param file_name
+     */
+    void LoadZoneMap(const std::string &file_name);
+
+    void FlushZoneMap(const std::string &file_name) const;
+
     [[nodiscard]] auto GetTableId() const -> table_id_t;
 
     [[nodiscard]] auto GetTableHeader() const -> const TableHeader &;
@@ -142,6 +218,17 @@ class TableHandle
      */
     auto CreateNewPageHandle() -> PageHandleUptr;
 
+    /**
+     * Make the copy plan of the fields in proj_schema from the table record, throw WSDB_FIELD_MISS if a field does not
+     * belong to the table. The rid field is skipped, the callers fill it from the slot id
+     * @param proj_schema
+     * @return
+     */
+    auto MakeFieldProjections(const RecordSchema *proj_schema) const -> std::vector<FieldProjection>;
+
+    /// index of the rid field in proj_schema, the field count if there is none
+    static auto RidFieldIndex(const RecordSchema *proj_schema) -> size_t;
+
     /**
      * Wrap the page handle according to the storage model
      * @param page
@@ -159,6 +246,12 @@ class TableHandle
     RecordSchemaUptr schema_;
     StorageModel     storage_model_;
 
+    // min/max of each field in each page, maintained by insert, update and delete
+    ZoneMapUptr zone_map_;
+
+    // null map of the old record read by delete and update to keep the zone map counts
+    std::vector<char> slot_nullmap_;
+
     /// field below is available when storage model is pax
     // field offsets is the offset of each field stored in page
     // pax model is stored like below, field_offset can be calculated by Record Schema
@@ -174,6 +267,44 @@ class TableHandle
 
 DEFINE_UNIQUE_PTR(TableHandle);
 
+template <typename Consumer>
+auto TableHandle::ScanPage(page_id_t pid, const RecordSchema *proj_schema, Consumer &&consumer) -> bool
+{
+    // a full record can be read by slot, otherwise copy the projected fields one by one
+    bool full    = proj_schema == schema_.get();
+    auto projs   = full ? std::vector<FieldProjection>{} : MakeFieldProjections(proj_schema);
+    auto rid_idx = full ? proj_schema->GetFieldCount() : RidFieldIndex(proj_schema);
+
+    auto  nullmap     = std::make_unique<char[]>(BITMAP_SIZE(proj_schema->GetFieldCount()));
+    auto  data        = std::make_unique<char[]>(proj_schema->GetRecordLength());
+    auto  page_handle = FetchPageHandle(pid);
+    char *bitmap      = page_handle->GetBitmap();
+    bool  go_on       = true;
+    try {
+        for (size_t slot_id = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, 0, true);
+             go_on && slot_id < tab_hdr_.rec_per_page_;
+             slot_id = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, slot_id + 1, true)) {
+            if (full) {
+                page_handle->ReadSlot(slot_id, nullmap.get(), data.get());
+            } else {
+                memset(nullmap.get(), 0, BITMAP_SIZE(proj_schema->GetFieldCount()));
+                page_handle->ReadSlotFields(slot_id, projs, nullmap.get(), data.get());
+            }
+            if (rid_idx != proj_schema->GetFieldCount()) {
+                RID rid(pid, static_cast<slot_id_t>(slot_id));
+                memcpy(data.get() + proj_schema->GetFieldOffset(rid_idx), &rid, sizeof(RID));
+            }
+            go_on = consumer(nullmap.get(), data.get(), static_cast<slot_id_t>(slot_id));
+        }
+    } catch (...) {
+        // the consumer may be any pipeline code, release the page whatever it throws
+        buffer_pool_manager_->UnpinPage(table_id_, pid, false);
+        throw;
+    }
+    buffer_pool_manager_->UnpinPage(table_id_, pid, false);
+    return go_on;
+}
+
 }  // namespace wsdb
 
 #endif  // WSDB_TABLE_HANDLE_H
@@ -0,0 +1,181 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+#include "zone_map.h"
+
+#include <fstream>
+
+namespace wsdb {
+
+ZoneMap::ZoneMap(const RecordSchema *schema) : schema_(schema) {}
+
+void ZoneMap::AddRecord(page_id_t pid, const char *null_map, const char *data)
+{
+  Reserve(pid);
+  auto field_num = schema_->GetFieldCount();
+  for (size_t i = 0; i < field_num; ++i) {
+    auto &stats = stats_[pid * field_num + i];
+    if (BitMap::GetBit(null_map, i)) {
+      stats.null_num_++;
+      continue;
+    }
+    auto  size  = schema_->GetFieldAt(i).field_.field_size_;
+    auto  value = data + schema_->GetFieldOffset(i);
+    auto *min   = const_cast<char *>(GetMin(pid, i));
+    auto *max   = const_cast<char *>(GetMax(pid, i));
+    // the bounds are stale once all values of the field are gone, start over from this value
+    if (stats.value_num_++ == 0) {
+      memcpy(min, value, size);
+      memcpy(max, value, size);
+      continue;
+    }
+    if (CompareRaw(i, value, min) < 0) {
+      memcpy(min, value, size);
+    } else if (CompareRaw(i, value, max) > 0) {
+      memcpy(max, value, size);
+    }
+  }
+}
+
+void ZoneMap::RemoveRecord(page_id_t pid, const char *null_map)
+{
+  auto field_num = schema_->GetFieldCount();
+  if ((pid + 1) * field_num > stats_.size()) {
+    return;
+  }
+  for (size_t i = 0; i < field_num; ++i) {
+    auto &stats = stats_[pid * field_num + i];
+    auto &num   = BitMap::GetBit(null_map, i) ? stats.null_num_ : stats.value_num_;
+    if (num > 0) {
+      num--;
+    }
+  }
+}
+
+auto ZoneMap::MayMatch(page_id_t pid, const ConditionVec &conds) const -> bool
+{
+  if (pid < 0 || (pid + 1) * schema_->GetFieldCount() > stats_.size()) {
+    return true;
+  }
+  return std::all_of(conds.begin(), conds.end(), [this, pid](const Condition &cond) {
+    return MayMatchCond(pid, cond);
+  });
+}
+
+auto ZoneMap::MayMatchCond(page_id_t pid, const Condition &cond) const -> bool
+{
+  if (cond.GetRhsType() != kValue) {
+    return true;
+  }
+  auto idx = schema_->GetRTFieldIndex(cond.GetLCol());
+  if (idx == schema_->GetFieldCount()) {
+    return true;
+  }
+  auto        op  = cond.GetOp();
+  const auto &rhs = cond.GetRDatum();
+  if (rhs.IsNull() || op == OP_IN || op == OP_RNG) {
+    return true;
+  }
+  const auto &field = schema_->GetFieldAt(idx).field_;
+  const auto &stats = stats_[pid * schema_->GetFieldCount() + idx];
+  if (stats.value_num_ == 0) {
+    // a null never equals to a constant, so only <> is satisfied
+    return op == OP_NE && stats.null_num_ > 0;
+  }
+  auto is_numeric = [](FieldType type) { return type == TYPE_INT || type == TYPE_FLOAT; };
+  if (field.field_type_ != rhs.GetType() && !(is_numeric(field.field_type_) && is_numeric(rhs.GetType()))) {
+    // leave the type error to the filter
+    return true;
+  }
+  auto min_cmp = Datum::Compare(Datum::FromRaw(field.field_type_, GetMin(pid, idx), field.field_size_), rhs);
+  auto max_cmp = Datum::Compare(Datum::FromRaw(field.field_type_, GetMax(pid, idx), field.field_size_), rhs);
+  switch (op) {
+    case OP_EQ: return min_cmp <= 0 && max_cmp >= 0;
+    case OP_NE: return stats.null_num_ > 0 || min_cmp != 0 || max_cmp != 0;
+    case OP_LT: return min_cmp < 0;
+    case OP_LE: return min_cmp <= 0;
+    case OP_GT: return max_cmp > 0;
+    case OP_GE: return max_cmp >= 0;
+    default: return true;
+  }
+}
+
+auto ZoneMap::Load(const std::string &file_name, size_t page_num) -> bool
+{
+  std::ifstream file(file_name, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  // | page num | tracked page num | field num | record length | stats | bounds |
+  size_t hdr[4];
+  file.read(reinterpret_cast<char *>(hdr), sizeof(hdr));
+  if (!file || hdr[0] != page_num || hdr[1] > page_num || hdr[2] != schema_->GetFieldCount() ||
+      hdr[3] != schema_->GetRecordLength()) {
+    return false;
+  }
+  stats_.resize(hdr[1] * schema_->GetFieldCount());
+  bounds_.resize(hdr[1] * 2 * schema_->GetRecordLength());
+  file.read(reinterpret_cast<char *>(stats_.data()), static_cast<std::streamsize>(stats_.size() * sizeof(FieldStats)));
+  file.read(bounds_.data(), static_cast<std::streamsize>(bounds_.size()));
+  if (!file) {
+    stats_.clear();
+    bounds_.clear();
+    return false;
+  }
+  return true;
+}
+
+void ZoneMap::Flush(const std::string &file_name, size_t page_num) const
+{
+  std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR, file_name);
+  }
+  size_t tracked = std::min(page_num, stats_.size() / schema_->GetFieldCount());
+  size_t hdr[4]  = {page_num, tracked, schema_->GetFieldCount(), schema_->GetRecordLength()};
+  file.write(reinterpret_cast<const char *>(hdr), sizeof(hdr));
+  file.write(reinterpret_cast<const char *>(stats_.data()),
+      static_cast<std::streamsize>(tracked * schema_->GetFieldCount() * sizeof(FieldStats)));
+  file.write(bounds_.data(), static_cast<std::streamsize>(tracked * 2 * schema_->GetRecordLength()));
+}
+
+void ZoneMap::Truncate(size_t page_num)
+{
+  if (page_num * schema_->GetFieldCount() < stats_.size()) {
+    stats_.resize(page_num * schema_->GetFieldCount());
+    bounds_.resize(page_num * 2 * schema_->GetRecordLength());
+  }
+}
+
+void ZoneMap::Reserve(page_id_t pid)
+{
+  auto page_num = static_cast<size_t>(pid) + 1;
+  if (page_num * schema_->GetFieldCount() > stats_.size()) {
+    stats_.resize(page_num * schema_->GetFieldCount());
+    bounds_.resize(page_num * 2 * schema_->GetRecordLength());
+  }
+}
+
+auto ZoneMap::CompareRaw(size_t field_idx, const char *lhs, const char *rhs) const -> int
+{
+  const auto &field = schema_->GetFieldAt(field_idx).field_;
+  return Datum::Compare(Datum::FromRaw(field.field_type_, lhs, field.field_size_),
+      Datum::FromRaw(field.field_type_, rhs, field.field_size_));
+}
+
+}  // namespace wsdb
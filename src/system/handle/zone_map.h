@@ -0,0 +1,127 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+/**
+ * @brief Per page summaries of the column values, used to skip pages that cannot satisfy the scan predicates
+ *
+ * For every page and every field, the zone map keeps the minimum and maximum of the non-null values written to the
+ * page, the number of non-null values and the number of nulls. Bounds are only widened by inserts and updates, and
+ * deletes just decrease the counters, so the bounds are always a superset of the live values. They are reset when no
+ * value of the field is left in the page.
+ */
+
+#ifndef WSDB_ZONE_MAP_H
+#define WSDB_ZONE_MAP_H
+
+#include "common/condition.h"
+#include "common/meta.h"
+#include "record_handle.h"
+
+namespace wsdb {
+
+class ZoneMap
+{
+public:
+  ZoneMap() = delete;
+
+  explicit ZoneMap(const RecordSchema *schema);
+
+  ~ZoneMap() = default;
+
+  /**
+   * Account a record written to the page
+   * @param pid
+   * @param null_map null map of the record in table schema
+   * @param data data of the record in table schema
+   */
+  void AddRecord(page_id_t pid, const char *null_map, const char *data);
+
+  /**
+   * Account a record removed from the page, the bounds are kept
+   * @param pid
+   * @param null_map null map of the record in table schema
+   */
+  void RemoveRecord(page_id_t pid, const char *null_map);
+
+  /**
+   * Forget the pages from page_num on, which are removed from the end of the table
+   * @param page_num
+   */
+  void Truncate(size_t page_num);
+
+  /**
+   * Check if any record of the page may satisfy all the conditions, conditions on other tables,
+   * conditions whose rhs is not a constant and pages not covered by the zone map always may match
+   * @param pid
+   * @param conds
+   * @return false if the page can be skipped
+   */
+  [[nodiscard]] auto MayMatch(page_id_t pid, const ConditionVec &conds) const -> bool;
+
+  /**
+   * Load the zone map from file
+   * @param file_name
+   * @param page_num page number of the table, used to check if the file is stale
+   * @return false if the file does not exist or does not match the table
+   */
+  auto Load(const std::string &file_name, size_t page_num) -> bool;
+
+  /**
+   * Write the zone map of pages [0, page_num) to file
+   * @param file_name
+   * @param page_num
+   */
+  void Flush(const std::string &file_name, size_t page_num) const;
+
+private:
+  struct FieldStats
+  {
+    size_t value_num_{0};
+    size_t null_num_{0};
+  };
+
+  void Reserve(page_id_t pid);
+
+  [[nodiscard]] auto MayMatchCond(page_id_t pid, const Condition &cond) const -> bool;
+
+  [[nodiscard]] auto GetMin(page_id_t pid, size_t field_idx) const -> const char *
+  {
+    return bounds_.data() + 2 * pid * schema_->GetRecordLength() + schema_->GetFieldOffset(field_idx);
+  }
+
+  [[nodiscard]] auto GetMax(page_id_t pid, size_t field_idx) const -> const char *
+  {
+    return GetMin(pid, field_idx) + schema_->GetRecordLength();
+  }
+
+  /// three-way comparison of two raw field values
+  [[nodiscard]] auto CompareRaw(size_t field_idx, const char *lhs, const char *rhs) const -> int;
+
+private:
+  const RecordSchema *schema_;
+  // stats of page pid and field i is stored in stats_[pid * field_num + i]
+  std::vector<FieldStats> stats_;
+  // bounds of page pid are stored as two records: | min record | max record |
+  std::vector<char> bounds_;
+};
+
+DEFINE_UNIQUE_PTR(ZoneMap);
+
+}  // namespace wsdb
+
+#endif  // WSDB_ZONE_MAP_H
@@ -0,0 +1,265 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "scheduler.h"
+
+namespace wsdb {
+
+namespace {
+// the scheduler and the worker index of the calling thread, if it is a worker
+thread_local Scheduler *tls_scheduler = nullptr;
+thread_local size_t     tls_worker    = 0;
+// client of the calling thread, -1 if the thread does not serve a client
+thread_local int tls_client = -1;
+}  // namespace
+
+Scheduler::Scheduler(size_t worker_num) : pending_(0), next_queue_(0), stopped_(false)
+{
+  worker_num = std::max<size_t>(worker_num, 1);
+  for (size_t i = 0; i < worker_num; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < worker_num; ++i) {
+    threads_.emplace_back([this, i]() { WorkerLoop(i); });
+  }
+}
+
+Scheduler::~Scheduler()
+{
+  {
+    std::lock_guard lock(sleep_latch_);
+    stopped_ = true;
+  }
+  sleep_cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+auto Scheduler::GetInstance() -> Scheduler *
+{
+  static Scheduler instance(std::thread::hardware_concurrency());
+  return &instance;
+}
+
+void Scheduler::SetClient(int client_id) { tls_client = client_id; }
+
+void Scheduler::Cancel(int client_id)
+{
+  std::lock_guard lock(groups_latch_);
+  auto [begin, end] = groups_.equal_range(client_id);
+  for (auto it = begin; it != end; ++it) {
+    it->second->Cancel();
+  }
+}
+
+void Scheduler::Push(Task task)
+{
+  auto queue = tls_scheduler == this ? tls_worker : next_queue_++ % workers_.size();
+  {
+    std::lock_guard lock(workers_[queue]->latch_);
+    workers_[queue]->tasks_.push_back(std::move(task));
+  }
+  pending_++;
+  // a worker checks pending_ under the latch before sleeping, so taking the latch here makes sure it is woken up
+  { std::lock_guard lock(sleep_latch_); }
+  sleep_cv_.notify_one();
+}
+
+auto Scheduler::Pop(size_t self, Task &task) -> bool
+{
+  if (self < workers_.size()) {
+    std::lock_guard lock(workers_[self]->latch_);
+    if (!workers_[self]->tasks_.empty()) {
+      task = std::move(workers_[self]->tasks_.back());
+      workers_[self]->tasks_.pop_back();
+      pending_--;
+      return true;
+    }
+  }
+  for (size_t i = 1; i <= workers_.size(); ++i) {
+    auto &victim = workers_[(self + i) % workers_.size()];
+    std::lock_guard lock(victim->latch_);
+    if (!victim->tasks_.empty()) {
+      task = std::move(victim->tasks_.front());
+      victim->tasks_.pop_front();
+      pending_--;
+      return true;
+    }
+  }
+  return false;
+}
+
+auto Scheduler::RunOne() -> bool
+{
+  // a thread that is not a worker has no deque of its own and only steals
+  Task task;
+  if (!Pop(tls_scheduler == this ? tls_worker : workers_.size(), task)) {
+    return false;
+  }
+  RunTask(task);
+  return true;
+}
+
+void Scheduler::RunTask(Task &task)
+{
+  auto              *group = task.group_;
+  std::exception_ptr error;
+  if (!group->IsCancelled()) {
+    // tasks work for the client of their group, so that the groups they create are cancelled together
+    auto client = tls_client;
+    tls_client  = group->client_id_;
+    try {
+      auto func = std::move(task.func_);
+      func();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    tls_client = client;
+  }
+  // the group may be destroyed by its owner as soon as the last task finishes, so a skipped task releases what it
+  // captured before that as well
+  task.func_ = nullptr;
+  group->Finish(error);
+}
+
+void Scheduler::WorkerLoop(size_t id)
+{
+  tls_scheduler = this;
+  tls_worker    = id;
+  while (true) {
+    if (RunOne()) {
+      continue;
+    }
+    std::unique_lock lock(sleep_latch_);
+    sleep_cv_.wait(lock, [this]() { return stopped_ || pending_ > 0; });
+    if (stopped_) {
+      return;
+    }
+  }
+}
+
+void Scheduler::Register(TaskGroup *group)
+{
+  if (group->client_id_ < 0) {
+    return;
+  }
+  std::lock_guard lock(groups_latch_);
+  groups_.emplace(group->client_id_, group);
+}
+
+void Scheduler::Unregister(TaskGroup *group)
+{
+  if (group->client_id_ < 0) {
+    return;
+  }
+  std::lock_guard lock(groups_latch_);
+  auto [begin, end] = groups_.equal_range(group->client_id_);
+  for (auto it = begin; it != end; ++it) {
+    if (it->second == group) {
+      groups_.erase(it);
+      return;
+    }
+  }
+}
+
+TaskGroup::TaskGroup(Scheduler *scheduler)
+    : scheduler_(scheduler), client_id_(tls_client), unfinished_(0), cancelled_(false)
+{
+  scheduler_->Register(this);
+}
+
+TaskGroup::~TaskGroup()
+{
+  Cancel();
+  try {
+    Wait();
+  } catch (...) {
+    // the owner did not wait for the result, so the error is dropped with it
+  }
+  scheduler_->Unregister(this);
+}
+
+void TaskGroup::Run(std::function<void()> func)
+{
+  unfinished_++;
+  scheduler_->Push({.func_ = std::move(func), .group_ = this});
+}
+
+void TaskGroup::Wait()
+{
+  while (unfinished_ > 0) {
+    if (scheduler_->RunOne()) {
+      continue;
+    }
+    // tasks of the group are running on other threads, check for new tasks to help with once in a while
+    std::unique_lock lock(latch_);
+    done_cv_.wait_for(lock, std::chrono::milliseconds(1), [this]() { return unfinished_ == 0; });
+  }
+  // the latch is held by the last task until it is done with the group
+  std::lock_guard lock(latch_);
+  if (error_ != nullptr) {
+    auto error = std::move(error_);
+    error_     = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void TaskGroup::Cancel()
+{
+  cancelled_ = true;
+  std::function<void()> handler;
+  {
+    std::lock_guard lock(latch_);
+    handler = cancel_handler_;
+  }
+  if (handler != nullptr) {
+    handler();
+  }
+}
+
+void TaskGroup::SetCancelHandler(std::function<void()> handler)
+{
+  std::lock_guard lock(latch_);
+  cancel_handler_ = std::move(handler);
+}
+
+void TaskGroup::Reset()
+{
+  try {
+    Wait();
+  } catch (...) {
+    // the owner has given up the run that failed
+  }
+  std::lock_guard lock(latch_);
+  cancelled_ = false;
+  error_     = nullptr;
+}
+
+void TaskGroup::Finish(std::exception_ptr error)
+{
+  std::lock_guard lock(latch_);
+  if (error != nullptr && error_ == nullptr) {
+    error_     = std::move(error);
+    cancelled_ = true;
+  }
+  if (--unfinished_ == 0) {
+    done_cv_.notify_all();
+  }
+}
+
+}  // namespace wsdb
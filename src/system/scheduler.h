@@ -0,0 +1,170 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Process-wide work-stealing scheduler for intra-query parallelism
+ *
+ * Each worker thread owns a deque of tasks. A worker pushes and pops tasks at the back of its own deque, and steals
+ * from the front of the other deques when its own is empty, so that work spreads to idle workers while a worker keeps
+ * running the tasks it just made. Tasks are submitted through a TaskGroup, which is joined by Wait. A group created by
+ * a client thread belongs to the client, and all groups of a client are cancelled when the client is found
+ * disconnected while its query runs, see SystemManager
+ */
+
+#ifndef WSDB_SCHEDULER_H
+#define WSDB_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "../../common/micro.h"
+
+namespace wsdb {
+
+class TaskGroup;
+
+class Scheduler
+{
+  friend class TaskGroup;
+
+public:
+  explicit Scheduler(size_t worker_num);
+
+  /// stop the workers, tasks left in the deques are dropped
+  ~Scheduler();
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(Scheduler)
+
+  /// the scheduler shared by the process, with a worker per core
+  static auto GetInstance() -> Scheduler *;
+
+  [[nodiscard]] auto GetWorkerNum() const -> size_t { return workers_.size(); }
+
+  /// set the client of the calling thread, groups created by the thread afterwards belong to the client
+  static void SetClient(int client_id);
+
+  /// cancel all groups of the client, their tasks that have not started are skipped
+  void Cancel(int client_id);
+
+private:
+  struct Task
+  {
+    std::function<void()> func_;
+    TaskGroup            *group_;
+  };
+
+  struct Worker
+  {
+    std::mutex       latch_;
+    std::deque<Task> tasks_;
+  };
+
+  /// push to the deque of the calling worker, or round robin if the caller is not a worker of this scheduler
+  void Push(Task task);
+
+  /// pop from the back of the deque of self, or steal from the front of the others
+  auto Pop(size_t self, Task &task) -> bool;
+
+  /// run a task if there is one, used by workers and by threads waiting for a group
+  auto RunOne() -> bool;
+
+  void RunTask(Task &task);
+
+  void WorkerLoop(size_t id);
+
+  void Register(TaskGroup *group);
+
+  void Unregister(TaskGroup *group);
+
+private:
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread>             threads_;
+  std::atomic<size_t>                  pending_;     // tasks in all deques
+  std::atomic<size_t>                  next_queue_;  // round robin of tasks pushed from outside
+  std::mutex                           sleep_latch_;
+  std::condition_variable              sleep_cv_;
+  bool                                 stopped_;
+
+  std::mutex                                groups_latch_;
+  std::unordered_multimap<int, TaskGroup *> groups_;  // groups of clients, by client id
+};
+
+/**
+ * A set of tasks that can be waited for together. Tasks may submit more tasks to the group they belong to. The first
+ * exception thrown by a task is kept and rethrown by Wait, and the group is cancelled at that point
+ */
+class TaskGroup
+{
+  friend class Scheduler;
+
+public:
+  explicit TaskGroup(Scheduler *scheduler = Scheduler::GetInstance());
+
+  /// cancel and wait, the tasks may refer to the owner of the group
+  ~TaskGroup();
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(TaskGroup)
+
+  void Run(std::function<void()> func);
+
+  /// wait until all tasks are done, running tasks of the scheduler in the meantime
+  void Wait();
+
+  /// tasks that have not started are skipped, running tasks should check IsCancelled to stop early
+  void Cancel();
+
+  /**
+   * Set a handler called by Cancel, so that an owner waiting for its tasks on a condition variable of its own is woken
+   * up. The handler may run on any thread, including that of Scheduler::Cancel, and should only notify the owner
+   */
+  void SetCancelHandler(std::function<void()> handler);
+
+  /**
+   * Wait for the tasks left by the last run, then clear its cancellation and drop its error, so that the owner can run
+   * tasks again after a failure, e.g. an executor initialized again
+   */
+  void Reset();
+
+  [[nodiscard]] auto IsCancelled() const -> bool { return cancelled_; }
+
+  [[nodiscard]] auto GetScheduler() const -> Scheduler * { return scheduler_; }
+
+private:
+  void Finish(std::exception_ptr error);
+
+private:
+  Scheduler              *scheduler_;
+  int                     client_id_;
+  std::atomic<size_t>     unfinished_;
+  std::atomic<bool>       cancelled_;
+  std::mutex              latch_;
+  std::condition_variable done_cv_;
+  std::exception_ptr      error_;
+  std::function<void()>   cancel_handler_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_SCHEDULER_H
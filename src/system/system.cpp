@@ -124,6 +124,7 @@ void SystemManager::Run()
     return;
   }
   WSDB_LOG("Server listening on port " + std::to_string(net::SERVER_PORT));
+  client_watcher_ = std::thread([this]() { WatchClients(); });
   while (is_running_) {
     auto client_sock = net_controller_->Accept();
     if (client_sock < 0) {
@@ -138,6 +139,7 @@ void SystemManager::Run()
   }
   // close the server
   net_controller_->Close();
+  client_watcher_.join();
   // wait for the clean-up daemon
   std::this_thread::sleep_for(std::chrono::seconds(1));
   // exit the system
@@ -152,6 +154,11 @@ void SystemManager::ClientHandler(int client_fd)
   // 4. send the response
   // 5. close the connection
   WSDB_LOG(fmt::format("Client {} connected", client_fd));
+  Scheduler::SetClient(client_fd);
+  {
+    std::lock_guard lock(clients_latch_);
+    clients_.insert(client_fd);
+  }
   // 1. read the request
   Transaction txn{};
   Context     context(&txn, log_manager_.get(), nullptr, net_controller_.get(), client_fd);
@@ -172,9 +179,13 @@ void SystemManager::ClientHandler(int client_fd)
         net_controller_->SendOK(client_fd);
       } else {
         /// plan is not a db plan
-        plan           = optimizer_->Optimize(plan, context.db_);
-        auto exec_tree = executor_->Translate(plan, context.db_);
-        executor_->Execute(exec_tree, &context);
+        plan = optimizer_->Optimize(plan, context.db_);
+        if (auto pipeline = executor_->Compile(plan, &context)) {
+          executor_->Execute(pipeline, &context);
+        } else {
+          auto exec_tree = executor_->Translate(plan, context.db_);
+          executor_->Execute(exec_tree, &context);
+        }
       }
       // commit transaction if this is a single sql statement
       if (!txn.IsExplicit()) {
@@ -192,12 +203,32 @@ void SystemManager::ClientHandler(int client_fd)
       }
     }
   }  // end of client while loop
+  {
+    // the socket is closed after return and its number may be reused by the next client
+    std::lock_guard lock(clients_latch_);
+    clients_.erase(client_fd);
+  }
   net_controller_->Remove(client_fd);
   if (context.db_ != nullptr) {
     context.db_->Close();
   }
 }
 
+void SystemManager::WatchClients()
+{
+  while (is_running_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(CLIENT_CHECK_INTERVAL_MS));
+    std::lock_guard lock(clients_latch_);
+    for (auto client_fd : clients_) {
+      // the client thread is blocked in its query and only notices the disconnection when it sends the result,
+      // cancelling the tasks of the query stops it early. Cancelling an idle client does nothing
+      if (net_controller_->IsClientDown(client_fd)) {
+        Scheduler::GetInstance()->Cancel(client_fd);
+      }
+    }
+  }
+}
+
 bool SystemManager::DoDBPlan(const std::shared_ptr<AbstractPlan> &plan, Context *ctx)
 {
   if (const auto cdb = std::dynamic_pointer_cast<CreateDBPlan>(plan)) {
@@ -231,6 +262,11 @@ bool SystemManager::DoExplainPlan(const std::shared_ptr<AbstractPlan> &plan, Con
     auto logical_str   = fmt::format("---\nLogical Plan:\n{}", exp->logical_plan_->ToString(0));
     auto physical_plan = optimizer_->Optimize(exp->logical_plan_, ctx->db_);
     auto physical_str  = fmt::format("---\nPhysical Plan:\n{}", physical_plan->ToString(0));
+    if (exp->analyze_) {
+      // the records are counted instead of sent, statistics kept in the plan, e.g. by runtime filters, are shown
+      auto rec_num = Executor::Analyze(physical_plan, ctx->db_);
+      physical_str = fmt::format("---\nPhysical Plan ({} records):\n{}", rec_num, physical_plan->ToString(0));
+    }
     net_controller_->SendRawString(ctx->client_fd_, logical_str);
     net_controller_->SendRawString(ctx->client_fd_, physical_str);
     return true;
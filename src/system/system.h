@@ -31,6 +31,11 @@
 #include "log/recovery.h"
 #include "concurrency/txn_manager.h"
 #include "handle/database_handle.h"
+#include "scheduler.h"
+
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_set>
 
 namespace wsdb {
 
@@ -63,6 +68,9 @@ private:
 
   void ClientHandler(int client_fd);
 
+  /// cancel the tasks of the clients that disconnected while their queries run, until the system stops
+  void WatchClients();
+
   void Recover();
 
 public:
@@ -89,6 +97,10 @@ private:
 
   bool                  is_running_{false};  // indicates whether the system is running
 
+  std::mutex              clients_latch_;
+  std::unordered_set<int> clients_;  // sockets of the connected clients
+  std::thread             client_watcher_;
+
   std::unordered_map<std::string, std::unique_ptr<DatabaseHandle>> databases_;
 };
 
@@ -30,8 +30,11 @@ void TableManager::CreateTable(
     WSDB_THROW(WSDB_RECLEN_ERROR, fmt::format("{}", schema.GetRecordLength()));
   }
 
-  // 1. create and open table file
+  // 1. create and open table file, drop the zone map left by a former table of the same name
   DiskManager::CreateFile(FILE_NAME(db_name, table_name, TAB_SUFFIX));
+  if (DiskManager::FileExists(FILE_NAME(db_name, table_name, ZM_SUFFIX))) {
+    DiskManager::DestroyFile(FILE_NAME(db_name, table_name, ZM_SUFFIX));
+  }
   auto table_file = disk_manager_->OpenFile(FILE_NAME(db_name, table_name, TAB_SUFFIX));
   // 2. prepare table header
   TableHeader table_header;
@@ -54,6 +57,9 @@ void TableManager::CreateTable(
 void TableManager::DropTable(const std::string &db_name, const std::string &table_name)
 {
   DiskManager::DestroyFile(FILE_NAME(db_name, table_name, TAB_SUFFIX));
+  if (DiskManager::FileExists(FILE_NAME(db_name, table_name, ZM_SUFFIX))) {
+    DiskManager::DestroyFile(FILE_NAME(db_name, table_name, ZM_SUFFIX));
+  }
 }
 
 TableHandleUptr TableManager::OpenTable(
@@ -83,13 +89,17 @@ TableHandleUptr TableManager::OpenTable(
   }
   schema = std::make_unique<RecordSchema>(fields);
   delete[] file_hdr_data;
-  return std::make_unique<TableHandle>(disk_manager_, buffer_pool_manager_, table_file, header, schema, storage_model);
+  auto table_handle =
+      std::make_unique<TableHandle>(disk_manager_, buffer_pool_manager_, table_file, header, schema, storage_model);
+  table_handle->LoadZoneMap(FILE_NAME(db_name, table_name, ZM_SUFFIX));
+  return table_handle;
 }
 
 void TableManager::CloseTable(const std::string &db_name, const TableHandle &table_handle)
 {
-  // 1. write table header to the zero page
+  // 1. write table header to the zero page, and the zone map to its side file
   WriteTableHeader(table_handle.GetTableId(), table_handle.GetTableHeader(), table_handle.GetSchema());
+  table_handle.FlushZoneMap(FILE_NAME(db_name, table_handle.GetTableName(), ZM_SUFFIX));
   // 2. flush all pages to disk
   buffer_pool_manager_->FlushAllPages(table_handle.GetTableId());
   // delete all pages
@@ -0,0 +1,89 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "common/datum.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+TEST(DatumTest, NullsFirst)
+{
+  std::vector<Datum> ordered{Datum(), Datum::FromInt(-5), Datum::FromInt(0), Datum::FromInt(7)};
+  for (size_t i = 0; i < ordered.size(); ++i) {
+    for (size_t j = 0; j < ordered.size(); ++j) {
+      SCOPED_TRACE(fmt::format("{} {}", i, j));
+      auto expect = i < j ? -1 : (i > j ? 1 : 0);
+      ASSERT_EQ(Datum::CompareNullsFirst(ordered[i], ordered[j]), expect);
+    }
+  }
+  ASSERT_EQ(Datum::CompareNullsFirst(Datum(), Datum::FromString("")), -1);
+  ASSERT_EQ(Datum::CompareNullsFirst(Datum::FromFloat(-1e30f), Datum()), 1);
+}
+
+TEST(DatumTest, NullComparison)
+{
+  // null = null is true, any other comparison with null is false
+  Datum null;
+  Datum one = Datum::FromInt(1);
+  ASSERT_TRUE(Datum::Eval(OP_EQ, null, null));
+  ASSERT_FALSE(Datum::Eval(OP_NE, null, null));
+  for (auto op : {OP_LT, OP_LE, OP_GT, OP_GE}) {
+    SCOPED_TRACE(CompOpToString(op));
+    ASSERT_FALSE(Datum::Eval(op, null, null));
+    ASSERT_FALSE(Datum::Eval(op, null, one));
+    ASSERT_FALSE(Datum::Eval(op, one, null));
+  }
+  ASSERT_FALSE(Datum::Eval(OP_EQ, null, one));
+  ASSERT_TRUE(Datum::Eval(OP_NE, one, null));
+  ASSERT_EQ(null.Hash(), Datum().Hash());
+}
+
+TEST(DatumTest, MixedIntFloat)
+{
+  // int and float are compared as float in both orders
+  ASSERT_EQ(Datum::Compare(Datum::FromInt(2), Datum::FromFloat(2.0f)), 0);
+  ASSERT_EQ(Datum::Compare(Datum::FromFloat(2.0f), Datum::FromInt(2)), 0);
+  ASSERT_EQ(Datum::Compare(Datum::FromInt(2), Datum::FromFloat(2.5f)), -1);
+  ASSERT_EQ(Datum::Compare(Datum::FromFloat(2.5f), Datum::FromInt(2)), 1);
+  ASSERT_EQ(Datum::Compare(Datum::FromInt(-3), Datum::FromFloat(-2.5f)), -1);
+  ASSERT_TRUE(Datum::Eval(OP_GE, Datum::FromFloat(-2.5f), Datum::FromInt(-3)));
+  ASSERT_TRUE(Datum::Eval(OP_EQ, Datum::FromInt(0), Datum::FromFloat(-0.0f)));
+  // other types that differ cannot be compared
+  ASSERT_THROW(Datum::Compare(Datum::FromInt(1), Datum::FromString("1")), WSDBException_);
+  ASSERT_THROW(Datum::Compare(Datum::FromBool(true), Datum::FromInt(1)), WSDBException_);
+}
+
+TEST(DatumTest, NegativeZero)
+{
+  // -0.0 and 0.0 are the same value, so they are equal and hash alike, e.g. for group by and hash join keys
+  auto neg_zero = Datum::FromFloat(-0.0f);
+  auto zero     = Datum::FromFloat(0.0f);
+  ASSERT_EQ(Datum::Compare(neg_zero, zero), 0);
+  ASSERT_EQ(Datum::CompareNullsFirst(neg_zero, zero), 0);
+  ASSERT_TRUE(Datum::Eval(OP_EQ, neg_zero, zero));
+  ASSERT_FALSE(Datum::Eval(OP_LT, neg_zero, zero));
+  ASSERT_EQ(neg_zero.Hash(), zero.Hash());
+  ASSERT_EQ(Datum::Compare(neg_zero, Datum::FromFloat(-1e-30f)), 1);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,174 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "expr/compiled_predicate.h"
+#include "expr/condition_expr.h"
+
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+static const CompOp OPS[] = {OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE};
+
+class CompiledPredicateTest : public ::testing::Test
+{
+protected:
+  static auto Field(const std::string &name, FieldType type, size_t size) -> RTField
+  {
+    RTField field;
+    field.field_.table_id_   = 1;
+    field.field_.field_name_ = name;
+    field.field_.field_type_ = type;
+    field.field_.field_size_ = size;
+    return field;
+  }
+
+  /// about one value in six is null
+  void SetUp() override
+  {
+    std::mt19937 rng(7);
+    static const char *strs[] = {"", "ab", "abc", "b", "zz"};
+    auto               null_or = [&rng](FieldType type, ValueSptr value) {
+      return rng() % 6 == 0 ? ValueFactory::CreateNullValue(type) : std::move(value);
+    };
+    for (int i = 0; i < 2000; ++i) {
+      const char *s1 = strs[rng() % 5];
+      const char *s2 = strs[rng() % 5];
+      auto                   half = static_cast<float>(static_cast<int>(rng() % 20) - 10) / 2;
+      std::vector<ValueSptr> values{null_or(TYPE_INT, ValueFactory::CreateIntValue(static_cast<int>(rng() % 10) - 5)),
+          null_or(TYPE_FLOAT, ValueFactory::CreateFloatValue(half)),
+          null_or(TYPE_STRING, ValueFactory::CreateStringValue(s1, strlen(s1))),
+          null_or(TYPE_STRING, ValueFactory::CreateStringValue(s2, strlen(s2))),
+          null_or(TYPE_INT, ValueFactory::CreateIntValue(static_cast<int>(rng() % 10) - 5)),
+          null_or(TYPE_BOOL, ValueFactory::CreateBoolValue(rng() % 2 == 0))};
+      records_.emplace_back(&schema_, values, INVALID_RID);
+    }
+  }
+
+  /// the compiled predicate, also once moved, agrees with ConditionExpr on every record
+  void Check(const ConditionVec &conds)
+  {
+    auto pred  = CompiledPredicate::Compile(conds, &schema_);
+    auto moved = std::move(pred);
+    for (const auto &record : records_) {
+      ASSERT_EQ(moved.Eval(record), ConditionExpr::Eval(conds, record)) << RecordString(record);
+    }
+  }
+
+  static auto RecordString(const Record &record) -> std::string
+  {
+    std::string str;
+    for (size_t i = 0; i < record.GetSchema()->GetFieldCount(); ++i) {
+      str += record.GetValueAt(i)->ToString() + "|";
+    }
+    return str;
+  }
+
+  RTField             i_{Field("i", TYPE_INT, 4)};
+  RTField             f_{Field("f", TYPE_FLOAT, 4)};
+  RTField             s_{Field("s", TYPE_STRING, 8)};
+  RTField             t_{Field("t", TYPE_STRING, 8)};
+  RTField             j_{Field("j", TYPE_INT, 4)};
+  RTField             b_{Field("b", TYPE_BOOL, 1)};
+  RecordSchema        schema_{std::vector<RTField>{i_, f_, s_, t_, j_, b_}};
+  std::vector<Record> records_;
+};
+
+TEST_F(CompiledPredicateTest, Constants)
+{
+  for (auto op : OPS) {
+    SCOPED_TRACE(CompOpToString(op));
+    std::vector<std::pair<RTField, ValueSptr>> cases{{i_, ValueFactory::CreateIntValue(1)},
+        {i_, ValueFactory::CreateFloatValue(1.5f)},
+        {i_, ValueFactory::CreateFloatValue(2.0f)},
+        {f_, ValueFactory::CreateIntValue(2)},
+        {f_, ValueFactory::CreateFloatValue(-1.5f)},
+        {s_, ValueFactory::CreateStringValue("ab", 2)},
+        {b_, ValueFactory::CreateBoolValue(true)},
+        {i_, ValueFactory::CreateNullValue(TYPE_INT)},
+        {s_, ValueFactory::CreateNullValue(TYPE_STRING)}};
+    for (auto &[field, value] : cases) {
+      SCOPED_TRACE(value->ToString());
+      Check({Condition(op, field, value)});
+    }
+  }
+}
+
+TEST_F(CompiledPredicateTest, Columns)
+{
+  for (auto op : OPS) {
+    SCOPED_TRACE(CompOpToString(op));
+    Check({Condition(op, i_, j_)});
+    Check({Condition(op, i_, f_)});
+    Check({Condition(op, f_, j_)});
+    Check({Condition(op, s_, t_)});
+  }
+}
+
+TEST_F(CompiledPredicateTest, InList)
+{
+  auto int_value   = [](int value) -> ValueSptr { return ValueFactory::CreateIntValue(value); };
+  auto float_value = [](float value) -> ValueSptr { return ValueFactory::CreateFloatValue(value); };
+  auto str_value   = [](const char *value) -> ValueSptr {
+    return ValueFactory::CreateStringValue(value, strlen(value));
+  };
+  std::vector<std::pair<RTField, std::vector<ValueSptr>>> cases{{i_, {int_value(1), int_value(3)}},
+      {i_, {}},
+      // an int field is compared as float with a list that has a float
+      {i_, {int_value(1), float_value(2.5f), float_value(-3.0f)}},
+      {i_, {int_value(1), ValueFactory::CreateNullValue(TYPE_INT)}},
+      {f_, {int_value(2), float_value(-1.5f)}},
+      {f_, {float_value(0.5f), ValueFactory::CreateNullValue(TYPE_FLOAT)}},
+      {s_, {str_value("ab"), str_value(""), ValueFactory::CreateNullValue(TYPE_STRING)}},
+      {b_, {ValueFactory::CreateBoolValue(true)}}};
+  for (auto &[field, values] : cases) {
+    ValueSptr list = ValueFactory::CreateArrayValue(values);
+    SCOPED_TRACE(field.field_.field_name_ + " IN " + list->ToString());
+    Check({Condition(OP_IN, field, list)});
+  }
+
+  // a list of a type the field cannot be compared with runs as a generic step, which throws like ConditionExpr
+  ValueSptr    list = ValueFactory::CreateArrayValue({int_value(1)});
+  ConditionVec conds{Condition(OP_IN, b_, list)};
+  auto         pred     = CompiledPredicate::Compile(conds, &schema_);
+  auto         eval_all = [this](const std::function<bool(const Record &)> &eval) {
+    for (const auto &record : records_) {
+      eval(record);
+    }
+  };
+  ASSERT_THROW(eval_all([&conds](const Record &record) { return ConditionExpr::Eval(conds, record); }), WSDBException_);
+  ASSERT_THROW(eval_all([&pred](const Record &record) { return pred.Eval(record); }), WSDBException_);
+}
+
+TEST_F(CompiledPredicateTest, Conjunction)
+{
+  ValueSptr zero = ValueFactory::CreateIntValue(0);
+  ValueSptr b    = ValueFactory::CreateStringValue("b", 1);
+  ValueSptr list =
+      ValueFactory::CreateArrayValue({ValueFactory::CreateFloatValue(-1.0f), ValueFactory::CreateIntValue(2)});
+  Check({Condition(OP_GT, i_, zero), Condition(OP_LE, s_, b), Condition(OP_NE, i_, j_)});
+  Check({Condition(OP_IN, f_, list), Condition(OP_GE, i_, zero)});
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,251 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "expr/filter_kernel.h"
+#include "common/bitmap.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+static const CompOp OPS[] = {OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE};
+
+/// a column of n rows in record layout, about one row in null_every is null
+class TestColumn
+{
+public:
+  TestColumn(FieldType type, size_t size, size_t n, size_t null_every, std::mt19937 &rng)
+      : type_(type), size_(size), data_(n * size), nullmap_(BITMAP_SIZE(n))
+  {
+    for (size_t row = 0; row < n; ++row) {
+      char *dst = data_.data() + row * size;
+      switch (type) {
+        case TYPE_BOOL: *reinterpret_cast<bool *>(dst) = rng() % 2; break;
+        case TYPE_INT: *reinterpret_cast<int32_t *>(dst) = static_cast<int32_t>(rng() % 10) - 5; break;
+        case TYPE_FLOAT: *reinterpret_cast<float *>(dst) = (static_cast<float>(rng() % 20) - 10) / 2; break;
+        case TYPE_STRING: {
+          static const char *strs[] = {"", "a", "ab", "abc", "b"};
+          auto               str    = strs[rng() % 5];
+          memcpy(dst, str, strlen(str));
+          break;
+        }
+        default: break;
+      }
+      if (null_every > 0 && rng() % null_every == 0) {
+        BitMap::SetBit(nullmap_.data(), row, true);
+        has_null_ = true;
+      }
+    }
+  }
+
+  [[nodiscard]] auto View() const -> ColumnView
+  {
+    return {.type_ = type_, .size_ = size_, .data_ = data_.data(), .nullmap_ = has_null_ ? nullmap_.data() : nullptr};
+  }
+
+  [[nodiscard]] auto DatumAt(uint32_t row) const -> Datum
+  {
+    if (BitMap::GetBit(nullmap_.data(), row)) {
+      return {};
+    }
+    return Datum::FromRaw(type_, data_.data() + row * size_, size_);
+  }
+
+private:
+  FieldType         type_;
+  size_t            size_;
+  std::vector<char> data_;
+  std::vector<char> nullmap_;
+  bool              has_null_{false};
+};
+
+/// every other row, to check that only the selected rows are evaluated
+static auto HalfSelection(size_t n) -> std::vector<uint32_t>
+{
+  std::vector<uint32_t> sel;
+  for (uint32_t row = 1; row < n; row += 2) {
+    sel.push_back(row);
+  }
+  return sel;
+}
+
+/// run the kernel without a selection, with a selection, and with the selection narrowed in place
+template <typename Kernel, typename Expect>
+static void CheckKernel(size_t n, Kernel kernel, Expect expect)
+{
+  std::vector<uint32_t> want_all;
+  for (uint32_t row = 0; row < n; ++row) {
+    if (expect(row)) {
+      want_all.push_back(row);
+    }
+  }
+  std::vector<uint32_t> out(n);
+  out.resize(kernel(nullptr, n, out.data()));
+  ASSERT_EQ(out, want_all);
+
+  auto                  sel = HalfSelection(n);
+  std::vector<uint32_t> want_sel;
+  for (auto row : sel) {
+    if (expect(row)) {
+      want_sel.push_back(row);
+    }
+  }
+  out.assign(sel.size(), 0);
+  out.resize(kernel(sel.data(), sel.size(), out.data()));
+  ASSERT_EQ(out, want_sel);
+
+  // out is the same array as the input selection, the passing rows are compacted to the front in order
+  sel.resize(kernel(sel.data(), sel.size(), sel.data()));
+  ASSERT_EQ(sel, want_sel);
+}
+
+TEST(FilterKernelTest, SelectConst)
+{
+  std::mt19937 rng(1);
+  const size_t n = 1000;
+  for (size_t null_every : {0, 3}) {
+    TestColumn ints(TYPE_INT, 4, n, null_every, rng);
+    TestColumn floats(TYPE_FLOAT, 4, n, null_every, rng);
+    TestColumn bools(TYPE_BOOL, 1, n, null_every, rng);
+    TestColumn strs(TYPE_STRING, 4, n, null_every, rng);
+    std::vector<std::pair<const TestColumn *, Datum>> cases{{&ints, Datum::FromInt(1)},
+        {&ints, Datum::FromFloat(1.5)},
+        {&floats, Datum::FromInt(2)},
+        {&floats, Datum::FromFloat(-1.5)},
+        {&bools, Datum::FromBool(true)},
+        {&strs, Datum::FromString("ab")},
+        {&ints, Datum{}}};
+    for (size_t i = 0; i < cases.size(); ++i) {
+      const auto &[col, val] = cases[i];
+      for (auto op : OPS) {
+        SCOPED_TRACE(fmt::format("case {}, {}, null every {}", i, CompOpToString(op), null_every));
+        CheckKernel(
+            n,
+            [&](const uint32_t *sel, size_t k, uint32_t *out) {
+              return FilterKernel::SelectConst(op, col->View(), val, sel, k, out);
+            },
+            [&](uint32_t row) { return Datum::Eval(op, col->DatumAt(row), val); });
+      }
+    }
+  }
+}
+
+TEST(FilterKernelTest, SelectColumns)
+{
+  std::mt19937 rng(2);
+  const size_t n = 1000;
+  TestColumn   ints(TYPE_INT, 4, n, 4, rng);
+  TestColumn   ints2(TYPE_INT, 4, n, 5, rng);
+  TestColumn   floats(TYPE_FLOAT, 4, n, 4, rng);
+  TestColumn   strs(TYPE_STRING, 4, n, 4, rng);
+  TestColumn   strs2(TYPE_STRING, 4, n, 0, rng);
+  std::vector<std::pair<const TestColumn *, const TestColumn *>> cases{
+      {&ints, &ints2}, {&ints, &floats}, {&floats, &ints}, {&strs, &strs2}};
+  for (const auto &[lhs, rhs] : cases) {
+    for (auto op : OPS) {
+      SCOPED_TRACE(CompOpToString(op));
+      CheckKernel(
+          n,
+          [&](const uint32_t *sel, size_t k, uint32_t *out) {
+            return FilterKernel::SelectColumns(op, lhs->View(), rhs->View(), sel, k, out);
+          },
+          [&](uint32_t row) { return Datum::Eval(op, lhs->DatumAt(row), rhs->DatumAt(row)); });
+    }
+  }
+}
+
+TEST(FilterKernelTest, SelectIn)
+{
+  std::mt19937 rng(3);
+  const size_t n = 1000;
+  TestColumn   ints(TYPE_INT, 4, n, 4, rng);
+  TestColumn   floats(TYPE_FLOAT, 4, n, 4, rng);
+  TestColumn   strs(TYPE_STRING, 4, n, 4, rng);
+  std::vector<std::pair<const TestColumn *, std::vector<Datum>>> cases{
+      {&ints, {Datum::FromInt(1), Datum::FromInt(-3)}},
+      {&ints, {Datum::FromInt(1), Datum{}}},
+      // int and float are compared as float, as SelectConst does
+      {&ints, {Datum::FromFloat(2), Datum::FromFloat(2.5), Datum::FromInt(-1)}},
+      {&floats, {Datum::FromInt(2), Datum::FromFloat(-0.5)}},
+      {&floats, {Datum{}}},
+      {&strs, {Datum::FromString("a"), Datum::FromString("abc"), Datum{}}},
+      {&strs, {}}};
+  for (const auto &[col, vals] : cases) {
+    CheckKernel(
+        n,
+        [&](const uint32_t *sel, size_t k, uint32_t *out) {
+          return FilterKernel::SelectIn(col->View(), vals, sel, k, out);
+        },
+        [&](uint32_t row) {
+          auto lhs = col->DatumAt(row);
+          return std::any_of(
+              vals.begin(), vals.end(), [&lhs](const Datum &val) { return Datum::Eval(OP_EQ, lhs, val); });
+        });
+  }
+  // a value that can not be compared with the column is an error, the same as SelectConst
+  std::vector<uint32_t> out(n);
+  ASSERT_THROW(FilterKernel::SelectIn(ints.View(), {Datum::FromString("a")}, nullptr, n, out.data()), WSDBException_);
+  ASSERT_THROW(FilterKernel::SelectConst(OP_EQ, ints.View(), Datum::FromString("a"), nullptr, n, out.data()),
+      WSDBException_);
+}
+
+TEST(FilterKernelTest, SelectString)
+{
+  std::mt19937 rng(4);
+  const size_t n = 1000;
+  TestColumn   strs(TYPE_STRING, 4, n, 3, rng);
+  for (std::string_view val : {"", "a", "ab", "abcd"}) {
+    for (bool equal : {true, false}) {
+      CheckKernel(
+          n,
+          [&](const uint32_t *sel, size_t k, uint32_t *out) {
+            return FilterKernel::SelectStringEqual(equal, strs.View(), val, sel, k, out);
+          },
+          [&](uint32_t row) { return Datum::Eval(equal ? OP_EQ : OP_NE, strs.DatumAt(row), Datum::FromString(val)); });
+    }
+    CheckKernel(
+        n,
+        [&](const uint32_t *sel, size_t k, uint32_t *out) {
+          return FilterKernel::SelectStringPrefix(strs.View(), val, sel, k, out);
+        },
+        [&](uint32_t row) {
+          auto lhs = strs.DatumAt(row);
+          return !lhs.IsNull() && lhs.GetString().starts_with(val);
+        });
+  }
+}
+
+TEST(FilterKernelTest, HasNull)
+{
+  std::vector<char> nullmap(BITMAP_SIZE(100));
+  ASSERT_FALSE(FilterKernel::HasNull(nullmap.data(), 100));
+  BitMap::SetBit(nullmap.data(), 99, true);
+  ASSERT_TRUE(FilterKernel::HasNull(nullmap.data(), 100));
+  // bits beyond the rows of the chunk are ignored
+  ASSERT_FALSE(FilterKernel::HasNull(nullmap.data(), 99));
+  BitMap::SetBit(nullmap.data(), 8, true);
+  ASSERT_TRUE(FilterKernel::HasNull(nullmap.data(), 9));
+  ASSERT_FALSE(FilterKernel::HasNull(nullmap.data(), 8));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
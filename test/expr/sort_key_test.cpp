@@ -0,0 +1,247 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "expr/sort_key.h"
+
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// memcmp of the keys agrees with Datum::CompareNullsFirst, reversed for descending fields
+class SortKeyTest : public ::testing::Test
+{
+protected:
+  /// a field value in record layout, an empty value is null
+  struct RawValue
+  {
+    std::vector<char> data_;
+
+    [[nodiscard]] auto IsNull() const -> bool { return data_.empty(); }
+
+    [[nodiscard]] auto ToDatum(FieldType type) const -> Datum
+    {
+      return IsNull() ? Datum() : Datum::FromRaw(type, data_.data(), data_.size());
+    }
+  };
+
+  static auto Null() -> RawValue { return {}; }
+
+  static auto Int(int32_t value) -> RawValue
+  {
+    RawValue raw{std::vector<char>(sizeof(int32_t))};
+    memcpy(raw.data_.data(), &value, sizeof(int32_t));
+    return raw;
+  }
+
+  static auto Float(float value) -> RawValue
+  {
+    RawValue raw{std::vector<char>(sizeof(float))};
+    memcpy(raw.data_.data(), &value, sizeof(float));
+    return raw;
+  }
+
+  static auto Bool(bool value) -> RawValue { return {std::vector<char>{static_cast<char>(value)}}; }
+
+  /// a string field of STR_SIZE bytes, zero-padded, a string of STR_SIZE bytes has no terminator
+  static auto Str(const std::string &value) -> RawValue
+  {
+    RawValue raw{std::vector<char>(STR_SIZE, 0)};
+    memcpy(raw.data_.data(), value.data(), std::min(value.size(), STR_SIZE));
+    return raw;
+  }
+
+  static auto Field(const std::string &name, FieldType type, size_t size) -> RTField
+  {
+    RTField field;
+    field.field_.table_id_   = 1;
+    field.field_.field_name_ = name;
+    field.field_.field_type_ = type;
+    field.field_.field_size_ = size;
+    return field;
+  }
+
+  static auto Sign(int cmp) -> int { return (cmp > 0) - (cmp < 0); }
+
+  static auto Encode(const SortKeyEncoder &encoder, size_t i, const RawValue &value) -> std::vector<char>
+  {
+    std::vector<char> key(encoder.GetKeySize());
+    encoder.EncodeField(i, value.data_.data(), value.IsNull(), key.data());
+    return key;
+  }
+
+  /// the keys of all pairs of values of one field compare as their datums, in both directions
+  static void CheckField(FieldType type, size_t size, const std::vector<RawValue> &values)
+  {
+    for (bool is_desc : {false, true}) {
+      SortKeyEncoder encoder;
+      encoder.AddField(0, type, size, is_desc);
+      for (const auto &lhs : values) {
+        for (const auto &rhs : values) {
+          auto lhs_datum = lhs.ToDatum(type);
+          auto rhs_datum = rhs.ToDatum(type);
+          auto expect    = Datum::CompareNullsFirst(lhs_datum, rhs_datum) * (is_desc ? -1 : 1);
+          auto lhs_key   = Encode(encoder, 0, lhs);
+          auto rhs_key   = Encode(encoder, 0, rhs);
+          ASSERT_EQ(encoder.Compare(lhs_key.data(), rhs_key.data()), expect)
+              << (lhs.IsNull() ? "null" : lhs_datum.ToValue()->ToString()) << " vs "
+              << (rhs.IsNull() ? "null" : rhs_datum.ToValue()->ToString()) << (is_desc ? " desc" : " asc");
+        }
+      }
+    }
+  }
+
+  static constexpr size_t STR_SIZE = 8;
+};
+
+TEST_F(SortKeyTest, Int)
+{
+  CheckField(TYPE_INT,
+      sizeof(int32_t),
+      {Int(INT_MIN), Int(INT_MIN + 1), Int(-65536), Int(-256), Int(-255), Int(-1), Int(0), Int(1), Int(255), Int(256),
+          Int(65536), Int(INT_MAX - 1), Int(INT_MAX), Null()});
+}
+
+TEST_F(SortKeyTest, Float)
+{
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  CheckField(TYPE_FLOAT,
+      sizeof(float),
+      {Float(-inf), Float(std::numeric_limits<float>::lowest()), Float(-1e10f), Float(-2.5f), Float(-1.5f),
+          Float(-std::numeric_limits<float>::denorm_min()), Float(-0.0f), Float(0.0f),
+          Float(std::numeric_limits<float>::denorm_min()), Float(1e-30f), Float(1.5f), Float(2.5f), Float(1e10f),
+          Float(std::numeric_limits<float>::max()), Float(inf), Null()});
+}
+
+TEST_F(SortKeyTest, NegativeAndPositiveZero)
+{
+  // -0.0 equals 0.0, so their keys have the same bytes and hash alike
+  SortKeyEncoder encoder;
+  encoder.AddField(0, TYPE_FLOAT, sizeof(float));
+  ASSERT_EQ(Encode(encoder, 0, Float(-0.0f)), Encode(encoder, 0, Float(0.0f)));
+}
+
+TEST_F(SortKeyTest, String)
+{
+  // prefixes of each other, the empty string, a string that fills the field and bytes above 0x7f
+  CheckField(TYPE_STRING,
+      STR_SIZE,
+      {Str(""), Str("a"), Str("ab"), Str("abc"), Str("abcdefg"), Str("abcdefgh"), Str("abd"), Str("b"), Str("B"),
+          Str("\x7f"), Str("\x80"), Str("\xff"), Str("\xff\xff"), Null()});
+}
+
+TEST_F(SortKeyTest, Bool) { CheckField(TYPE_BOOL, sizeof(bool), {Bool(false), Bool(true), Null()}); }
+
+TEST_F(SortKeyTest, NullsFirstAndLast)
+{
+  // nulls come before all values of an ascending field and after all values of a descending one
+  for (bool is_desc : {false, true}) {
+    SortKeyEncoder encoder;
+    encoder.AddField(0, TYPE_INT, sizeof(int32_t), is_desc);
+    auto null_key = Encode(encoder, 0, Null());
+    for (auto value : {INT_MIN, -1, 0, INT_MAX}) {
+      auto key = Encode(encoder, 0, Int(value));
+      ASSERT_EQ(encoder.Compare(null_key.data(), key.data()), is_desc ? 1 : -1) << value;
+    }
+    ASSERT_EQ(encoder.Compare(null_key.data(), Encode(encoder, 0, Null()).data()), 0);
+  }
+}
+
+TEST_F(SortKeyTest, Records)
+{
+  // records of (i, s, f) with i ascending, s descending and f ascending compare field by field
+  RTField           i = Field("i", TYPE_INT, sizeof(int32_t));
+  RTField           s = Field("s", TYPE_STRING, STR_SIZE);
+  RTField           f = Field("f", TYPE_FLOAT, sizeof(float));
+  RecordSchema      schema(std::vector<RTField>{f, s, i});
+  RecordSchema      key_schema(std::vector<RTField>{i, s, f});
+  std::vector<bool> is_desc{false, true, false};
+  SortKeyEncoder    encoder(&schema, &key_schema, is_desc);
+
+  std::vector<ValueSptr> i_values{ValueFactory::CreateIntValue(INT_MIN),
+      ValueFactory::CreateIntValue(-1),
+      ValueFactory::CreateIntValue(0),
+      ValueFactory::CreateIntValue(INT_MAX),
+      ValueFactory::CreateNullValue(TYPE_INT)};
+  std::vector<ValueSptr> s_values{ValueFactory::CreateStringValue("", 0),
+      ValueFactory::CreateStringValue("a", 1),
+      ValueFactory::CreateStringValue("ab", 2),
+      ValueFactory::CreateNullValue(TYPE_STRING)};
+  std::vector<ValueSptr> f_values{ValueFactory::CreateFloatValue(-1.5f),
+      ValueFactory::CreateFloatValue(-0.0f),
+      ValueFactory::CreateFloatValue(0.0f),
+      ValueFactory::CreateFloatValue(2.0f),
+      ValueFactory::CreateNullValue(TYPE_FLOAT)};
+  std::vector<Record> records;
+  for (const auto &i_value : i_values) {
+    for (const auto &s_value : s_values) {
+      for (const auto &f_value : f_values) {
+        records.emplace_back(&schema, std::vector<ValueSptr>{f_value, s_value, i_value}, INVALID_RID);
+      }
+    }
+  }
+  std::vector<std::vector<char>> keys;
+  for (const auto &record : records) {
+    keys.emplace_back(encoder.GetKeySize());
+    encoder.Encode(record, keys.back().data());
+  }
+  for (size_t l = 0; l < records.size(); ++l) {
+    for (size_t r = 0; r < records.size(); ++r) {
+      int expect = 0;
+      for (size_t k = 0; k < key_schema.GetFieldCount() && expect == 0; ++k) {
+        auto col = schema.GetRTFieldIndex(key_schema.GetFieldAt(k));
+        expect   = Datum::CompareNullsFirst(records[l].GetDatumAt(col), records[r].GetDatumAt(col));
+        expect   = is_desc[k] ? -expect : expect;
+      }
+      ASSERT_EQ(Sign(memcmp(keys[l].data(), keys[r].data(), encoder.GetKeySize())), expect) << l << " vs " << r;
+    }
+  }
+}
+
+TEST_F(SortKeyTest, AlignIntWithFloat)
+{
+  // an int field aligned with a float field is encoded as float, so keys of both sides compare as their values
+  RTField        i = Field("i", TYPE_INT, sizeof(int32_t));
+  RTField        f = Field("f", TYPE_FLOAT, sizeof(float));
+  RecordSchema   int_schema(std::vector<RTField>{i});
+  RecordSchema   float_schema(std::vector<RTField>{f});
+  SortKeyEncoder int_encoder(&int_schema, &int_schema);
+  SortKeyEncoder float_encoder(&float_schema, &float_schema);
+  SortKeyEncoder::Align(int_encoder, float_encoder);
+  ASSERT_EQ(int_encoder.GetKeySize(), float_encoder.GetKeySize());
+
+  std::vector<RawValue> ints{Int(-1000000), Int(-3), Int(-1), Int(0), Int(1), Int(2), Int(16777216), Null()};
+  std::vector<RawValue> floats{Float(-1e7f), Float(-2.5f), Float(-1.0f), Float(-0.0f), Float(0.5f), Float(2.0f),
+      Float(16777216.0f), Null()};
+  for (const auto &int_value : ints) {
+    for (const auto &float_value : floats) {
+      auto expect    = Datum::CompareNullsFirst(int_value.ToDatum(TYPE_INT), float_value.ToDatum(TYPE_FLOAT));
+      auto int_key   = Encode(int_encoder, 0, int_value);
+      auto float_key = Encode(float_encoder, 0, float_value);
+      ASSERT_EQ(int_encoder.Compare(int_key.data(), float_key.data()), expect);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
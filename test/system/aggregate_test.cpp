@@ -0,0 +1,312 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor_aggregate_parallel.h"
+#include "execution/executor_aggregate_stream.h"
+#include "execution/executor_aggregate_vec.h"
+#include "execution/executor_filter.h"
+#include "execution/executor_seqscan.h"
+#include "execution/executor_sort.h"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <optional>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// exposes the number of tmp files, to check that the aggregation did spill
+class SpillingAggregateExecutor : public AggregateExecutorVec
+{
+public:
+  using AggregateExecutorVec::AggregateExecutorVec;
+
+  [[nodiscard]] auto GetSpillFileNum() const -> size_t { return spill_file_num_; }
+};
+
+/// hides the batch interface of the child, so the chunks of the parent are made row at a time by the default NextBatch
+class RowAtATimeExecutor : public AbstractExecutor
+{
+public:
+  explicit RowAtATimeExecutor(AbstractExecutorUptr child) : AbstractExecutor(Basic), child_(std::move(child)) {}
+
+  void Init() override
+  {
+    child_->Init();
+    record_ = child_->GetRecord();
+  }
+
+  void Next() override
+  {
+    child_->Next();
+    record_ = child_->GetRecord();
+  }
+
+  [[nodiscard]] auto IsEnd() const -> bool override { return child_->IsEnd(); }
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override { return child_->GetOutSchema(); }
+
+private:
+  AbstractExecutorUptr child_;
+};
+
+class AggregateTest : public ::testing::Test
+{
+protected:
+  /// group by g, s and aggregate COUNT(*), COUNT(x), SUM(x), AVG(x), SUM(y), MIN(y), MAX(s)
+  struct Group
+  {
+    int64_t              count_star_{0};
+    int64_t              count_x_{0};
+    int64_t              sum_x_{0};
+    int64_t              count_y_{0};
+    float                sum_y_{0};
+    bool                 has_min_y_{false};
+    float                min_y_{0};
+    std::string          max_s_;
+  };
+
+  void SetUp() override
+  {
+    db_->CreateTable("t",
+        RecordSchema({MakeField("g", TYPE_INT, 4),
+            MakeField("s", TYPE_STRING, 8),
+            MakeField("x", TYPE_INT, 4),
+            MakeField("y", TYPE_FLOAT, 4)}),
+        NARY_MODEL);
+    for (int i = 0; i < ROW_NUM; ++i) {
+      std::optional<int> g = i % 31 == 0 ? std::nullopt : std::optional<int>(i % 150);
+      std::string        s = fmt::format("s{}", i % 3);
+      bool               has_x = i % 7 != 0;
+      int                x     = i % 23 - 11;
+      // quarters add up exactly in any order
+      bool  has_y = i % 5 != 0;
+      float y     = static_cast<float>(i % 9) * 0.25f - 1;
+      InsertRow(db_->GetTable("t"),
+          {g ? ValueFactory::CreateIntValue(*g) : ValueFactory::CreateNullValue(TYPE_INT),
+              ValueFactory::CreateStringValue(s.c_str(), s.size()),
+              has_x ? ValueFactory::CreateIntValue(x) : ValueFactory::CreateNullValue(TYPE_INT),
+              has_y ? ValueFactory::CreateFloatValue(y) : ValueFactory::CreateNullValue(TYPE_FLOAT)});
+      auto &group = groups_[{g, s}];
+      group.count_star_++;
+      if (has_x) {
+        group.count_x_++;
+        group.sum_x_ += x;
+      }
+      if (has_y) {
+        group.count_y_++;
+        group.sum_y_ += y;
+        group.min_y_     = group.has_min_y_ ? std::min(group.min_y_, y) : y;
+        group.has_min_y_ = true;
+      }
+      group.max_s_ = std::max(group.max_s_, s);
+    }
+  }
+
+  auto Field(size_t idx, AggType agg_type = AGG_NONE) -> RTField
+  {
+    auto field = db_->GetTable("t")->GetSchema().GetFieldAt(idx);
+    if (agg_type != AGG_NONE) {
+      field.is_agg_   = true;
+      field.agg_type_ = agg_type;
+    }
+    if (agg_type == AGG_COUNT || agg_type == AGG_COUNT_STAR) {
+      field.field_.field_type_ = TYPE_INT;
+      field.field_.field_size_ = sizeof(int);
+    }
+    return field;
+  }
+
+  auto AggSchema() -> RecordSchemaUptr
+  {
+    RTField count_star;
+    count_star.is_agg_            = true;
+    count_star.agg_type_          = AGG_COUNT_STAR;
+    count_star.field_.field_type_ = TYPE_INT;
+    count_star.field_.field_size_ = sizeof(int);
+    return std::make_unique<RecordSchema>(std::vector<RTField>{count_star,
+        Field(2, AGG_COUNT),
+        Field(2, AGG_SUM),
+        Field(2, AGG_AVG),
+        Field(3, AGG_SUM),
+        Field(3, AGG_MIN),
+        Field(1, AGG_MAX)});
+  }
+
+  auto GroupSchema() -> RecordSchemaUptr
+  {
+    return std::make_unique<RecordSchema>(std::vector<RTField>{Field(0), Field(1)});
+  }
+
+  auto Aggregate(size_t buffer_size) -> std::unique_ptr<SpillingAggregateExecutor>
+  {
+    return std::make_unique<SpillingAggregateExecutor>(
+        std::make_unique<SeqScanExecutor>(db_->GetTable("t")), AggSchema(), GroupSchema(), buffer_size);
+  }
+
+  auto Expect(const RecordSchema *out_schema) -> std::vector<std::string>
+  {
+    auto int_or_null = [](bool is_null, int64_t value) {
+      return is_null ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(static_cast<int>(value));
+    };
+    auto float_or_null = [](bool is_null, float value) {
+      return is_null ? ValueFactory::CreateNullValue(TYPE_FLOAT) : ValueFactory::CreateFloatValue(value);
+    };
+    std::vector<std::string> expect;
+    for (const auto &[key, group] : groups_) {
+      const auto &[g, s] = key;
+      std::vector<ValueSptr> values{int_or_null(!g, g.value_or(0)),
+          ValueFactory::CreateStringValue(s.c_str(), s.size()),
+          ValueFactory::CreateIntValue(static_cast<int>(group.count_star_)),
+          ValueFactory::CreateIntValue(static_cast<int>(group.count_x_)),
+          int_or_null(group.count_x_ == 0, group.sum_x_),
+          int_or_null(group.count_x_ == 0, group.count_x_ == 0 ? 0 : group.sum_x_ / group.count_x_),
+          float_or_null(group.count_y_ == 0, group.sum_y_),
+          float_or_null(!group.has_min_y_, group.min_y_),
+          ValueFactory::CreateStringValue(group.max_s_.c_str(), group.max_s_.size())};
+      expect.push_back(RowString(Record(out_schema, values, INVALID_RID)));
+    }
+    return Sorted(expect);
+  }
+
+  static constexpr int ROW_NUM = 4000;
+
+  TestDatabase                                                    db_{"aggregate_test"};
+  std::map<std::pair<std::optional<int>, std::string>, Group> groups_;
+};
+
+TEST_F(AggregateTest, SpillMatchesInMemory)
+{
+  auto in_memory = Aggregate(AGG_BUFFER_SIZE);
+  auto expect    = Expect(in_memory->GetOutSchema());
+  ASSERT_EQ(expect.size(), groups_.size());
+  ASSERT_EQ(Sorted(DumpRows(in_memory.get())), expect);
+  ASSERT_EQ(Sorted(DumpBatches(in_memory.get())), expect);
+  ASSERT_EQ(in_memory->GetSpillFileNum(), 0);
+
+  // the groups do not fit in a few KB, rows of the others are partitioned once, or partitioned again when a partition
+  // still has too many groups. with a buffer of one group, each pass aggregates a single group and spills the rest
+  std::vector<std::pair<size_t, size_t>> cases{
+      {16 * 1024, AGG_PARTITION_NUM}, {2 * 1024, 2 * AGG_PARTITION_NUM}, {1, 2 * AGG_PARTITION_NUM}};
+  for (auto [buffer_size, min_spill_file_num] : cases) {
+    SCOPED_TRACE(buffer_size);
+    auto spilled = Aggregate(buffer_size);
+    ASSERT_EQ(Sorted(DumpRows(spilled.get())), expect);
+    ASSERT_GE(spilled->GetSpillFileNum(), min_spill_file_num);
+    ASSERT_EQ(Sorted(DumpBatches(spilled.get())), expect);
+  }
+  for (const auto &entry : std::filesystem::directory_iterator(TMP_DIR)) {
+    ASSERT_EQ(entry.path().filename().string().rfind("agg_", 0), std::string::npos) << entry.path();
+  }
+}
+
+TEST_F(AggregateTest, AllExecutorsAgree)
+{
+  auto expect = Expect(Aggregate(AGG_BUFFER_SIZE)->GetOutSchema());
+
+  // the stream aggregation reads the groups one after another from the sort
+  StreamAggregateExecutor stream(std::make_unique<SortExecutor>(std::make_unique<SeqScanExecutor>(db_->GetTable("t")),
+                                     GroupSchema(),
+                                     std::vector<bool>{false, false}),
+      AggSchema(),
+      GroupSchema());
+  ASSERT_EQ(Sorted(DumpRows(&stream)), expect);
+
+  ParallelAggregateExecutor parallel(
+      std::make_unique<SeqScanExecutor>(db_->GetTable("t")), AggSchema(), GroupSchema());
+  ASSERT_EQ(Sorted(DumpRows(&parallel)), expect);
+}
+
+TEST(AggregateBenchmarkTest, RowVsBatch)
+{
+  // select g, count(*), sum(x), min(y) from t where x >= 0 and y < 500 group by g
+  TestDatabase db("aggregate_bench");
+  db->CreateTable("t",
+      RecordSchema({MakeField("g", TYPE_INT, 4), MakeField("x", TYPE_INT, 4), MakeField("y", TYPE_FLOAT, 4)}),
+      NARY_MODEL);
+  auto     *table   = db->GetTable("t");
+  const int row_num = 500000;
+  for (int i = 0; i < row_num; ++i) {
+    InsertRow(table,
+        {ValueFactory::CreateIntValue(i % 100),
+            ValueFactory::CreateIntValue(i % 37 - 12),
+            ValueFactory::CreateFloatValue(static_cast<float>(i % 1000))});
+  }
+  auto field = [table](size_t idx, AggType agg_type = AGG_NONE) {
+    auto f = table->GetSchema().GetFieldAt(idx);
+    if (agg_type != AGG_NONE) {
+      f.is_agg_   = true;
+      f.agg_type_ = agg_type;
+    }
+    return f;
+  };
+  auto agg_schema = [&]() {
+    RTField count_star;
+    count_star.is_agg_            = true;
+    count_star.agg_type_          = AGG_COUNT_STAR;
+    count_star.field_.field_type_ = TYPE_INT;
+    count_star.field_.field_size_ = sizeof(int);
+    return std::make_unique<RecordSchema>(std::vector<RTField>{count_star, field(1, AGG_SUM), field(2, AGG_MIN)});
+  };
+  auto group_schema = [&]() { return std::make_unique<RecordSchema>(std::vector<RTField>{field(0)}); };
+  auto filter       = [&]() {
+    ValueSptr x = ValueFactory::CreateIntValue(0);
+    ValueSptr y = ValueFactory::CreateFloatValue(500.0f);
+    return std::make_unique<FilterExecutor>(std::make_unique<SeqScanExecutor>(table),
+        ConditionVec{Condition(OP_GE, field(1), x), Condition(OP_LT, field(2), y)});
+  };
+
+  // the row-at-a-time AggregateExecutor is not implemented yet, so both plans end in the vectorized aggregation and
+  // differ in how the scan and the filter run
+  AggregateExecutorVec row(std::make_unique<RowAtATimeExecutor>(filter()), agg_schema(), group_schema());
+  AggregateExecutorVec batch(filter(), agg_schema(), group_schema());
+  auto                 expect = Sorted(DumpBatches(&row));
+  ASSERT_EQ(expect.size(), 100);
+  ASSERT_EQ(Sorted(DumpBatches(&batch)), expect);
+
+  // best of a few runs, the table is in the buffer pool after the first one
+  auto best_ms = [](const std::function<void()> &run) {
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < 3; ++i) {
+      auto begin = std::chrono::steady_clock::now();
+      run();
+      auto end = std::chrono::steady_clock::now();
+      best     = std::min(best, std::chrono::duration<double, std::milli>(end - begin).count());
+    }
+    return best;
+  };
+  auto row_ms = best_ms([&]() {
+    row.Init();
+    while (row.NextBatch() != nullptr) {}
+  });
+  auto batch_ms = best_ms([&]() {
+    batch.Init();
+    while (batch.NextBatch() != nullptr) {}
+  });
+  std::cout << row_num << " rows, row at a time: " << row_ms << " ms, chunk at a time: " << batch_ms
+            << " ms, speedup: " << row_ms / batch_ms << "x" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
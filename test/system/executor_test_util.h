@@ -0,0 +1,130 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+/**
+ * @brief Helpers shared by the tests that run executors on a scratch database
+ */
+
+#ifndef WSDB_EXECUTOR_TEST_UTIL_H
+#define WSDB_EXECUTOR_TEST_UTIL_H
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "execution/executor_abstract.h"
+#include "system/handle/database_handle.h"
+#include "system/index/index_manager.h"
+#include "system/table/table_manager.h"
+
+namespace wsdb {
+
+/// a database in the working directory, it is removed when the test ends
+class TestDatabase
+{
+public:
+  explicit TestDatabase(std::string name) : name_(std::move(name))
+  {
+    std::filesystem::remove_all(name_);
+    disk_manager_        = std::make_unique<DiskManager>();
+    buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), nullptr);
+    table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    index_manager_       = std::make_unique<IndexManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    std::filesystem::create_directory(name_);
+    // spilling executors write their tmp files there
+    std::filesystem::create_directory(TMP_DIR);
+    DiskManager::CreateFile(FILE_NAME(name_, name_, DB_SUFFIX));
+    db_ = std::make_unique<DatabaseHandle>(name_, disk_manager_.get(), table_manager_.get(), index_manager_.get());
+    db_->Open();
+  }
+
+  ~TestDatabase()
+  {
+    db_->Close();
+    std::filesystem::remove_all(name_);
+  }
+
+  auto operator->() -> DatabaseHandle * { return db_.get(); }
+
+  auto Get() -> DatabaseHandle * { return db_.get(); }
+
+private:
+  std::string                        name_;
+  std::unique_ptr<DiskManager>       disk_manager_;
+  std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+  std::unique_ptr<TableManager>      table_manager_;
+  std::unique_ptr<IndexManager>      index_manager_;
+  std::unique_ptr<DatabaseHandle>    db_;
+};
+
+inline auto MakeField(const std::string &name, FieldType type, size_t size) -> RTField
+{
+  RTField field;
+  field.field_.field_name_ = name;
+  field.field_.field_type_ = type;
+  field.field_.field_size_ = size;
+  return field;
+}
+
+inline void InsertRow(TableHandle *table, const std::vector<ValueSptr> &values)
+{
+  table->InsertRecord(Record(&table->GetSchema(), values, INVALID_RID));
+}
+
+/// values of the record separated by '|'
+inline auto RowString(const Record &record) -> std::string
+{
+  std::string row;
+  for (size_t i = 0; i < record.GetSchema()->GetFieldCount(); ++i) {
+    row += record.GetValueAt(i)->ToString() + "|";
+  }
+  return row;
+}
+
+/// run the executor row at a time
+inline auto DumpRows(AbstractExecutor *exec) -> std::vector<std::string>
+{
+  std::vector<std::string> rows;
+  for (exec->Init(); !exec->IsEnd(); exec->Next()) {
+    rows.push_back(RowString(*exec->GetRecord()));
+  }
+  return rows;
+}
+
+/// run the executor chunk at a time
+inline auto DumpBatches(AbstractExecutor *exec) -> std::vector<std::string>
+{
+  std::vector<std::string> rows;
+  exec->Init();
+  while (auto chunk = exec->NextBatch()) {
+    for (size_t i = 0; i < chunk->GetSize(); ++i) {
+      rows.push_back(RowString(*chunk->GetRecord(i)));
+    }
+  }
+  return rows;
+}
+
+inline auto Sorted(std::vector<std::string> rows) -> std::vector<std::string>
+{
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_TEST_UTIL_H
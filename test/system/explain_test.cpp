@@ -0,0 +1,135 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor.h"
+#include "optimizer/optimizer.h"
+
+#include <functional>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// EXPLAIN ANALYZE optimizes the plan of the planner, runs it and shows the physical plan, see DoExplainPlan
+class ExplainTest : public ::testing::Test
+{
+protected:
+  using MakePlan = std::function<std::shared_ptr<AbstractPlan>()>;
+
+  void SetUp() override
+  {
+    db_->CreateTable("t",
+        RecordSchema({MakeField("id", TYPE_INT, 4),
+            MakeField("name", TYPE_STRING, 40),
+            MakeField("score", TYPE_FLOAT, 4)}),
+        NARY_MODEL);
+    db_->CreateTable(
+        "u", RecordSchema({MakeField("uid", TYPE_INT, 4), MakeField("pad", TYPE_STRING, 100)}), NARY_MODEL);
+    for (int i = 0; i < ROW_NUM; ++i) {
+      auto name = fmt::format("name{}", i);
+      InsertRow(db_->GetTable("t"),
+          {ValueFactory::CreateIntValue(i),
+              ValueFactory::CreateStringValue(name.c_str(), name.size()),
+              i % 7 == 0 ? ValueFactory::CreateNullValue(TYPE_FLOAT) : ValueFactory::CreateFloatValue(i * 0.5f)});
+    }
+    // few rows of t have a match, so the runtime filter drops most of them
+    for (int i = 0; i < ROW_NUM; i += 10) {
+      auto pad = fmt::format("pad{}", i);
+      InsertRow(db_->GetTable("u"),
+          {ValueFactory::CreateIntValue(i), ValueFactory::CreateStringValue(pad.c_str(), pad.size())});
+    }
+  }
+
+  auto T(size_t idx) -> RTField { return db_->GetTable("t")->GetSchema().GetFieldAt(idx); }
+
+  auto U(size_t idx) -> RTField { return db_->GetTable("u")->GetSchema().GetFieldAt(idx); }
+
+  /// SELECT fields FROM t WHERE id < max_id, the projection and filter as made by the planner
+  auto ProjectFilterScan(std::vector<RTField> fields, int max_id) -> std::shared_ptr<AbstractPlan>
+  {
+    ValueSptr    id = ValueFactory::CreateIntValue(max_id);
+    ConditionVec conds{Condition(OP_LT, T(0), id)};
+    return std::make_shared<ProjectPlan>(std::make_shared<FilterPlan>(std::make_shared<ScanPlan>("t"), conds), fields);
+  }
+
+  /**
+   * the physical plan shown by EXPLAIN ANALYZE, after checking that the number of records is that of the query and
+   * that the plan can be shown and run again
+   */
+  auto Analyze(const MakePlan &make_plan) -> std::string
+  {
+    auto expect = DumpRows(Executor::Translate(Optimizer::Optimize(make_plan(), db_.Get()), db_.Get()).get());
+
+    auto plan    = Optimizer::Optimize(make_plan(), db_.Get());
+    auto rec_num = Executor::Analyze(plan, db_.Get());
+    EXPECT_EQ(rec_num, expect.size());
+    auto plan_str = plan->ToString(0);
+    EXPECT_EQ(DumpRows(Executor::Translate(plan, db_.Get()).get()), expect);
+    EXPECT_EQ(plan->ToString(0).size(), plan_str.size());
+    return plan_str;
+  }
+
+  static constexpr int ROW_NUM = 3000;
+
+  TestDatabase db_{"explain_test"};
+};
+
+TEST_F(ExplainTest, Projection)
+{
+  auto plan_str = Analyze([this]() { return ProjectFilterScan({T(2), T(0)}, 1000); });
+  ASSERT_NE(plan_str.find("ProjectPlan"), std::string::npos) << plan_str;
+}
+
+TEST_F(ExplainTest, Sort)
+{
+  auto plan_str = Analyze([this]() {
+    ValueSptr    id = ValueFactory::CreateIntValue(1000);
+    ConditionVec conds{Condition(OP_LT, T(0), id)};
+    auto         filter     = std::make_shared<FilterPlan>(std::make_shared<ScanPlan>("t"), conds);
+    auto         key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{T(2)});
+    auto         sort       = std::make_shared<SortPlan>(filter, std::move(key_schema), std::vector<bool>{true});
+    return std::make_shared<ProjectPlan>(sort, std::vector<RTField>{T(2), T(0)});
+  });
+  ASSERT_NE(plan_str.find("SortPlan"), std::string::npos) << plan_str;
+}
+
+TEST_F(ExplainTest, HashJoin)
+{
+  // SELECT t.name, u.pad FROM t JOIN u ON t.id = u.uid ORDER BY t.id
+  auto plan_str = Analyze([this]() {
+    ConditionVec conds{Condition(OP_EQ, T(0), U(0))};
+    auto join = std::make_shared<JoinPlan>(
+        std::make_shared<ScanPlan>("t"), std::make_shared<ScanPlan>("u"), conds, INNER_JOIN, HASH);
+    auto key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{T(0)});
+    auto sort       = std::make_shared<SortPlan>(join, std::move(key_schema), std::vector<bool>{false});
+    return std::make_shared<ProjectPlan>(sort, std::vector<RTField>{T(1), U(1)});
+  });
+  ASSERT_NE(plan_str.find("strategy: HASH"), std::string::npos) << plan_str;
+  // the counters of the runtime filter are filled by the run
+  ASSERT_NE(plan_str.find(fmt::format("of {} rows dropped", ROW_NUM)), std::string::npos) << plan_str;
+}
+
+TEST_F(ExplainTest, NotAQuery)
+{
+  ASSERT_THROW(Executor::Analyze(std::make_shared<ShowTablesPlan>(), db_.Get()), WSDBException_);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
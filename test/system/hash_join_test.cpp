@@ -0,0 +1,122 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor_join_hash.h"
+#include "execution/executor_join_nestedloop.h"
+#include "execution/executor_seqscan.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class HashJoinTest : public ::testing::TestWithParam<JoinType>
+{
+protected:
+  void SetUp() override
+  {
+    // keys repeat on both sides, some keys have no match and some are null
+    db_->CreateTable("l", RecordSchema({MakeField("k", TYPE_INT, 4), MakeField("v", TYPE_STRING, 16)}), NARY_MODEL);
+    db_->CreateTable("r", RecordSchema({MakeField("k", TYPE_INT, 4), MakeField("w", TYPE_STRING, 64)}), NARY_MODEL);
+    for (int i = 0; i < 1500; ++i) {
+      auto v = fmt::format("l{}", i);
+      InsertRow(db_->GetTable("l"),
+          {i % 50 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(i % 700),
+              ValueFactory::CreateStringValue(v.c_str(), v.size())});
+    }
+    for (int i = 0; i < 3000; ++i) {
+      auto w = fmt::format("r{}", i);
+      InsertRow(db_->GetTable("r"),
+          {i % 97 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(i % 1000 + 200),
+              ValueFactory::CreateStringValue(w.c_str(), w.size())});
+    }
+  }
+
+  auto Key(const std::string &table) -> RTField { return db_->GetTable(table)->GetSchema().GetFieldAt(0); }
+
+  auto HashJoin(size_t buffer_size, const RuntimeFilterSptr &runtime_filter = nullptr)
+      -> std::unique_ptr<HashJoinExecutor>
+  {
+    return std::make_unique<HashJoinExecutor>(GetParam(),
+        std::make_unique<SeqScanExecutor>(db_->GetTable("l"), nullptr, ConditionVec{}, runtime_filter),
+        std::make_unique<SeqScanExecutor>(db_->GetTable("r")),
+        std::make_unique<RecordSchema>(std::vector<RTField>{Key("l")}),
+        std::make_unique<RecordSchema>(std::vector<RTField>{Key("r")}),
+        runtime_filter,
+        buffer_size);
+  }
+
+  TestDatabase db_{"hash_join_test"};
+};
+
+TEST_P(HashJoinTest, SpillMatchesInMemory)
+{
+  NestedLoopJoinExecutor nested_loop(GetParam(),
+      std::make_unique<SeqScanExecutor>(db_->GetTable("l")),
+      std::make_unique<SeqScanExecutor>(db_->GetTable("r")),
+      {Condition(OP_EQ, Key("l"), Key("r"))});
+  auto expect = Sorted(DumpRows(&nested_loop));
+  ASSERT_FALSE(expect.empty());
+
+  auto in_memory = HashJoin(HASH_JOIN_BUFFER_SIZE);
+  ASSERT_EQ(Sorted(DumpRows(in_memory.get())), expect);
+  ASSERT_EQ(Sorted(DumpBatches(in_memory.get())), expect);
+
+  // a build side of 3000 records in a few KB is partitioned, and its partitions are still too large and partitioned
+  // again. no tmp file should be left once the executors are gone
+  for (size_t buffer_size : {64 * 1024, 4 * 1024, 1}) {
+    SCOPED_TRACE(buffer_size);
+    auto spilled = HashJoin(buffer_size);
+    ASSERT_EQ(Sorted(DumpRows(spilled.get())), expect);
+    ASSERT_EQ(Sorted(DumpBatches(spilled.get())), expect);
+  }
+  for (const auto &entry : std::filesystem::directory_iterator(TMP_DIR)) {
+    ASSERT_EQ(entry.path().filename().string().rfind("hash_join_", 0), std::string::npos) << entry.path();
+  }
+}
+
+TEST_P(HashJoinTest, RuntimeFilterDropsRows)
+{
+  if (GetParam() != INNER_JOIN) {
+    GTEST_SKIP() << "outer joins keep all left rows, so they get no runtime filter";
+  }
+  auto expect = Sorted(DumpRows(HashJoin(HASH_JOIN_BUFFER_SIZE).get()));
+
+  // 490 of the 1500 left rows have a key below 200, which is not in the right table. the filter may let a few of them
+  // pass, but drops no other row
+  auto filter = std::make_shared<RuntimeFilter>(std::vector<RTField>{Key("l")});
+  auto join   = HashJoin(HASH_JOIN_BUFFER_SIZE, filter);
+  ASSERT_EQ(Sorted(DumpRows(join.get())), expect);
+  ASSERT_EQ(filter->GetCheckedNum(), 1500);
+  ASSERT_GT(filter->GetDroppedNum(), 400);
+  ASSERT_LE(filter->GetDroppedNum(), 490);
+  ASSERT_EQ(Sorted(DumpBatches(join.get())), expect);
+  ASSERT_EQ(filter->GetCheckedNum(), 3000);
+
+  // the filter is filled by the partitioned build side as well, sized for the 3000 build rows
+  auto spilled_filter = std::make_shared<RuntimeFilter>(std::vector<RTField>{Key("l")}, 3000);
+  auto spilled        = HashJoin(4 * 1024, spilled_filter);
+  ASSERT_EQ(Sorted(DumpRows(spilled.get())), expect);
+  ASSERT_GT(spilled_filter->GetDroppedNum(), 400);
+}
+
+INSTANTIATE_TEST_SUITE_P(JoinTypes, HashJoinTest, ::testing::Values(INNER_JOIN, OUTER_JOIN));
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
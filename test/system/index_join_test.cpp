@@ -0,0 +1,194 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor_join_idxnestedloop.h"
+#include "execution/executor_join_nestedloop.h"
+#include "execution/executor_seqscan.h"
+
+#include <map>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// an index kept in memory that supports lookups, the key of a record is the string of its values
+class MemoryIndex : public Index
+{
+public:
+  explicit MemoryIndex(RecordSchema *key_schema) : Index(nullptr, nullptr, IndexType::HASH, 0, key_schema) {}
+
+  void Insert(const Record &key, const RID &rid) override { rids_.emplace(RowString(key), rid); }
+
+  void Delete(const Record &key, const RID &rid) override
+  {
+    auto [begin, end] = rids_.equal_range(RowString(key));
+    for (auto it = begin; it != end; ++it) {
+      if (it->second == rid) {
+        rids_.erase(it);
+        return;
+      }
+    }
+  }
+
+  auto Lookup(const Record &key) -> std::vector<RID> override
+  {
+    lookup_num_++;
+    std::vector<RID> rids;
+    auto [begin, end] = rids_.equal_range(RowString(key));
+    for (auto it = begin; it != end; ++it) {
+      rids.push_back(it->second);
+    }
+    return rids;
+  }
+
+  [[nodiscard]] auto IsLookupSupported() const -> bool override { return true; }
+
+  [[nodiscard]] auto GetLookupNum() const -> size_t { return lookup_num_; }
+
+private:
+  std::multimap<std::string, RID> rids_;
+  size_t                          lookup_num_{0};
+};
+
+class IndexJoinTest : public ::testing::TestWithParam<JoinType>
+{
+protected:
+  void SetUp() override
+  {
+    // keys repeat on both sides, some keys have no match and some are null, k2 is a join key that is not indexed
+    db_->CreateTable("l",
+        RecordSchema({MakeField("k", TYPE_INT, 4), MakeField("k2", TYPE_INT, 4), MakeField("v", TYPE_STRING, 16)}),
+        NARY_MODEL);
+    db_->CreateTable("r",
+        RecordSchema({MakeField("k", TYPE_INT, 4), MakeField("k2", TYPE_INT, 4), MakeField("w", TYPE_STRING, 64)}),
+        NARY_MODEL);
+    for (int i = 0; i < 1500; ++i) {
+      auto v = fmt::format("l{}", i);
+      InsertRow(db_->GetTable("l"),
+          {i % 50 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(i % 700),
+              ValueFactory::CreateIntValue(i % 3),
+              ValueFactory::CreateStringValue(v.c_str(), v.size())});
+    }
+    for (int i = 0; i < 3000; ++i) {
+      auto w = fmt::format("r{}", i);
+      InsertRow(db_->GetTable("r"),
+          {i % 97 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(i % 1000 + 200),
+              ValueFactory::CreateIntValue(i % 2),
+              ValueFactory::CreateStringValue(w.c_str(), w.size())});
+    }
+    // index on r.k, filled from the records of r
+    auto key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{Field("r", 0)});
+    index_          = new MemoryIndex(key_schema.get());
+    SeqScanExecutor scan(db_->GetTable("r"));
+    for (scan.Init(); !scan.IsEnd(); scan.Next()) {
+      auto record = scan.GetRecord();
+      index_->Insert(Record(key_schema.get(), *record), record->GetRID());
+    }
+    auto tid      = db_->GetTable("r")->GetTableId();
+    index_handle_ = std::make_unique<IndexHandle>(nullptr, nullptr, tid, 0, index_, std::move(key_schema));
+  }
+
+  auto Field(const std::string &table, size_t idx) -> RTField
+  {
+    return db_->GetTable(table)->GetSchema().GetFieldAt(idx);
+  }
+
+  auto KeySchema(const std::string &table, size_t key_num) -> RecordSchemaUptr
+  {
+    std::vector<RTField> keys;
+    for (size_t i = 0; i < key_num; ++i) {
+      keys.push_back(Field(table, i));
+    }
+    return std::make_unique<RecordSchema>(keys);
+  }
+
+  /// join l and r on their first key_num fields
+  auto IndexJoin(size_t key_num) -> std::unique_ptr<IndexNestedLoopJoinExecutor>
+  {
+    return std::make_unique<IndexNestedLoopJoinExecutor>(GetParam(),
+        std::make_unique<SeqScanExecutor>(db_->GetTable("l")),
+        std::make_unique<SeqScanExecutor>(db_->GetTable("r")),
+        db_->GetTable("r"),
+        index_handle_.get(),
+        KeySchema("l", key_num),
+        KeySchema("r", key_num));
+  }
+
+  auto Expect(size_t key_num) -> std::vector<std::string>
+  {
+    ConditionVec conds;
+    for (size_t i = 0; i < key_num; ++i) {
+      conds.emplace_back(OP_EQ, Field("l", i), Field("r", i));
+    }
+    NestedLoopJoinExecutor nested_loop(GetParam(),
+        std::make_unique<SeqScanExecutor>(db_->GetTable("l")),
+        std::make_unique<SeqScanExecutor>(db_->GetTable("r")),
+        conds);
+    return Sorted(DumpRows(&nested_loop));
+  }
+
+  TestDatabase   db_{"index_join_test"};
+  MemoryIndex   *index_{nullptr};  // owned by index_handle_
+  IndexHandleUptr index_handle_;
+};
+
+TEST_P(IndexJoinTest, MatchesNestedLoop)
+{
+  auto expect = Expect(1);
+  // null keys join with null keys, those of the right side are not looked up but read by a scan
+  ASSERT_TRUE(std::any_of(expect.begin(), expect.end(), [](const std::string &row) {
+    return row.rfind("(null)|", 0) == 0 && row.find("|r") != std::string::npos;
+  }));
+  auto join = IndexJoin(1);
+  ASSERT_EQ(Sorted(DumpRows(join.get())), expect);
+  // each left record without a null key is looked up once
+  ASSERT_EQ(index_->GetLookupNum(), 1500 - 1500 / 50);
+  ASSERT_EQ(Sorted(DumpBatches(join.get())), expect);
+  ASSERT_EQ(Sorted(DumpRows(join.get())), expect);
+}
+
+TEST_P(IndexJoinTest, KeyFieldsNotInIndex)
+{
+  // the index is on k only, k2 is compared on the fetched records
+  auto expect = Expect(2);
+  ASSERT_LT(expect.size(), Expect(1).size());
+  auto join = IndexJoin(2);
+  ASSERT_EQ(Sorted(DumpRows(join.get())), expect);
+  ASSERT_EQ(Sorted(DumpBatches(join.get())), expect);
+}
+
+TEST_P(IndexJoinTest, KeepsLeftOrder)
+{
+  // the matches of each left record are returned in turn, unmatched records of an outer join in their place
+  auto join = IndexJoin(1);
+  int  last = -1;
+  for (join->Init(); !join->IsEnd(); join->Next()) {
+    auto v = join->GetRecord()->GetValueAt(2)->ToString();
+    int  id = std::stoi(v.substr(1));
+    ASSERT_GE(id, last);
+    last = id;
+  }
+  ASSERT_GT(last, 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(JoinTypes, IndexJoinTest, ::testing::Values(INNER_JOIN, OUTER_JOIN));
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,157 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor.h"
+#include "execution/executor_join_nestedloop.h"
+#include "execution/executor_projection.h"
+#include "execution/executor_seqscan.h"
+#include "execution/executor_sort.h"
+#include "optimizer/optimizer.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class LateMaterializationTest : public ::testing::TestWithParam<JoinType>
+{
+protected:
+  void SetUp() override
+  {
+    // the wide fields are fetched by rid after the join and the sort, some of them are null
+    db_->CreateTable("l",
+        RecordSchema({MakeField("id", TYPE_INT, 4), MakeField("k", TYPE_INT, 4), MakeField("lw", TYPE_STRING, 64)}),
+        NARY_MODEL);
+    db_->CreateTable("r",
+        RecordSchema({MakeField("id", TYPE_INT, 4), MakeField("k", TYPE_INT, 4), MakeField("rw", TYPE_STRING, 100)}),
+        NARY_MODEL);
+    for (int i = 0; i < 3000; ++i) {
+      auto lw = fmt::format("lw{}", i);
+      InsertRow(db_->GetTable("l"),
+          {ValueFactory::CreateIntValue(i),
+              ValueFactory::CreateIntValue(i % 900),
+              i % 5 == 0 ? ValueFactory::CreateNullValue(TYPE_STRING)
+                         : ValueFactory::CreateStringValue(lw.c_str(), lw.size())});
+    }
+    for (int i = 0; i < 2000; ++i) {
+      auto rw = fmt::format("rw{}", i);
+      InsertRow(db_->GetTable("r"),
+          {ValueFactory::CreateIntValue(i),
+              ValueFactory::CreateIntValue(i % 1200),
+              i % 7 == 0 ? ValueFactory::CreateNullValue(TYPE_STRING)
+                         : ValueFactory::CreateStringValue(rw.c_str(), rw.size())});
+    }
+  }
+
+  auto Field(const std::string &table, size_t idx) -> RTField
+  {
+    return db_->GetTable(table)->GetSchema().GetFieldAt(idx);
+  }
+
+  auto ProjFields() -> std::vector<RTField> { return {Field("l", 2), Field("r", 0), Field("r", 2), Field("l", 0)}; }
+
+  /// order by l.id desc, r.id, which is unique for each row of the join, so that the rids are read across the pages
+  auto SortKeys() -> RecordSchemaUptr
+  {
+    return std::make_unique<RecordSchema>(std::vector<RTField>{Field("l", 0), Field("r", 0)});
+  }
+
+  static auto SortDirections() -> std::vector<bool> { return {true, false}; }
+
+  /// SELECT l.lw, r.id, r.rw, l.id FROM l JOIN r ON l.k = r.k ORDER BY l.id DESC, r.id, optimized
+  auto Optimized(size_t limit) -> std::shared_ptr<AbstractPlan>
+  {
+    ConditionVec                  conds{Condition(OP_EQ, Field("l", 1), Field("r", 1))};
+    std::shared_ptr<AbstractPlan> plan = std::make_shared<JoinPlan>(
+        std::make_shared<ScanPlan>("l"), std::make_shared<ScanPlan>("r"), conds, GetParam(), HASH);
+    plan = std::make_shared<ProjectPlan>(std::make_shared<SortPlan>(plan, SortKeys(), SortDirections()), ProjFields());
+    if (limit != SIZE_MAX) {
+      plan = std::make_shared<LimitPlan>(plan, limit);
+    }
+    return Optimizer::Optimize(plan, db_.Get());
+  }
+
+  /// the same query run with all fields carried through the join and the sort
+  auto Expect(size_t limit) -> std::vector<std::string>
+  {
+    auto join = std::make_unique<NestedLoopJoinExecutor>(GetParam(),
+        std::make_unique<SeqScanExecutor>(db_->GetTable("l")),
+        std::make_unique<SeqScanExecutor>(db_->GetTable("r")),
+        ConditionVec{Condition(OP_EQ, Field("l", 1), Field("r", 1))});
+    auto sort = std::make_unique<SortExecutor>(std::move(join), SortKeys(), SortDirections());
+    ProjectionExecutor proj(std::move(sort), std::make_unique<RecordSchema>(ProjFields()));
+    auto               rows = DumpRows(&proj);
+    rows.resize(std::min(rows.size(), limit));
+    return rows;
+  }
+
+  static auto FieldNames(const std::vector<RTField> &fields) -> std::vector<std::string>
+  {
+    std::vector<std::string> names;
+    for (const auto &field : fields) {
+      names.push_back(field.field_.field_name_);
+    }
+    return names;
+  }
+
+  TestDatabase db_{"late_materialization_test"};
+};
+
+TEST_P(LateMaterializationTest, SortedJoin)
+{
+  auto plan  = Optimized(SIZE_MAX);
+  auto fetch = std::dynamic_pointer_cast<FetchPlan>(plan);
+  ASSERT_NE(fetch, nullptr) << plan->ToString(0);
+  ASSERT_EQ(fetch->table_names_, (std::vector<std::string>{"l", "r"}));
+  // the scans carry the rid of their records instead of the wide fields
+  auto sort = std::dynamic_pointer_cast<SortPlan>(fetch->child_);
+  ASSERT_NE(sort, nullptr) << plan->ToString(0);
+  auto join = std::dynamic_pointer_cast<JoinPlan>(sort->child_);
+  ASSERT_NE(join, nullptr) << plan->ToString(0);
+  auto left  = std::dynamic_pointer_cast<ScanPlan>(join->left_);
+  auto right = std::dynamic_pointer_cast<ScanPlan>(join->right_);
+  ASSERT_NE(left, nullptr) << plan->ToString(0);
+  ASSERT_NE(right, nullptr) << plan->ToString(0);
+  ASSERT_EQ(FieldNames(left->proj_fields_), (std::vector<std::string>{"id", "k", RID_FIELD_NAME}));
+  ASSERT_EQ(FieldNames(right->proj_fields_), (std::vector<std::string>{"id", "k", RID_FIELD_NAME}));
+
+  // more rows than a batch of the fetch, rows of the null side of an outer join have null rids
+  auto expect = Expect(SIZE_MAX);
+  ASSERT_GT(expect.size(), CHUNK_SIZE);
+  auto exec = Executor::Translate(plan, db_.Get());
+  ASSERT_EQ(DumpRows(exec.get()), expect);
+  ASSERT_EQ(DumpBatches(exec.get()), expect);
+}
+
+TEST_P(LateMaterializationTest, TopN)
+{
+  for (size_t limit : {1UL, 100UL, CHUNK_SIZE + 1}) {
+    SCOPED_TRACE(limit);
+    auto plan  = Optimized(limit);
+    auto fetch = std::dynamic_pointer_cast<FetchPlan>(plan);
+    ASSERT_NE(fetch, nullptr) << plan->ToString(0);
+    ASSERT_NE(std::dynamic_pointer_cast<TopNPlan>(fetch->child_), nullptr) << plan->ToString(0);
+    ASSERT_EQ(DumpRows(Executor::Translate(plan, db_.Get()).get()), Expect(limit));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(JoinTypes, LateMaterializationTest, ::testing::Values(INNER_JOIN, OUTER_JOIN));
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
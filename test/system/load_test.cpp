@@ -0,0 +1,254 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor_load.h"
+#include "execution/executor_seqscan.h"
+
+#include <fstream>
+#include <set>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+static void WriteFile(const std::string &path, const std::string &content)
+{
+  std::ofstream out(path, std::ios::trunc);
+  out << content;
+}
+
+static auto Load(DatabaseHandle *db, const std::string &path) -> int
+{
+  LoadDataExecutor load(db->GetTable("t"), db->GetIndexes("t"), path);
+  load.Next();
+  return std::stoi(load.GetRecord()->GetValueAt(0)->ToString());
+}
+
+static auto ScanRows(DatabaseHandle *db) -> std::vector<std::string>
+{
+  SeqScanExecutor scan(db->GetTable("t"));
+  return DumpRows(&scan);
+}
+
+/// an index of rids kept in memory, insertions fail once it holds max_size entries
+class RidIndex : public Index
+{
+public:
+  RidIndex(RecordSchema *key_schema, size_t max_size)
+      : Index(nullptr, nullptr, IndexType::HASH, 0, key_schema), max_size_(max_size)
+  {}
+
+  void Insert(const Record &key, const RID &rid) override
+  {
+    if (rids_.size() == max_size_) {
+      WSDB_THROW(WSDB_FILE_WRITE_ERROR, "index is full");
+    }
+    rids_.emplace(rid.PageID(), rid.SlotID());
+  }
+
+  void Delete(const Record &key, const RID &rid) override
+  {
+    if (fail_delete_) {
+      WSDB_THROW(WSDB_RECORD_MISS, "index is read only");
+    }
+    if (rids_.erase({rid.PageID(), rid.SlotID()}) == 0) {
+      WSDB_THROW(WSDB_RECORD_MISS, "rid is not in the index");
+    }
+  }
+
+  auto Lookup(const Record &key) -> std::vector<RID> override { return {}; }
+
+  [[nodiscard]] auto GetSize() const -> size_t { return rids_.size(); }
+
+  void FailDelete() { fail_delete_ = true; }
+
+private:
+  std::set<std::pair<page_id_t, slot_id_t>> rids_;
+  size_t                                    max_size_;
+  bool                                      fail_delete_{false};
+};
+
+class LoadTest : public ::testing::TestWithParam<StorageModel>
+{};
+
+TEST_P(LoadTest, GoodFile)
+{
+  TestDatabase db("load_test_good");
+  db->CreateTable("t",
+      RecordSchema({MakeField("id", TYPE_INT, 4),
+          MakeField("name", TYPE_STRING, 16),
+          MakeField("score", TYPE_FLOAT, 4)}),
+      GetParam());
+  // enough lines to fill several pages, with nulls, quoted fields and a crlf line break
+  std::string content;
+  for (int i = 0; i < 2000; ++i) {
+    content += i % 5 == 0 ? fmt::format("{},,\n", i) : fmt::format("{},\"n,\"\"{}\",{}.5\n", i, i, i);
+  }
+  content += "2000,\"\",-1\r\n";
+  WriteFile("load_test_good.csv", content);
+  ASSERT_EQ(Load(db.Get(), "load_test_good.csv"), 2001);
+  ASSERT_EQ(db->GetTable("t")->GetTableHeader().rec_num_, 2001);
+
+  auto rows = ScanRows(db.Get());
+  ASSERT_EQ(rows.size(), 2001);
+  auto                     schema = &db->GetTable("t")->GetSchema();
+  std::vector<std::string> expect;
+  for (int i = 0; i < 2000; ++i) {
+    auto                   name = fmt::format("n,\"{}", i);
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i),
+        ValueFactory::CreateStringValue(name.c_str(), name.size()),
+        ValueFactory::CreateFloatValue(static_cast<float>(i) + 0.5f)};
+    if (i % 5 == 0) {
+      values[1] = ValueFactory::CreateNullValue(TYPE_STRING);
+      values[2] = ValueFactory::CreateNullValue(TYPE_FLOAT);
+    }
+    expect.push_back(RowString(Record(schema, values, INVALID_RID)));
+  }
+  std::vector<ValueSptr> last{
+      ValueFactory::CreateIntValue(2000), ValueFactory::CreateStringValue("", 0), ValueFactory::CreateFloatValue(-1)};
+  expect.push_back(RowString(Record(schema, last, INVALID_RID)));
+  ASSERT_EQ(Sorted(rows), Sorted(expect));
+  std::filesystem::remove("load_test_good.csv");
+}
+
+TEST_P(LoadTest, MalformedLine)
+{
+  TestDatabase db("load_test_malformed");
+  db->CreateTable("t", RecordSchema({MakeField("id", TYPE_INT, 4), MakeField("name", TYPE_STRING, 16)}), GetParam());
+  WriteFile("load_test_ok.tsv", "1\ta\n2\t\n");
+  ASSERT_EQ(Load(db.Get(), "load_test_ok.tsv"), 2);
+  auto before     = ScanRows(db.Get());
+  auto page_num   = db->GetTable("t")->GetTableHeader().page_num_;
+  auto first_free = db->GetTable("t")->GetTableHeader().first_free_page_;
+
+  // the bad line comes after several full pages are written
+  std::string content;
+  for (int i = 0; i < 5000; ++i) {
+    content += fmt::format("{}\tx{}\n", i, i);
+  }
+  content += "5000\tnot\tthree\n";
+  WriteFile("load_test_bad.tsv", content);
+  ASSERT_THROW(Load(db.Get(), "load_test_bad.tsv"), WSDBException_);
+  ASSERT_EQ(db->GetTable("t")->GetTableHeader().page_num_, page_num);
+  ASSERT_EQ(db->GetTable("t")->GetTableHeader().first_free_page_, first_free);
+  ASSERT_EQ(db->GetTable("t")->GetTableHeader().rec_num_, 2);
+  ASSERT_EQ(ScanRows(db.Get()), before);
+
+  WriteFile("load_test_bad.tsv", "3\tc\nfour\td\n");
+  ASSERT_THROW(Load(db.Get(), "load_test_bad.tsv"), WSDBException_);
+  ASSERT_EQ(ScanRows(db.Get()), before);
+
+  // float values are cast to the int field only when they fit
+  for (const auto *id : {"1e20", "-3e9", "2147483648", "nan", "inf", "-inf"}) {
+    SCOPED_TRACE(id);
+    WriteFile("load_test_bad.tsv", fmt::format("3\tc\n{}\td\n", id));
+    ASSERT_THROW(Load(db.Get(), "load_test_bad.tsv"), WSDBException_);
+    ASSERT_EQ(ScanRows(db.Get()), before);
+  }
+
+  // the table is still usable after a failed load
+  ASSERT_EQ(Load(db.Get(), "load_test_ok.tsv"), 2);
+  ASSERT_EQ(ScanRows(db.Get()).size(), 4);
+  std::filesystem::remove("load_test_ok.tsv");
+  std::filesystem::remove("load_test_bad.tsv");
+}
+
+TEST_P(LoadTest, IndexFailure)
+{
+  TestDatabase db("load_test_index");
+  db->CreateTable("t", RecordSchema({MakeField("id", TYPE_INT, 4), MakeField("name", TYPE_STRING, 16)}), GetParam());
+  auto *tbl         = db->GetTable("t");
+  auto  make_handle = [tbl](size_t max_size, RidIndex *&index) {
+    auto key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{tbl->GetSchema().GetFieldAt(0)});
+    index           = new RidIndex(key_schema.get(), max_size);
+    return std::make_unique<IndexHandle>(nullptr, nullptr, tbl->GetTableId(), 0, index, std::move(key_schema));
+  };
+  std::string content;
+  for (int i = 0; i < 5000; ++i) {
+    content += fmt::format("{}\tx{}\n", i, i);
+  }
+  WriteFile("load_test_index.tsv", content);
+
+  // the second index fails after the records of several pages are in both indexes
+  RidIndex *first         = nullptr;
+  RidIndex *second        = nullptr;
+  auto      first_handle  = make_handle(SIZE_MAX, first);
+  auto      second_handle = make_handle(3000, second);
+  {
+    LoadDataExecutor load(tbl, {first_handle.get(), second_handle.get()}, "load_test_index.tsv");
+    ASSERT_THROW(load.Next(), WSDBException_);
+  }
+  ASSERT_EQ(first->GetSize(), 0);
+  ASSERT_EQ(second->GetSize(), 0);
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, 0);
+  ASSERT_TRUE(ScanRows(db.Get()).empty());
+
+  // a load that succeeds puts every record into every index
+  auto full_handle = make_handle(SIZE_MAX, second);
+  {
+    LoadDataExecutor load(tbl, {first_handle.get(), full_handle.get()}, "load_test_index.tsv");
+    load.Next();
+  }
+  ASSERT_EQ(first->GetSize(), 5000);
+  ASSERT_EQ(second->GetSize(), 5000);
+  ASSERT_EQ(ScanRows(db.Get()).size(), 5000);
+  std::filesystem::remove("load_test_index.tsv");
+}
+
+TEST_P(LoadTest, RollbackFailure)
+{
+  TestDatabase db("load_test_rollback");
+  db->CreateTable("t", RecordSchema({MakeField("id", TYPE_INT, 4), MakeField("name", TYPE_STRING, 16)}), GetParam());
+  auto *tbl         = db->GetTable("t");
+  auto  make_handle = [tbl](size_t max_size, RidIndex *&index) {
+    auto key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{tbl->GetSchema().GetFieldAt(0)});
+    index           = new RidIndex(key_schema.get(), max_size);
+    return std::make_unique<IndexHandle>(nullptr, nullptr, tbl->GetTableId(), 0, index, std::move(key_schema));
+  };
+  std::string content;
+  for (int i = 0; i < 5000; ++i) {
+    content += fmt::format("{}\tx{}\n", i, i);
+  }
+  WriteFile("load_test_rollback.tsv", content);
+
+  // the second index fails and the entries of the first cannot be removed, the error of the load is still the one
+  // reported and the pages are removed
+  RidIndex *first         = nullptr;
+  RidIndex *second        = nullptr;
+  auto      first_handle  = make_handle(SIZE_MAX, first);
+  auto      second_handle = make_handle(3000, second);
+  first->FailDelete();
+  LoadDataExecutor load(tbl, {first_handle.get(), second_handle.get()}, "load_test_rollback.tsv");
+  try {
+    load.Next();
+    FAIL() << "the load should fail";
+  } catch (WSDBException_ &e) {
+    ASSERT_EQ(e.type_, WSDB_FILE_WRITE_ERROR);
+  }
+  ASSERT_GT(first->GetSize(), 0);
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, 0);
+  ASSERT_TRUE(ScanRows(db.Get()).empty());
+  std::filesystem::remove("load_test_rollback.tsv");
+}
+
+INSTANTIATE_TEST_SUITE_P(StorageModels, LoadTest, ::testing::Values(NARY_MODEL, PAX_MODEL));
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,207 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor_join_nestedloop.h"
+#include "execution/executor_seqscan.h"
+#include "expr/condition_expr.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// pass the records of its child through and count how many times it is initialized
+class CountingExecutor : public AbstractExecutor
+{
+public:
+  explicit CountingExecutor(AbstractExecutorUptr child) : AbstractExecutor(Basic), child_(std::move(child)) {}
+
+  void Init() override
+  {
+    init_num_++;
+    child_->Init();
+    record_ = child_->GetRecord();
+  }
+
+  void Next() override
+  {
+    child_->Next();
+    record_ = child_->GetRecord();
+  }
+
+  [[nodiscard]] auto IsEnd() const -> bool override { return child_->IsEnd(); }
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override { return child_->GetOutSchema(); }
+
+  [[nodiscard]] auto GetInitNum() const -> size_t { return init_num_; }
+
+private:
+  AbstractExecutorUptr child_;
+  size_t               init_num_{0};
+};
+
+class NestedLoopJoinTest : public ::testing::TestWithParam<JoinType>
+{
+protected:
+  void SetUp() override
+  {
+    db_->CreateTable("l",
+        RecordSchema({MakeField("id", TYPE_INT, 4), MakeField("k", TYPE_INT, 4), MakeField("v", TYPE_STRING, 16)}),
+        NARY_MODEL);
+    auto right_schema = RecordSchema({MakeField("k", TYPE_INT, 4), MakeField("w", TYPE_STRING, 16)});
+    db_->CreateTable("r", right_schema, NARY_MODEL);
+    db_->CreateTable("empty", right_schema, NARY_MODEL);
+    // some keys are null, which match the null keys of the other side, the last left records have no match
+    for (int i = 0; i < LEFT_NUM; ++i) {
+      auto v = fmt::format("l{}", i);
+      auto k = i >= LEFT_NUM - 5 ? ValueFactory::CreateIntValue(5000 + i)
+               : i % 50 == 0     ? ValueFactory::CreateNullValue(TYPE_INT)
+                                 : ValueFactory::CreateIntValue(i % 400);
+      InsertRow(db_->GetTable("l"),
+          {ValueFactory::CreateIntValue(i), k, ValueFactory::CreateStringValue(v.c_str(), v.size())});
+    }
+    for (int i = 0; i < 600; ++i) {
+      auto w = fmt::format("r{}", i);
+      InsertRow(db_->GetTable("r"),
+          {i % 97 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(i % 500),
+              ValueFactory::CreateStringValue(w.c_str(), w.size())});
+    }
+  }
+
+  auto Conds(const std::string &right) -> ConditionVec
+  {
+    auto l_k = db_->GetTable("l")->GetSchema().GetFieldAt(1);
+    auto r_k = db_->GetTable(right)->GetSchema().GetFieldAt(0);
+    return {Condition(OP_EQ, l_k, r_k)};
+  }
+
+  auto Join(const std::string &right, size_t buffer_size) -> std::unique_ptr<NestedLoopJoinExecutor>
+  {
+    return std::make_unique<NestedLoopJoinExecutor>(GetParam(),
+        std::make_unique<SeqScanExecutor>(db_->GetTable("l")),
+        std::make_unique<SeqScanExecutor>(db_->GetTable(right)),
+        Conds(right),
+        buffer_size);
+  }
+
+  auto Records(const std::string &table) -> std::vector<RecordUptr>
+  {
+    std::vector<RecordUptr> records;
+    SeqScanExecutor         scan(db_->GetTable(table));
+    for (scan.Init(); !scan.IsEnd(); scan.Next()) {
+      records.push_back(scan.GetRecord());
+    }
+    return records;
+  }
+
+  /**
+   * the results in the documented order for blocks of block_rec_num left records: the matches in the order of the
+   * right input for each block, then the unmatched left records of the block for an outer join
+   */
+  auto Expect(const std::string &right, size_t block_rec_num) -> std::vector<std::string>
+  {
+    auto        left_recs  = Records("l");
+    auto        right_recs = Records(right);
+    auto        conds      = Conds(right);
+    auto        join       = Join(right, NESTED_LOOP_JOIN_BUFFER_SIZE);
+    const auto *out_schema = join->GetOutSchema();
+    Record      null_right(&db_->GetTable(right)->GetSchema());
+
+    std::vector<std::string> rows;
+    for (size_t begin = 0; begin < left_recs.size(); begin += block_rec_num) {
+      auto              end = std::min(left_recs.size(), begin + block_rec_num);
+      std::vector<bool> matched(end - begin, false);
+      for (const auto &right_rec : right_recs) {
+        for (auto i = begin; i < end; ++i) {
+          Record rec(out_schema, *left_recs[i], *right_rec);
+          if (ConditionExpr::Eval(conds, rec)) {
+            matched[i - begin] = true;
+            rows.push_back(RowString(rec));
+          }
+        }
+      }
+      for (auto i = begin; i < end && GetParam() == OUTER_JOIN; ++i) {
+        if (!matched[i - begin]) {
+          rows.push_back(RowString(Record(out_schema, *left_recs[i], null_right)));
+        }
+      }
+    }
+    return rows;
+  }
+
+  static constexpr int LEFT_NUM = 1000;
+
+  TestDatabase db_{"nested_loop_join_test"};
+};
+
+TEST_P(NestedLoopJoinTest, OneBlock)
+{
+  auto expect = Expect("r", LEFT_NUM);
+  auto join   = Join("r", NESTED_LOOP_JOIN_BUFFER_SIZE);
+  ASSERT_EQ(DumpRows(join.get()), expect);
+  ASSERT_EQ(DumpBatches(join.get()), expect);
+}
+
+TEST_P(NestedLoopJoinTest, BlockOfOneRecord)
+{
+  // each left record is a block, its matches come in turn and the left records without a match in their place
+  auto expect = Expect("r", 1);
+  auto join   = Join("r", 1);
+  ASSERT_EQ(DumpRows(join.get()), expect);
+  ASSERT_EQ(DumpBatches(join.get()), expect);
+}
+
+TEST_P(NestedLoopJoinTest, SeveralBlocks)
+{
+  // the left records without a match are in the last block
+  auto                   expect   = Sorted(Expect("r", LEFT_NUM));
+  auto                   counting = std::make_unique<CountingExecutor>(
+      std::make_unique<SeqScanExecutor>(db_->GetTable("r")));
+  auto                  *right    = counting.get();
+  NestedLoopJoinExecutor join(GetParam(),
+      std::make_unique<SeqScanExecutor>(db_->GetTable("l")),
+      std::move(counting),
+      Conds("r"),
+      8 * 1024);
+  ASSERT_EQ(Sorted(DumpRows(&join)), expect);
+  // the right input is rescanned once per block
+  auto block_num = right->GetInitNum();
+  ASSERT_GT(block_num, 2);
+  ASSERT_LT(block_num, LEFT_NUM);
+  ASSERT_EQ(Sorted(DumpBatches(&join)), expect);
+  ASSERT_EQ(right->GetInitNum(), 2 * block_num);
+}
+
+TEST_P(NestedLoopJoinTest, EmptyRight)
+{
+  // an inner join has no result, an outer join has all left records joined with nulls
+  for (size_t buffer_size : {size_t{1}, size_t{8 * 1024}, NESTED_LOOP_JOIN_BUFFER_SIZE}) {
+    SCOPED_TRACE(buffer_size);
+    auto expect = Expect("empty", LEFT_NUM);
+    ASSERT_EQ(expect.size(), GetParam() == OUTER_JOIN ? LEFT_NUM : 0);
+    auto join = Join("empty", buffer_size);
+    ASSERT_EQ(DumpRows(join.get()), expect);
+    ASSERT_EQ(DumpBatches(join.get()), expect);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(JoinTypes, NestedLoopJoinTest, ::testing::Values(INNER_JOIN, OUTER_JOIN));
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
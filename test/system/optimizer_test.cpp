@@ -0,0 +1,163 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor.h"
+#include "optimizer/optimizer.h"
+#include "system/scheduler.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// plans of queries with a LIMIT, which the planner puts above the projection of the query
+class OptimizerTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    db_->CreateTable("t",
+        RecordSchema({MakeField("id", TYPE_INT, 4),
+            MakeField("name", TYPE_STRING, 40),
+            MakeField("score", TYPE_FLOAT, 4)}),
+        NARY_MODEL);
+    db_->CreateTable(
+        "u", RecordSchema({MakeField("uid", TYPE_INT, 4), MakeField("pad", TYPE_STRING, 100)}), NARY_MODEL);
+    Fill(ROW_NUM);
+    for (int i = 0; i < ROW_NUM; i += 3) {
+      auto pad = fmt::format("pad{}", i);
+      InsertRow(db_->GetTable("u"),
+          {ValueFactory::CreateIntValue(i), ValueFactory::CreateStringValue(pad.c_str(), pad.size())});
+    }
+  }
+
+  /// append rows to t until it has row_num rows
+  void Fill(int row_num)
+  {
+    for (int i = static_cast<int>(db_->GetTable("t")->GetTableHeader().rec_num_); i < row_num; ++i) {
+      auto name = fmt::format("name{}", i);
+      InsertRow(db_->GetTable("t"),
+          {ValueFactory::CreateIntValue(i),
+              ValueFactory::CreateStringValue(name.c_str(), name.size()),
+              ValueFactory::CreateFloatValue(i * 0.5f)});
+    }
+  }
+
+  auto T(size_t idx) -> RTField { return db_->GetTable("t")->GetSchema().GetFieldAt(idx); }
+
+  auto U(size_t idx) -> RTField { return db_->GetTable("u")->GetSchema().GetFieldAt(idx); }
+
+  /// SELECT name FROM t WHERE id < 500 LIMIT limit
+  auto LimitFilterScan(size_t limit) -> std::shared_ptr<AbstractPlan>
+  {
+    ValueSptr    id = ValueFactory::CreateIntValue(500);
+    ConditionVec conds{Condition(OP_LT, T(0), id)};
+    auto         filter = std::make_shared<FilterPlan>(std::make_shared<ScanPlan>("t"), conds);
+    return std::make_shared<LimitPlan>(std::make_shared<ProjectPlan>(filter, std::vector<RTField>{T(1)}), limit);
+  }
+
+  static auto FieldNames(const std::vector<RTField> &fields) -> std::vector<std::string>
+  {
+    std::vector<std::string> names;
+    for (const auto &field : fields) {
+      names.push_back(field.field_.field_name_);
+    }
+    return names;
+  }
+
+  static constexpr int ROW_NUM = 1000;
+
+  TestDatabase db_{"optimizer_test"};
+};
+
+TEST_F(OptimizerTest, LimitFilterScan)
+{
+  auto plan = Optimizer::Optimize(LimitFilterScan(5), db_.Get());
+  auto lim  = std::dynamic_pointer_cast<LimitPlan>(plan);
+  ASSERT_NE(lim, nullptr) << plan->ToString(0);
+  ASSERT_EQ(lim->limit_, 5);
+  auto proj = std::dynamic_pointer_cast<ProjectPlan>(lim->child_);
+  ASSERT_NE(proj, nullptr) << plan->ToString(0);
+  auto filter = std::dynamic_pointer_cast<FilterPlan>(proj->child_);
+  ASSERT_NE(filter, nullptr) << plan->ToString(0);
+  auto scan = std::dynamic_pointer_cast<ScanPlan>(filter->child_);
+  ASSERT_NE(scan, nullptr) << plan->ToString(0);
+  // the projection is pushed down through the limit, the scan only materializes the fields of the query
+  ASSERT_EQ(FieldNames(scan->proj_fields_), (std::vector<std::string>{"id", "name"}));
+  ASSERT_EQ(DumpRows(Executor::Translate(plan, db_.Get()).get()).size(), 5);
+}
+
+TEST_F(OptimizerTest, LimitJoin)
+{
+  // SELECT t.name, u.pad FROM t JOIN u ON t.id = u.uid LIMIT 10
+  auto make_join = [this]() -> std::shared_ptr<AbstractPlan> {
+    ConditionVec conds{Condition(OP_EQ, T(0), U(0))};
+    auto         join = std::make_shared<JoinPlan>(
+        std::make_shared<ScanPlan>("t"), std::make_shared<ScanPlan>("u"), conds, INNER_JOIN, AUTO);
+    return std::make_shared<ProjectPlan>(join, std::vector<RTField>{T(1), U(1)});
+  };
+  auto plan = Optimizer::Optimize(std::make_shared<LimitPlan>(make_join(), 10), db_.Get());
+  auto lim  = std::dynamic_pointer_cast<LimitPlan>(plan);
+  ASSERT_NE(lim, nullptr) << plan->ToString(0);
+  // the wide fields are fetched by rid after the join
+  auto fetch = std::dynamic_pointer_cast<FetchPlan>(lim->child_);
+  ASSERT_NE(fetch, nullptr) << plan->ToString(0);
+  ASSERT_EQ(fetch->table_names_, (std::vector<std::string>{"t", "u"}));
+  auto join = std::dynamic_pointer_cast<JoinPlan>(fetch->child_);
+  ASSERT_NE(join, nullptr) << plan->ToString(0);
+  ASSERT_EQ(join->strategy_, HASH);
+  auto left  = std::dynamic_pointer_cast<ScanPlan>(join->left_);
+  auto right = std::dynamic_pointer_cast<ScanPlan>(join->right_);
+  ASSERT_NE(left, nullptr) << plan->ToString(0);
+  ASSERT_NE(right, nullptr) << plan->ToString(0);
+  ASSERT_EQ(FieldNames(left->proj_fields_), (std::vector<std::string>{"id", RID_FIELD_NAME}));
+  ASSERT_EQ(FieldNames(right->proj_fields_), (std::vector<std::string>{"uid", RID_FIELD_NAME}));
+  // the join publishes a runtime filter to the scan of its probe side
+  ASSERT_NE(join->runtime_filter_, nullptr);
+  ASSERT_EQ(left->runtime_filter_, join->runtime_filter_);
+
+  auto rows = DumpRows(Executor::Translate(plan, db_.Get()).get());
+  auto all  = Sorted(DumpRows(Executor::Translate(Optimizer::Optimize(make_join(), db_.Get()), db_.Get()).get()));
+  ASSERT_EQ(rows.size(), 10);
+  for (const auto &row : rows) {
+    ASSERT_TRUE(std::binary_search(all.begin(), all.end(), row)) << row;
+  }
+}
+
+TEST_F(OptimizerTest, LimitParallelScan)
+{
+  if (std::min(Scheduler::GetInstance()->GetWorkerNum(), PARALLEL_SCAN_WORKER_NUM) < 2) {
+    GTEST_SKIP() << "a parallel scan needs two workers";
+  }
+  // more pages than two morsels
+  while (db_->GetTable("t")->GetTableHeader().page_num_ <= 2 * PARALLEL_SCAN_MORSEL_SIZE) {
+    Fill(static_cast<int>(db_->GetTable("t")->GetTableHeader().rec_num_) + ROW_NUM);
+  }
+  auto plan = Optimizer::Optimize(LimitFilterScan(5), db_.Get());
+  auto lim  = std::dynamic_pointer_cast<LimitPlan>(plan);
+  ASSERT_NE(lim, nullptr) << plan->ToString(0);
+  auto par_scan = std::dynamic_pointer_cast<ParallelScanPlan>(lim->child_);
+  ASSERT_NE(par_scan, nullptr) << plan->ToString(0);
+  ASSERT_EQ(par_scan->conds_.size(), 1);
+  ASSERT_EQ(FieldNames(par_scan->out_fields_), (std::vector<std::string>{"name"}));
+  ASSERT_EQ(DumpRows(Executor::Translate(plan, db_.Get()).get()).size(), 5);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
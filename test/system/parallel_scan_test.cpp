@@ -0,0 +1,215 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor_filter.h"
+#include "execution/executor_parallel_scan.h"
+#include "execution/executor_projection.h"
+#include "execution/executor_seqscan.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// the parallel scan returns the records of the serial pipeline in the same order, for each worker number
+class ParallelScanTest : public ::testing::TestWithParam<std::tuple<StorageModel, size_t>>
+{
+protected:
+  void SetUp() override
+  {
+    // pad is not materialized, name and score are null in some records
+    auto schema = RecordSchema({MakeField("id", TYPE_INT, 4),
+        MakeField("name", TYPE_STRING, 120),
+        MakeField("score", TYPE_FLOAT, 4),
+        MakeField("pad", TYPE_STRING, 100)});
+    db_->CreateTable("big", schema, std::get<0>(GetParam()));
+    db_->CreateTable("small", schema, std::get<0>(GetParam()));
+    db_->CreateTable("empty", schema, std::get<0>(GetParam()));
+    // more than three morsels and a part of one
+    auto *big = db_->GetTable("big");
+    for (int i = 0; big->GetTableHeader().page_num_ <= 3 * PARALLEL_SCAN_MORSEL_SIZE + PARALLEL_SCAN_MORSEL_SIZE / 2;
+         ++i) {
+      Insert(big, i);
+    }
+    // less than a page
+    for (int i = 0; i < 10; ++i) {
+      Insert(db_->GetTable("small"), i);
+    }
+  }
+
+  static void Insert(TableHandle *table, int id)
+  {
+    auto name = fmt::format("name{}", id);
+    InsertRow(table,
+        {ValueFactory::CreateIntValue(id),
+            id % 11 == 0 ? ValueFactory::CreateNullValue(TYPE_STRING)
+                         : ValueFactory::CreateStringValue(name.c_str(), name.size()),
+            id % 13 == 0 ? ValueFactory::CreateNullValue(TYPE_FLOAT) : ValueFactory::CreateFloatValue(id * 0.5f),
+            ValueFactory::CreateStringValue("pad", 3)});
+  }
+
+  auto Field(const std::string &table, size_t idx) -> RTField
+  {
+    return db_->GetTable(table)->GetSchema().GetFieldAt(idx);
+  }
+
+  /// materialize id, name and score
+  auto ProjSchema(const std::string &table) -> RecordSchemaUptr
+  {
+    return std::make_unique<RecordSchema>(std::vector<RTField>{Field(table, 0), Field(table, 1), Field(table, 2)});
+  }
+
+  /// output name and id
+  auto OutSchema(const std::string &table) -> RecordSchemaUptr
+  {
+    return std::make_unique<RecordSchema>(std::vector<RTField>{Field(table, 1), Field(table, 0)});
+  }
+
+  /// id >= 5 AND score < 2000, the score of some records is null
+  auto Conds(const std::string &table) -> ConditionVec
+  {
+    ValueSptr id    = ValueFactory::CreateIntValue(5);
+    ValueSptr score = ValueFactory::CreateFloatValue(2000.0f);
+    return {Condition(OP_GE, Field(table, 0), id), Condition(OP_LT, Field(table, 2), score)};
+  }
+
+  /// a runtime filter published with the ids that are multiples of 3
+  auto PublishedFilter(const std::string &table) -> RuntimeFilterSptr
+  {
+    auto              rec_num = db_->GetTable(table)->GetTableHeader().rec_num_;
+    auto              filter  = std::make_shared<RuntimeFilter>(std::vector<RTField>{Field(table, 0)}, rec_num / 3 + 1);
+    RecordSchema      key_schema(std::vector<RTField>{Field(table, 0)});
+    SortKeyEncoder    encoder(&key_schema, &key_schema);
+    std::vector<char> key(encoder.GetKeySize());
+    auto              bloom_filter = filter->MakeBloomFilter();
+    for (int i = 0; i < static_cast<int>(rec_num); i += 3) {
+      encoder.Encode(Record(&key_schema, {ValueFactory::CreateIntValue(i)}, INVALID_RID), key.data());
+      bloom_filter->Insert(RuntimeFilter::Hash(key.data(), key.size()));
+    }
+    filter->Publish(encoder, std::move(bloom_filter));
+    return filter;
+  }
+
+  /// scan, filter and projection run one after another
+  auto Serial(const std::string &table, bool filter, bool project, const RuntimeFilterSptr &runtime_filter = nullptr)
+      -> std::vector<std::string>
+  {
+    AbstractExecutorUptr exec = std::make_unique<SeqScanExecutor>(
+        db_->GetTable(table), project ? ProjSchema(table) : nullptr, ConditionVec{}, runtime_filter);
+    if (filter) {
+      exec = std::make_unique<FilterExecutor>(std::move(exec), Conds(table));
+    }
+    if (project) {
+      exec = std::make_unique<ProjectionExecutor>(std::move(exec), OutSchema(table));
+    }
+    return DumpRows(exec.get());
+  }
+
+  auto Parallel(const std::string &table, bool filter, bool project, const RuntimeFilterSptr &runtime_filter = nullptr)
+      -> std::unique_ptr<ParallelScanExecutor>
+  {
+    auto conds = filter ? Conds(table) : ConditionVec{};
+    return std::make_unique<ParallelScanExecutor>(db_->GetTable(table),
+        project ? ProjSchema(table) : nullptr,
+        conds,
+        conds,
+        project ? OutSchema(table) : nullptr,
+        std::get<1>(GetParam()),
+        runtime_filter);
+  }
+
+  /// the records of the parallel scan by rows and by chunks, in the order of the serial pipeline
+  void Check(const std::string &table, bool filter, bool project)
+  {
+    auto expect = Serial(table, filter, project);
+    auto exec   = Parallel(table, filter, project);
+    ASSERT_EQ(DumpRows(exec.get()), expect);
+    ASSERT_EQ(DumpBatches(exec.get()), expect);
+  }
+
+  TestDatabase db_{"parallel_scan_test"};
+};
+
+TEST_P(ParallelScanTest, MatchesSerialScan)
+{
+  for (bool filter : {false, true}) {
+    for (bool project : {false, true}) {
+      SCOPED_TRACE(fmt::format("filter: {}, project: {}", filter, project));
+      Check("big", filter, project);
+    }
+  }
+  ASSERT_GT(Serial("big", true, true).size(), CHUNK_SIZE);
+}
+
+TEST_P(ParallelScanTest, SmallTables)
+{
+  for (const auto *table : {"small", "empty"}) {
+    SCOPED_TRACE(table);
+    Check(table, false, false);
+    Check(table, true, true);
+  }
+  ASSERT_EQ(Serial("empty", false, false).size(), 0);
+}
+
+TEST_P(ParallelScanTest, RuntimeFilter)
+{
+  // the filter drops rows before the conditions are checked, false positives are the same for both scans
+  auto filter = PublishedFilter("big");
+  auto expect = Serial("big", true, true, filter);
+  ASSERT_LT(expect.size(), Serial("big", true, true).size());
+  auto dropped = filter->GetDroppedNum();
+  ASSERT_GT(dropped, 0);
+  auto exec = Parallel("big", true, true, filter);
+  ASSERT_EQ(DumpRows(exec.get()), expect);
+  ASSERT_EQ(filter->GetDroppedNum(), 2 * dropped);
+  ASSERT_EQ(DumpBatches(exec.get()), expect);
+
+  // a filter that is not published yet lets all rows pass
+  auto empty_filter = std::make_shared<RuntimeFilter>(std::vector<RTField>{Field("big", 0)});
+  ASSERT_EQ(DumpRows(Parallel("big", true, true, empty_filter).get()), Serial("big", true, true));
+}
+
+TEST_P(ParallelScanTest, RowsThenBatches)
+{
+  // rows read one at a time are not returned again by the chunks that follow
+  auto expect = Serial("big", true, true);
+  auto exec   = Parallel("big", true, true);
+  exec->Init();
+  std::vector<std::string> rows;
+  for (int i = 0; i < 100 && !exec->IsEnd(); ++i, exec->Next()) {
+    rows.push_back(RowString(*exec->GetRecord()));
+  }
+  while (auto chunk = exec->NextBatch()) {
+    for (size_t i = 0; i < chunk->GetSize(); ++i) {
+      rows.push_back(RowString(*chunk->GetRecord(i)));
+    }
+  }
+  ASSERT_EQ(rows, expect);
+
+  // the workers are stopped if the scan is not read to the end
+  exec->Init();
+  ASSERT_FALSE(exec->IsEnd());
+  exec.reset();
+}
+
+INSTANTIATE_TEST_SUITE_P(StorageModels, ParallelScanTest,
+    ::testing::Combine(::testing::Values(NARY_MODEL, PAX_MODEL), ::testing::Values(1, 2, 4)));
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
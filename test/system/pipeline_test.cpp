@@ -0,0 +1,122 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor.h"
+#include "execution/executor_pipeline.h"
+
+#include <functional>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class PipelineTest : public ::testing::Test
+{
+protected:
+  using MakePlan = std::function<std::shared_ptr<AbstractPlan>()>;
+
+  void SetUp() override
+  {
+    db_->CreateTable("t",
+        RecordSchema({MakeField("id", TYPE_INT, 4),
+            MakeField("name", TYPE_STRING, 40),
+            MakeField("score", TYPE_FLOAT, 4)}),
+        NARY_MODEL);
+    for (int i = 0; i < ROW_NUM; ++i) {
+      auto name = fmt::format("name{}", i);
+      InsertRow(db_->GetTable("t"),
+          {ValueFactory::CreateIntValue(i),
+              ValueFactory::CreateStringValue(name.c_str(), name.size()),
+              i % 7 == 0 ? ValueFactory::CreateNullValue(TYPE_FLOAT) : ValueFactory::CreateFloatValue(i * 0.5f)});
+    }
+  }
+
+  auto Field(size_t idx) -> RTField { return db_->GetTable("t")->GetSchema().GetFieldAt(idx); }
+
+  /// id < max_id AND score > 10, rows with a null score do not pass
+  auto FilterScan(int max_id) -> std::shared_ptr<AbstractPlan>
+  {
+    ValueSptr    id    = ValueFactory::CreateIntValue(max_id);
+    ValueSptr    score = ValueFactory::CreateFloatValue(10.0f);
+    ConditionVec conds{Condition(OP_LT, Field(0), id), Condition(OP_GT, Field(2), score)};
+    return std::make_shared<FilterPlan>(std::make_shared<ScanPlan>("t"), conds);
+  }
+
+  auto Project(std::shared_ptr<AbstractPlan> child) -> std::shared_ptr<AbstractPlan>
+  {
+    return std::make_shared<ProjectPlan>(std::move(child), std::vector<RTField>{Field(2), Field(0)});
+  }
+
+  /// the pipeline returns the records of the executors, row at a time, chunk at a time and when run again
+  void Check(const MakePlan &make_plan)
+  {
+    auto volcano = Executor::Translate(make_plan(), db_.Get());
+    auto expect  = DumpRows(volcano.get());
+
+    auto rows     = std::make_unique<RowBuffer>();
+    auto pipeline = Pipeline::CompileToBuffer(make_plan(), db_.Get(), rows.get());
+    ASSERT_NE(pipeline, nullptr);
+    PipelineExecutor exec(std::move(pipeline), std::move(rows));
+    ASSERT_EQ(DumpRows(&exec), expect);
+    ASSERT_EQ(DumpBatches(&exec), expect);
+    ASSERT_EQ(DumpRows(&exec), expect);
+  }
+
+  // more rows than a chunk, so that chunks span the pages of the table
+  static constexpr int ROW_NUM = 3 * CHUNK_SIZE;
+
+  TestDatabase db_{"pipeline_test"};
+};
+
+TEST_F(PipelineTest, Filter) { Check([this]() { return FilterScan(ROW_NUM - 100); }); }
+
+TEST_F(PipelineTest, ProjectFilter) { Check([this]() { return Project(FilterScan(ROW_NUM - 100)); }); }
+
+TEST_F(PipelineTest, ProjectScanFields)
+{
+  Check([this]() {
+    auto scan          = std::make_shared<ScanPlan>("t");
+    scan->proj_fields_ = {Field(0), Field(2)};
+    return Project(scan);
+  });
+}
+
+TEST_F(PipelineTest, Limit)
+{
+  for (size_t limit : {0UL, 17UL, CHUNK_SIZE + 1, static_cast<size_t>(ROW_NUM) * 2}) {
+    SCOPED_TRACE(limit);
+    Check([this, limit]() { return std::make_shared<LimitPlan>(Project(FilterScan(ROW_NUM - 100)), limit); });
+  }
+}
+
+TEST_F(PipelineTest, NoRows) { Check([this]() { return Project(FilterScan(0)); }); }
+
+TEST_F(PipelineTest, ExecutorSource)
+{
+  // the sort is a pipeline breaker, the projection above it is pushed the sorted records
+  Check([this]() {
+    auto key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{Field(2)});
+    return Project(
+        std::make_shared<SortPlan>(FilterScan(ROW_NUM - 100), std::move(key_schema), std::vector<bool>{true}));
+  });
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,229 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "system/scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+// sum 0..n-1 by splitting the range in halves, every split is a task of the group
+static void SplitSum(TaskGroup &group, int64_t begin, int64_t end, std::atomic<int64_t> &sum)
+{
+  if (end - begin <= 16) {
+    int64_t local = 0;
+    for (auto i = begin; i < end; ++i) {
+      local += i;
+    }
+    sum += local;
+    return;
+  }
+  auto mid = begin + (end - begin) / 2;
+  group.Run([&group, begin, mid, &sum]() { SplitSum(group, begin, mid, sum); });
+  SplitSum(group, mid, end, sum);
+}
+
+TEST(SchedulerTest, Stress)
+{
+  Scheduler                scheduler(4);
+  std::vector<std::thread> clients;
+  std::atomic<int>         failures(0);
+  for (int c = 0; c < 8; ++c) {
+    clients.emplace_back([&scheduler, &failures, c]() {
+      Scheduler::SetClient(c);
+      for (int round = 0; round < 50; ++round) {
+        // flat tasks
+        std::atomic<int> cnt(0);
+        TaskGroup        flat(&scheduler);
+        for (int i = 0; i < 200; ++i) {
+          flat.Run([&cnt]() { cnt++; });
+        }
+        flat.Wait();
+        failures += cnt != 200;
+        // nested tasks, which are pushed to the deques of workers and stolen by the others
+        std::atomic<int64_t> sum(0);
+        TaskGroup            nested(&scheduler);
+        int64_t              n = 10000 + round;
+        nested.Run([&nested, n, &sum]() { SplitSum(nested, 0, n, sum); });
+        nested.Wait();
+        failures += sum != n * (n - 1) / 2;
+      }
+    });
+  }
+  for (auto &client : clients) {
+    client.join();
+  }
+  EXPECT_EQ(failures, 0);
+}
+
+TEST(SchedulerTest, Exception)
+{
+  Scheduler        scheduler(4);
+  TaskGroup        group(&scheduler);
+  std::atomic<int> cnt(0);
+  group.Run([]() { throw std::runtime_error("task failed"); });
+  for (int i = 0; i < 1000; ++i) {
+    group.Run([&cnt]() {
+      std::this_thread::sleep_for(std::chrono::microseconds(10));
+      cnt++;
+    });
+  }
+  EXPECT_THROW(group.Wait(), std::runtime_error);
+  // the group is cancelled by the error, tasks that have not started are skipped
+  EXPECT_TRUE(group.IsCancelled());
+  EXPECT_LE(cnt, 1000);
+  // the error is reported once
+  EXPECT_NO_THROW(group.Wait());
+}
+
+TEST(SchedulerTest, ResetAfterError)
+{
+  // an executor initialized again after a failed run, which may have thrown before waiting for its tasks
+  Scheduler        scheduler(2);
+  TaskGroup        group(&scheduler);
+  std::atomic<int> cnt(0);
+  group.Run([]() { throw std::runtime_error("task failed"); });
+  for (int i = 0; i < 100; ++i) {
+    group.Run([&cnt]() { cnt++; });
+  }
+  group.Reset();
+  EXPECT_FALSE(group.IsCancelled());
+  cnt = 0;
+  for (int i = 0; i < 100; ++i) {
+    group.Run([&cnt]() { cnt++; });
+  }
+  EXPECT_NO_THROW(group.Wait());
+  EXPECT_FALSE(group.IsCancelled());
+  EXPECT_EQ(cnt, 100);
+}
+
+TEST(SchedulerTest, CancelClient)
+{
+  Scheduler        scheduler(2);
+  std::atomic<int> started(0);
+  std::atomic<int> stopped(0);
+  std::thread      client([&]() {
+    Scheduler::SetClient(7);
+    TaskGroup group(&scheduler);
+    for (int i = 0; i < 100; ++i) {
+      group.Run([&]() {
+        started++;
+        while (!group.IsCancelled()) {
+          std::this_thread::yield();
+        }
+        stopped++;
+      });
+    }
+    group.Wait();
+  });
+  while (started == 0) {
+    std::this_thread::yield();
+  }
+  // groups of other clients are not affected
+  scheduler.Cancel(8);
+  EXPECT_EQ(stopped, 0);
+  scheduler.Cancel(7);
+  client.join();
+  EXPECT_EQ(started, stopped);
+  EXPECT_LT(started, 100);
+}
+
+TEST(SchedulerTest, CancelHandler)
+{
+  // an owner waiting for its tasks on a condition variable of its own is woken up by the cancellation
+  Scheduler               scheduler(2);
+  std::mutex              latch;
+  std::condition_variable cv;
+  bool                    waiting = false;
+  std::thread             client([&]() {
+    Scheduler::SetClient(7);
+    TaskGroup group(&scheduler);
+    group.SetCancelHandler([&]() {
+      std::lock_guard lock(latch);
+      cv.notify_all();
+    });
+    std::unique_lock lock(latch);
+    waiting = true;
+    cv.wait(lock, [&]() { return group.IsCancelled(); });
+  });
+  while (true) {
+    std::lock_guard lock(latch);
+    if (waiting) {
+      break;
+    }
+  }
+  scheduler.Cancel(7);
+  client.join();
+}
+
+TEST(SchedulerTest, Overhead)
+{
+  auto      worker_num = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  Scheduler scheduler(worker_num);
+  auto      ns         = [](auto begin, auto end) {
+    return std::chrono::duration<double, std::nano>(end - begin).count();
+  };
+  // empty tasks, so the time is all spent on scheduling
+  const int        task_num = 1000000;
+  std::atomic<int> cnt(0);
+  auto             begin = std::chrono::steady_clock::now();
+  {
+    TaskGroup group(&scheduler);
+    for (int i = 0; i < task_num; ++i) {
+      group.Run([&cnt]() { cnt++; });
+    }
+    group.Wait();
+  }
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_EQ(cnt, task_num);
+  std::cout << worker_num << " workers, submit and run: " << ns(begin, end) / task_num << " ns/task" << std::endl;
+
+  // tasks made by tasks stay in the deque of their worker unless stolen
+  std::atomic<int64_t> sum(0);
+  const int64_t        n = 1 << 22;
+  begin                  = std::chrono::steady_clock::now();
+  {
+    TaskGroup group(&scheduler);
+    group.Run([&group, n, &sum]() { SplitSum(group, 0, n, sum); });
+    group.Wait();
+  }
+  end = std::chrono::steady_clock::now();
+  EXPECT_EQ(sum, n * (n - 1) / 2);
+  std::cout << worker_num << " workers, nested split: " << ns(begin, end) / (n / 16) << " ns/task" << std::endl;
+
+  // compared with a thread per task
+  begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < 1000; ++i) {
+    std::thread([&cnt]() { cnt++; }).join();
+  }
+  end = std::chrono::steady_clock::now();
+  std::cout << "thread per task: " << ns(begin, end) / 1000 << " ns/task" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
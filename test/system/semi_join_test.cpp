@@ -0,0 +1,132 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor_join_semi.h"
+#include "execution/executor_seqscan.h"
+#include "execution/executor_values.h"
+
+#include <optional>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class SemiJoinTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    db_->CreateTable("t", RecordSchema({MakeField("k", TYPE_INT, 4), MakeField("id", TYPE_INT, 4)}), NARY_MODEL);
+    for (int i = 0; i < ROW_NUM; ++i) {
+      auto k = i % 10 == 0 ? std::nullopt : std::optional<int>(i % 20);
+      InsertRow(db_->GetTable("t"),
+          {k ? ValueFactory::CreateIntValue(*k) : ValueFactory::CreateNullValue(TYPE_INT),
+              ValueFactory::CreateIntValue(i)});
+      keys_.push_back(k);
+    }
+  }
+
+  /// t IN (or NOT IN) the list, which is a single column of type
+  auto Join(const std::vector<std::optional<float>> &list, FieldType type, bool is_anti)
+      -> std::unique_ptr<SemiJoinExecutor>
+  {
+    std::vector<std::vector<ValueSptr>> rows;
+    for (const auto &value : list) {
+      if (!value) {
+        rows.push_back({ValueFactory::CreateNullValue(type)});
+      } else if (type == TYPE_INT) {
+        rows.push_back({ValueFactory::CreateIntValue(static_cast<int>(*value))});
+      } else {
+        rows.push_back({ValueFactory::CreateFloatValue(*value)});
+      }
+    }
+    auto schema = std::make_unique<RecordSchema>(std::vector<RTField>{MakeField("v", type, 4)});
+    return std::make_unique<SemiJoinExecutor>(std::make_unique<SeqScanExecutor>(db_->GetTable("t")),
+        std::make_unique<ValuesExecutor>(std::move(schema), rows),
+        db_->GetTable("t")->GetSchema().GetFieldAt(0),
+        is_anti);
+  }
+
+  /**
+   * rows of t whose key is IN the list, where a null is IN a list with a null, or NOT IN the list, where a row passes
+   * if the list is empty, otherwise only if its key is not null, the list has no null and the key is not in the list
+   */
+  auto Expect(const std::vector<std::optional<float>> &list, bool is_anti) -> std::vector<std::string>
+  {
+    bool list_has_null = std::find(list.begin(), list.end(), std::nullopt) != list.end();
+    std::vector<std::string> expect;
+    for (int i = 0; i < ROW_NUM; ++i) {
+      const auto &k     = keys_[i];
+      bool        is_in = std::any_of(list.begin(), list.end(), [&k](const std::optional<float> &value) {
+        return k ? value && static_cast<float>(*k) == *value : !value;
+      });
+      bool pass = !is_anti ? is_in : list.empty() || (k && !list_has_null && !is_in);
+      if (pass) {
+        std::vector<ValueSptr> values{
+            k ? ValueFactory::CreateIntValue(*k) : ValueFactory::CreateNullValue(TYPE_INT),
+            ValueFactory::CreateIntValue(i)};
+        expect.push_back(RowString(Record(&db_->GetTable("t")->GetSchema(), values, INVALID_RID)));
+      }
+    }
+    return expect;
+  }
+
+  static constexpr int ROW_NUM = 3000;
+
+  TestDatabase                    db_{"semi_join_test"};
+  std::vector<std::optional<int>> keys_;
+};
+
+TEST_F(SemiJoinTest, NullAware)
+{
+  std::vector<std::vector<std::optional<float>>> lists{
+      {1, 3, 5, 100}, {2, 4, std::nullopt}, {std::nullopt}, {}, {7, 7, 8}};
+  for (const auto &list : lists) {
+    for (bool is_anti : {false, true}) {
+      SCOPED_TRACE(fmt::format("list of {} values, anti {}", list.size(), is_anti));
+      auto expect = Expect(list, is_anti);
+      auto join   = Join(list, TYPE_INT, is_anti);
+      ASSERT_EQ(DumpRows(join.get()), expect);
+      ASSERT_EQ(DumpBatches(join.get()), expect);
+    }
+  }
+  // a NOT IN list with a null rejects every row, an empty one keeps every row
+  ASSERT_TRUE(Expect({2, 4, std::nullopt}, true).empty());
+  ASSERT_EQ(Expect({}, true).size(), ROW_NUM);
+}
+
+TEST_F(SemiJoinTest, IntKeyInFloatList)
+{
+  // int keys are compared with float values as floats, 3.5 matches no key
+  std::vector<std::vector<std::optional<float>>> lists{{2, 3.5f, 19}, {2, 3.5f, std::nullopt}};
+  for (const auto &list : lists) {
+    for (bool is_anti : {false, true}) {
+      SCOPED_TRACE(fmt::format("list of {} values, anti {}", list.size(), is_anti));
+      auto expect = Expect(list, is_anti);
+      auto join   = Join(list, TYPE_FLOAT, is_anti);
+      ASSERT_EQ(DumpRows(join.get()), expect);
+      ASSERT_EQ(DumpBatches(join.get()), expect);
+    }
+  }
+  ASSERT_FALSE(Expect({2, 3.5f, 19}, false).empty());
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
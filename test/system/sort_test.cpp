@@ -0,0 +1,222 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "executor_test_util.h"
+#include "execution/executor.h"
+#include "execution/executor_limit.h"
+#include "execution/executor_seqscan.h"
+#include "execution/executor_sort.h"
+#include "execution/executor_sort_parallel.h"
+#include "execution/executor_topn.h"
+
+#include <optional>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class SortTest : public ::testing::Test
+{
+protected:
+  struct Row
+  {
+    std::optional<int>   a_;
+    std::optional<float> b_;
+    int                  id_;
+  };
+
+  void SetUp() override
+  {
+    db_->CreateTable("t",
+        RecordSchema({MakeField("a", TYPE_INT, 4), MakeField("b", TYPE_FLOAT, 4), MakeField("id", TYPE_INT, 4)}),
+        NARY_MODEL);
+    // few distinct keys, so that most records tie with records of other runs
+    for (int i = 0; i < ROW_NUM; ++i) {
+      Row row{i % 53 == 0 ? std::nullopt : std::optional<int>(i % 37 - 18),
+          i % 41 == 0 ? std::nullopt : std::optional<float>(static_cast<float>(i * 7 % 11) * 0.5f),
+          i};
+      InsertRow(db_->GetTable("t"),
+          {row.a_ ? ValueFactory::CreateIntValue(*row.a_) : ValueFactory::CreateNullValue(TYPE_INT),
+              row.b_ ? ValueFactory::CreateFloatValue(*row.b_) : ValueFactory::CreateNullValue(TYPE_FLOAT),
+              ValueFactory::CreateIntValue(row.id_)});
+      rows_.push_back(row);
+    }
+  }
+
+  /// order by a, b in the given directions, nulls go first in ascending order and last in descending order, ties keep
+  /// the input order
+  auto ExpectRows(const std::vector<bool> &is_desc) -> std::vector<Row>
+  {
+    auto rows = rows_;
+    std::stable_sort(rows.begin(), rows.end(), [&is_desc](const Row &lhs, const Row &rhs) {
+      if (lhs.a_ != rhs.a_) {
+        return is_desc[0] ? lhs.a_ > rhs.a_ : lhs.a_ < rhs.a_;
+      }
+      return is_desc[1] ? lhs.b_ > rhs.b_ : lhs.b_ < rhs.b_;
+    });
+    return rows;
+  }
+
+  auto Expect(const std::vector<bool> &is_desc = {false, true}) -> std::vector<std::string>
+  {
+    std::vector<std::string> expect;
+    for (const auto &row : ExpectRows(is_desc)) {
+      std::vector<ValueSptr> values{
+          row.a_ ? ValueFactory::CreateIntValue(*row.a_) : ValueFactory::CreateNullValue(TYPE_INT),
+          row.b_ ? ValueFactory::CreateFloatValue(*row.b_) : ValueFactory::CreateNullValue(TYPE_FLOAT),
+          ValueFactory::CreateIntValue(row.id_)};
+      expect.push_back(RowString(Record(&db_->GetTable("t")->GetSchema(), values, INVALID_RID)));
+    }
+    return expect;
+  }
+
+  auto KeySchema() -> RecordSchemaUptr
+  {
+    const auto &schema = db_->GetTable("t")->GetSchema();
+    return std::make_unique<RecordSchema>(std::vector<RTField>{schema.GetFieldAt(0), schema.GetFieldAt(1)});
+  }
+
+  template <typename SortExecutorType = SortExecutor>
+  auto Sort(size_t buffer_size, const std::vector<bool> &is_desc = {false, true}) -> std::unique_ptr<SortExecutor>
+  {
+    return std::make_unique<SortExecutorType>(
+        std::make_unique<SeqScanExecutor>(db_->GetTable("t")), KeySchema(), is_desc, buffer_size);
+  }
+
+  auto TopN(size_t limit, const std::vector<bool> &is_desc) -> std::unique_ptr<TopNExecutor>
+  {
+    return std::make_unique<TopNExecutor>(
+        std::make_unique<SeqScanExecutor>(db_->GetTable("t")), KeySchema(), is_desc, limit);
+  }
+
+  static inline const std::vector<std::vector<bool>> DIRECTIONS{
+      {false, false}, {false, true}, {true, false}, {true, true}};
+
+  static constexpr int ROW_NUM = 12000;
+
+  TestDatabase     db_{"sort_test"};
+  std::vector<Row> rows_;
+};
+
+TEST_F(SortTest, InMemory)
+{
+  auto sort = Sort(SORT_BUFFER_SIZE);
+  ASSERT_EQ(DumpRows(sort.get()), Expect());
+  ASSERT_EQ(DumpBatches(sort.get()), Expect());
+}
+
+TEST_F(SortTest, MultiPassMerge)
+{
+  // runs of 100 records and less are more than SORT_WAY_NUM * SORT_WAY_NUM, so they take several merge passes
+  size_t rec_len = db_->GetTable("t")->GetSchema().GetRecordLength();
+  for (size_t run_len : {ROW_NUM / SORT_WAY_NUM, 100UL, 2UL}) {
+    SCOPED_TRACE(run_len);
+    auto sort = Sort(run_len * rec_len);
+    ASSERT_EQ(DumpRows(sort.get()), Expect());
+    ASSERT_EQ(DumpBatches(sort.get()), Expect());
+  }
+  for (const auto &entry : std::filesystem::directory_iterator(TMP_DIR)) {
+    ASSERT_EQ(entry.path().filename().string().rfind("sort_", 0), std::string::npos) << entry.path();
+  }
+}
+
+TEST_F(SortTest, ParallelMatchesSerial)
+{
+  // runs of a third of the input are sorted and merged by several tasks, small runs take several merge passes
+  size_t rec_len = db_->GetTable("t")->GetSchema().GetRecordLength();
+  for (size_t run_len : {static_cast<size_t>(ROW_NUM), ROW_NUM / 3UL, 100UL, 2UL}) {
+    SCOPED_TRACE(run_len);
+    auto serial   = Sort(run_len * rec_len);
+    auto parallel = Sort<ParallelSortExecutor>(run_len * rec_len);
+    auto expect   = DumpRows(serial.get());
+    ASSERT_EQ(expect, Expect());
+    ASSERT_EQ(DumpRows(parallel.get()), expect);
+    ASSERT_EQ(DumpBatches(parallel.get()), expect);
+  }
+
+  // three runs are merged by the last pass alone, which is returned without writing a merged run
+  auto parallel = Sort<ParallelSortExecutor>(ROW_NUM / 3 * db_->GetTable("t")->GetSchema().GetRecordLength());
+  parallel->Init();
+  size_t run_file_num = 0;
+  for (const auto &entry : std::filesystem::directory_iterator(TMP_DIR)) {
+    // run files are named sort_result_<sort>_<group>_<idx>, runs of the buffer are in group 0
+    auto file_name = entry.path().stem().string();
+    if (file_name.rfind("sort_", 0) == 0) {
+      auto group_end   = file_name.rfind('_');
+      auto group_begin = file_name.rfind('_', group_end - 1) + 1;
+      ASSERT_EQ(file_name.substr(group_begin, group_end - group_begin), "0") << file_name;
+      run_file_num++;
+    }
+  }
+  ASSERT_EQ(run_file_num, 3);
+}
+
+TEST_F(SortTest, MixedDirections)
+{
+  for (const auto &is_desc : DIRECTIONS) {
+    SCOPED_TRACE(fmt::format("a {}, b {}", is_desc[0] ? "desc" : "asc", is_desc[1] ? "desc" : "asc"));
+    auto expect = Expect(is_desc);
+    auto sort   = Sort(SORT_BUFFER_SIZE, is_desc);
+    ASSERT_EQ(DumpRows(sort.get()), expect);
+    // the merge of runs orders by the same keys
+    auto spilled = Sort(ROW_NUM / 7 * db_->GetTable("t")->GetSchema().GetRecordLength(), is_desc);
+    ASSERT_EQ(DumpRows(spilled.get()), expect);
+  }
+}
+
+TEST_F(SortTest, TopNMatchesSortLimit)
+{
+  for (const auto &is_desc : DIRECTIONS) {
+    SCOPED_TRACE(fmt::format("a {}, b {}", is_desc[0] ? "desc" : "asc", is_desc[1] ? "desc" : "asc"));
+    auto rows   = ExpectRows(is_desc);
+    auto expect = Expect(is_desc);
+    // the record at the cutoff of tie_limit ties with the next one, so the input order decides which is kept
+    size_t tie_limit = 37;
+    while (rows[tie_limit - 1].a_ != rows[tie_limit].a_ || rows[tie_limit - 1].b_ != rows[tie_limit].b_) {
+      tie_limit++;
+    }
+    for (size_t limit : {0UL, 1UL, tie_limit, ROW_NUM - 1UL, static_cast<size_t>(ROW_NUM), ROW_NUM + 5UL}) {
+      SCOPED_TRACE(limit);
+      auto limited = std::vector<std::string>(expect.begin(), expect.begin() + std::min<size_t>(limit, ROW_NUM));
+      auto top_n   = TopN(limit, is_desc);
+      ASSERT_EQ(DumpRows(top_n.get()), limited);
+      ASSERT_EQ(DumpBatches(top_n.get()), limited);
+      LimitExecutor sort_limit(Sort(SORT_BUFFER_SIZE, is_desc), static_cast<int>(limit));
+      ASSERT_EQ(DumpRows(&sort_limit), limited);
+    }
+  }
+}
+
+TEST_F(SortTest, TopNFallsBackToSortLimit)
+{
+  // records kept by a top-n should fit in the sort buffer, a larger limit sorts with tmp files and cuts the result
+  size_t max_kept = SORT_BUFFER_SIZE / db_->GetTable("t")->GetSchema().GetRecordLength();
+  for (size_t limit : {max_kept, max_kept + 1}) {
+    SCOPED_TRACE(limit);
+    auto plan = std::make_shared<TopNPlan>(
+        std::make_shared<ScanPlan>("t"), KeySchema(), std::vector<bool>{false, true}, limit);
+    auto exec = Executor::Translate(plan, db_.Get());
+    ASSERT_EQ(dynamic_cast<TopNExecutor *>(exec.get()) != nullptr, limit == max_kept);
+    ASSERT_EQ(dynamic_cast<LimitExecutor *>(exec.get()) != nullptr, limit > max_kept);
+    ASSERT_EQ(DumpRows(exec.get()), Expect());
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -3,12 +3,14 @@
 //
 
 #include "../config.h"
+#include "executor_test_util.h"
 #include "common/types.h"
 #include "storage/storage.h"
 #include "system/handle/table_handle.h"
 #include "system/table/table_manager.h"
 
 #include <cassert>
+#include <map>
 #include <unordered_map>
 #include <vector>
 #include <unordered_set>
@@ -304,6 +306,132 @@ TEST(TableHandle, PAX_MultiThread)
     ASSERT_EQ(cnt, rids.size());
 }
 
+/**
+ * Check a record read with only the fields of proj_schema against the full record: each field comes from its field
+ * of the table with its own null bit, the rid field holds the rid, and no other bit of the null map is set
+ */
+void CheckProjected(const TableHandle &tbl, const RecordSchema &proj_schema, const Record &full, const char *null_map,
+    const char *data)
+{
+    Record proj(&proj_schema, null_map, data, full.GetRID());
+    for (size_t i = 0; i < proj_schema.GetFieldCount(); ++i) {
+        const auto &field = proj_schema.GetFieldAt(i);
+        if (IsRidField(field)) {
+            ASSERT_FALSE(BitMap::GetBit(null_map, i));
+            RID rid;
+            memcpy(&rid, data + proj_schema.GetFieldOffset(i), sizeof(RID));
+            ASSERT_EQ(rid, full.GetRID());
+            continue;
+        }
+        auto idx = tbl.GetSchema().GetRTFieldIndex(field);
+        ASSERT_EQ(BitMap::GetBit(null_map, i), BitMap::GetBit(full.GetNullMap(), idx)) << field.field_.field_name_;
+        ASSERT_EQ(proj.GetValueAt(i)->ToString(), full.GetValueAt(idx)->ToString()) << field.field_.field_name_;
+    }
+    for (size_t i = proj_schema.GetFieldCount(); i < BITMAP_SIZE(proj_schema.GetFieldCount()) * 8; ++i) {
+        ASSERT_FALSE(BitMap::GetBit(null_map, i));
+    }
+}
+
+/// read each page with projections of fields that are null in some records, and with fields in another order
+void CheckProjectedScan(StorageModel model, const std::string &table_name)
+{
+    auto disk_manager        = std::make_unique<DiskManager>();
+    auto buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+    auto table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+    if (!std::filesystem::exists(TEST_DIR))
+        std::filesystem::create_directory(TEST_DIR);
+    if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+        std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+    RecordSchema tbl_schema({MakeField("a", TYPE_INT, 4),
+        MakeField("b", TYPE_STRING, 12),
+        MakeField("c", TYPE_FLOAT, 4),
+        MakeField("d", TYPE_STRING, 20),
+        MakeField("e", TYPE_INT, 4)});
+    table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, model);
+    auto tbl = table_manager->OpenTable(TEST_DIR, table_name, model);
+    // a is never null, the other fields are null in different records
+    std::vector<RID> rids;
+    for (int i = 0; i < 1000; ++i) {
+        auto b       = fmt::format("b{}", i);
+        auto d       = fmt::format("d{}", i);
+        auto null_or = [i](int n, FieldType type, ValueSptr value) {
+            return i % n == 0 ? ValueFactory::CreateNullValue(type) : std::move(value);
+        };
+        std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i),
+            null_or(3, TYPE_STRING, ValueFactory::CreateStringValue(b.c_str(), b.size())),
+            null_or(5, TYPE_FLOAT, ValueFactory::CreateFloatValue(i * 0.25f)),
+            null_or(2, TYPE_STRING, ValueFactory::CreateStringValue(d.c_str(), d.size())),
+            null_or(7, TYPE_INT, ValueFactory::CreateIntValue(-i))};
+        rids.push_back(tbl->InsertRecord(Record(&tbl->GetSchema(), values, INVALID_RID)));
+    }
+    // empty slots are skipped
+    for (size_t i = 0; i < rids.size(); i += 10) {
+        tbl->DeleteRecord(rids[i]);
+    }
+    std::map<page_id_t, std::vector<RecordUptr>> pages;
+    for (auto rid = tbl->GetFirstRID(); rid != INVALID_RID; rid = tbl->GetNextRID(rid)) {
+        pages[rid.PageID()].push_back(tbl->GetRecord(rid));
+    }
+    ASSERT_GT(pages.size(), 1);
+
+    const auto                   &fields = tbl->GetSchema().GetFields();
+    std::vector<RecordSchemaUptr> proj_schemas;
+    proj_schemas.push_back(std::make_unique<RecordSchema>(std::vector<RTField>{fields[3], fields[0]}));
+    proj_schemas.push_back(std::make_unique<RecordSchema>(std::vector<RTField>{fields[2]}));
+    proj_schemas.push_back(std::make_unique<RecordSchema>(
+        std::vector<RTField>{fields[4], MakeRidField(tbl->GetTableId()), fields[1]}));
+    proj_schemas.push_back(std::make_unique<RecordSchema>(std::vector<RTField>{fields[0]}));
+    for (const auto &schema : proj_schemas) {
+        const auto &proj_schema = *schema;
+        for (const auto &[pid, records] : pages) {
+            auto page_records = tbl->GetPageRecords(pid, &proj_schema);
+            ASSERT_EQ(page_records.size(), records.size());
+            for (size_t i = 0; i < records.size(); ++i) {
+                ASSERT_EQ(page_records[i]->GetSchema()->GetRecordLength(), proj_schema.GetRecordLength());
+                const auto &rec = page_records[i];
+                CheckProjected(*tbl, proj_schema, *records[i], rec->GetNullMap(), rec->GetData());
+            }
+
+            size_t scanned = 0;
+            tbl->ScanPage(pid, &proj_schema, [&](const char *null_map, const char *data, size_t) {
+                CheckProjected(*tbl, proj_schema, *records[scanned++], null_map, data);
+                return true;
+            });
+            ASSERT_EQ(scanned, records.size());
+
+            Chunk chunk(&proj_schema, tbl->GetTableHeader().rec_per_page_);
+            tbl->AppendChunk(pid, &chunk);
+            ASSERT_EQ(chunk.GetSize(), records.size());
+            for (size_t i = 0; i < records.size(); ++i) {
+                auto record = chunk.GetRecord(i);
+                CheckProjected(*tbl, proj_schema, *records[i], record->GetNullMap(), record->GetData());
+            }
+
+            std::vector<RID> page_rids;
+            for (const auto &record : records) {
+                page_rids.push_back(record->GetRID());
+            }
+            auto fetched = tbl->GetRecords(page_rids, &proj_schema);
+            ASSERT_EQ(fetched.size(), records.size());
+            for (size_t i = 0; i < records.size(); ++i) {
+                ASSERT_EQ(fetched[i]->GetRID(), records[i]->GetRID());
+                CheckProjected(*tbl, proj_schema, *records[i], fetched[i]->GetNullMap(), fetched[i]->GetData());
+            }
+        }
+    }
+    // the page is released whatever the consumer throws
+    auto pid      = pages.begin()->first;
+    auto throwing = [](const char *, const char *, size_t) -> bool { throw std::bad_alloc(); };
+    ASSERT_THROW(tbl->ScanPage(pid, &tbl->GetSchema(), throwing), std::bad_alloc);
+    ASSERT_EQ(buffer_pool_manager->GetFrame(tbl->GetTableId(), pid)->GetPinCount(), 0);
+    table_manager->CloseTable(TEST_DIR, *tbl);
+    table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, ProjectedScan) { CheckProjectedScan(NARY_MODEL, "table_handle_projected_scan"); }
+
+TEST(TableHandle, PAX_ProjectedScan) { CheckProjectedScan(PAX_MODEL, "table_handle_pax_projected_scan"); }
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
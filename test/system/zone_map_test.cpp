@@ -0,0 +1,195 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "../config.h"
+#include "executor_test_util.h"
+#include "execution/executor_filter.h"
+#include "execution/executor_seqscan.h"
+#include "expr/condition_expr.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class ZoneMapTest : public ::testing::TestWithParam<StorageModel>
+{
+protected:
+  void SetUp() override
+  {
+    disk_manager_        = std::make_unique<DiskManager>();
+    buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), nullptr);
+    table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    if (!std::filesystem::exists(TEST_DIR)) {
+      std::filesystem::create_directory(TEST_DIR);
+    }
+    if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name_, TAB_SUFFIX))) {
+      TableManager::DropTable(TEST_DIR, table_name_);
+    }
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name_, ZM_SUFFIX));
+    RecordSchema schema({MakeField("id", TYPE_INT, 4), MakeField("pad", TYPE_STRING, 60)});
+    table_manager_->CreateTable(TEST_DIR, table_name_, schema, GetParam());
+    tbl_ = table_manager_->OpenTable(TEST_DIR, table_name_, GetParam());
+  }
+
+  void TearDown() override
+  {
+    table_manager_->CloseTable(TEST_DIR, *tbl_);
+    TableManager::DropTable(TEST_DIR, table_name_);
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name_, ZM_SUFFIX));
+  }
+
+  void Reopen()
+  {
+    table_manager_->CloseTable(TEST_DIR, *tbl_);
+    tbl_ = table_manager_->OpenTable(TEST_DIR, table_name_, GetParam());
+  }
+
+  auto Insert(int id) -> RID
+  {
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(id), ValueFactory::CreateStringValue("p", 1)};
+    return tbl_->InsertRecord(Record(&tbl_->GetSchema(), values, INVALID_RID));
+  }
+
+  void Update(const RID &rid, int id)
+  {
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(id), ValueFactory::CreateStringValue("u", 1)};
+    tbl_->UpdateRecord(rid, Record(&tbl_->GetSchema(), values, INVALID_RID));
+  }
+
+  auto IdLess(int bound) -> ConditionVec
+  {
+    ValueSptr val = ValueFactory::CreateIntValue(bound);
+    return {Condition(OP_LT, tbl_->GetSchema().GetFieldAt(0), val)};
+  }
+
+  /// check that no page holding a matching record is skipped, and return the number of pages skipped
+  auto CheckPages(const ConditionVec &conds) -> size_t
+  {
+    size_t skipped  = 0;
+    auto   page_num = static_cast<page_id_t>(tbl_->GetTableHeader().page_num_);
+    for (auto pid = FILE_HEADER_PAGE_ID + 1; pid < page_num; ++pid) {
+      bool matched = false;
+      tbl_->ScanPage(pid, &tbl_->GetSchema(), [&](const char *nullmap, const char *data, slot_id_t) {
+        matched = ConditionExpr::Eval(conds, Record(&tbl_->GetSchema(), nullmap, data, INVALID_RID));
+        return !matched;
+      });
+      bool may_match = tbl_->PageMayMatch(pid, conds);
+      EXPECT_TRUE(may_match || !matched) << "page " << pid << " is skipped but has a matching record";
+      skipped += may_match ? 0 : 1;
+    }
+    return skipped;
+  }
+
+  /// scan with page skipping and filter, compared with a filter over a full scan
+  void CheckScan(const ConditionVec &conds)
+  {
+    FilterExecutor skip(std::make_unique<SeqScanExecutor>(tbl_.get(), nullptr, conds), conds);
+    FilterExecutor full(std::make_unique<SeqScanExecutor>(tbl_.get()), conds);
+    auto           expect = DumpRows(&full);
+    EXPECT_EQ(DumpRows(&skip), expect);
+    EXPECT_EQ(DumpBatches(&skip), expect);
+  }
+
+  std::string                        table_name_ = "zone_map_test";
+  std::unique_ptr<DiskManager>       disk_manager_;
+  std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+  std::unique_ptr<TableManager>      table_manager_;
+  TableHandleUptr                    tbl_;
+};
+
+TEST_P(ZoneMapTest, SkipAndMaintain)
+{
+  // ids ascend with the pages, so a range predicate on id matches only a few pages
+  std::vector<RID> rids;
+  for (int i = 0; i < 3000; ++i) {
+    rids.push_back(Insert(i));
+  }
+  ASSERT_GT(tbl_->GetTableHeader().page_num_, 10);
+  auto page_num = tbl_->GetTableHeader().page_num_ - 1;
+  ASSERT_GE(CheckPages(IdLess(100)), page_num - 2);
+  ASSERT_EQ(CheckPages(IdLess(0)), page_num);
+  CheckScan(IdLess(100));
+
+  // an update widens the bounds of the page
+  auto last = rids.back();
+  Update(last, -7);
+  ASSERT_TRUE(tbl_->PageMayMatch(last.PageID(), IdLess(0)));
+  CheckPages(IdLess(0));
+  CheckScan(IdLess(0));
+
+  // deleting all the records of a page leaves no value to match
+  auto first_page = rids.front().PageID();
+  for (const auto &rid : rids) {
+    if (rid.PageID() == first_page) {
+      tbl_->DeleteRecord(rid);
+    }
+  }
+  ASSERT_FALSE(tbl_->PageMayMatch(first_page, IdLess(100)));
+  CheckScan(IdLess(100));
+
+  // inserts reuse the freed slots and widen the bounds again
+  auto rid = Insert(-3);
+  ASSERT_TRUE(tbl_->PageMayMatch(rid.PageID(), IdLess(-2)));
+  CheckPages(IdLess(-2));
+  CheckScan(IdLess(100));
+}
+
+TEST_P(ZoneMapTest, SideFile)
+{
+  std::vector<RID> rids;
+  for (int i = 0; i < 3000; ++i) {
+    rids.push_back(Insert(i));
+  }
+  // bounds are only widened, so the page keeps -100 as its minimum while no record has it
+  Update(rids.back(), -100);
+  Update(rids.back(), 2999);
+  ASSERT_TRUE(tbl_->PageMayMatch(rids.back().PageID(), IdLess(-50)));
+
+  // the zone map is saved on close and loaded on open, stale bounds included
+  table_manager_->CloseTable(TEST_DIR, *tbl_);
+  ASSERT_TRUE(std::filesystem::exists(FILE_NAME(TEST_DIR, table_name_, ZM_SUFFIX)));
+  tbl_ = table_manager_->OpenTable(TEST_DIR, table_name_, GetParam());
+  ASSERT_FALSE(std::filesystem::exists(FILE_NAME(TEST_DIR, table_name_, ZM_SUFFIX)));
+  ASSERT_TRUE(tbl_->PageMayMatch(rids.back().PageID(), IdLess(-50)));
+  CheckPages(IdLess(100));
+  CheckScan(IdLess(100));
+
+  // without the side file, e.g. the table was not closed properly, the zone map is rebuilt with tight bounds
+  table_manager_->CloseTable(TEST_DIR, *tbl_);
+  std::filesystem::remove(FILE_NAME(TEST_DIR, table_name_, ZM_SUFFIX));
+  tbl_ = table_manager_->OpenTable(TEST_DIR, table_name_, GetParam());
+  ASSERT_FALSE(tbl_->PageMayMatch(rids.back().PageID(), IdLess(-50)));
+  ASSERT_GE(CheckPages(IdLess(100)), tbl_->GetTableHeader().page_num_ - 3);
+  CheckScan(IdLess(100));
+
+  // pages added after a reopen are saved with the others on the next close
+  Reopen();
+  for (int i = 0; i < 1000; ++i) {
+    Insert(-i);
+  }
+  CheckPages(IdLess(0));
+  Reopen();
+  CheckPages(IdLess(0));
+  CheckScan(IdLess(0));
+}
+
+INSTANTIATE_TEST_SUITE_P(StorageModels, ZoneMapTest, ::testing::Values(NARY_MODEL, PAX_MODEL));
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}